@@ -0,0 +1,185 @@
+#version 450
+
+#extension GL_KHR_shader_subgroup_quad : require
+
+//generates whole mip chain of a texture with single pass downsampler, spd mip 0 is mip 1 of the texture.
+//values are reduced in linear space, srgb is decoded on load and encoded on store
+#define FFX_GPU
+#define FFX_GLSL
+
+#include "ffx_core.h"
+
+//keep in sync with VulkanMipGenerator
+#define MIP_GENERATOR_MAX_MIP_COUNT 12
+
+#define MIP_GENERATION_SRGB				0x1
+#define MIP_GENERATION_NORMAL_MAP		0x2
+#define MIP_GENERATION_ALPHA_COVERAGE	0x4
+
+//glTF default alpha cutoff
+#define ALPHA_COVERAGE_CUTOFF 0.5
+
+layout(binding = 0) uniform sampler2D sourceTexture;
+
+layout(std430, binding = 1) coherent buffer SPDAtomicCounterBuffer
+{
+	uint counters[];
+} spdGlobalAtomic;
+
+layout(rgba8, binding = 2) uniform writeonly image2D outputMip0;
+layout(rgba8, binding = 3) uniform writeonly image2D outputMip1;
+layout(rgba8, binding = 4) uniform writeonly image2D outputMip2;
+layout(rgba8, binding = 5) uniform writeonly image2D outputMip3;
+layout(rgba8, binding = 6) uniform writeonly image2D outputMip4;
+layout(rgba8, binding = 7) coherent uniform image2D outputMip5;
+layout(rgba8, binding = 8) uniform writeonly image2D outputMip6;
+layout(rgba8, binding = 9) uniform writeonly image2D outputMip7;
+layout(rgba8, binding = 10) uniform writeonly image2D outputMip8;
+layout(rgba8, binding = 11) uniform writeonly image2D outputMip9;
+layout(rgba8, binding = 12) uniform writeonly image2D outputMip10;
+layout(rgba8, binding = 13) uniform writeonly image2D outputMip11;
+
+layout(push_constant) uniform Push
+{
+	uvec2 sourceSize;
+	uint mipCount;
+	uint numWorkGroups;
+	uint counterIndex;
+	uint flags;
+} push;
+
+shared uint spdCounter;
+shared vec4 spdIntermediate[16][16];
+
+bool HasFlag(uint flag)
+{
+	return (push.flags & flag) != 0;
+}
+
+vec3 SRGBToLinear(vec3 color)
+{
+	return mix(color / 12.92, pow((color + 0.055) / 1.055, vec3(2.4)), greaterThan(color, vec3(0.04045)));
+}
+
+vec3 LinearToSRGB(vec3 color)
+{
+	return mix(color * 12.92, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, greaterThan(color, vec3(0.0031308)));
+}
+
+uvec2 GetMipSize(uint textureMip)
+{
+	return max(push.sourceSize >> textureMip, uvec2(1));
+}
+
+//normals are averaged unpacked, with alpha coverage alpha holds the part of mip 0 texels that pass the alpha test,
+//so the test keeps roughly the same coverage in every mip instead of fading out
+vec4 DecodeTexel(vec4 texel, bool isSource)
+{
+	if (HasFlag(MIP_GENERATION_NORMAL_MAP))
+	{
+		texel.xyz = texel.xyz * 2.0 - 1.0;
+	}
+	else if (HasFlag(MIP_GENERATION_SRGB) && !isSource)
+	{
+		texel.rgb = SRGBToLinear(texel.rgb);
+	}
+
+	if (HasFlag(MIP_GENERATION_ALPHA_COVERAGE) && isSource)
+	{
+		texel.a = texel.a >= ALPHA_COVERAGE_CUTOFF ? 1.0 : 0.0;
+	}
+
+	return texel;
+}
+
+vec4 EncodeTexel(vec4 value)
+{
+	if (HasFlag(MIP_GENERATION_NORMAL_MAP))
+	{
+		float normalLength = length(value.xyz);
+		value.xyz = (normalLength > 0.0 ? value.xyz / normalLength : vec3(0.0, 0.0, 1.0)) * 0.5 + 0.5;
+	}
+	else if (HasFlag(MIP_GENERATION_SRGB))
+	{
+		value.rgb = LinearToSRGB(clamp(value.rgb, 0.0, 1.0));
+	}
+
+	return value;
+}
+
+//srgb view decodes source texels already, edges are clamped for textures that are not power of two
+FfxFloat32x4 SpdLoadSourceImage(FfxInt32x2 p, FfxUInt32 slice)
+{
+	ivec2 texel = min(p, ivec2(push.sourceSize) - 1);
+	return DecodeTexel(texelFetch(sourceTexture, texel, 0), true);
+}
+
+FfxFloat32x4 SpdLoad(FfxInt32x2 p, FfxUInt32 slice)
+{
+	ivec2 texel = min(p, ivec2(GetMipSize(6)) - 1);
+	return DecodeTexel(imageLoad(outputMip5, texel), false);
+}
+
+void SpdStore(FfxInt32x2 p, FfxFloat32x4 value, FfxUInt32 mip, FfxUInt32 slice)
+{
+	if (any(greaterThanEqual(uvec2(p), GetMipSize(mip + 1))))
+	{
+		return;
+	}
+
+	vec4 texel = EncodeTexel(value);
+
+	switch (mip)
+	{
+		case 0: imageStore(outputMip0, p, texel); break;
+		case 1: imageStore(outputMip1, p, texel); break;
+		case 2: imageStore(outputMip2, p, texel); break;
+		case 3: imageStore(outputMip3, p, texel); break;
+		case 4: imageStore(outputMip4, p, texel); break;
+		case 5: imageStore(outputMip5, p, texel); break;
+		case 6: imageStore(outputMip6, p, texel); break;
+		case 7: imageStore(outputMip7, p, texel); break;
+		case 8: imageStore(outputMip8, p, texel); break;
+		case 9: imageStore(outputMip9, p, texel); break;
+		case 10: imageStore(outputMip10, p, texel); break;
+		case 11: imageStore(outputMip11, p, texel); break;
+	}
+}
+
+FfxFloat32x4 SpdLoadIntermediate(FfxUInt32 x, FfxUInt32 y)
+{
+	return spdIntermediate[x][y];
+}
+
+void SpdStoreIntermediate(FfxUInt32 x, FfxUInt32 y, FfxFloat32x4 value)
+{
+	spdIntermediate[x][y] = value;
+}
+
+FfxFloat32x4 SpdReduce4(FfxFloat32x4 v0, FfxFloat32x4 v1, FfxFloat32x4 v2, FfxFloat32x4 v3)
+{
+	return (v0 + v1 + v2 + v3) * 0.25;
+}
+
+void SpdIncreaseAtomicCounter(FfxUInt32 slice)
+{
+	spdCounter = atomicAdd(spdGlobalAtomic.counters[push.counterIndex], 1);
+}
+
+FfxUInt32 SpdGetAtomicCounter()
+{
+	return spdCounter;
+}
+
+void SpdResetAtomicCounter(FfxUInt32 slice)
+{
+	spdGlobalAtomic.counters[push.counterIndex] = 0;
+}
+
+#include "ffx_spd.h"
+
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+void main()
+{
+	SpdDownsample(gl_WorkGroupID.xy, gl_LocalInvocationIndex, push.mipCount, push.numWorkGroups, 0);
+}
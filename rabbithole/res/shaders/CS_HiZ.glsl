@@ -0,0 +1,122 @@
+#version 450
+
+#extension GL_KHR_shader_subgroup_quad : require
+
+//builds min/max depth pyramid with single pass downsampler, r = closest depth, g = farthest depth
+#define FFX_GPU
+#define FFX_GLSL
+
+#include "ffx_core.h"
+
+//keep in sync with HIZ_MAX_MIP_COUNT
+#define HIZ_MAX_MIP_COUNT 12
+
+layout(binding = 0) uniform sampler2D depthTexture;
+
+layout(std430, binding = 1) coherent buffer SPDAtomicCounterBuffer
+{
+	uint counter;
+} spdGlobalAtomic;
+
+layout(rg32f, binding = 2) uniform writeonly image2D hizMip0;
+layout(rg32f, binding = 3) uniform writeonly image2D hizMip1;
+layout(rg32f, binding = 4) uniform writeonly image2D hizMip2;
+layout(rg32f, binding = 5) uniform writeonly image2D hizMip3;
+layout(rg32f, binding = 6) uniform writeonly image2D hizMip4;
+layout(rg32f, binding = 7) coherent uniform image2D hizMip5;
+layout(rg32f, binding = 8) uniform writeonly image2D hizMip6;
+layout(rg32f, binding = 9) uniform writeonly image2D hizMip7;
+layout(rg32f, binding = 10) uniform writeonly image2D hizMip8;
+layout(rg32f, binding = 11) uniform writeonly image2D hizMip9;
+layout(rg32f, binding = 12) uniform writeonly image2D hizMip10;
+layout(rg32f, binding = 13) uniform writeonly image2D hizMip11;
+
+layout(push_constant) uniform Push
+{
+	uint mipCount;
+	uint numWorkGroups;
+	uvec2 depthSize;
+} push;
+
+shared uint spdCounter;
+shared float spdIntermediateR[16][16];
+shared float spdIntermediateG[16][16];
+
+FfxFloat32x4 SpdLoadSourceImage(FfxInt32x2 p, FfxUInt32 slice)
+{
+	//pyramid is padded to power of two, treat everything outside of the screen as far plane
+	if (any(greaterThanEqual(uvec2(p), push.depthSize)))
+	{
+		return vec4(1.0);
+	}
+
+	float depth = texelFetch(depthTexture, p, 0).r;
+	return vec4(depth, depth, 0.0, 0.0);
+}
+
+FfxFloat32x4 SpdLoad(FfxInt32x2 p, FfxUInt32 slice)
+{
+	return vec4(imageLoad(hizMip5, p).rg, 0.0, 0.0);
+}
+
+void SpdStore(FfxInt32x2 p, FfxFloat32x4 value, FfxUInt32 mip, FfxUInt32 slice)
+{
+	vec4 minMax = vec4(value.rg, 0.0, 0.0);
+
+	switch (mip)
+	{
+		case 0: imageStore(hizMip0, p, minMax); break;
+		case 1: imageStore(hizMip1, p, minMax); break;
+		case 2: imageStore(hizMip2, p, minMax); break;
+		case 3: imageStore(hizMip3, p, minMax); break;
+		case 4: imageStore(hizMip4, p, minMax); break;
+		case 5: imageStore(hizMip5, p, minMax); break;
+		case 6: imageStore(hizMip6, p, minMax); break;
+		case 7: imageStore(hizMip7, p, minMax); break;
+		case 8: imageStore(hizMip8, p, minMax); break;
+		case 9: imageStore(hizMip9, p, minMax); break;
+		case 10: imageStore(hizMip10, p, minMax); break;
+		case 11: imageStore(hizMip11, p, minMax); break;
+	}
+}
+
+FfxFloat32x4 SpdLoadIntermediate(FfxUInt32 x, FfxUInt32 y)
+{
+	return vec4(spdIntermediateR[x][y], spdIntermediateG[x][y], 0.0, 0.0);
+}
+
+void SpdStoreIntermediate(FfxUInt32 x, FfxUInt32 y, FfxFloat32x4 value)
+{
+	spdIntermediateR[x][y] = value.r;
+	spdIntermediateG[x][y] = value.g;
+}
+
+FfxFloat32x4 SpdReduce4(FfxFloat32x4 v0, FfxFloat32x4 v1, FfxFloat32x4 v2, FfxFloat32x4 v3)
+{
+	float minDepth = min(min(v0.r, v1.r), min(v2.r, v3.r));
+	float maxDepth = max(max(v0.g, v1.g), max(v2.g, v3.g));
+	return vec4(minDepth, maxDepth, 0.0, 0.0);
+}
+
+void SpdIncreaseAtomicCounter(FfxUInt32 slice)
+{
+	spdCounter = atomicAdd(spdGlobalAtomic.counter, 1);
+}
+
+FfxUInt32 SpdGetAtomicCounter()
+{
+	return spdCounter;
+}
+
+void SpdResetAtomicCounter(FfxUInt32 slice)
+{
+	spdGlobalAtomic.counter = 0;
+}
+
+#include "ffx_spd.h"
+
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+void main()
+{
+	SpdDownsample(gl_WorkGroupID.xy, gl_LocalInvocationIndex, push.mipCount, push.numWorkGroups, 0);
+}
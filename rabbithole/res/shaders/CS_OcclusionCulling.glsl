@@ -0,0 +1,157 @@
+#version 450
+
+#include "common.h"
+
+//keep in sync with OcclusionCullingPhase
+#define CULLING_PHASE_EARLY 0
+#define CULLING_PHASE_LATE 1
+
+//VkDrawIndexedIndirectCommand is 5 uints, instanceCount is the second one
+#define INDIRECT_COMMAND_STRIDE 5
+#define INDIRECT_COMMAND_INSTANCE_COUNT 1
+
+struct DrawBounds
+{
+	vec4 boundsMin;
+	vec4 boundsMax;
+	vec4 coneApex;
+	vec4 coneAxisAndCutoff;
+};
+
+struct OcclusionCullingParams
+{
+	uint enabled;
+	uint drawCount;
+	uint earlyDrawOffset;
+	uint lateDrawOffset;
+	vec2 hizSize;
+	vec2 hizUVScale;
+	uint hizMipCount;
+};
+
+layout(binding = 0) uniform UniformBufferObjectBuffer
+{
+	UniformBufferObject UBO;
+};
+
+layout(binding = 1) uniform sampler2D hizTexture;
+
+layout(std430, binding = 2) readonly buffer DrawBoundsBuffer
+{
+	DrawBounds drawBounds[];
+};
+
+layout(std430, binding = 3) buffer IndirectCommandsBuffer
+{
+	uint indirectCommands[];
+};
+
+layout(std430, binding = 4) buffer VisibilityBuffer
+{
+	uint visibility[];
+};
+
+layout(binding = 5) uniform OcclusionCullingParamsBuffer
+{
+	OcclusionCullingParams params;
+};
+
+layout(push_constant) uniform Push
+{
+	uint phase;
+} push;
+
+bool IsVisible(DrawBounds bounds, bool testOcclusion)
+{
+	//whole meshlet is backfacing
+	vec3 viewDirection = normalize(bounds.coneApex.xyz - UBO.cameraPosition);
+	if (dot(viewDirection, bounds.coneAxisAndCutoff.xyz) >= bounds.coneAxisAndCutoff.w)
+	{
+		return false;
+	}
+
+	vec3 ndcMin = vec3(1.0);
+	vec3 ndcMax = vec3(-1.0);
+
+	for (uint corner = 0; corner < 8; corner++)
+	{
+		vec3 position = vec3(
+			(corner & 1) != 0 ? bounds.boundsMax.x : bounds.boundsMin.x,
+			(corner & 2) != 0 ? bounds.boundsMax.y : bounds.boundsMin.y,
+			(corner & 4) != 0 ? bounds.boundsMax.z : bounds.boundsMin.z);
+
+		vec4 clipPosition = UBO.viewProjMatrix * vec4(position, 1.0);
+
+		//box intersects near plane, projection is not reliable
+		if (clipPosition.w <= EPSILON)
+		{
+			return true;
+		}
+
+		vec3 ndc = clipPosition.xyz / clipPosition.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+
+	//frustum
+	if (ndcMax.x < -1.0 || ndcMin.x > 1.0 || ndcMax.y < -1.0 || ndcMin.y > 1.0 || ndcMin.z > 1.0 || ndcMax.z < 0.0)
+	{
+		return false;
+	}
+
+	if (!testOcclusion)
+	{
+		return true;
+	}
+
+	//hi-z covers padded resolution, scale uv so only the part with valid depth is addressed
+	vec2 uvMin = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0) * params.hizUVScale;
+	vec2 uvMax = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0) * params.hizUVScale;
+
+	//pick mip where the box covers at most 2x2 texels
+	vec2 extent = (uvMax - uvMin) * params.hizSize;
+	float mip = ceil(log2(max(max(extent.x, extent.y), 1.0)));
+	mip = clamp(mip, 0.0, float(params.hizMipCount - 1));
+
+	float maxDepth = textureLod(hizTexture, vec2(uvMin.x, uvMin.y), mip).g;
+	maxDepth = max(maxDepth, textureLod(hizTexture, vec2(uvMax.x, uvMin.y), mip).g);
+	maxDepth = max(maxDepth, textureLod(hizTexture, vec2(uvMin.x, uvMax.y), mip).g);
+	maxDepth = max(maxDepth, textureLod(hizTexture, vec2(uvMax.x, uvMax.y), mip).g);
+
+	//closest point of the box is behind everything already drawn in that area
+	return ndcMin.z <= maxDepth;
+}
+
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+void main()
+{
+	uint drawIndex = gl_GlobalInvocationID.x;
+
+	if (drawIndex >= params.drawCount)
+	{
+		return;
+	}
+
+	DrawBounds bounds = drawBounds[params.earlyDrawOffset + drawIndex];
+	bool cullingEnabled = params.enabled != 0;
+
+	if (push.phase == CULLING_PHASE_EARLY)
+	{
+		//draw only what was visible last frame, pyramid is not built yet
+		bool visible = !cullingEnabled || (visibility[drawIndex] != 0 && IsVisible(bounds, false));
+
+		uint commandIndex = (params.earlyDrawOffset + drawIndex) * INDIRECT_COMMAND_STRIDE + INDIRECT_COMMAND_INSTANCE_COUNT;
+		indirectCommands[commandIndex] = visible ? 1 : 0;
+	}
+	else
+	{
+		//test against this frame's pyramid and draw only what early phase missed
+		bool visible = !cullingEnabled || IsVisible(bounds, true);
+		bool drawnInEarlyPhase = visibility[drawIndex] != 0;
+
+		uint commandIndex = (params.lateDrawOffset + drawIndex) * INDIRECT_COMMAND_STRIDE + INDIRECT_COMMAND_INSTANCE_COUNT;
+		indirectCommands[commandIndex] = (cullingEnabled && visible && !drawnInEarlyPhase) ? 1 : 0;
+
+		visibility[drawIndex] = visible ? 1 : 0;
+	}
+}
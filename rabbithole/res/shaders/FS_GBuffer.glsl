@@ -1,5 +1,18 @@
 #version 450
 
+//feedback is written only for fragments that end up visible
+layout(early_fragment_tests) in;
+
+//keep in sync with MaterialFlags
+#define MATERIAL_FLAG_ALBEDO_MAP                1
+#define MATERIAL_FLAG_NORMAL_MAP                2
+#define MATERIAL_FLAG_METALLIC_ROUGHNESS_MAP    4
+
+//keep in sync with TextureStreamer.h
+#define TEXTURE_FEEDBACK_LOD_BIAS   32.0
+#define TEXTURE_FEEDBACK_LOD_STEPS  4.0
+#define NO_FEEDBACK_SLOT            0xFFFFFFFF
+
 layout(location = 0) in VS_OUT {
     vec3 FragPos;
     vec2 FragUV;
@@ -25,28 +38,70 @@ layout (binding = 1) uniform sampler2D samplerAlbedo;
 layout (binding = 2) uniform sampler2D samplerNormal;
 layout (binding = 3) uniform sampler2D samplerMetalicRoughness;
 
+//finest uv space lod every material is sampled with, read back by texture streaming
+layout (std430, binding = 4) buffer TextureFeedback
+{
+    uint requestedLod[];
+} feedback;
+
 layout(push_constant) uniform Push 
 {
     mat4 model;
     uint id;
-	bool useAlbedoMap;
-	bool useNormalMap;
-	bool useMetallicRoughnessMap;
+    uint materialFlags;
+    uint feedbackSlot;
+    uint padding;
     vec4 baseColor;
     vec4 emissiveColorAndStrenght;
+    vec3 positionScale;
+    uint vertexLayout;
 } push;
 
+//lod hardware picks for anisotropic sampling, in uv space so it is the same for every texture of material
+float GetUVLod(vec2 uv)
+{
+    float lengthX = length(dFdx(uv));
+    float lengthY = length(dFdy(uv));
+    float lengthMax = max(lengthX, lengthY);
+    float lengthMin = max(min(lengthX, lengthY), 1e-8);
+    float anisotropy = min(ceil(lengthMax / lengthMin), 16.0);
+    return log2(max(lengthMax / anisotropy, 1e-8));
+}
+
+void WriteTextureFeedback()
+{
+    //quarter of pixels in each direction is enough, derivatives are still computed for every quad
+    float uvLod = GetUVLod(fs_in.FragUV);
+    if (push.feedbackSlot == NO_FEEDBACK_SLOT || any(notEqual(uvec2(gl_FragCoord.xy) & 3u, uvec2(0))))
+    {
+        return;
+    }
+
+    uint quantizedLod = uint(clamp(uvLod + TEXTURE_FEEDBACK_LOD_BIAS, 0.0, 2.0 * TEXTURE_FEEDBACK_LOD_BIAS) * TEXTURE_FEEDBACK_LOD_STEPS);
+    atomicMin(feedback.requestedLod[push.feedbackSlot], quantizedLod);
+}
+
 void main() 
 {
+    WriteTextureFeedback();
+
     float roughness = texture(samplerMetalicRoughness, fs_in.FragUV).g;
     float metalness = texture(samplerMetalicRoughness, fs_in.FragUV).b;
-	vec3 N = normalize(fs_in.FragTBN * (texture(samplerNormal, fs_in.FragUV).xyz * 2.0 - vec3(1.0)));
+    //normal maps can be bc5, which stores only xy
+    vec3 tangentNormal;
+    tangentNormal.xy = texture(samplerNormal, fs_in.FragUV).xy * 2.0 - vec2(1.0);
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+	vec3 N = normalize(fs_in.FragTBN * tangentNormal);
+
+    bool useAlbedoMap = (push.materialFlags & MATERIAL_FLAG_ALBEDO_MAP) != 0;
+    bool useNormalMap = (push.materialFlags & MATERIAL_FLAG_NORMAL_MAP) != 0;
+    bool useMetallicRoughnessMap = (push.materialFlags & MATERIAL_FLAG_METALLIC_ROUGHNESS_MAP) != 0;
 
-    outAlbedo = push.useAlbedoMap ? vec4(texture(samplerAlbedo, fs_in.FragUV).rgb, 1.0) : push.baseColor;
-    outNormalRoughness.xyz = push.useNormalMap ? N :  fs_in.FragNormal;
-    outNormalRoughness.w = push.useMetallicRoughnessMap ? roughness : 1.f;
+    outAlbedo = useAlbedoMap ? vec4(texture(samplerAlbedo, fs_in.FragUV).rgb, 1.0) : push.baseColor;
+    outNormalRoughness.xyz = useNormalMap ? N :  fs_in.FragNormal;
+    outNormalRoughness.w = useMetallicRoughnessMap ? roughness : 1.f;
     outWorldPosMetalness.xyz = fs_in.FragPos;
-    outWorldPosMetalness.w = push.useMetallicRoughnessMap ? metalness : 1.f;
+    outWorldPosMetalness.w = useMetallicRoughnessMap ? metalness : 1.f;
 
     outVelocity = fs_in.FragVelocity;
     outEmissive = fs_in.FragEmissive;
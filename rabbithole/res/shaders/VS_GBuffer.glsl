@@ -2,6 +2,11 @@
 
 #include "common.h"
 
+//keep in sync with VertexLayout
+#define VERTEX_LAYOUT_FULL 0
+#define VERTEX_LAYOUT_COMPRESSED 1
+
+//compressed layout has position in [0, 1] of primitive bounds and octahedral normal and tangent in xy
 LAYOUT_IN_VEC3(0) position;
 LAYOUT_IN_VEC3(1) normal;
 LAYOUT_IN_VEC3(2) tangent;
@@ -30,11 +35,13 @@ layout(push_constant) uniform Push
 {
     mat4 model;
     uint id;
-	bool useAlbedoMap;
-	bool useNormalMap;
-	bool useMetallicRoughnessMap;
+    uint materialFlags;
+    uint feedbackSlot;
+    uint padding;
     vec4 baseColor;
     vec4 emissiveColorAndStrenght;
+    vec3 positionScale;
+    uint vertexLayout;
 } push;
 
 void main() 
@@ -45,8 +52,17 @@ void main()
     
     mat3 mNormal = transpose(inverse(mat3(push.model)));
 
-	vs_out.FragNormal = normalize(mNormal * normalize(normal));
-    vs_out.FragTangent = normalize(mNormal * normalize(tangent));
+    vec3 vertexNormal = normal;
+    vec3 vertexTangent = tangent;
+    if (push.vertexLayout == VERTEX_LAYOUT_COMPRESSED)
+    {
+        //model matrix also scales quantized positions, normal matrix divides by that scale so apply it once more
+        vertexNormal = OctahedralDecode(normal.xy) * push.positionScale;
+        vertexTangent = OctahedralDecode(tangent.xy) * push.positionScale;
+    }
+
+	vs_out.FragNormal = normalize(mNormal * normalize(vertexNormal));
+    vs_out.FragTangent = normalize(mNormal * normalize(vertexTangent));
 
 	vec3 N = vs_out.FragNormal;
 	vec3 T = vs_out.FragTangent;
@@ -217,4 +217,13 @@ float DistanceSquared(vec3 a, vec3 b)
 {
 	vec3 v = b - a;
 	return dot(v, v);
-}
\ No newline at end of file
+}
+
+vec3 OctahedralDecode(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-direction.z, 0.0);
+	direction.x += direction.x >= 0.0 ? -fold : fold;
+	direction.y += direction.y >= 0.0 ? -fold : fold;
+	return normalize(direction);
+}
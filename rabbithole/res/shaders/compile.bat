@@ -22,6 +22,9 @@ glslc.exe -g -fshader-stage=fragment FS_ApplyBloom.glsl -o FS_ApplyBloom.spv
 glslc.exe -g -fshader-stage=fragment FS_TextureDebug.glsl -o FS_TextureDebug.spv
 glslc.exe -g -fshader-stage=compute CS_Downsample.glsl -o CS_Downsample.spv
 glslc.exe -g -fshader-stage=compute CS_Upsample.glsl -o CS_Upsample.spv
+glslc.exe -g -fshader-stage=compute -I ../../src/vendor/fsr2.0/shaders CS_HiZ.glsl -o CS_HiZ.spv
+glslc.exe -g -fshader-stage=compute -I ../../src/vendor/fsr2.0/shaders CS_GenerateMips.glsl -o CS_GenerateMips.spv
+glslc.exe -g -fshader-stage=compute CS_OcclusionCulling.glsl -o CS_OcclusionCulling.spv
 dxc.exe -Zpc -Zi -Qembed_debug -enable-16bit-types -T cs_6_5 -E main -spirv -fspv-target-env=vulkan1.2 CS_PrepareShadowMask.hlsl -Fo CS_PrepareShadowMask.spv
 dxc.exe -Zpc -Zi -Qembed_debug -enable-16bit-types -T cs_6_5 -E main -spirv -fspv-target-env=vulkan1.2 CS_TileClassification.hlsl -Fo CS_TileClassification.spv
 dxc.exe -Zpc -Zi -Qembed_debug -enable-16bit-types -T cs_6_5  -E Pass0 -spirv -fspv-target-env=vulkan1.2 CS_FilterSoftShadows.hlsl -Fo CS_FilterSoftShadowsPass0.spv
@@ -1,4 +1,6 @@
 #include "Application.h"
+#include "Core/JobSystem.h"
+#include "Core/LoadProfiler.h"
 #include "ECS/EntityManager.h"
 #include "Input/InputManager.h"
 #include "Logger/Logger.h"
@@ -19,10 +21,32 @@ void ErrorCallback(int, const char* err_str)
     LOG_CRITICAL("GLFW error: {}", err_str);
 }
 
+void Application::ParseCommandLine(int argc, char** argv)
+{
+	const std::string loadProfileArgument = "--load-profile=";
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if (argument.starts_with(loadProfileArgument))
+		{
+			m_LoadProfilePath = argument.substr(loadProfileArgument.size());
+		}
+		else if (argument == "--exit-after-load")
+		{
+			m_ExitAfterLoad = true;
+		}
+	}
+}
+
 bool Application::Init()
 {
 	Logger::Init();
 	LOG_INFO("Logger succesfully created.");
+
+	LoadProfiler::instance().SetReportPath(m_LoadProfilePath);
+	LoadPhaseScope initPhase("Application init");
     
     glfwSetErrorCallback(ErrorCallback);
     const int ret = glfwInit();
@@ -65,6 +89,15 @@ bool Application::Init()
 		LOG_INFO("InputManager initialized.");
 	}
 
+	if (!JobSystem::instance().Init())
+	{
+		LOG_CRITICAL("JobSystem failed to initialize!");
+	}
+	else
+	{
+		LOG_INFO("JobSystem initialized with {} workers.", JobSystem::instance().GetWorkerCount());
+	}
+
 	if (!RenderSystem::instance().Init())
     { 
 		
@@ -92,6 +125,11 @@ void Application::Run()
 			m_IsRunning = false;
 		}
 
+		if (m_ExitAfterLoad && LoadProfiler::instance().IsReported())
+		{
+			m_IsRunning = false;
+		}
+
 		auto frameTime = glfwGetTimerValue();
 		float deltaTime = (frameTime - previousFrameTime)  / static_cast<float>(glfwGetTimerFrequency());
 		
@@ -132,6 +170,14 @@ void Application::Shutdown()
     {
         LOG_INFO("RenderSystem successfully shutdown!");
     }
+    if (!JobSystem::instance().Shutdown())
+    {
+        LOG_CRITICAL("JobSystem failed to shutdown!");
+    }
+    else
+    {
+        LOG_INFO("JobSystem successfully shutdown!");
+    }
     if (!Window      ::instance().Shutdown())
     {
         LOG_CRITICAL("Window failed to shutdown!");
@@ -1,14 +1,20 @@
 #pragma once
 #include <memory>
+#include <string>
 
 class Application
 {
 private:
 	bool m_IsRunning = false;
+	//for load benchmarks, app quits once load profile is reported
+	bool m_ExitAfterLoad = false;
+	std::string m_LoadProfilePath;
 	
 public:
 	Application() {}
 	~Application() {}
+	//--load-profile=<path> writes load phases as json, --exit-after-load quits once the scene is loaded
+	void ParseCommandLine(int argc, char** argv);
 	bool Init();
 	void Run();
 	void Shutdown();
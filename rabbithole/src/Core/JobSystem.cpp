@@ -0,0 +1,138 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+bool JobSystem::Init(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	m_ShuttingDown = false;
+	m_Workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+
+	return true;
+}
+
+bool JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_JobsMutex);
+		m_ShuttingDown = true;
+	}
+	m_JobsAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+	m_Workers.clear();
+
+	return true;
+}
+
+void JobSystem::Submit(Job job, JobCounter* counter, JobPriority priority)
+{
+	if (counter)
+	{
+		counter->pendingJobs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//without workers jobs run inline, so callers don't need to care whether the system is running
+	if (m_Workers.empty())
+	{
+		QueuedJob queuedJob{ std::move(job), counter };
+		Execute(queuedJob);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_JobsMutex);
+		m_Jobs[static_cast<size_t>(priority)].push_back({ std::move(job), counter });
+	}
+	m_JobsAvailable.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter, JobPriority priority)
+{
+	while (counter.pendingJobs.load(std::memory_order_acquire) > 0)
+	{
+		if (!TryExecuteJob(priority))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& job, JobPriority priority)
+{
+	JobCounter counter;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Submit([&job, i]() { job(i); }, &counter, priority);
+	}
+	Wait(counter, priority);
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		QueuedJob queuedJob;
+		{
+			std::unique_lock<std::mutex> lock(m_JobsMutex);
+			m_JobsAvailable.wait(lock, [this, &queuedJob]() { return TryPopJob(JobPriority::Normal, queuedJob) || m_ShuttingDown; });
+
+			if (!queuedJob.job)
+			{
+				return;
+			}
+		}
+
+		Execute(queuedJob);
+	}
+}
+
+bool JobSystem::TryExecuteJob(JobPriority minPriority)
+{
+	QueuedJob queuedJob;
+	{
+		std::lock_guard<std::mutex> lock(m_JobsMutex);
+		if (!TryPopJob(minPriority, queuedJob))
+		{
+			return false;
+		}
+	}
+
+	Execute(queuedJob);
+	return true;
+}
+
+bool JobSystem::TryPopJob(JobPriority minPriority, QueuedJob& queuedJob)
+{
+	for (size_t priority = static_cast<size_t>(JobPriority::Count); priority-- > static_cast<size_t>(minPriority);)
+	{
+		if (!m_Jobs[priority].empty())
+		{
+			queuedJob = std::move(m_Jobs[priority].front());
+			m_Jobs[priority].pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute(QueuedJob& queuedJob)
+{
+	queuedJob.job();
+
+	if (queuedJob.counter)
+	{
+		queuedJob.counter->pendingJobs.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "common.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//number of jobs that are submitted and not finished yet, Wait returns once it drops to zero
+struct JobCounter
+{
+	std::atomic<uint32_t> pendingJobs{ 0 };
+};
+
+//frame critical jobs are taken before anything else, waiting for them never runs long background jobs
+enum class JobPriority : uint8_t
+{
+	Normal,
+	High,
+	Count
+};
+
+//fixed pool of worker threads with a job queue per priority. thread that waits on a counter helps executing
+//jobs of the same or higher priority, so jobs can submit and wait on other jobs without blocking the pool
+class JobSystem
+{
+	SingletonClass(JobSystem);
+
+public:
+	using Job = std::function<void()>;
+
+	//zero worker count uses every core except the calling one
+	bool Init(uint32_t workerCount = 0);
+	bool Shutdown();
+
+	void Submit(Job job, JobCounter* counter = nullptr, JobPriority priority = JobPriority::Normal);
+	//jobs of lower priority than the given one are left to workers while waiting
+	void Wait(JobCounter& counter, JobPriority priority = JobPriority::Normal);
+
+	//runs job(i) for every i in [0, count) and waits for all of them
+	void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& job, JobPriority priority = JobPriority::Normal);
+
+	inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+private:
+	struct QueuedJob
+	{
+		Job			job;
+		JobCounter* counter = nullptr;
+	};
+
+	void WorkerLoop();
+	bool TryExecuteJob(JobPriority minPriority);
+	//queue lock has to be held
+	bool TryPopJob(JobPriority minPriority, QueuedJob& queuedJob);
+	void Execute(QueuedJob& queuedJob);
+
+	std::vector<std::thread>	m_Workers;
+	std::deque<QueuedJob>		m_Jobs[static_cast<size_t>(JobPriority::Count)];
+	std::mutex					m_JobsMutex;
+	std::condition_variable		m_JobsAvailable;
+	bool						m_ShuttingDown = false;
+};
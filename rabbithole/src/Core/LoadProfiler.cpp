@@ -0,0 +1,172 @@
+#include "LoadProfiler.h"
+
+#include "Logger/Logger.h"
+
+#include <format>
+#include <fstream>
+
+//innermost scoped phase of every thread, jobs start without one
+static thread_local uint32_t t_CurrentPhase = LOAD_PROFILER_NO_PHASE;
+
+static double GetPerSecond(double value, double durationMs)
+{
+	return durationMs > 0.0 ? value / (durationMs / 1000.0) : 0.0;
+}
+
+static double GetMegabytes(uint64_t bytes)
+{
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+static std::string EscapeJson(const std::string& text)
+{
+	std::string escaped;
+	for (char character : text)
+	{
+		if (character == '"' || character == '\\')
+		{
+			escaped += '\\';
+		}
+		escaped += character;
+	}
+	return escaped;
+}
+
+uint32_t LoadProfiler::BeginPhase(const std::string& name, uint32_t parent)
+{
+	const double startMs = GetElapsedMs();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Phases.push_back(Phase{ name, parent, startMs });
+	return static_cast<uint32_t>(m_Phases.size() - 1);
+}
+
+void LoadProfiler::EndPhase(uint32_t phase)
+{
+	const double endMs = GetElapsedMs();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Phases[phase].durationMs = endMs - m_Phases[phase].startMs;
+}
+
+void LoadProfiler::AddBytes(uint32_t phase, uint64_t bytes)
+{
+	AddCounts(phase, bytes, 0);
+}
+
+void LoadProfiler::AddItems(uint32_t phase, uint64_t items)
+{
+	AddCounts(phase, 0, items);
+}
+
+uint32_t LoadProfiler::GetCurrentPhase() const
+{
+	return t_CurrentPhase;
+}
+
+void LoadProfiler::AddCounts(uint32_t phase, uint64_t bytes, uint64_t items)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (; phase != LOAD_PROFILER_NO_PHASE; phase = m_Phases[phase].parent)
+	{
+		m_Phases[phase].bytes += bytes;
+		m_Phases[phase].items += items;
+	}
+}
+
+double LoadProfiler::GetElapsedMs() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_StartTime).count();
+}
+
+void LoadProfiler::Report()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		LOG_INFO(std::format("{:<48} {:>10} {:>10} {:>10} {:>10} {:>8} {:>12}", "Load phase", "start ms", "ms", "MB", "MB/s", "items", "items/s"));
+		for (uint32_t phase = 0; phase < m_Phases.size(); phase++)
+		{
+			if (m_Phases[phase].parent == LOAD_PROFILER_NO_PHASE)
+			{
+				PrintPhase(phase, 0);
+			}
+		}
+	}
+
+	if (!m_ReportPath.empty() && !WriteJson(m_ReportPath))
+	{
+		LOG_WARNING("Could not write load profile to " + m_ReportPath);
+	}
+
+	m_Reported = true;
+}
+
+void LoadProfiler::PrintPhase(uint32_t phase, uint32_t depth) const
+{
+	const Phase& data = m_Phases[phase];
+
+	//phases that are still running are reported up to now
+	const bool finished = data.durationMs >= 0.0;
+	const double durationMs = finished ? data.durationMs : GetElapsedMs() - data.startMs;
+	const std::string name = std::string(depth * 2, ' ') + data.name + (finished ? "" : " (running)");
+
+	LOG_INFO(std::format("{:<48} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} {:>8} {:>12.1f}",
+		name, data.startMs, durationMs, GetMegabytes(data.bytes), GetPerSecond(GetMegabytes(data.bytes), durationMs),
+		data.items, GetPerSecond(static_cast<double>(data.items), durationMs)));
+
+	for (uint32_t child = phase + 1; child < m_Phases.size(); child++)
+	{
+		if (m_Phases[child].parent == phase)
+		{
+			PrintPhase(child, depth + 1);
+		}
+	}
+}
+
+bool LoadProfiler::WriteJson(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	file << "{\n\t\"phases\": [\n";
+	for (uint32_t phase = 0; phase < m_Phases.size(); phase++)
+	{
+		const Phase& data = m_Phases[phase];
+		const bool finished = data.durationMs >= 0.0;
+		const double durationMs = finished ? data.durationMs : GetElapsedMs() - data.startMs;
+
+		file << std::format("\t\t{{ \"name\": \"{}\", \"parent\": {}, \"finished\": {}, \"startMs\": {:.3f}, \"durationMs\": {:.3f}, "
+			"\"bytes\": {}, \"items\": {}, \"mbPerSecond\": {:.3f}, \"itemsPerSecond\": {:.3f} }}{}\n",
+			EscapeJson(data.name), data.parent == LOAD_PROFILER_NO_PHASE ? -1 : static_cast<int64_t>(data.parent), finished ? "true" : "false",
+			data.startMs, durationMs, data.bytes, data.items, GetPerSecond(GetMegabytes(data.bytes), durationMs),
+			GetPerSecond(static_cast<double>(data.items), durationMs), phase + 1 < m_Phases.size() ? "," : "");
+	}
+	file << "\t]\n}\n";
+
+	return true;
+}
+
+LoadPhaseScope::LoadPhaseScope(const std::string& name)
+	: LoadPhaseScope(name, t_CurrentPhase)
+{
+}
+
+LoadPhaseScope::LoadPhaseScope(const std::string& name, uint32_t parent)
+	: m_Phase(LoadProfiler::instance().BeginPhase(name, parent))
+	, m_PreviousPhase(t_CurrentPhase)
+{
+	t_CurrentPhase = m_Phase;
+}
+
+LoadPhaseScope::~LoadPhaseScope()
+{
+	t_CurrentPhase = m_PreviousPhase;
+	LoadProfiler::instance().EndPhase(m_Phase);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "common.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define LOAD_PROFILER_NO_PHASE UINT32_MAX
+
+//cpu timings of startup and load phases. scoped phases nest into the innermost scoped phase of the same thread,
+//phases that span frames or jobs are begun and ended explicitly with a given parent. bytes and items of a phase
+//include the ones of its children. report prints the tree with throughput and writes it as json when path is set
+class LoadProfiler
+{
+	SingletonClass(LoadProfiler);
+
+public:
+	uint32_t	BeginPhase(const std::string& name, uint32_t parent);
+	void		EndPhase(uint32_t phase);
+	//can be called from any thread
+	void		AddBytes(uint32_t phase, uint64_t bytes);
+	void		AddItems(uint32_t phase, uint64_t items);
+
+	//innermost scoped phase of the calling thread
+	uint32_t	GetCurrentPhase() const;
+
+	inline void	SetReportPath(const std::string& path) { m_ReportPath = path; }
+	void		Report();
+	inline bool	IsReported() const { return m_Reported; }
+
+private:
+	friend class LoadPhaseScope;
+
+	struct Phase
+	{
+		std::string	name;
+		uint32_t	parent;
+		double		startMs;
+		double		durationMs = -1.0; //negative while phase is running
+		uint64_t	bytes = 0;
+		uint64_t	items = 0;
+	};
+
+	double	GetElapsedMs() const;
+	void	AddCounts(uint32_t phase, uint64_t bytes, uint64_t items);
+	void	PrintPhase(uint32_t phase, uint32_t depth) const;
+	bool	WriteJson(const std::string& path) const;
+
+	mutable std::mutex						m_Mutex;
+	std::vector<Phase>						m_Phases;
+	std::chrono::steady_clock::time_point	m_StartTime = std::chrono::steady_clock::now();
+	std::string								m_ReportPath;
+	bool									m_Reported = false;
+};
+
+//phase that lasts until the end of the scope, without a parent it nests into the current phase of the thread
+class LoadPhaseScope
+{
+public:
+	LoadPhaseScope(const std::string& name);
+	LoadPhaseScope(const std::string& name, uint32_t parent);
+	~LoadPhaseScope();
+
+	NonCopyableAndMovable(LoadPhaseScope);
+
+	inline void		AddBytes(uint64_t bytes) { LoadProfiler::instance().AddBytes(m_Phase, bytes); }
+	inline void		AddItems(uint64_t items) { LoadProfiler::instance().AddItems(m_Phase, items); }
+	inline uint32_t	GetPhase() const { return m_Phase; }
+
+private:
+	uint32_t m_Phase;
+	uint32_t m_PreviousPhase;
+};
@@ -5,9 +5,10 @@
 #include "Core/Application.h"
 #include "Render/Renderer.h"
 
-int main() 
+int main(int argc, char** argv) 
 {
 	auto app = std::make_unique<Application>();
+	app->ParseCommandLine(argc, argv);
 	app->Init();
 	app->Run();
 	app->Shutdown();
@@ -3,8 +3,9 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/dist_sink.h>
 
-using consoleSink_t = spdlog::sinks::windebug_sink_st;
-using fileSink_t = spdlog::sinks::basic_file_sink_st;
+//workers log while loading models and compiling pipelines, so sinks have to be thread safe
+using consoleSink_t = spdlog::sinks::windebug_sink_mt;
+using fileSink_t = spdlog::sinks::basic_file_sink_mt;
 
 void Logger::Init()
 {
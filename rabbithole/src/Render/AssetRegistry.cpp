@@ -0,0 +1,73 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "AssetRegistry.h"
+
+#include <filesystem>
+#include <format>
+
+#include "Render/Model/Model.h"
+#include "Render/Renderer.h"
+#include "Render/TextureStreamer.h"
+
+bool AssetRegistry::Init(Renderer* renderer)
+{
+	m_Renderer = renderer;
+	return true;
+}
+
+bool AssetRegistry::Shutdown()
+{
+	//instances own models, registry only forgets them
+	m_Models.clear();
+	m_Textures.clear();
+	m_SharedTextures.clear();
+	return true;
+}
+
+std::shared_ptr<VulkanglTFModel> AssetRegistry::AcquireModel(const std::string& path, VertexLayout vertexLayout)
+{
+	//the same file is loaded separately for every layout, gpu data differs between them
+	const std::string key = std::format("{}:{}", std::filesystem::path(path).lexically_normal().generic_string(), static_cast<uint32_t>(vertexLayout));
+
+	if (std::shared_ptr<VulkanglTFModel> model = m_Models[key].lock())
+	{
+		return model;
+	}
+
+	auto model = std::make_shared<VulkanglTFModel>(m_Renderer, path, vertexLayout);
+	m_Models[key] = model;
+	return model;
+}
+
+uint32_t AssetRegistry::AcquireTexture(const Utils::Hash128& contentHash)
+{
+	auto texture = m_Textures.find(contentHash);
+	if (texture == m_Textures.end())
+	{
+		return TEXTURE_STREAMING_INVALID_HANDLE;
+	}
+
+	m_SharedTextures[texture->second].refCount++;
+	return texture->second;
+}
+
+void AssetRegistry::RegisterTexture(const Utils::Hash128& contentHash, uint32_t textureHandle)
+{
+	m_Textures[contentHash] = textureHandle;
+	m_SharedTextures[textureHandle] = SharedTexture{ contentHash, 1 };
+}
+
+void AssetRegistry::ReleaseTexture(uint32_t textureHandle)
+{
+	auto sharedTexture = m_SharedTextures.find(textureHandle);
+	ASSERT(sharedTexture != m_SharedTextures.end(), "Released texture is not registered!");
+
+	if (--sharedTexture->second.refCount > 0)
+	{
+		return;
+	}
+
+	m_Textures.erase(sharedTexture->second.contentHash);
+	m_SharedTextures.erase(sharedTexture);
+	m_Renderer->GetTextureStreamer().UnregisterTexture(textureHandle);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common.h"
+#include "Render/Vulkan/VulkanTypes.h"
+#include "Utils/utils.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class Renderer;
+class VulkanglTFModel;
+
+//shared assets of the scene. models are keyed by their path and layout, every instance of the same file references
+//one model, so its buffers, materials and textures are paid once. model lives while any instance holds it.
+//model textures are keyed by hash of their contents, images repeated across models are created only once and live
+//while any model references them
+class AssetRegistry
+{
+public:
+	bool Init(Renderer* renderer);
+	bool Shutdown();
+
+	//starts loading the model on the first acquire, later ones return the same model
+	std::shared_ptr<VulkanglTFModel>	AcquireModel(const std::string& path, VertexLayout vertexLayout);
+	//streamer handle of texture with the same contents and a new reference to it, invalid if there is none yet
+	uint32_t							AcquireTexture(const Utils::Hash128& contentHash);
+	//texture is referenced once by the model that created it
+	void								RegisterTexture(const Utils::Hash128& contentHash, uint32_t textureHandle);
+	//texture is removed from streamer together with its last reference, gpu must not use it anymore
+	void								ReleaseTexture(uint32_t textureHandle);
+
+	//calls func for every model some instance still holds
+	template<typename Func>
+	void ForEachModel(Func&& func)
+	{
+		std::erase_if(m_Models, [](const auto& model) { return model.second.expired(); });
+		for (auto& model : m_Models)
+		{
+			func(*model.second.lock());
+		}
+	}
+
+private:
+	struct SharedTexture
+	{
+		Utils::Hash128	contentHash;
+		uint32_t		refCount;
+	};
+
+	Renderer*															m_Renderer = nullptr;
+
+	std::unordered_map<std::string, std::weak_ptr<VulkanglTFModel>>	m_Models;
+	std::unordered_map<Utils::Hash128, uint32_t, Utils::Hash128Hasher>	m_Textures;	//content hash to streamer handle
+	std::unordered_map<uint32_t, SharedTexture>							m_SharedTextures;	//by streamer handle
+};
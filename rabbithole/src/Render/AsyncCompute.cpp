@@ -0,0 +1,259 @@
+#include "common.h"
+
+#include "AsyncCompute.h"
+#include "Logger/Logger.h"
+#include "Render/Vulkan/VulkanCommandBuffer.h"
+#include "Render/Vulkan/VulkanDevice.h"
+
+#include <algorithm>
+
+void AsyncComputeScheduler::Init(VulkanDevice& device, uint32_t imageCount)
+{
+	m_Device = &device;
+	m_Enabled = device.HasDedicatedComputeQueue();
+
+	if (!m_Enabled)
+	{
+		return;
+	}
+
+	VkSemaphoreTypeCreateInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &timelineInfo;
+
+	const char* semaphoreNames[] = { "GraphicsTimeline", "AsyncComputeTimeline" };
+	for (uint32_t queue = 0; queue < static_cast<uint32_t>(QueueType::Count); queue++)
+	{
+		VULKAN_API_CALL(vkCreateSemaphore(device.GetGraphicDevice(), &semaphoreInfo, nullptr, &m_Batches[queue].semaphore));
+		device.SetObjectName((uint64_t)m_Batches[queue].semaphore, VK_OBJECT_TYPE_SEMAPHORE, semaphoreNames[queue]);
+
+		m_Batches[queue].commandBuffers.resize(imageCount);
+	}
+}
+
+void AsyncComputeScheduler::Destroy()
+{
+	for (Batch& batch : m_Batches)
+	{
+		batch.commandBuffers.clear();
+		if (batch.semaphore != VK_NULL_HANDLE)
+		{
+			vkDestroySemaphore(m_Device->GetGraphicDevice(), batch.semaphore, nullptr);
+			batch.semaphore = VK_NULL_HANDLE;
+		}
+	}
+
+	m_Enabled = false;
+}
+
+void AsyncComputeScheduler::BeginFrame(VulkanCommandBuffer& mainCommandBuffer, uint32_t imageIndex)
+{
+	if (!m_Enabled)
+	{
+		return;
+	}
+
+	m_ImageIndex = imageIndex;
+	m_CurrentQueue = QueueType::Graphics;
+	m_Accesses.clear();
+	m_PendingAccesses.clear();
+	m_RequiredWait = 0;
+
+	//every resource starts the frame as written by the last graphics batch of the previous one
+	m_FrameStartValue = GetBatch(QueueType::Graphics).submittedValue;
+
+	for (Batch& batch : m_Batches)
+	{
+		batch.usedCommandBuffers = 0;
+		batch.commandBuffer = nullptr;
+	}
+	GetBatch(QueueType::Graphics).commandBuffer = &mainCommandBuffer;
+}
+
+void AsyncComputeScheduler::EndFrame()
+{
+	if (!m_Enabled)
+	{
+		return;
+	}
+
+	SetQueue(QueueType::Graphics);
+
+	Batch& compute = GetBatch(QueueType::Compute);
+	if (compute.commandBuffer)
+	{
+		Submit(QueueType::Compute);
+	}
+
+	//frame fence has to cover compute work as well, so frame end waits for everything compute submitted
+	Batch& graphics = GetBatch(QueueType::Graphics);
+	graphics.waitedValue = std::max(graphics.waitedValue, compute.submittedValue);
+
+	m_FrameSync.waitSemaphore = graphics.waitedValue > 0 ? compute.semaphore : VK_NULL_HANDLE;
+	m_FrameSync.waitValue = graphics.waitedValue;
+	m_FrameSync.signalSemaphore = graphics.semaphore;
+	m_FrameSync.signalValue = ++graphics.submittedValue;
+}
+
+void AsyncComputeScheduler::SetQueue(QueueType queue)
+{
+	if (!m_Enabled)
+	{
+		return;
+	}
+
+	m_CurrentQueue = queue;
+}
+
+bool AsyncComputeScheduler::AddAccess(ManagableResource* resource, bool isWrite)
+{
+	if (!m_Enabled)
+	{
+		return false;
+	}
+
+	const size_t other = static_cast<size_t>(GetOtherQueue(m_CurrentQueue));
+
+	auto [access, inserted] = m_Accesses.try_emplace(resource);
+	if (inserted)
+	{
+		access->second.lastAccess[static_cast<size_t>(QueueType::Graphics)] = m_FrameStartValue;
+		access->second.lastWrite[static_cast<size_t>(QueueType::Graphics)] = m_FrameStartValue;
+		access->second.lastAccess[static_cast<size_t>(QueueType::Compute)] = 0;
+		access->second.lastWrite[static_cast<size_t>(QueueType::Compute)] = 0;
+		access->second.lastQueue = QueueType::Graphics;
+	}
+	ResourceAccess& resourceAccess = access->second;
+
+	//reads wait for writes of the other queue, writes also for its reads
+	m_RequiredWait = std::max(m_RequiredWait, resourceAccess.lastWrite[other]);
+	if (isWrite)
+	{
+		m_RequiredWait = std::max(m_RequiredWait, resourceAccess.lastAccess[other]);
+	}
+
+	//batch value is known only after sync decides whether to cut
+	m_PendingAccesses.push_back(PendingAccess{ &resourceAccess, isWrite });
+
+	const bool isCrossQueue = resourceAccess.lastQueue != m_CurrentQueue;
+	resourceAccess.lastQueue = m_CurrentQueue;
+	return isCrossQueue;
+}
+
+void AsyncComputeScheduler::SyncAccesses()
+{
+	if (!m_Enabled)
+	{
+		return;
+	}
+
+	const QueueType otherQueue = GetOtherQueue(m_CurrentQueue);
+	Batch& current = GetBatch(m_CurrentQueue);
+	Batch& other = GetBatch(otherQueue);
+
+	if (m_RequiredWait > current.waitedValue)
+	{
+		//batch that is still being recorded on the other queue is the one we wait for
+		if (m_RequiredWait > other.submittedValue)
+		{
+			Submit(otherQueue);
+		}
+
+		//wait applies to a whole submission, so commands recorded so far go without it
+		if (current.commandBuffer)
+		{
+			Submit(m_CurrentQueue);
+		}
+		current.waitedValue = m_RequiredWait;
+	}
+
+	const size_t queue = static_cast<size_t>(m_CurrentQueue);
+	const uint64_t batchValue = current.submittedValue + 1;
+	for (const PendingAccess& pendingAccess : m_PendingAccesses)
+	{
+		pendingAccess.access->lastAccess[queue] = batchValue;
+		if (pendingAccess.isWrite)
+		{
+			pendingAccess.access->lastWrite[queue] = batchValue;
+		}
+	}
+
+	m_PendingAccesses.clear();
+	m_RequiredWait = 0;
+}
+
+VulkanCommandBuffer* AsyncComputeScheduler::GetCommandBuffer()
+{
+	if (!m_Enabled)
+	{
+		return nullptr;
+	}
+
+	//batch is opened by the first command recorded into it, so a cut before any command doesn't submit an empty one
+	if (!GetBatch(m_CurrentQueue).commandBuffer)
+	{
+		OpenBatch(m_CurrentQueue);
+	}
+	return GetBatch(m_CurrentQueue).commandBuffer;
+}
+
+void AsyncComputeScheduler::OpenBatch(QueueType queue)
+{
+	Batch& batch = GetBatch(queue);
+	auto& commandBuffers = batch.commandBuffers[m_ImageIndex];
+
+	if (batch.usedCommandBuffers == commandBuffers.size())
+	{
+		const bool isCompute = queue == QueueType::Compute;
+		commandBuffers.push_back(std::make_unique<VulkanCommandBuffer>(*m_Device,
+			isCompute ? m_Device->GetComputeCommandPool() : m_Device->GetCommandPool(),
+			isCompute ? "Async Compute Command Buffer" : "Graphics Batch Command Buffer"));
+	}
+
+	batch.commandBuffer = commandBuffers[batch.usedCommandBuffers++].get();
+	batch.commandBuffer->BeginCommandBuffer();
+}
+
+void AsyncComputeScheduler::Submit(QueueType queue)
+{
+	Batch& batch = GetBatch(queue);
+	const Batch& other = GetBatch(GetOtherQueue(queue));
+
+	//value the other queue waits for is signaled even when nothing was recorded into the batch
+	if (!batch.commandBuffer)
+	{
+		OpenBatch(queue);
+	}
+	batch.commandBuffer->EndCommandBuffer();
+
+	VkCommandBuffer commandBuffer = GET_VK_HANDLE_PTR(batch.commandBuffer);
+	const uint64_t signalValue = ++batch.submittedValue;
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = batch.waitedValue > 0 ? 1 : 0;
+	timelineSubmitInfo.pWaitSemaphoreValues = &batch.waitedValue;
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.waitSemaphoreCount = timelineSubmitInfo.waitSemaphoreValueCount;
+	submitInfo.pWaitSemaphores = &other.semaphore;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &batch.semaphore;
+
+	VULKAN_API_CALL(vkQueueSubmit(queue == QueueType::Compute ? m_Device->GetComputeQueue() : m_Device->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+
+	batch.commandBuffer = nullptr;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "common.h"
+#include "Render/Vulkan/VulkanSwapchain.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class ManagableResource;
+class VulkanCommandBuffer;
+class VulkanDevice;
+
+enum class QueueType : uint8_t
+{
+	Graphics,
+	Compute,
+	Count
+};
+
+//splits the frame into batches on graphics and dedicated compute queue. every queue signals its own timeline
+//semaphore, value of a batch is known before it is submitted, so an access only has to wait for the last batch
+//of the other queue that touched the resource. batch is cut only when a wait is needed, without a dedicated
+//compute queue every pass is recorded to the main command buffer as before
+class AsyncComputeScheduler
+{
+public:
+	void Init(VulkanDevice& device, uint32_t imageCount);
+	void Destroy();
+
+	//main command buffer is the first graphics batch, it is begun and ended by renderer
+	void BeginFrame(VulkanCommandBuffer& mainCommandBuffer, uint32_t imageIndex);
+	//submits the remaining compute batch, last graphics batch is submitted by the swapchain with frame sync
+	void EndFrame();
+
+	void SetQueue(QueueType queue);
+	inline bool		IsEnabled() const { return m_Enabled; }
+	inline bool		IsOnComputeQueue() const { return m_Enabled && m_CurrentQueue == QueueType::Compute; }
+
+	//returns true when the resource was last used on the other queue, its barrier can't rely on stages recorded there
+	bool AddAccess(ManagableResource* resource, bool isWrite);
+	//cuts batches so accesses added since last sync wait for the other queue
+	void SyncAccesses();
+
+	//command buffer of the current batch, null when everything goes to the main command buffer
+	VulkanCommandBuffer*			GetCommandBuffer();
+	const TimelineSemaphoreSync&	GetFrameSync() const { return m_FrameSync; }
+
+private:
+	struct Batch
+	{
+		VkSemaphore				semaphore = VK_NULL_HANDLE;
+		uint64_t				submittedValue = 0;
+		uint64_t				waitedValue = 0;	//value of the other queue every submission waits for
+		VulkanCommandBuffer*	commandBuffer = nullptr;
+
+		//pooled per swapchain image, reused once the frame that used them is finished
+		std::vector<std::vector<std::unique_ptr<VulkanCommandBuffer>>>	commandBuffers;
+		uint32_t														usedCommandBuffers = 0;
+	};
+
+	//values of the batches that last accessed and wrote the resource this frame, per queue
+	struct ResourceAccess
+	{
+		uint64_t	lastAccess[static_cast<size_t>(QueueType::Count)];
+		uint64_t	lastWrite[static_cast<size_t>(QueueType::Count)];
+		QueueType	lastQueue;
+	};
+
+	struct PendingAccess
+	{
+		ResourceAccess*	access;
+		bool			isWrite;
+	};
+
+	inline Batch&		GetBatch(QueueType queue) { return m_Batches[static_cast<size_t>(queue)]; }
+	static QueueType	GetOtherQueue(QueueType queue) { return queue == QueueType::Graphics ? QueueType::Compute : QueueType::Graphics; }
+
+	void OpenBatch(QueueType queue);
+	void Submit(QueueType queue);
+
+	VulkanDevice*	m_Device = nullptr;
+	bool			m_Enabled = false;
+	QueueType		m_CurrentQueue = QueueType::Graphics;
+	uint32_t		m_ImageIndex = 0;
+	Batch			m_Batches[static_cast<size_t>(QueueType::Count)];
+
+	std::unordered_map<ManagableResource*, ResourceAccess>	m_Accesses;
+	std::vector<PendingAccess>								m_PendingAccesses;
+	uint64_t												m_FrameStartValue = 0;
+	uint64_t												m_RequiredWait = 0;
+
+	TimelineSemaphoreSync	m_FrameSync;
+};
@@ -180,6 +180,10 @@ VkFormat GetVkFormatFrom(const Format format)
 		return VK_FORMAT_BC3_UNORM_BLOCK;
 	case Format::BC3_UNORM_SRGB:
 		return VK_FORMAT_BC3_SRGB_BLOCK;
+	case Format::BC4_UNORM:
+		return VK_FORMAT_BC4_UNORM_BLOCK;
+	case Format::BC5_UNORM:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
 	case Format::BC7_UNORM:
 		return VK_FORMAT_BC7_UNORM_BLOCK;
 	case Format::BC7_UNORM_SRGB:
@@ -510,6 +514,51 @@ VkBorderColor GetVkBorderColorFrom(const Color color)
 	}
 }
 
+bool IsBlockCompressedFormat(const Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_UNORM:
+	case Format::BC1_UNORM_SRGB:
+	case Format::BC2_UNORM:
+	case Format::BC2_UNORM_SRGB:
+	case Format::BC3_UNORM:
+	case Format::BC3_UNORM_SRGB:
+	case Format::BC4_UNORM:
+	case Format::BC5_UNORM:
+	case Format::BC7_UNORM:
+	case Format::BC7_UNORM_SRGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint64_t GetImageSizeFrom(const Format format, const uint32_t width, const uint32_t height)
+{
+	//block compressed formats store 4x4 texel blocks, partial blocks on the edges are stored whole
+	const uint64_t blockCountX = (static_cast<uint64_t>(width) + 3) / 4;
+	const uint64_t blockCountY = (static_cast<uint64_t>(height) + 3) / 4;
+
+	switch (format)
+	{
+	case Format::BC1_UNORM:
+	case Format::BC1_UNORM_SRGB:
+	case Format::BC4_UNORM:
+		return blockCountX * blockCountY * 8;
+	case Format::BC2_UNORM:
+	case Format::BC2_UNORM_SRGB:
+	case Format::BC3_UNORM:
+	case Format::BC3_UNORM_SRGB:
+	case Format::BC5_UNORM:
+	case Format::BC7_UNORM:
+	case Format::BC7_UNORM_SRGB:
+		return blockCountX * blockCountY * 16;
+	default:
+		return static_cast<uint64_t>(width) * height * GetBPPFrom(format);
+	}
+}
+
 bool IsDepthFormat(const Format format)
 {
 	return (format == Format::D32_SFLOAT || format == Format::D32_SFLOAT);
@@ -520,6 +569,9 @@ VkPipelineStageFlags GetVkPipelineStageFromResourceStageAndState(const ResourceS
 	if (state == ResourceState::DepthStencilWrite || state == ResourceState::DepthStencilRead)
 		return isSrcStage ? VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT : VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 
+	if (state == ResourceState::IndirectArgument)
+		return VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+
 	switch (stage)
 	{
 	case ResourceStage::None:
@@ -568,6 +620,8 @@ VkAccessFlags GetVkAccessFlagsFromResourceState(const ResourceState state)
 		return VK_ACCESS_SHADER_WRITE_BIT;
 	case ResourceState::BufferReadWrite:
 		return VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	case ResourceState::IndirectArgument:
+		return VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 
 	default:
 		ASSERT(false, "Not supported access state.");
@@ -575,6 +629,81 @@ VkAccessFlags GetVkAccessFlagsFromResourceState(const ResourceState state)
 	}
 }
 
+//synchronization2 masks, shader accesses are split into sampled and storage ones and attachments get their own stages
+VkPipelineStageFlags2 GetVkPipelineStage2FromResourceStageAndState(const ResourceStage stage, const ResourceState state)
+{
+	switch (state)
+	{
+	case ResourceState::None:
+		return VK_PIPELINE_STAGE_2_NONE;
+	case ResourceState::Present:
+		return VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	case ResourceState::RenderTarget:
+		return VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+	case ResourceState::DepthStencilRead:
+	case ResourceState::DepthStencilWrite:
+		return VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+	case ResourceState::IndirectArgument:
+		return VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+	case ResourceState::TransferSrc:
+	case ResourceState::TransferDst:
+		return VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+	default:
+		break;
+	}
+
+	switch (stage)
+	{
+	case ResourceStage::None:
+		return VK_PIPELINE_STAGE_2_NONE;
+	case ResourceStage::Compute:
+		return VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+	case ResourceStage::Graphics:
+		return VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+	case ResourceStage::Transfer:
+		return VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+	default:
+		return VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	}
+}
+
+VkAccessFlags2 GetVkAccess2FlagsFromResourceState(const ResourceState state)
+{
+	switch (state)
+	{
+	case ResourceState::None:
+	case ResourceState::Present:
+		return VK_ACCESS_2_NONE;
+	case ResourceState::GenericRead:
+		return VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+	case ResourceState::RenderTarget:
+		return VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+	case ResourceState::GeneralComputeRead:
+	case ResourceState::BufferRead:
+		return VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+	case ResourceState::GeneralComputeWrite:
+	case ResourceState::BufferWrite:
+		return VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+	case ResourceState::GeneralComputeReadWrite:
+	case ResourceState::BufferReadWrite:
+		return VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+	case ResourceState::TransferDst:
+		return VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	case ResourceState::TransferSrc:
+		return VK_ACCESS_2_TRANSFER_READ_BIT;
+	case ResourceState::DepthStencilRead:
+		return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+	case ResourceState::DepthStencilWrite:
+		return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	case ResourceState::IndirectArgument:
+		return VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+
+	default:
+		ASSERT(false, "Not supported access state.");
+		return VK_ACCESS_2_NONE;
+	}
+}
+
 enum VkPipelineBindPoint GetVkBindPointFrom(const PipelineType pipelineType)
 {
 	switch (pipelineType)
@@ -691,6 +820,10 @@ ClearValue GetClearColorValueFor(const Format format)
 	case Format::R16G16B16A16_FLOAT:
 	case Format::R16G16B16A16_UNORM:
 	case Format::R32G32B32A32_FLOAT:
+	case Format::BC1_UNORM:
+	case Format::BC4_UNORM:
+	case Format::BC5_UNORM:
+	case Format::BC7_UNORM:
 		return ClearValue{ rabbitVec4f(0.5f, 0.5f, 0.5f, 1.0f) };
 	case Format::R8_UNORM:
 	case Format::R32_SFLOAT:
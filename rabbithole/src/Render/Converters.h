@@ -28,10 +28,14 @@ VkBlendOp					GetVkBlendOpFrom(const BlendOperation blendOperation);
 VkVertexInputRate			GetVkVertexInputRateFrom(const VertexInputRate inputRate);
 ClearValue					GetClearColorValueFor(const Format format);
 uint32_t					GetBPPFrom(const Format format);
+bool						IsBlockCompressedFormat(const Format format);
+uint64_t					GetImageSizeFrom(const Format format, const uint32_t width, const uint32_t height);
 VkImageUsageFlags			GetVkImageUsageFlagsFrom(const ImageUsageFlags usageFlags);
 VkBorderColor				GetVkBorderColorFrom(const Color color);
 bool						IsDepthFormat(const Format format);
 VkPipelineStageFlags		GetVkPipelineStageFromResourceStageAndState(const ResourceStage stage, const ResourceState state, bool isSrcStage);
 VkAccessFlags				GetVkAccessFlagsFromResourceState(const ResourceState state);
+VkPipelineStageFlags2		GetVkPipelineStage2FromResourceStageAndState(const ResourceStage stage, const ResourceState state);
+VkAccessFlags2				GetVkAccess2FlagsFromResourceState(const ResourceState state);
 enum VkPipelineBindPoint	GetVkBindPointFrom(const PipelineType pipelineType);
 VkAttachmentLoadOp			GetVkLoadOpFrom(LoadOp op);
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "DescriptorAllocator.h"
+
+DescriptorAllocator::DescriptorAllocator(VulkanDevice& device)
+	: m_Device(device)
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	//sets are released with their pools
+	m_Sets.clear();
+	m_Pools.clear();
+}
+
+void DescriptorAllocator::Reset()
+{
+	for (uint32_t i = 0; i < m_Pools.size() && i <= m_CurrentPool; i++)
+	{
+		VULKAN_API_CALL(vkResetDescriptorPool(m_Device.GetGraphicDevice(), GET_VK_HANDLE_PTR(m_Pools[i]), 0));
+	}
+
+	m_CurrentPool = 0;
+	m_UsedSets = 0;
+	m_SetsByKey.clear();
+}
+
+VulkanDescriptorSet* DescriptorAllocator::Allocate(const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors)
+{
+	if (m_Pools.empty())
+	{
+		m_Pools.emplace_back(CreatePool());
+	}
+
+	if (m_UsedSets == m_Sets.size())
+	{
+		m_Sets.push_back(std::make_unique<VulkanDescriptorSet>());
+	}
+	VulkanDescriptorSet* descriptorSet = m_Sets[m_UsedSets++].get();
+
+	if (!descriptorSet->TryAllocate(&m_Device, m_Pools[m_CurrentPool].get(), descriptorSetLayout))
+	{
+		//pools after the current one are empty since the last reset, they are reused before a new one is created
+		if (++m_CurrentPool == m_Pools.size())
+		{
+			m_Pools.emplace_back(CreatePool());
+		}
+
+		const bool allocated = descriptorSet->TryAllocate(&m_Device, m_Pools[m_CurrentPool].get(), descriptorSetLayout);
+		ASSERT(allocated, "Descriptor set doesn't fit into an empty pool, increase DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL!");
+	}
+
+	descriptorSet->Update(&m_Device, descriptors);
+	return descriptorSet;
+}
+
+VulkanDescriptorSet* DescriptorAllocator::FindOrAllocate(const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors)
+{
+	VulkanDescriptorSet*& descriptorSet = m_SetsByKey[PipelineManager::GetDescriptorSetKey(descriptors)];
+	if (!descriptorSet)
+	{
+		descriptorSet = Allocate(descriptorSetLayout, descriptors);
+	}
+	return descriptorSet;
+}
+
+VulkanDescriptorPool* DescriptorAllocator::CreatePool()
+{
+	VulkanDescriptorPoolInfo poolInfo{};
+	poolInfo.DescriptorSizes = {
+		{ DescriptorType::UniformBuffer, DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL },
+		{ DescriptorType::CombinedSampler, DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL },
+		{ DescriptorType::SampledImage, DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL },
+		{ DescriptorType::Sampler, DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL },
+		{ DescriptorType::StorageImage, DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL },
+		{ DescriptorType::StorageBuffer, DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL } };
+	poolInfo.MaxSets = DESCRIPTOR_ALLOCATOR_SETS_PER_POOL;
+
+	return new VulkanDescriptorPool(&m_Device, poolInfo);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common.h"
+#include "Render/PipelineManager.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class VulkanDescriptor;
+class VulkanDescriptorPool;
+class VulkanDescriptorSet;
+class VulkanDescriptorSetLayout;
+class VulkanDevice;
+
+//every chained pool holds this many sets and this many descriptors of every type
+#define DESCRIPTOR_ALLOCATOR_SETS_PER_POOL			256
+#define DESCRIPTOR_ALLOCATOR_DESCRIPTORS_PER_POOL	1024
+
+//allocates descriptor sets from a chain of pools, a new pool is added when the current one runs out instead of
+//sizing a single pool for the worst case. sets are never freed one by one, reset returns all of them at once and
+//keeps the pools, so memory is bounded by the most sets used between two resets
+class DescriptorAllocator
+{
+public:
+	DescriptorAllocator(VulkanDevice& device);
+	~DescriptorAllocator();
+
+	NonCopyableAndMovable(DescriptorAllocator);
+
+	//sets allocated so far must not be in use by the gpu anymore
+	void Reset();
+
+	VulkanDescriptorSet* Allocate(const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors);
+	//binds with the same descriptors since last reset share a set
+	VulkanDescriptorSet* FindOrAllocate(const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors);
+
+private:
+	VulkanDescriptorPool* CreatePool();
+
+	VulkanDevice&										m_Device;
+
+	std::vector<std::unique_ptr<VulkanDescriptorPool>>	m_Pools;
+	uint32_t											m_CurrentPool = 0;
+
+	//set objects are reused after reset, only their handles are allocated again
+	std::vector<std::unique_ptr<VulkanDescriptorSet>>	m_Sets;
+	uint32_t											m_UsedSets = 0;
+
+	std::unordered_map<DescriptorSetKey, VulkanDescriptorSet*, VectorHasher>	m_SetsByKey;
+};
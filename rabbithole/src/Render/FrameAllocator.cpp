@@ -0,0 +1,52 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "FrameAllocator.h"
+
+#include <algorithm>
+
+#include "Render/ResourceManager.h"
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+void FrameAllocator::Init(VulkanDevice& device, ResourceManager& resourceManager, uint32_t imageCount)
+{
+	//every allocation can be bound as uniform or storage buffer offset
+	const VkPhysicalDeviceLimits& limits = device.GetPhysicalDeviceProperties().limits;
+	m_Alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+	m_ImageCount = imageCount;
+
+	m_Buffer = resourceManager.CreateBuffer(device, BufferCreateInfo{
+			.flags = {BufferUsageFlags::UniformBuffer | BufferUsageFlags::StorageBuffer},
+			.memoryAccess = {MemoryAccess::CPU2GPU},
+			.size = {FRAME_ALLOCATOR_REGION_SIZE * imageCount},
+			.name = {"Frame Allocator"}
+		});
+	m_Data = static_cast<uint8_t*>(m_Buffer->Map());
+}
+
+void FrameAllocator::BeginFrame(uint32_t imageIndex)
+{
+	ASSERT(imageIndex < m_ImageCount, "Frame allocator has no region for this swapchain image!");
+
+	m_CurrentOffset = static_cast<uint64_t>(imageIndex) * FRAME_ALLOCATOR_REGION_SIZE;
+	m_RegionEnd = m_CurrentOffset + FRAME_ALLOCATOR_REGION_SIZE;
+}
+
+FrameAllocation FrameAllocator::Allocate(uint64_t size)
+{
+	const uint64_t offset = AlignUp(m_CurrentOffset, m_Alignment);
+	ASSERT(offset + size <= m_RegionEnd, "Frame allocator region is full, increase FRAME_ALLOCATOR_REGION_SIZE!");
+
+	m_CurrentOffset = offset + size;
+	return FrameAllocation{ m_Buffer, offset, size, m_Data + offset };
+}
+
+FrameAllocation FrameAllocator::Write(const void* data, uint64_t size)
+{
+	FrameAllocation allocation = Allocate(size);
+	memcpy(allocation.data, data, size);
+	return allocation;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common.h"
+
+class ResourceManager;
+class VulkanBuffer;
+class VulkanDevice;
+
+//space every swapchain image gets for data written during its frame
+#define FRAME_ALLOCATOR_REGION_SIZE (256 * 1024)
+
+//part of frame allocator buffer, valid until the same swapchain image is recorded again
+struct FrameAllocation
+{
+	VulkanBuffer*	buffer = nullptr;
+	uint64_t		offset = 0;
+	uint64_t		size = 0;
+	void*			data = nullptr; //mapped memory of the allocation, cpu writes it directly
+};
+
+//linear allocator for constants and other data rewritten every frame. one buffer is mapped for its whole life and
+//split into a region per swapchain image, region is reset only once the frame that last used the image is finished,
+//so data gpu may still read is never overwritten. allocations are bound as buffer offsets, sets referencing them
+//come from frame descriptor allocator of the same image
+class FrameAllocator
+{
+public:
+	void Init(VulkanDevice& device, ResourceManager& resourceManager, uint32_t imageCount);
+	void BeginFrame(uint32_t imageIndex);
+
+	FrameAllocation Allocate(uint64_t size);
+	FrameAllocation Write(const void* data, uint64_t size);
+	template<typename T>
+	FrameAllocation Write(const T& data) { return Write(&data, sizeof(T)); }
+
+private:
+	VulkanBuffer*	m_Buffer = nullptr;
+	uint8_t*		m_Data = nullptr;
+	uint64_t		m_Alignment = 0;
+	uint32_t		m_ImageCount = 0;
+
+	uint64_t		m_CurrentOffset = 0;
+	uint64_t		m_RegionEnd = 0;
+};
@@ -42,7 +42,11 @@ void ImGuiManager::Init(Renderer& renderer)
 #ifdef RABBITHOLE_USING_IMGUI
 	VulkanDevice& device = renderer.GetVulkanDevice();
 	VulkanSwapchain& swapchain = *renderer.GetSwapchain();
-	VulkanDescriptorPool& descriptorPool = renderer.GetDescriptorPool();
+
+	VulkanDescriptorPoolInfo descriptorPoolInfo{};
+	descriptorPoolInfo.DescriptorSizes = { { DescriptorType::CombinedSampler, IMGUI_MAX_DESCRIPTOR_SETS } };
+	descriptorPoolInfo.MaxSets = IMGUI_MAX_DESCRIPTOR_SETS;
+	m_DescriptorPool = std::make_unique<VulkanDescriptorPool>(&device, descriptorPoolInfo);
 
     ImGui::CreateContext();
 
@@ -59,7 +63,7 @@ void ImGuiManager::Init(Renderer& renderer)
 
 	ImGui_ImplVulkan_InitInfo init_info = {};
 	device.InitImguiForVulkan(init_info);
-	init_info.DescriptorPool = GET_VK_HANDLE(descriptorPool);
+	init_info.DescriptorPool = GET_VK_HANDLE_PTR(m_DescriptorPool);
 	init_info.MinImageCount = swapchain.GetImageCount();
 	init_info.ImageCount = swapchain.GetImageCount();
 
@@ -150,6 +154,7 @@ void ImGuiManager::Shutdown()
 {
 #ifdef RABBITHOLE_USING_IMGUI
     ImGui_ImplVulkan_Shutdown();
+	m_DescriptorPool.reset();
 #endif
 }
 
@@ -1,12 +1,17 @@
 #pragma once
 
 class Renderer;
+class VulkanDescriptorPool;
 class VulkanTexture;
 
 #include <vulkan/vulkan.h>
 
+#include <memory>
 #include <unordered_map>
 
+//sets of the font and of every texture shown in debugger, imgui never frees them
+#define IMGUI_MAX_DESCRIPTOR_SETS 400
+
 class ImGuiManager
 {
 public:
@@ -27,5 +32,6 @@ private:
 	bool m_IsImguiInitialized = false;
 	bool m_ImGuiReady = false;
 
+	std::unique_ptr<VulkanDescriptorPool> m_DescriptorPool;
 	std::unordered_map<VulkanTexture*, VkDescriptorSet> m_RegisteredImGuiTextures;
 };
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "KTX2.h"
+
+#include <numeric>
+
+#include "SceneBake.h"
+#include "TextureCompression.h"
+#include "Render/Converters.h"
+
+namespace KTX2
+{
+	static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct Header
+	{
+		uint8_t		identifier[12];
+		uint32_t	vkFormat;
+		uint32_t	typeSize;
+		uint32_t	pixelWidth;
+		uint32_t	pixelHeight;
+		uint32_t	pixelDepth;
+		uint32_t	layerCount;
+		uint32_t	faceCount;
+		uint32_t	levelCount;
+		uint32_t	supercompressionScheme;
+		uint32_t	dfdByteOffset;
+		uint32_t	dfdByteLength;
+		uint32_t	kvdByteOffset;
+		uint32_t	kvdByteLength;
+		uint64_t	sgdByteOffset;
+		uint64_t	sgdByteLength;
+	};
+
+	struct Level
+	{
+		uint64_t	byteOffset;
+		uint64_t	byteLength;
+		uint64_t	uncompressedByteLength;
+	};
+
+	//data format descriptor values from the Khronos data format specification
+	constexpr uint32_t dfdModelRGBSDA = 1;
+	constexpr uint32_t dfdModelBC1A = 128;
+	constexpr uint32_t dfdModelBC4 = 131;
+	constexpr uint32_t dfdModelBC5 = 132;
+	constexpr uint32_t dfdModelBC7 = 134;
+	constexpr uint32_t dfdPrimariesBT709 = 1;
+	constexpr uint32_t dfdTransferLinear = 1;
+	constexpr uint32_t dfdChannelAlpha = 15;
+
+	struct DescriptorSample
+	{
+		uint32_t	bitOffset;
+		uint32_t	bitLength;
+		uint32_t	channel;
+		uint32_t	upper;
+	};
+
+	static void WriteDataFormatDescriptor(SceneBake::Writer& writer, Format format)
+	{
+		uint32_t colorModel = dfdModelRGBSDA;
+		uint32_t blockDimension = 0;
+		std::vector<DescriptorSample> samples;
+
+		switch (format)
+		{
+		case Format::BC1_UNORM:
+			colorModel = dfdModelBC1A;
+			samples = { { 0, 64, 1, UINT32_MAX } };
+			break;
+		case Format::BC4_UNORM:
+			colorModel = dfdModelBC4;
+			samples = { { 0, 64, 0, UINT32_MAX } };
+			break;
+		case Format::BC5_UNORM:
+			colorModel = dfdModelBC5;
+			samples = { { 0, 64, 0, UINT32_MAX }, { 64, 64, 1, UINT32_MAX } };
+			break;
+		case Format::BC7_UNORM:
+			colorModel = dfdModelBC7;
+			samples = { { 0, 128, 0, UINT32_MAX } };
+			break;
+		default:
+			samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, dfdChannelAlpha, 255 } };
+			break;
+		}
+
+		if (IsBlockCompressedFormat(format))
+		{
+			blockDimension = 3 | (3 << 8);
+		}
+
+		const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+		const uint32_t bytesPlane0 = static_cast<uint32_t>(GetImageSizeFrom(format, 1, 1));
+
+		writer.Write<uint32_t>(4 + blockSize);
+		writer.Write<uint32_t>(0);
+		writer.Write<uint32_t>(2 | (blockSize << 16));
+		writer.Write<uint32_t>(colorModel | (dfdPrimariesBT709 << 8) | (dfdTransferLinear << 16));
+		writer.Write<uint32_t>(blockDimension);
+		writer.Write<uint32_t>(bytesPlane0);
+		writer.Write<uint32_t>(0);
+
+		for (const DescriptorSample& sample : samples)
+		{
+			writer.Write<uint32_t>(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+			writer.Write<uint32_t>(0);
+			writer.Write<uint32_t>(0);
+			writer.Write<uint32_t>(sample.upper);
+		}
+	}
+
+	static bool GetFormatFrom(uint32_t vkFormat, Format& format)
+	{
+		for (Format candidate : { Format::R8G8B8A8_UNORM, Format::BC1_UNORM, Format::BC4_UNORM, Format::BC5_UNORM, Format::BC7_UNORM })
+		{
+			if (GetVkFormatFrom(candidate) == static_cast<VkFormat>(vkFormat))
+			{
+				format = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WriteToFile(const std::string& path, const TextureCompression::MipChain& mipChain)
+	{
+		SceneBake::Writer writer;
+
+		Header header{};
+		memcpy(header.identifier, identifier, sizeof(identifier));
+		header.vkFormat = static_cast<uint32_t>(GetVkFormatFrom(mipChain.format));
+		header.typeSize = 1;
+		header.pixelWidth = mipChain.width;
+		header.pixelHeight = mipChain.height;
+		header.faceCount = 1;
+		header.levelCount = mipChain.mipCount;
+		writer.Write(header);
+
+		const uint64_t levelIndexOffset = writer.GetSize();
+		std::vector<Level> levels(mipChain.mipCount);
+		writer.WriteBytes(levels.data(), levels.size() * sizeof(Level));
+
+		header.dfdByteOffset = static_cast<uint32_t>(writer.GetSize());
+		WriteDataFormatDescriptor(writer, mipChain.format);
+		header.dfdByteLength = static_cast<uint32_t>(writer.GetSize()) - header.dfdByteOffset;
+
+		//mips are stored smallest first and aligned to both texel block size and 4
+		const uint64_t texelBlockSize = GetImageSizeFrom(mipChain.format, 1, 1);
+		const uint64_t levelAlignment = std::lcm(texelBlockSize, static_cast<uint64_t>(4));
+
+		for (uint32_t mip = mipChain.mipCount; mip-- > 0;)
+		{
+			levels[mip].byteOffset = writer.Align(levelAlignment);
+			levels[mip].byteLength = mipChain.GetMipSize(mip);
+			levels[mip].uncompressedByteLength = levels[mip].byteLength;
+			writer.WriteBytes(mipChain.data.data() + mipChain.GetMipOffset(mip), levels[mip].byteLength);
+		}
+
+		writer.Patch(0, header);
+		for (uint32_t mip = 0; mip < mipChain.mipCount; mip++)
+		{
+			writer.Patch(levelIndexOffset + mip * sizeof(Level), levels[mip]);
+		}
+
+		return writer.SaveToFile(path);
+	}
+
+	bool Read(const uint8_t* data, size_t size, TextureView& output)
+	{
+		SceneBake::Reader reader(data, size);
+		Header header = reader.Read<Header>();
+
+		if (!reader.IsValid() || memcmp(header.identifier, identifier, sizeof(identifier)) != 0 ||
+			header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 || header.layerCount > 1 ||
+			header.faceCount != 1 || header.supercompressionScheme != 0 || header.levelCount == 0 ||
+			header.levelCount > GET_MIP_LEVELS_FROM_RES(header.pixelWidth, header.pixelHeight))
+		{
+			return false;
+		}
+
+		if (!GetFormatFrom(header.vkFormat, output.format))
+		{
+			return false;
+		}
+
+		output.width = header.pixelWidth;
+		output.height = header.pixelHeight;
+		output.mipData.resize(header.levelCount);
+
+		for (uint32_t mip = 0; mip < header.levelCount; mip++)
+		{
+			Level level = reader.Read<Level>();
+			uint64_t expectedSize = GetImageSizeFrom(output.format, std::max(output.width >> mip, 1u), std::max(output.height >> mip, 1u));
+
+			if (!reader.IsValid() || level.byteLength != expectedSize || level.byteOffset > size || level.byteLength > size - level.byteOffset)
+			{
+				return false;
+			}
+
+			output.mipData[mip] = data + level.byteOffset;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "common.h"
+#include "Render/Vulkan/VulkanTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace TextureCompression { struct MipChain; }
+
+//minimal KTX2 container support for baked model textures. only single 2D images without supercompression
+//are written and read, which is everything the texture import produces
+namespace KTX2
+{
+	struct TextureView
+	{
+		Format								format = Format::UNDEFINED;
+		uint32_t							width = 0;
+		uint32_t							height = 0;
+		//largest mip first, points into the data view was read from
+		std::vector<const unsigned char*>	mipData;
+	};
+
+	bool WriteToFile(const std::string& path, const TextureCompression::MipChain& mipChain);
+	//validates the whole container, mip sizes included, so view can be uploaded without further checks
+	bool Read(const uint8_t* data, size_t size, TextureView& output);
+}
@@ -0,0 +1,328 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "MeshOptimization.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Model.h"
+
+namespace MeshOptimization
+{
+	//size of simulated LRU cache, larger than any real hardware so result is good for all of them
+	constexpr uint32_t vertexCacheSize = 32;
+	//size of FIFO cache used to find cache restarts when clustering for overdraw
+	constexpr uint32_t overdrawCacheSize = 16;
+
+	constexpr float cacheDecayPower = 1.5f;
+	constexpr float lastTriangleScore = 0.75f;
+	constexpr float valenceBoostScale = 2.f;
+	constexpr float valenceBoostPower = 0.5f;
+
+	static float VertexScore(int32_t cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return -1.f;
+		}
+
+		float score = 0.f;
+		if (cachePosition >= 0)
+		{
+			//vertices of the last triangle get fixed score so it is not immediately reused in the other direction
+			if (cachePosition < 3)
+			{
+				score = lastTriangleScore;
+			}
+			else
+			{
+				const float scaler = 1.f / (vertexCacheSize - 3);
+				score = powf(1.f - (cachePosition - 3) * scaler, cacheDecayPower);
+			}
+		}
+
+		//prefer vertices with few triangles left, finishing them removes lone triangles that would cost a miss later
+		score += valenceBoostScale * powf(static_cast<float>(remainingTriangles), -valenceBoostPower);
+		return score;
+	}
+
+	void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::unordered_map<Vertex, uint32_t> uniqueVertices;
+		uniqueVertices.reserve(vertices.size());
+
+		std::vector<uint32_t> remap(vertices.size());
+		std::vector<Vertex> weldedVertices;
+		weldedVertices.reserve(vertices.size());
+
+		for (uint32_t v = 0; v < vertices.size(); v++)
+		{
+			auto inserted = uniqueVertices.emplace(vertices[v], static_cast<uint32_t>(weldedVertices.size()));
+			if (inserted.second)
+			{
+				weldedVertices.push_back(vertices[v]);
+			}
+			remap[v] = inserted.first->second;
+		}
+
+		for (uint32_t& index : indices)
+		{
+			index = remap[index];
+		}
+
+		vertices.swap(weldedVertices);
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		//vertex to triangle adjacency
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacencyOffsets[indices[i] + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[adjacencyFill[indices[i]]++] = i / 3;
+		}
+
+		std::vector<uint32_t> remainingTriangles(vertexCount);
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			remainingTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+			vertexScores[v] = VertexScore(-1, remainingTriangles[v]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(triangleCount * 3);
+
+		uint32_t cache[vertexCacheSize + 3];
+		uint32_t cacheCount = 0;
+		uint32_t newCache[vertexCacheSize + 3];
+
+		uint32_t scanCursor = 0;
+		uint32_t bestTriangle = UINT32_MAX;
+
+		while (result.size() < triangleCount * 3)
+		{
+			//nothing around the cache is left, continue with the first triangle that is not emitted yet
+			if (bestTriangle == UINT32_MAX)
+			{
+				while (emitted[scanCursor])
+				{
+					scanCursor++;
+				}
+				bestTriangle = scanCursor;
+			}
+
+			const uint32_t* triangle = &indices[bestTriangle * 3];
+			emitted[bestTriangle] = true;
+			result.insert(result.end(), triangle, triangle + 3);
+
+			//vertices of emitted triangle move to the front of the cache, others are pushed back
+			uint32_t newCacheCount = 0;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = triangle[corner];
+				remainingTriangles[vertex]--;
+
+				if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+				{
+					newCache[newCacheCount++] = vertex;
+				}
+			}
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				uint32_t vertex = cache[i];
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				{
+					newCache[newCacheCount++] = vertex;
+				}
+			}
+
+			//rescore every vertex that moved, including the ones that just fell out of the cache
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				uint32_t vertex = newCache[i];
+				cachePositions[vertex] = i < vertexCacheSize ? static_cast<int32_t>(i) : -1;
+
+				float newScore = VertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+				float scoreDelta = newScore - vertexScores[vertex];
+				vertexScores[vertex] = newScore;
+
+				for (uint32_t adj = adjacencyOffsets[vertex]; adj < adjacencyOffsets[vertex + 1]; adj++)
+				{
+					triangleScores[adjacency[adj]] += scoreDelta;
+				}
+			}
+
+			cacheCount = std::min(newCacheCount, vertexCacheSize);
+			std::copy(newCache, newCache + cacheCount, cache);
+
+			//next triangle is the best one touching the cache
+			bestTriangle = UINT32_MAX;
+			float bestScore = -FLT_MAX;
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				uint32_t vertex = cache[i];
+				for (uint32_t adj = adjacencyOffsets[vertex]; adj < adjacencyOffsets[vertex + 1]; adj++)
+				{
+					uint32_t candidate = adjacency[adj];
+					if (!emitted[candidate] && triangleScores[candidate] > bestScore)
+					{
+						bestScore = triangleScores[candidate];
+						bestTriangle = candidate;
+					}
+				}
+			}
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const std::vector<Vertex>& vertices)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+		{
+			return;
+		}
+
+		//cluster starts where all three vertices miss the cache, reordering clusters doesn't add misses there
+		std::vector<uint32_t> clusterOffsets;
+		{
+			std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+			uint32_t cacheTime = overdrawCacheSize + 1;
+
+			for (uint32_t t = 0; t < triangleCount; t++)
+			{
+				uint32_t misses = 0;
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t vertex = indices[t * 3 + corner];
+					if (cacheTime - cacheTimestamps[vertex] > overdrawCacheSize)
+					{
+						cacheTimestamps[vertex] = cacheTime++;
+						misses++;
+					}
+				}
+
+				if (t == 0 || misses == 3)
+				{
+					clusterOffsets.push_back(t);
+				}
+			}
+		}
+
+		if (clusterOffsets.size() < 2)
+		{
+			return;
+		}
+
+		const uint32_t clusterCount = static_cast<uint32_t>(clusterOffsets.size());
+		clusterOffsets.push_back(triangleCount);
+
+		//area weighted centroids, sum of unnormalized triangle normals is area weighted as well
+		std::vector<rabbitVec3f> clusterCentroids(clusterCount, rabbitVec3f{ 0.f });
+		std::vector<rabbitVec3f> clusterNormals(clusterCount, rabbitVec3f{ 0.f });
+		rabbitVec3f meshCentroid{ 0.f };
+		float meshArea = 0.f;
+
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			float clusterArea = 0.f;
+
+			for (uint32_t t = clusterOffsets[cluster]; t < clusterOffsets[cluster + 1]; t++)
+			{
+				const rabbitVec3f& p0 = vertices[indices[t * 3 + 0]].position;
+				const rabbitVec3f& p1 = vertices[indices[t * 3 + 1]].position;
+				const rabbitVec3f& p2 = vertices[indices[t * 3 + 2]].position;
+
+				rabbitVec3f normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+
+				clusterCentroids[cluster] += (p0 + p1 + p2) * (area / 3.f);
+				clusterNormals[cluster] += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroids[cluster];
+			meshArea += clusterArea;
+			clusterCentroids[cluster] = clusterArea > FLT_EPSILON ? clusterCentroids[cluster] / clusterArea : clusterCentroids[cluster];
+		}
+
+		if (meshArea <= FLT_EPSILON)
+		{
+			return;
+		}
+		meshCentroid /= meshArea;
+
+		//clusters far out in the direction they face are likely in front of the rest of the mesh
+		std::vector<float> clusterSortKeys(clusterCount, 0.f);
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			float normalLength = glm::length(clusterNormals[cluster]);
+			if (normalLength > FLT_EPSILON)
+			{
+				clusterSortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid, clusterNormals[cluster] / normalLength);
+			}
+		}
+
+		std::vector<uint32_t> clusterOrder(clusterCount);
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			clusterOrder[cluster] = cluster;
+		}
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t lhs, uint32_t rhs) { return clusterSortKeys[lhs] > clusterSortKeys[rhs]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(triangleCount * 3);
+		for (uint32_t cluster : clusterOrder)
+		{
+			result.insert(result.end(), indices + clusterOffsets[cluster] * 3, indices + clusterOffsets[cluster + 1] * 3);
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+		std::vector<Vertex> reorderedVertices;
+		reorderedVertices.reserve(vertices.size());
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = static_cast<uint32_t>(reorderedVertices.size());
+				reorderedVertices.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices.swap(reorderedVertices);
+	}
+}
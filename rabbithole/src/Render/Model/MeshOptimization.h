@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+struct Vertex;
+
+namespace MeshOptimization
+{
+	//merges vertices with equal attributes and rewrites indices to point to the merged ones
+	void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	//reorders triangles so vertices still in the post-transform cache are reused (Forsyth's linear speed algorithm),
+	//indices have to be in [0, vertexCount)
+	void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+	//splits cache optimized triangles into clusters at cache restarts and draws outward facing clusters first,
+	//so they occlude the rest of the mesh
+	void OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const std::vector<Vertex>& vertices);
+
+	//reorders vertices in order of first use so vertex fetch reads memory linearly, unused vertices are dropped
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+}
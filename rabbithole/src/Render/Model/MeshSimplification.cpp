@@ -0,0 +1,304 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "MeshSimplification.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Model.h"
+
+namespace MeshSimplification
+{
+	//symmetric 4x4 matrix of plane equation products, sum of squared distances to all planes
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+
+		static Quadric FromPlane(const rabbitVec3f& normal, float distance)
+		{
+			Quadric q;
+			q.a00 = normal.x * normal.x; q.a01 = normal.x * normal.y; q.a02 = normal.x * normal.z; q.a03 = normal.x * distance;
+			q.a11 = normal.y * normal.y; q.a12 = normal.y * normal.z; q.a13 = normal.y * distance;
+			q.a22 = normal.z * normal.z; q.a23 = normal.z * distance;
+			q.a33 = distance * distance;
+			return q;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+			a11 += other.a11; a12 += other.a12; a13 += other.a13;
+			a22 += other.a22; a23 += other.a23;
+			a33 += other.a33;
+		}
+
+		double Evaluate(const rabbitVec3f& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double result =
+				a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+				a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+				a22 * z * z + 2 * a23 * z +
+				a33;
+			return std::max(result, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double	 error;
+	};
+
+	static rabbitVec3f TriangleNormal(const rabbitVec3f& p0, const rabbitVec3f& p1, const rabbitVec3f& p2)
+	{
+		return glm::cross(p1 - p0, p2 - p0);
+	}
+
+	float Simplify(const std::vector<Vertex>& vertexBuffer, const uint32_t* indices, uint32_t indexCount, uint32_t targetIndexCount, float targetError, std::vector<uint32_t>& result)
+	{
+		result.clear();
+
+		//work on compact local vertex ids
+		std::unordered_map<uint32_t, uint32_t> globalToLocal;
+		std::vector<uint32_t> localToGlobal;
+		std::vector<uint32_t> triangles(indexCount - indexCount % 3);
+
+		for (uint32_t i = 0; i < triangles.size(); i++)
+		{
+			auto inserted = globalToLocal.emplace(indices[i], static_cast<uint32_t>(localToGlobal.size()));
+			if (inserted.second)
+			{
+				localToGlobal.push_back(indices[i]);
+			}
+			triangles[i] = inserted.first->second;
+		}
+
+		const uint32_t vertexCount = static_cast<uint32_t>(localToGlobal.size());
+
+		std::vector<rabbitVec3f> positions(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			positions[v] = vertexBuffer[localToGlobal[v]].position;
+		}
+
+		//vertices sharing position with another one lie on uv/normal seam, moving them would tear the surface
+		std::vector<bool> locked(vertexCount, false);
+		{
+			std::unordered_map<rabbitVec3f, uint32_t> positionOwner;
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				auto inserted = positionOwner.emplace(positions[v], v);
+				if (!inserted.second)
+				{
+					locked[v] = true;
+					locked[inserted.first->second] = true;
+				}
+			}
+		}
+
+		//edges used by a single triangle are on open border, lock them so the outline is kept
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeUseCount;
+			for (uint32_t i = 0; i < triangles.size(); i += 3)
+			{
+				for (uint32_t e = 0; e < 3; e++)
+				{
+					uint32_t a = triangles[i + e];
+					uint32_t b = triangles[i + (e + 1) % 3];
+					uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+					edgeUseCount[key]++;
+				}
+			}
+
+			for (auto& [key, useCount] : edgeUseCount)
+			{
+				if (useCount == 1)
+				{
+					locked[static_cast<uint32_t>(key >> 32)] = true;
+					locked[static_cast<uint32_t>(key & 0xffffffff)] = true;
+				}
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (uint32_t i = 0; i < triangles.size(); i += 3)
+		{
+			rabbitVec3f normal = TriangleNormal(positions[triangles[i]], positions[triangles[i + 1]], positions[triangles[i + 2]]);
+			float length = glm::length(normal);
+			if (length <= FLT_EPSILON)
+			{
+				continue;
+			}
+
+			normal /= length;
+			Quadric plane = Quadric::FromPlane(normal, -glm::dot(normal, positions[triangles[i]]));
+
+			quadrics[triangles[i + 0]].Add(plane);
+			quadrics[triangles[i + 1]].Add(plane);
+			quadrics[triangles[i + 2]].Add(plane);
+		}
+
+		const double maxError = static_cast<double>(targetError) * targetError;
+		double resultError = 0.0;
+
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<bool> touched(vertexCount);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+
+		while (triangles.size() > targetIndexCount)
+		{
+			//vertex to triangle adjacency for flip checks
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (uint32_t index : triangles)
+			{
+				adjacencyOffsets[index + 1]++;
+			}
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+			adjacency.resize(triangles.size());
+			std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t i = 0; i < triangles.size(); i++)
+			{
+				adjacency[adjacencyFill[triangles[i]]++] = i / 3;
+			}
+
+			collapses.clear();
+			for (uint32_t i = 0; i < triangles.size(); i += 3)
+			{
+				for (uint32_t e = 0; e < 3; e++)
+				{
+					uint32_t a = triangles[i + e];
+					uint32_t b = triangles[i + (e + 1) % 3];
+
+					Quadric combined = quadrics[a];
+					combined.Add(quadrics[b]);
+
+					if (!locked[a])
+					{
+						collapses.push_back({ a, b, combined.Evaluate(positions[b]) });
+					}
+					if (!locked[b])
+					{
+						collapses.push_back({ b, a, combined.Evaluate(positions[a]) });
+					}
+				}
+			}
+
+			if (collapses.empty())
+			{
+				break;
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				remap[v] = v;
+			}
+			std::fill(touched.begin(), touched.end(), false);
+
+			//every collapse removes about two triangles
+			const size_t trianglesToRemove = (triangles.size() - targetIndexCount) / 3;
+			const size_t collapseLimit = std::max<size_t>(trianglesToRemove / 2, 1);
+			size_t collapseCount = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.error > maxError || collapseCount >= collapseLimit)
+				{
+					break;
+				}
+
+				if (touched[collapse.from] || touched[collapse.to])
+				{
+					continue;
+				}
+
+				//reject collapse if any triangle around the vertex would flip
+				bool flips = false;
+				for (uint32_t adj = adjacencyOffsets[collapse.from]; adj < adjacencyOffsets[collapse.from + 1] && !flips; adj++)
+				{
+					const uint32_t* triangle = &triangles[adjacency[adj] * 3];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					{
+						continue;
+					}
+
+					rabbitVec3f oldPositions[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+					rabbitVec3f newPositions[3] = { oldPositions[0], oldPositions[1], oldPositions[2] };
+					for (uint32_t corner = 0; corner < 3; corner++)
+					{
+						if (triangle[corner] == collapse.from)
+						{
+							newPositions[corner] = positions[collapse.to];
+						}
+					}
+
+					rabbitVec3f oldNormal = TriangleNormal(oldPositions[0], oldPositions[1], oldPositions[2]);
+					rabbitVec3f newNormal = TriangleNormal(newPositions[0], newPositions[1], newPositions[2]);
+					flips = glm::dot(oldNormal, newNormal) <= 0.f;
+				}
+
+				if (flips)
+				{
+					continue;
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].Add(quadrics[collapse.from]);
+				resultError = std::max(resultError, collapse.error);
+				collapseCount++;
+
+				//neighbourhood changed, flip checks of other collapses around it are not valid anymore
+				for (uint32_t adj = adjacencyOffsets[collapse.from]; adj < adjacencyOffsets[collapse.from + 1]; adj++)
+				{
+					const uint32_t* triangle = &triangles[adjacency[adj] * 3];
+					touched[triangle[0]] = true;
+					touched[triangle[1]] = true;
+					touched[triangle[2]] = true;
+				}
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			//apply collapses and drop triangles that became degenerate
+			size_t writeOffset = 0;
+			for (size_t i = 0; i < triangles.size(); i += 3)
+			{
+				uint32_t a = remap[triangles[i + 0]];
+				uint32_t b = remap[triangles[i + 1]];
+				uint32_t c = remap[triangles[i + 2]];
+
+				if (a == b || b == c || a == c)
+				{
+					continue;
+				}
+
+				triangles[writeOffset++] = a;
+				triangles[writeOffset++] = b;
+				triangles[writeOffset++] = c;
+			}
+			triangles.resize(writeOffset);
+		}
+
+		result.reserve(triangles.size());
+		for (uint32_t index : triangles)
+		{
+			result.push_back(localToGlobal[index]);
+		}
+
+		return static_cast<float>(sqrt(resultError));
+	}
+}
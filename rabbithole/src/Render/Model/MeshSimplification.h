@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+struct Vertex;
+
+namespace MeshSimplification
+{
+	//collapses edges ordered by quadric error until index count drops to targetIndexCount or next collapse would
+	//exceed targetError. vertices on borders and attribute seams are never moved, result indexes original vertices
+	//so every LOD can share the same vertex buffer. returns largest error introduced, in units of vertex positions
+	float Simplify(const std::vector<Vertex>& vertexBuffer, const uint32_t* indices, uint32_t indexCount, uint32_t targetIndexCount, float targetError, std::vector<uint32_t>& result);
+}
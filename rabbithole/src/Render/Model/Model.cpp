@@ -4,14 +4,24 @@
 
 #include <stddef.h>
 #include <iostream>
+#include <algorithm>
 
 #include "stb_image/stb_image.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include "Render/AssetRegistry.h"
 #include "Render/Renderer.h"
 #include "Render/Vulkan/VulkanDescriptors.h"
 #include "Render/Vulkan/VulkanTexture.h"
+#include "Render/Model/MeshSimplification.h"
+#include "Render/Model/MeshOptimization.h"
+#include "Render/Model/SceneBake.h"
+#include "Render/Model/KTX2.h"
+#include "Render/Model/TextureCompression.h"
+#include "Core/JobSystem.h"
+#include "Utils/utils.h"
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -55,6 +65,245 @@ std::vector<VkVertexInputAttributeDescription> Vertex::GetAttributeDescriptions(
 	return attributeDescriptions;
 }
 
+rabbitVec3f GetPositionQuantizationScale(const AABB& bounds)
+{
+	rabbitVec3f extent = bounds.bounds[1] - bounds.bounds[0];
+	float minExtent = std::max(std::max(extent.x, std::max(extent.y, extent.z)) * 0.001f, 0.0001f);
+	return glm::max(extent, rabbitVec3f(minExtent));
+}
+
+static uint32_t OctahedralEncode(rabbitVec3f direction)
+{
+	float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+	if (length <= FLT_EPSILON)
+	{
+		return glm::packSnorm2x16(rabbitVec2f(0.f));
+	}
+
+	direction /= length;
+	rabbitVec2f encoded = rabbitVec2f(direction.x, direction.y);
+
+	//lower hemisphere is folded over the diagonals
+	if (direction.z < 0.f)
+	{
+		encoded = (1.f - glm::abs(rabbitVec2f(direction.y, direction.x))) * rabbitVec2f(direction.x >= 0.f ? 1.f : -1.f, direction.y >= 0.f ? 1.f : -1.f);
+	}
+
+	return glm::packSnorm2x16(encoded);
+}
+
+CompressedVertex CompressedVertex::Encode(const Vertex& vertex, const AABB& bounds)
+{
+	rabbitVec3f scale = GetPositionQuantizationScale(bounds);
+	rabbitVec3f normalizedPosition = glm::clamp((vertex.position - bounds.bounds[0]) / scale, 0.f, 1.f);
+
+	CompressedVertex result{};
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		result.position[i] = static_cast<uint16_t>(glm::packUnorm1x16(normalizedPosition[i]));
+	}
+
+	result.normal = OctahedralEncode(vertex.normal);
+	result.tangent = OctahedralEncode(vertex.tangent);
+	result.uv = glm::packHalf2x16(vertex.uv);
+	return result;
+}
+
+rabbitVec3f CompressedVertex::DecodePosition(const AABB& bounds) const
+{
+	rabbitVec3f normalizedPosition = { glm::unpackUnorm1x16(position[0]), glm::unpackUnorm1x16(position[1]), glm::unpackUnorm1x16(position[2]) };
+	return bounds.bounds[0] + normalizedPosition * GetPositionQuantizationScale(bounds);
+}
+
+std::vector<VkVertexInputBindingDescription> CompressedVertex::GetBindingDescriptions()
+{
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(CompressedVertex);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> CompressedVertex::GetAttributeDescriptions()
+{
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+	attributeDescriptions[0].offset = offsetof(CompressedVertex, position);
+
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+	attributeDescriptions[1].offset = offsetof(CompressedVertex, normal);
+
+	attributeDescriptions[2].binding = 0;
+	attributeDescriptions[2].location = 2;
+	attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+	attributeDescriptions[2].offset = offsetof(CompressedVertex, tangent);
+
+	attributeDescriptions[3].binding = 0;
+	attributeDescriptions[3].location = 3;
+	attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+	attributeDescriptions[3].offset = offsetof(CompressedVertex, uv);
+
+	return attributeDescriptions;
+}
+
+AABB AABB::Transform(const rabbitMat4f& matrix) const
+{
+	rabbitVec3f minPos = { FLT_MAX, FLT_MAX, FLT_MAX };
+	rabbitVec3f maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		rabbitVec3f position = {
+			bounds[(corner >> 0) & 1].x,
+			bounds[(corner >> 1) & 1].y,
+			bounds[(corner >> 2) & 1].z };
+
+		rabbitVec3f transformed = rabbitVec3f(matrix * rabbitVec4f(position, 1.f));
+		minPos = glm::min(transformed, minPos);
+		maxPos = glm::max(transformed, maxPos);
+	}
+
+	return AABB{ minPos, maxPos };
+}
+
+static void ComputeMeshletBounds(const std::vector<uint32_t>& indexBuffer, const std::vector<Vertex>& vertexBuffer, Meshlet& meshlet)
+{
+	rabbitVec3f minPos = { FLT_MAX, FLT_MAX, FLT_MAX };
+	rabbitVec3f maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+	{
+		minPos = glm::min(vertexBuffer[indexBuffer[i]].position, minPos);
+		maxPos = glm::max(vertexBuffer[indexBuffer[i]].position, maxPos);
+	}
+
+	meshlet.bbox = { minPos, maxPos };
+	meshlet.coneApex = meshlet.bbox.centroid();
+	meshlet.coneAxis = { 0.f, 0.f, 1.f };
+	meshlet.coneCutoff = MESHLET_NO_CONE_CUTOFF;
+
+	//normal cone, every triangle of the meshlet is backfacing when view direction falls inside of it
+	rabbitVec3f triangleNormals[MESHLET_MAX_TRIANGLES];
+	rabbitVec3f triangleFirstVertex[MESHLET_MAX_TRIANGLES];
+	uint32_t triangleCount = 0;
+	rabbitVec3f normalSum{ 0.f };
+
+	for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+	{
+		const rabbitVec3f& p0 = vertexBuffer[indexBuffer[i + 0]].position;
+		const rabbitVec3f& p1 = vertexBuffer[indexBuffer[i + 1]].position;
+		const rabbitVec3f& p2 = vertexBuffer[indexBuffer[i + 2]].position;
+
+		rabbitVec3f normal = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(normal);
+
+		//degenerate triangles don't affect the cone
+		if (area <= FLT_EPSILON)
+		{
+			continue;
+		}
+
+		triangleNormals[triangleCount] = normal / area;
+		triangleFirstVertex[triangleCount] = p0;
+		normalSum += triangleNormals[triangleCount];
+		triangleCount++;
+	}
+
+	float normalSumLength = glm::length(normalSum);
+	if (triangleCount == 0 || normalSumLength <= FLT_EPSILON)
+	{
+		return;
+	}
+
+	rabbitVec3f axis = normalSum / normalSumLength;
+
+	float minDot = 1.f;
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		minDot = std::min(minDot, glm::dot(triangleNormals[i], axis));
+	}
+
+	//cone wider than ~85 degrees almost never culls anything
+	if (minDot <= 0.1f)
+	{
+		return;
+	}
+
+	//move apex back along the axis so that cone contains all triangle planes
+	rabbitVec3f center = meshlet.bbox.centroid();
+	float maxT = 0.f;
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		float distanceToPlane = glm::dot(center - triangleFirstVertex[i], triangleNormals[i]);
+		float axisDotNormal = glm::dot(axis, triangleNormals[i]);
+		maxT = std::max(maxT, distanceToPlane / axisDotNormal);
+	}
+
+	meshlet.coneApex = center - axis * maxT;
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+}
+
+void BuildMeshlets(const std::vector<uint32_t>& indexBuffer, const std::vector<Vertex>& vertexBuffer, uint32_t firstIndex, uint32_t indexCount, std::vector<Meshlet>& meshlets)
+{
+	//greedy scan in index order, triangles keep their order so meshlet is just a range of the index buffer
+	std::vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(MESHLET_MAX_VERTICES);
+
+	Meshlet currentMeshlet{};
+
+	auto flushMeshlet = [&]()
+	{
+		if (currentMeshlet.indexCount > 0)
+		{
+			ComputeMeshletBounds(indexBuffer, vertexBuffer, currentMeshlet);
+			meshlets.push_back(currentMeshlet);
+		}
+
+		currentMeshlet = {};
+		meshletVertices.clear();
+	};
+
+	auto isInMeshlet = [&](uint32_t vertexIndex)
+	{
+		return std::find(meshletVertices.begin(), meshletVertices.end(), vertexIndex) != meshletVertices.end();
+	};
+
+	for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3)
+	{
+		uint32_t newVertexCount = 0;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			newVertexCount += isInMeshlet(indexBuffer[i + corner]) ? 0 : 1;
+		}
+
+		if (meshletVertices.size() + newVertexCount > MESHLET_MAX_VERTICES || currentMeshlet.indexCount / 3 + 1 > MESHLET_MAX_TRIANGLES)
+		{
+			flushMeshlet();
+		}
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			if (!isInMeshlet(indexBuffer[i + corner]))
+			{
+				meshletVertices.push_back(indexBuffer[i + corner]);
+			}
+		}
+
+		if (currentMeshlet.indexCount == 0)
+		{
+			currentMeshlet.firstIndex = i;
+		}
+		currentMeshlet.indexCount += 3;
+	}
+
+	flushMeshlet();
+}
+
 BVHNode* Recurse(BBoxEntries& work, int depth)
 {
 	// terminate recursion case: 
@@ -334,10 +583,10 @@ void CreateCFBVH(const Triangle* triangles, BVHNode* rootBVH, uint32_t** triInde
 	unsigned idxBoxes = 0;
 
 	*triIndexListNum = CountTriangles(rootBVH);
-	*triIndexList = new uint32_t[*triIndexListNum];
+	*triIndexList = RABBIT_ALLOC(uint32_t, *triIndexListNum);
 
 	*nodeListNum = CountBoxes(rootBVH);
-	*nodeList = new CacheFriendlyBVHNode[*nodeListNum]; // array
+	*nodeList = RABBIT_ALLOC(CacheFriendlyBVHNode, *nodeListNum); // array
 
 	PopulateCacheFriendlyBVH(&triangles[0], rootBVH, idxBoxes, idxTriList, *triIndexList, *nodeList);
 
@@ -429,71 +678,477 @@ void PopulateCacheFriendlyBVH(
 	}
 }
 
+//tinygltf only keeps encoded bytes, images are decoded in parallel in LoadImages
+static bool StoreEncodedImage(tinygltf::Image* image, const int imageIndex, std::string* error, std::string* warning, int requestedWidth, int requestedHeight, const unsigned char* bytes, int size, void* userData)
+{
+	image->image.assign(bytes, bytes + size);
+	image->as_is = true;
+	return true;
+}
+
+const char* GetModelLoadStateName(ModelLoadState state)
+{
+	switch (state)
+	{
+	case ModelLoadState::LoadingCPU:		return "Loading";
+	case ModelLoadState::UploadingGeometry:	return "Uploading geometry";
+	case ModelLoadState::LoadingTextures:	return "Loading textures";
+	case ModelLoadState::Loaded:			return "Loaded";
+	case ModelLoadState::Failed:			return "Failed";
+	default:								return "Unknown";
+	}
+}
+
 void VulkanglTFModel::LoadModelFromFile(std::string filename)
 {
+	auto lastDot = filename.find_last_of('.');
+
+	const std::string& name = m_Name;
+	auto extension = filename.substr(lastDot + 1);
+
+	//runs on a job, so phases of the model nest into scene loading explicitly
+	LoadPhaseScope modelPhase("Load model " + name, m_Renderer->GetSceneLoadPhase());
+
+	//baked scene is already processed, only its blobs have to be uploaded
+	const uint32_t sourceHash = SceneBake::ComputeSourceHash(filename);
+	const std::string bakeName = SceneBake::GetBakeName(filename);
+	const std::string bakedScenePath = SceneBake::GetBakedScenePath(bakeName);
+	{
+		LoadPhaseScope bakedScenePhase("Read baked scene");
+		if (this->LoadBakedScene(bakedScenePath, sourceHash))
+		{
+			bakedScenePhase.AddBytes(m_GeometrySource.vertexDataSize + m_GeometrySource.indexDataSize);
+			bakedScenePhase.AddItems(m_Nodes.size());
+			this->LinkNodeParents();
+			return;
+		}
+	}
+
 	tinygltf::Model glTFInput;
 	tinygltf::TinyGLTF gltfContext;
 	std::string error, warning;
 
-	auto lastSlash = filename.find_last_of('/');
-	auto lastDot = filename.find_last_of('.');
+	gltfContext.SetImageLoader(StoreEncodedImage, nullptr);
 
-	auto name = filename.substr(lastSlash + 1, lastDot - lastSlash - 1);
+	bool fileLoaded = false;
+	{
+		LoadPhaseScope parsePhase("Parse glTF");
+		fileLoaded = extension == "glb" ?
+			gltfContext.LoadBinaryFromFile(&glTFInput, &error, &warning, filename) :
+			gltfContext.LoadASCIIFromFile(&glTFInput, &error, &warning, filename);
 
-	bool fileLoaded = gltfContext.LoadASCIIFromFile(&glTFInput, &error, &warning, filename);
+		for (const tinygltf::Buffer& buffer : glTFInput.buffers)
+		{
+			parsePhase.AddBytes(buffer.data.size());
+		}
+		for (const tinygltf::Image& image : glTFInput.images)
+		{
+			parsePhase.AddBytes(image.image.size());
+		}
+		parsePhase.AddItems(glTFInput.meshes.size());
+	}
 
 	std::vector<uint32_t> indexBuffer;
 	std::vector<Vertex> vertexBuffer;
 
 	if (fileLoaded)
 	{
-		this->LoadImages(glTFInput);
+		//images are compressed by the way materials sample them, so materials go first
 		this->LoadMaterials(glTFInput);
 		this->LoadTextures(glTFInput);
-		const tinygltf::Scene& scene = glTFInput.scenes[0];
-		for (size_t i = 0; i < scene.nodes.size(); i++)
+		this->LoadImages(glTFInput, bakeName);
+
+		{
+			LoadPhaseScope nodesPhase("Nodes");
+			const tinygltf::Scene& scene = glTFInput.scenes[0];
+			for (size_t i = 0; i < scene.nodes.size(); i++)
+			{
+				const tinygltf::Node node = glTFInput.nodes[scene.nodes[i]];
+				this->LoadNode(node, glTFInput, nullptr, indexBuffer, vertexBuffer);
+			}
+			nodesPhase.AddBytes(vertexBuffer.size() * sizeof(Vertex) + indexBuffer.size() * sizeof(uint32_t));
+			nodesPhase.AddItems(vertexBuffer.size());
+		}
+
+		//LOD indices are appended after all full detail ones
+		LoadPhaseScope lodsPhase("LODs");
+		for (auto& node : m_Nodes)
 		{
-			const tinygltf::Node node = glTFInput.nodes[scene.nodes[i]];
-			this->LoadNode(node, glTFInput, nullptr, indexBuffer, vertexBuffer);
+			this->GenerateLods(node, indexBuffer, vertexBuffer);
 		}
+		lodsPhase.AddItems(m_Nodes.size());
 	}
 	else
 	{
-		ASSERT(false, "Could not open the glTF file");
+		LOG_ERROR("Could not open the glTF file " + filename);
+		m_LoadFailed = true;
+		return;
+	}
+
+	this->LinkNodeParents();
+
+	//full precision vertices are kept only for processing on cpu, gpu gets the layout model was created with
+	const bool compressedVertices = m_VertexLayout == VertexLayout::Compressed;
+	std::vector<CompressedVertex> compressedVertexBuffer;
+	if (compressedVertices)
+	{
+		compressedVertexBuffer.resize(vertexBuffer.size());
+		for (auto& node : m_Nodes)
+		{
+			this->CompressVertices(node, vertexBuffer, compressedVertexBuffer);
+		}
 	}
 
-	size_t vertexBufferSize = vertexBuffer.size() * sizeof(Vertex);
-	size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
+	void* vertexData = compressedVertices ? static_cast<void*>(compressedVertexBuffer.data()) : static_cast<void*>(vertexBuffer.data());
+	size_t vertexBufferSize = vertexBuffer.size() * (compressedVertices ? sizeof(CompressedVertex) : sizeof(Vertex));
 	this->m_IndexCount = static_cast<uint32_t>(indexBuffer.size());
 
+	std::vector<uint16_t> indices16;
+	std::vector<uint32_t> indices32;
+	for (auto& node : m_Nodes)
+	{
+		this->PackIndices(node, indexBuffer, indices16, indices32);
+	}
+
+	//32 bit section has to be aligned to its index size
+	m_Index32Offset = (indices16.size() * sizeof(uint16_t) + sizeof(uint32_t) - 1) & ~static_cast<uint64_t>(sizeof(uint32_t) - 1);
+	size_t indexBufferSize = m_Index32Offset + indices32.size() * sizeof(uint32_t);
+
+	std::vector<uint8_t> indexData(indexBufferSize, 0);
+	memcpy(indexData.data(), indices16.data(), indices16.size() * sizeof(uint16_t));
+	memcpy(indexData.data() + m_Index32Offset, indices32.data(), indices32.size() * sizeof(uint32_t));
+
+	{
+		LoadPhaseScope bakePhase("Write baked scene");
+		this->WriteBakedScene(bakedScenePath, sourceHash, glTFInput, bakeName, vertexData, vertexBufferSize, indexData.data(), indexBufferSize);
+		bakePhase.AddBytes(vertexBufferSize + indexBufferSize);
+	}
+
+	//buffers are created from these on the main thread
+	const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertexData);
+	m_GeometrySource.vertexBlob.assign(vertexBytes, vertexBytes + vertexBufferSize);
+	m_GeometrySource.indexBlob = std::move(indexData);
+	m_GeometrySource.vertexData = m_GeometrySource.vertexBlob.data();
+	m_GeometrySource.vertexDataSize = vertexBufferSize;
+	m_GeometrySource.indexData = m_GeometrySource.indexBlob.data();
+	m_GeometrySource.indexDataSize = indexBufferSize;
+}
+
+void VulkanglTFModel::CreateGeometryBuffers()
+{
 	ResourceManager& resourceManager = m_Renderer->GetResourceManager();
 	VulkanDevice& device = m_Renderer->GetVulkanDevice();
 
 	m_VertexBuffer = resourceManager.CreateBuffer(device, BufferCreateInfo{
 			.flags = {BufferUsageFlags::VertexBuffer | BufferUsageFlags::TransferSrc},
 			.memoryAccess = {MemoryAccess::GPU},
-			.size = {static_cast<uint32_t>(vertexBufferSize)},
-			.name = {std::format("ModelVertexBuffer_{}", name)}
+			.size = {static_cast<uint32_t>(m_GeometrySource.vertexDataSize)},
+			.name = {std::format("ModelVertexBuffer_{}", m_Name)}
 		});
-	m_VertexBuffer->FillBuffer(vertexBuffer.data(), vertexBufferSize);
+	m_VertexBuffer->FillBuffer(const_cast<uint8_t*>(m_GeometrySource.vertexData), m_GeometrySource.vertexDataSize);
 
 	m_IndexBuffer = resourceManager.CreateBuffer(device, BufferCreateInfo{
 			.flags = {BufferUsageFlags::IndexBuffer | BufferUsageFlags::TransferSrc},
 			.memoryAccess = {MemoryAccess::GPU},
-			.size = {static_cast<uint32_t>(indexBufferSize)},
-			.name = {std::format("ModelIndexBuffer_{}", name)}
+			.size = {static_cast<uint32_t>(m_GeometrySource.indexDataSize)},
+			.name = {std::format("ModelIndexBuffer_{}", m_Name)}
 		});
-	m_IndexBuffer->FillBuffer(indexBuffer.data(), indexBufferSize);
+	m_IndexBuffer->FillBuffer(const_cast<uint8_t*>(m_GeometrySource.indexData), m_GeometrySource.indexDataSize);
+
+	//data is in staging memory already
+	m_GeometrySource = {};
+}
+
+static ROTextureCreateInfo GetModelTextureCreateInfo(Format format, const std::string& name)
+{
+	return ROTextureCreateInfo{
+			.flags = {TextureFlags::Color | TextureFlags::Read | TextureFlags::TransferDst | TextureFlags::TransferSrc},
+			.format = {format},
+			.name = {std::format("InputTexture_{}", name)},
+			.generateMips = true,
+			.samplerType = SamplerType::Anisotropic,
+			.addressMode = AddressMode::Repeat
+		};
+}
+
+VulkanTexture* VulkanglTFModel::CreateModelTexture(TextureData* textureData, Format format, const std::string& name)
+{
+	VulkanDevice& device = m_Renderer->GetVulkanDevice();
+
+	return m_Renderer->GetResourceManager().CreateTexture(device, textureData, GetModelTextureCreateInfo(format, name));
+}
+
+uint32_t VulkanglTFModel::CreateModelTexture(TextureSource& source)
+{
+	TextureStreamer& textureStreamer = m_Renderer->GetTextureStreamer();
+	AssetRegistry& assetRegistry = m_Renderer->GetAssetRegistry();
+
+	//another model created it already, its upload is submitted before the batch of this one
+	uint32_t handle = assetRegistry.AcquireTexture(source.contentHash);
+	if (handle != TEXTURE_STREAMING_INVALID_HANDLE)
+	{
+		source = {};
+		return handle;
+	}
+
+	//streamer keeps file mapped, only tail mips are uploaded here
+	if (source.file)
+	{
+		handle = textureStreamer.RegisterTexture(std::move(source.file), source.view, GetModelTextureCreateInfo(source.view.format, source.name));
+		assetRegistry.RegisterTexture(source.contentHash, handle);
+		return handle;
+	}
+
+	//without a baked file there is nothing to stream from, whole chain stays resident
+	const TextureCompression::MipChain& mipChain = source.mipChain;
+
+	TextureData textureData{};
+	textureData.height = static_cast<int>(mipChain.height);
+	textureData.width = static_cast<int>(mipChain.width);
+	for (uint32_t mip = 0; mip < mipChain.mipCount; mip++)
+	{
+		textureData.mipData.push_back(mipChain.data.data() + mipChain.GetMipOffset(mip));
+	}
+
+	handle = textureStreamer.RegisterTexture(CreateModelTexture(&textureData, mipChain.format, source.name));
+	assetRegistry.RegisterTexture(source.contentHash, handle);
+	source.mipChain = {};
+
+	return handle;
+}
+
+uint32_t VulkanglTFModel::GetMaterialTexture(const Material& material, uint32_t textureIndex) const
+{
+	if (material.texturesLoaded && textureIndex < m_TextureIndices.size() && m_TextureIndices[textureIndex] < m_Textures.size())
+	{
+		return m_Textures[m_TextureIndices[textureIndex]];
+	}
+	return TEXTURE_STREAMING_INVALID_HANDLE;
+}
+
+void VulkanglTFModel::StartTextureLoading()
+{
+	//textures are created in order materials use them, so materials get completed one after another.
+	//images no material uses are never created
+	std::vector<bool> imageQueued(m_TextureSources.size(), false);
+	auto queueTexture = [this, &imageQueued](uint32_t textureIndex)
+	{
+		if (textureIndex < m_TextureIndices.size() && m_TextureIndices[textureIndex] < imageQueued.size() && !imageQueued[m_TextureIndices[textureIndex]])
+		{
+			imageQueued[m_TextureIndices[textureIndex]] = true;
+			m_TextureLoadOrder.push_back(m_TextureIndices[textureIndex]);
+		}
+	};
+
+	for (const Material& material : m_Materials)
+	{
+		queueTexture(material.baseColorTextureIndex);
+		queueTexture(material.normalTextureIndex);
+		queueTexture(material.metallicRoughnessTextureIndex);
+	}
+
+	m_Textures.assign(m_TextureSources.size(), TEXTURE_STREAMING_INVALID_HANDLE);
+}
+
+bool VulkanglTFModel::PublishLoadedMaterials()
+{
+	//texture that doesn't exist is never going to load, material uses only its factor for that slot
+	auto isTextureLoaded = [this](uint32_t textureIndex)
+	{
+		if (textureIndex >= m_TextureIndices.size() || m_TextureIndices[textureIndex] >= m_Textures.size())
+		{
+			return true;
+		}
+		return m_Textures[m_TextureIndices[textureIndex]] != TEXTURE_STREAMING_INVALID_HANDLE;
+	};
+
+	bool published = false;
+	for (Material& material : m_Materials)
+	{
+		if (material.texturesLoaded || !isTextureLoaded(material.baseColorTextureIndex) ||
+			!isTextureLoaded(material.normalTextureIndex) || !isTextureLoaded(material.metallicRoughnessTextureIndex))
+		{
+			continue;
+		}
+
+		material.texturesLoaded = true;
+		material.feedbackSlot = m_Renderer->GetTextureStreamer().RegisterMaterial(GetMaterialTexture(material, material.baseColorTextureIndex),
+			GetMaterialTexture(material, material.normalTextureIndex), GetMaterialTexture(material, material.metallicRoughnessTextureIndex));
+		published = true;
+	}
+
+	return published;
+}
+
+bool VulkanglTFModel::UpdateLoading()
+{
+	VulkanUploadContext& uploadContext = m_Renderer->GetVulkanDevice().GetUploadContext();
+
+	switch (m_LoadState)
+	{
+	case ModelLoadState::LoadingCPU:
+	{
+		if (m_LoadJob.pendingJobs.load(std::memory_order_acquire) > 0)
+		{
+			return false;
+		}
+
+		if (m_LoadFailed)
+		{
+			m_LoadState = ModelLoadState::Failed;
+			return false;
+		}
+
+		m_UploadPhase = LoadProfiler::instance().BeginPhase("Upload model " + m_Name, m_Renderer->GetSceneLoadPhase());
+		LoadProfiler::instance().AddBytes(m_UploadPhase, m_GeometrySource.vertexDataSize + m_GeometrySource.indexDataSize);
+
+		//batch can be nested in a longer one, upload has to be submitted to know when it is done
+		uploadContext.BeginBatch();
+		CreateGeometryBuffers();
+		uploadContext.EndBatch(false);
+		uploadContext.Flush();
+
+		m_UploadSubmission = uploadContext.GetLastSubmissionId();
+		m_LoadState = ModelLoadState::UploadingGeometry;
+		return false;
+	}
+	case ModelLoadState::UploadingGeometry:
+	{
+		if (!uploadContext.IsSubmissionHandedOver(m_UploadSubmission))
+		{
+			return false;
+		}
+
+		StartTextureLoading();
+		PublishLoadedMaterials();
+
+		//model is drawn from now on, every material needs its first set
+		m_LoadState = ModelLoadState::LoadingTextures;
+		return true;
+	}
+	case ModelLoadState::LoadingTextures:
+	{
+		bool published = false;
+		if (!m_PendingTextures.empty())
+		{
+			if (!uploadContext.IsSubmissionHandedOver(m_UploadSubmission))
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < m_PendingTextures.size(); i++)
+			{
+				m_Textures[m_TextureLoadOrder[m_LoadedTextureCount + i]] = m_PendingTextures[i];
+			}
+			m_LoadedTextureCount += static_cast<uint32_t>(m_PendingTextures.size());
+			m_PendingTextures.clear();
+
+			published = PublishLoadedMaterials();
+		}
+
+		if (m_LoadedTextureCount == m_TextureLoadOrder.size())
+		{
+			//sources of created textures are owned by streamer now
+			std::vector<TextureSource>().swap(m_TextureSources);
+			LoadProfiler::instance().EndPhase(m_UploadPhase);
+			m_LoadState = ModelLoadState::Loaded;
+			return published;
+		}
+
+		const uint32_t textureCount = std::min<uint32_t>(MODEL_LOADING_TEXTURES_PER_FRAME, static_cast<uint32_t>(m_TextureLoadOrder.size()) - m_LoadedTextureCount);
+
+		uploadContext.BeginBatch();
+		for (uint32_t i = 0; i < textureCount; i++)
+		{
+			TextureSource& source = m_TextureSources[m_TextureLoadOrder[m_LoadedTextureCount + i]];
+			LoadProfiler::instance().AddBytes(m_UploadPhase, source.file ? source.file->GetSize() : source.mipChain.data.size());
+			m_PendingTextures.push_back(CreateModelTexture(source));
+		}
+		LoadProfiler::instance().AddItems(m_UploadPhase, textureCount);
+		uploadContext.EndBatch(false);
+		uploadContext.Flush();
+
+		m_UploadSubmission = uploadContext.GetLastSubmissionId();
+		return published;
+	}
+	default:
+		return false;
+	}
 }
 
-VulkanglTFModel::VulkanglTFModel(Renderer* renderer, std::string filename)
+void VulkanglTFModel::LinkNodeParents()
+{
+	//nodes are copied around while loading, so parents can be linked only once the tree is final
+	auto linkNode = [](auto& self, Node& node, Node* parent) -> void
+	{
+		node.parent = parent;
+		for (Node& child : node.children)
+		{
+			self(self, child, &node);
+		}
+	};
+
+	for (Node& node : m_Nodes)
+	{
+		linkNode(linkNode, node, nullptr);
+	}
+}
+
+VulkanglTFModel::VulkanglTFModel(Renderer* renderer, std::string filename, VertexLayout vertexLayout)
 	: m_Renderer(renderer)
+	, m_VertexBuffer(nullptr)
+	, m_IndexBuffer(nullptr)
+	, m_Index32Offset(0)
+	, m_VertexLayout(vertexLayout)
 {
-	LoadModelFromFile(filename);
+	auto lastSlash = filename.find_last_of('/');
+	auto lastDot = filename.find_last_of('.');
+	m_Name = filename.substr(lastSlash + 1, lastDot - lastSlash - 1);
+
+	//main thread doesn't touch the model until the job is done, gpu resources are created by UpdateLoading
+	JobSystem::instance().Submit([this, filename]() { LoadModelFromFile(filename); }, &m_LoadJob);
 }
 
 VulkanglTFModel::~VulkanglTFModel()
 {
+	//job writes into the model, so it can't outlive it
+	JobSystem::instance().Wait(m_LoadJob);
+
+	//gpu resources exist only once geometry upload started
+	if (!m_VertexBuffer)
+	{
+		return;
+	}
+
+	//model goes away with its last instance, that is rare enough to wait for the gpu instead of deferring deletes
+	VULKAN_API_CALL(vkDeviceWaitIdle(m_Renderer->GetVulkanDevice().GetGraphicDevice()));
+
+	TextureStreamer& textureStreamer = m_Renderer->GetTextureStreamer();
+	for (const Material& material : m_Materials)
+	{
+		if (material.feedbackSlot != TEXTURE_STREAMING_INVALID_HANDLE)
+		{
+			textureStreamer.UnregisterMaterial(material.feedbackSlot);
+		}
+	}
+
+	//textures shared with other models stay until their last user is gone
+	AssetRegistry& assetRegistry = m_Renderer->GetAssetRegistry();
+	for (uint32_t handle : m_Textures)
+	{
+		if (handle != TEXTURE_STREAMING_INVALID_HANDLE)
+		{
+			assetRegistry.ReleaseTexture(handle);
+		}
+	}
+	for (uint32_t handle : m_PendingTextures)
+	{
+		assetRegistry.ReleaseTexture(handle);
+	}
+
+	ResourceManager& resourceManager = m_Renderer->GetResourceManager();
+	resourceManager.DeleteBuffer(m_VertexBuffer);
+	resourceManager.DeleteBuffer(m_IndexBuffer);
 }
 
 uint32_t VulkanglTFModel::ms_CurrentDrawId = 0;
@@ -504,60 +1159,110 @@ uint32_t VulkanglTFModel::ms_CurrentDrawId = 0;
 	The following functions take a glTF input model loaded via tinyglTF and convert all required data into our own structure
 */
 
-void VulkanglTFModel::LoadImages(tinygltf::Model& input)
+void VulkanglTFModel::LoadImages(tinygltf::Model& input, const std::string& bakeName)
 {
-	// Images can be stored inside the glTF (which is the case for the sample model), so instead of directly
-	// loading them from disk, we fetch them from the glTF loader and upload the buffers
-	m_Textures.resize(input.images.size());
-	for (size_t i = 0; i < input.images.size(); i++) 
+	using TextureCompression::TextureUsage;
+
+	//image shared between slots is compressed as color, it is the only format that keeps every channel
+	std::vector<TextureUsage> imageUsages(input.images.size(), TextureUsage::Color);
+	auto setImageUsage = [this, &imageUsages](uint32_t textureIndex, TextureUsage usage)
 	{
-		tinygltf::Image& glTFImage = input.images[i];
-		// Get the image data from the glTF loader
-		unsigned char* buffer = nullptr;
-		VkDeviceSize bufferSize = 0;
-		bool deleteBuffer = false;
-		// We convert RGB-only images to RGBA, as most devices don't support RGB-formats in Vulkan
-		if (glTFImage.component == 3) 
-		{
-			bufferSize = glTFImage.width * glTFImage.height * 4;
-			buffer = new unsigned char[bufferSize];
-			unsigned char* rgba = buffer;
-			unsigned char* rgb = &glTFImage.image[0];
-			for (size_t i = 0; i < glTFImage.width * glTFImage.height; ++i) 
-			{
-				memcpy(rgba, rgb, sizeof(unsigned char) * 3);
-				rgba += 4;
-				rgb += 3;
-			}
-			deleteBuffer = true;
+		if (textureIndex < m_TextureIndices.size() && m_TextureIndices[textureIndex] < imageUsages.size())
+		{
+			imageUsages[m_TextureIndices[textureIndex]] = usage;
 		}
-		else 
+	};
+	for (const Material& material : m_Materials)
+	{
+		setImageUsage(material.normalTextureIndex, TextureUsage::Normal);
+		setImageUsage(material.metallicRoughnessTextureIndex, TextureUsage::MetallicRoughness);
+	}
+	for (const Material& material : m_Materials)
+	{
+		setImageUsage(material.baseColorTextureIndex, TextureUsage::Color);
+	}
+
+	//base color of masked materials is alpha tested, its mips keep the coverage at material cutoff
+	std::vector<float> alphaCutoffs(input.images.size(), 0.f);
+	for (size_t i = 0; i < m_Materials.size() && i < input.materials.size(); i++)
+	{
+		const uint32_t textureIndex = m_Materials[i].baseColorTextureIndex;
+		if (input.materials[i].alphaMode == "MASK" && textureIndex < m_TextureIndices.size() && m_TextureIndices[textureIndex] < alphaCutoffs.size())
 		{
-			buffer = &glTFImage.image[0];
-			bufferSize = glTFImage.image.size();
+			alphaCutoffs[m_TextureIndices[textureIndex]] = static_cast<float>(input.materials[i].alphaCutoff);
 		}
+	}
+
+	const bool useBlockCompression = m_Renderer->GetVulkanDevice().IsBlockCompressionSupported();
+
+	// Images can be stored inside the glTF (which is the case for the sample model), so instead of directly
+	// loading them from disk, we fetch them from the glTF loader and upload the buffers.
+	// every image is decoded, mipped and compressed on its own job, result is baked to KTX2 right away
+	LoadPhaseScope imagesPhase("Images");
+	imagesPhase.AddItems(input.images.size());
+
+	std::vector<TextureCompression::MipChain> mipChains(input.images.size());
+	std::vector<Utils::Hash128> contentHashes(input.images.size());
+	JobSystem::instance().ParallelFor(static_cast<uint32_t>(input.images.size()), [&](uint32_t i)
+		{
+			tinygltf::Image& glTFImage = input.images[i];
+
+			//encoded bytes, usage and alpha cutoff decide the baked mips, block compression support is the same for every model
+			const uint32_t seed = static_cast<uint32_t>(imageUsages[i]) | (static_cast<uint32_t>(alphaCutoffs[i] * 255.f + 0.5f) << 8);
+			contentHashes[i] = Utils::HashContent(glTFImage.image.data(), glTFImage.image.size(), seed);
 
-		TextureData textureData{};
-		textureData.bpp = 4;
-		textureData.height = input.images[i].height;
-		textureData.width = input.images[i].width;
-		textureData.pData = buffer;
+			// We convert RGB-only images to RGBA, as most devices don't support RGB-formats in Vulkan
+			int width, height, components;
+			unsigned char* pixels = glTFImage.as_is ?
+				stbi_load_from_memory(glTFImage.image.data(), static_cast<int>(glTFImage.image.size()), &width, &height, &components, 4) : nullptr;
+			if (pixels)
+			{
+				glTFImage.image.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+				stbi_image_free(pixels);
+			}
+			else
+			{
+				LOG_WARNING("Could not decode image " + glTFImage.name);
+				width = height = 1;
+				glTFImage.image = { 0xff, 0x00, 0x33, 0xff };
+			}
 
-		ResourceManager& resourceManager = m_Renderer->GetResourceManager();
-		VulkanDevice& device = m_Renderer->GetVulkanDevice();
-		
-		m_Textures[i] = Renderer::instance().GetResourceManager().CreateTexture(device, &textureData, ROTextureCreateInfo{
-				.flags = {TextureFlags::Color | TextureFlags::Read | TextureFlags::TransferDst | TextureFlags::TransferSrc},
-				.format = {Format::R8G8B8A8_UNORM},
-				.name = {std::format("InputTexture_{}", glTFImage.name)},
-				.generateMips = true,
-				.samplerType = SamplerType::Anisotropic,
-				.addressMode = AddressMode::Repeat
-			});
+			imagesPhase.AddBytes(glTFImage.image.size());
 
-		if (deleteBuffer) 
+			glTFImage.width = width;
+			glTFImage.height = height;
+			glTFImage.component = 4;
+			glTFImage.bits = 8;
+			glTFImage.as_is = false;
+
+			TextureCompression::CompressTexture(glTFImage.image.data(), static_cast<uint32_t>(width), static_cast<uint32_t>(height), imageUsages[i], alphaCutoffs[i], useBlockCompression, mipChains[i]);
+
+			const std::string texturePath = SceneBake::GetBakedTexturePath(bakeName, i);
+			if (!KTX2::WriteToFile(texturePath, mipChains[i]))
+			{
+				LOG_WARNING("Could not write baked texture " + texturePath);
+			}
+
+			//mip chain replaces decoded pixels
+			std::vector<unsigned char>().swap(glTFImage.image);
+		});
+
+	//textures are streamed from the KTX2 files that were just written, they are created on the main thread
+	m_TextureSources.resize(input.images.size());
+	for (size_t i = 0; i < input.images.size(); i++) 
+	{
+		TextureSource& source = m_TextureSources[i];
+		source.name = input.images[i].name;
+		source.contentHash = contentHashes[i];
+
+		auto textureFile = std::make_unique<Utils::MappedFile>(SceneBake::GetBakedTexturePath(bakeName, static_cast<uint32_t>(i)));
+		if (textureFile->IsValid() && KTX2::Read(textureFile->GetData(), textureFile->GetSize(), source.view))
 		{
-			delete buffer;
+			source.file = std::move(textureFile);
+		}
+		else
+		{
+			source.mipChain = std::move(mipChains[i]);
 		}
 	}
 }
@@ -604,10 +1309,23 @@ void VulkanglTFModel::LoadMaterials(tinygltf::Model& input)
 	}
 }
 
+template<typename T>
+static void AppendIndices(const uint8_t* data, size_t count, std::vector<uint32_t>& indices)
+{
+	indices.reserve(indices.size() + count);
+	for (size_t i = 0; i < count; i++)
+	{
+		T index;
+		memcpy(&index, data + i * sizeof(T), sizeof(T));
+		indices.push_back(static_cast<uint32_t>(index));
+	}
+}
+
 void VulkanglTFModel::LoadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, VulkanglTFModel::Node* parent, std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer)
 {
 	VulkanglTFModel::Node node{};
 	node.matrix = glm::mat4(1.0f);
+	node.bbox = { rabbitVec3f{ FLT_MAX, FLT_MAX, FLT_MAX }, rabbitVec3f{ -FLT_MAX, -FLT_MAX, -FLT_MAX } };
 
 	// Get the local node matrix
 	// It's either made up from translation, rotation, scale or a 4x4 matrix
@@ -649,7 +1367,11 @@ void VulkanglTFModel::LoadNode(const tinygltf::Node& inputNode, const tinygltf::
 			const tinygltf::Primitive& glTFPrimitive = mesh.primitives[i];
 			uint32_t firstIndex = static_cast<uint32_t>(indexBuffer.size());
 			uint32_t vertexStart = static_cast<uint32_t>(vertexBuffer.size());
-			uint32_t indexCount = 0;
+			AABB aabb{};
+
+			//primitive is optimized on its own with local indices, then appended to the model buffers
+			std::vector<Vertex> primitiveVertices;
+			std::vector<uint32_t> primitiveIndices;
 			// Vertices
 			{
 				const float* positionBuffer = nullptr;
@@ -690,66 +1412,51 @@ void VulkanglTFModel::LoadNode(const tinygltf::Node& inputNode, const tinygltf::
 				}
 
 				// Append data to model's vertex buffer and calculate AABB
-				
-				AABB aabb{};
 				rabbitVec3f minPos= { FLT_MAX, FLT_MAX, FLT_MAX };
 				rabbitVec3f maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
+				primitiveVertices.reserve(vertexCount);
 				for (size_t v = 0; v < vertexCount; v++) 
 				{
 					Vertex vert{};
 					vert.position = glm::make_vec3(&positionBuffer[v * 3]);
 					vert.normal = glm::normalize(glm::vec3(normalsBuffer ? glm::make_vec3(&normalsBuffer[v * 3]) : glm::vec3(0.0f)));
 					vert.uv = texCoordsBuffer ? glm::make_vec2(&texCoordsBuffer[v * 2]) : glm::vec2(0.0f);
-					vert.tangent = tangentBuffer ? glm::make_vec3(&tangentBuffer[v * 3]) : glm::vec3(0.0f);
-					vertexBuffer.push_back(vert);
+					//glTF tangents are vec4, w is handedness
+					vert.tangent = tangentBuffer ? glm::make_vec3(&tangentBuffer[v * 4]) : glm::vec3(0.0f);
+					primitiveVertices.push_back(vert);
 
 					minPos = glm::min(vert.position, minPos);
 					maxPos = glm::max(vert.position, maxPos);
 				}
 
 				aabb = { minPos, maxPos };
-				node.bbox = aabb;
+				node.bbox.bounds[0] = glm::min(node.bbox.bounds[0], minPos);
+				node.bbox.bounds[1] = glm::max(node.bbox.bounds[1], maxPos);
 			}
 			// Indices
 			{
 				const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.indices];
 				const tinygltf::BufferView& bufferView = input.bufferViews[accessor.bufferView];
 				const tinygltf::Buffer& buffer = input.buffers[bufferView.buffer];
-
-				indexCount += static_cast<uint32_t>(accessor.count);
+				const uint8_t* indexData = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
 
 				// glTF supports different component types of indices
 				switch (accessor.componentType) 
 				{
 				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: 
 				{
-					uint32_t* buf = new uint32_t[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
-					for (size_t index = 0; index < accessor.count; index++) 
-					{
-						indexBuffer.push_back(buf[index] + vertexStart);
-					}
+					AppendIndices<uint32_t>(indexData, accessor.count, primitiveIndices);
 					break;
 				}
 				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: 
 				{
-					uint16_t* buf = new uint16_t[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
-					for (size_t index = 0; index < accessor.count; index++)
-					{
-						indexBuffer.push_back(buf[index] + vertexStart);
-					}
+					AppendIndices<uint16_t>(indexData, accessor.count, primitiveIndices);
 					break;
 				}
 				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: 
 				{
-					uint8_t* buf = new uint8_t[accessor.count];
-					memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
-					for (size_t index = 0; index < accessor.count; index++)
-					{
-						indexBuffer.push_back(buf[index] + vertexStart);
-					}
+					AppendIndices<uint8_t>(indexData, accessor.count, primitiveIndices);
 					break;
 				}
 				default:
@@ -757,10 +1464,31 @@ void VulkanglTFModel::LoadNode(const tinygltf::Node& inputNode, const tinygltf::
 					return;
 				}
 			}
+
+			MeshOptimization::WeldVertices(primitiveVertices, primitiveIndices);
+			MeshOptimization::OptimizeVertexCache(primitiveIndices.data(), static_cast<uint32_t>(primitiveIndices.size()), static_cast<uint32_t>(primitiveVertices.size()));
+			MeshOptimization::OptimizeOverdraw(primitiveIndices.data(), static_cast<uint32_t>(primitiveIndices.size()), primitiveVertices);
+			MeshOptimization::OptimizeVertexFetch(primitiveVertices, primitiveIndices);
+
+			uint32_t indexCount = static_cast<uint32_t>(primitiveIndices.size());
+			vertexBuffer.insert(vertexBuffer.end(), primitiveVertices.begin(), primitiveVertices.end());
+			for (uint32_t index : primitiveIndices)
+			{
+				indexBuffer.push_back(index + vertexStart);
+			}
+
 			Primitive primitive{};
-			primitive.firstIndex = firstIndex;
-			primitive.indexCount = indexCount;
 			primitive.materialIndex = glTFPrimitive.material;
+			primitive.firstVertex = vertexStart;
+			primitive.vertexCount = static_cast<uint32_t>(vertexBuffer.size()) - vertexStart;
+			primitive.bbox = aabb;
+
+			PrimitiveLod fullDetail{};
+			fullDetail.firstIndex = firstIndex;
+			fullDetail.indexCount = indexCount;
+			fullDetail.error = 0.f;
+			BuildMeshlets(indexBuffer, vertexBuffer, firstIndex, indexCount, fullDetail.meshlets);
+			primitive.lods.push_back(fullDetail);
 			node.mesh.primitives.push_back(primitive);
 		}
 	}
@@ -773,11 +1501,165 @@ void VulkanglTFModel::LoadNode(const tinygltf::Node& inputNode, const tinygltf::
 	}
 }
 
-void VulkanglTFModel::DrawNode(VulkanCommandBuffer& commandBuffer, const VulkanPipelineLayout* pipelineLayout, VulkanglTFModel::Node node, uint8_t backBufferIndex, IndexedIndirectBuffer* indirectBuffer)
+void VulkanglTFModel::GenerateLods(VulkanglTFModel::Node& node, std::vector<uint32_t>& indexBuffer, const std::vector<Vertex>& vertexBuffer)
+{
+	for (auto& child : node.children)
+	{
+		GenerateLods(child, indexBuffer, vertexBuffer);
+	}
+
+	for (Primitive& primitive : node.mesh.primitives)
+	{
+		const float primitiveSize = glm::length(primitive.bbox.bounds[1] - primitive.bbox.bounds[0]);
+
+		while (primitive.lods.size() < MAX_LOD_COUNT)
+		{
+			//every level is simplified from the previous one, so errors add up
+			const PrimitiveLod& previousLod = primitive.lods.back();
+			const uint32_t targetIndexCount = (previousLod.indexCount / 6) * 3;
+
+			if (targetIndexCount < LOD_MIN_TRIANGLE_COUNT * 3)
+			{
+				break;
+			}
+
+			std::vector<uint32_t> lodIndices;
+			float lodError = MeshSimplification::Simplify(vertexBuffer, &indexBuffer[previousLod.firstIndex], previousLod.indexCount,
+				targetIndexCount, LOD_MAX_RELATIVE_ERROR * primitiveSize, lodIndices);
+
+			if (lodIndices.size() > previousLod.indexCount * (1.f - LOD_MIN_REDUCTION))
+			{
+				break;
+			}
+
+			PrimitiveLod lod{};
+			lod.firstIndex = static_cast<uint32_t>(indexBuffer.size());
+			lod.indexCount = static_cast<uint32_t>(lodIndices.size());
+			lod.error = previousLod.error + lodError;
+
+			//simplification keeps triangle order of the previous level, which is not cache friendly anymore
+			for (uint32_t& index : lodIndices)
+			{
+				index -= primitive.firstVertex;
+			}
+			MeshOptimization::OptimizeVertexCache(lodIndices.data(), lod.indexCount, primitive.vertexCount);
+			for (uint32_t& index : lodIndices)
+			{
+				index += primitive.firstVertex;
+			}
+
+			indexBuffer.insert(indexBuffer.end(), lodIndices.begin(), lodIndices.end());
+			BuildMeshlets(indexBuffer, vertexBuffer, lod.firstIndex, lod.indexCount, lod.meshlets);
+
+			primitive.lods.push_back(std::move(lod));
+		}
+	}
+}
+
+uint32_t VulkanglTFModel::SelectLod(const Primitive& primitive, const rabbitMat4f& nodeMatrix) const
+{
+	if (primitive.lods.size() == 1)
+	{
+		return 0;
+	}
+
+	const CameraState& cameraState = m_Renderer->GetCameraState();
+
+	//distance to the closest point of the bounds, camera inside of them always gets full detail
+	AABB worldBounds = primitive.bbox.Transform(nodeMatrix);
+	rabbitVec3f closestPoint = glm::clamp(cameraState.CameraPosition, worldBounds.bounds[0], worldBounds.bounds[1]);
+	float distance = glm::length(closestPoint - cameraState.CameraPosition);
+
+	if (distance <= FLT_EPSILON)
+	{
+		return 0;
+	}
+
+	rabbitMat3f scaleMatrix = rabbitMat3f(nodeMatrix);
+	float scale = std::max(glm::length(scaleMatrix[0]), std::max(glm::length(scaleMatrix[1]), glm::length(scaleMatrix[2])));
+
+	//projection[1][1] is 1 / tan(fovY / 2), sign is flipped for vulkan
+	float pixelsPerUnit = GetNativeHeight * std::abs(cameraState.ProjectionMatrix[1][1]) / (2.f * distance);
+
+	for (uint32_t lod = static_cast<uint32_t>(primitive.lods.size()) - 1; lod > 0; lod--)
+	{
+		if (primitive.lods[lod].error * scale * pixelsPerUnit <= LOD_MAX_SCREEN_ERROR_PIXELS)
+		{
+			return lod;
+		}
+	}
+
+	return 0;
+}
+
+void VulkanglTFModel::PackIndices(VulkanglTFModel::Node& node, const std::vector<uint32_t>& indexBuffer, std::vector<uint16_t>& indices16, std::vector<uint32_t>& indices32)
+{
+	for (auto& child : node.children)
+	{
+		PackIndices(child, indexBuffer, indices16, indices32);
+	}
+
+	for (Primitive& primitive : node.mesh.primitives)
+	{
+		//draws add firstVertex as vertex offset, so indices only have to address vertices of the primitive
+		primitive.use16BitIndices = primitive.vertexCount <= UINT16_MAX + 1;
+
+		for (PrimitiveLod& lod : primitive.lods)
+		{
+			const uint32_t packedFirstIndex = static_cast<uint32_t>(primitive.use16BitIndices ? indices16.size() : indices32.size());
+
+			for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; i++)
+			{
+				const uint32_t localIndex = indexBuffer[i] - primitive.firstVertex;
+				if (primitive.use16BitIndices)
+				{
+					indices16.push_back(static_cast<uint16_t>(localIndex));
+				}
+				else
+				{
+					indices32.push_back(localIndex);
+				}
+			}
+
+			for (Meshlet& meshlet : lod.meshlets)
+			{
+				meshlet.firstIndex = meshlet.firstIndex - lod.firstIndex + packedFirstIndex;
+			}
+			lod.firstIndex = packedFirstIndex;
+		}
+	}
+}
+
+uint32_t VulkanglTFModel::GetVertexIndex(const void* indexBufferData, const Primitive& primitive, uint32_t index) const
+{
+	const uint8_t* indexBytes = static_cast<const uint8_t*>(indexBufferData);
+	uint32_t localIndex = primitive.use16BitIndices
+		? reinterpret_cast<const uint16_t*>(indexBytes)[index]
+		: reinterpret_cast<const uint32_t*>(indexBytes + m_Index32Offset)[index];
+
+	return primitive.firstVertex + localIndex;
+}
+
+void VulkanglTFModel::CompressVertices(const VulkanglTFModel::Node& node, const std::vector<Vertex>& vertexBuffer, std::vector<CompressedVertex>& compressedVertexBuffer) const
+{
+	for (auto& child : node.children)
+	{
+		CompressVertices(child, vertexBuffer, compressedVertexBuffer);
+	}
+
+	for (const Primitive& primitive : node.mesh.primitives)
+	{
+		for (uint32_t v = primitive.firstVertex; v < primitive.firstVertex + primitive.vertexCount; v++)
+		{
+			compressedVertexBuffer[v] = CompressedVertex::Encode(vertexBuffer[v], primitive.bbox);
+		}
+	}
+}
+
+void VulkanglTFModel::CollectNodeDraws(const VulkanglTFModel::Node& node, const rabbitMat4f& instanceMatrix, std::vector<PrimitiveDraw>& draws, IndexedIndirectBuffer* indirectBuffer) const
 {
 	if (node.mesh.primitives.size() > 0) 
 	{
-		// Pass the node's matrix via push constants
 		// Traverse the node hierarchy to the top-most parent to get the final matrix of the current node
 		glm::mat4 nodeMatrix = node.matrix;
 		VulkanglTFModel::Node* currentParent = node.parent;
@@ -786,59 +1668,131 @@ void VulkanglTFModel::DrawNode(VulkanCommandBuffer& commandBuffer, const VulkanP
 			nodeMatrix = currentParent->matrix * nodeMatrix;
 			currentParent = currentParent->parent;
 		}
-		// Pass the final matrix to the vertex shader using push constants
+		nodeMatrix = instanceMatrix * nodeMatrix;
+
+		//normal cone survives only rotation and uniform scale, mirrored or skewed nodes skip the backface test
+		rabbitMat3f coneMatrix = rabbitMat3f(nodeMatrix);
+		float scaleX = glm::length(coneMatrix[0]);
+		float scaleY = glm::length(coneMatrix[1]);
+		float scaleZ = glm::length(coneMatrix[2]);
+		bool coneCullingValid = glm::determinant(coneMatrix) > 0.f &&
+			std::abs(scaleX - scaleY) <= 0.001f * scaleX && std::abs(scaleX - scaleZ) <= 0.001f * scaleX;
 
-		for (VulkanglTFModel::Primitive& primitive : node.mesh.primitives) 
+		for (const VulkanglTFModel::Primitive& primitive : node.mesh.primitives) 
 		{
-			SimplePushConstantData pushData{};
+			PrimitiveDraw draw{};
+			draw.primitive = &primitive;
+			draw.lod = &primitive.lods[SelectLod(primitive, nodeMatrix)];
+			draw.nodeMatrix = nodeMatrix;
 			//TODO: add primitive id
-			pushData.id = ms_CurrentDrawId++;
-			pushData.modelMatrix = nodeMatrix;
-			pushData.useAlbedoMap = (uint32_t)(m_Materials[primitive.materialIndex].baseColorTextureIndex != UINT32_MAX);
-			pushData.useNormalMap = (uint32_t)(m_Materials[primitive.materialIndex].normalTextureIndex != UINT32_MAX);
-			pushData.useMetallicRoughnessMap = (uint32_t)(m_Materials[primitive.materialIndex].metallicRoughnessTextureIndex != UINT32_MAX);
-			pushData.baseColor = m_Materials[primitive.materialIndex].baseColorFactor;
-			pushData.emmisiveColorAndStrength = m_Materials[primitive.materialIndex].emissiveColorAndStrenght;
-
-			vkCmdPushConstants(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE_PTR(pipelineLayout), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &pushData);
-
-			//TODO: decrease num of descriptor set binding to number of different materials
-			//sort primitives by materialIndexNumber
-			if (primitive.indexCount > 0) 
+			draw.drawId = ms_CurrentDrawId++;
+			draw.coneCullingValid = coneCullingValid;
+
+			//every meshlet is separate command so gpu culling can drop it, whole primitive is still a single draw call
+			if (draw.lod->indexCount > 0)
 			{
-				VulkanDescriptorSet* materialDescriptorSet = m_Materials[primitive.materialIndex].materialDescriptorSet[backBufferIndex];
-				// Bind the descriptor for the current primitive's texture
-				vkCmdBindDescriptorSets(GET_VK_HANDLE(commandBuffer), VK_PIPELINE_BIND_POINT_GRAPHICS, GET_VK_HANDLE_PTR(pipelineLayout), 0, 1, GET_VK_HANDLE_PTR(materialDescriptorSet), 0, nullptr);
-
-				IndexIndirectDrawData indexIndirectDrawCommand{};
-                indexIndirectDrawCommand.firstIndex = primitive.firstIndex;
-                indexIndirectDrawCommand.firstInstance = 0;
-                indexIndirectDrawCommand.indexCount = primitive.indexCount;
-                indexIndirectDrawCommand.instanceCount = 1;
-                indexIndirectDrawCommand.vertexOffset = 0;
-
-				indirectBuffer->AddIndirectDrawCommand(commandBuffer, indexIndirectDrawCommand);
+				draw.firstCommand = indirectBuffer->ReserveIndirectDrawCommands(static_cast<uint32_t>(draw.lod->meshlets.size()));
 			}
+
+			draws.push_back(draw);
 		}
 	}
 	for (auto& child : node.children) 
 	{
-		DrawNode(commandBuffer, pipelineLayout, child, backBufferIndex, indirectBuffer);
+		CollectNodeDraws(child, instanceMatrix, draws, indirectBuffer);
 	}
 }
 
-void VulkanglTFModel::Draw(VulkanCommandBuffer& commandBuffer, const VulkanPipelineLayout* pipeLayout, uint8_t backBufferIndex, IndexedIndirectBuffer* indirectBuffer)
+void VulkanglTFModel::CollectDraws(const rabbitMat4f& instanceMatrix, std::vector<PrimitiveDraw>& draws, IndexedIndirectBuffer* indirectBuffer) const
 {
 	for (auto& node : m_Nodes)
 	{
-		DrawNode(commandBuffer, pipeLayout, node, backBufferIndex, indirectBuffer);
+		CollectNodeDraws(node, instanceMatrix, draws, indirectBuffer);
 	}
 }
 
-void VulkanglTFModel::BindBuffers(VulkanCommandBuffer& commandBuffer)
+void VulkanglTFModel::RecordDraw(VulkanCommandBuffer& commandBuffer, const VulkanPipelineLayout* pipelineLayout, const PrimitiveDraw& draw, uint8_t backBufferIndex, IndexedIndirectBuffer* indirectBuffer, bool& bound16BitIndices) const
+{
+	const Primitive& primitive = *draw.primitive;
+	const PrimitiveLod& lod = *draw.lod;
+	const rabbitMat4f& nodeMatrix = draw.nodeMatrix;
+
+	// Pass the final matrix to the vertex shader using push constants
+	SimplePushConstantData pushData{};
+	pushData.id = draw.drawId;
+	pushData.modelMatrix = nodeMatrix;
+	pushData.positionScale = rabbitVec3f(1.f);
+	pushData.vertexLayout = static_cast<uint32_t>(m_VertexLayout);
+	if (m_VertexLayout == VertexLayout::Compressed)
+	{
+		//positions are in [0, 1] of primitive bounds, dequantization is folded into the model matrix
+		pushData.positionScale = GetPositionQuantizationScale(primitive.bbox);
+		pushData.modelMatrix = glm::scale(glm::translate(nodeMatrix, primitive.bbox.bounds[0]), pushData.positionScale);
+	}
+	//placeholder material samples no maps, until its textures are loaded only factors are used
+	const Material& material = m_Materials[primitive.materialIndex];
+	pushData.materialFlags = (GetMaterialTexture(material, material.baseColorTextureIndex) != TEXTURE_STREAMING_INVALID_HANDLE ? MaterialFlags_AlbedoMap : 0) |
+		(GetMaterialTexture(material, material.normalTextureIndex) != TEXTURE_STREAMING_INVALID_HANDLE ? MaterialFlags_NormalMap : 0) |
+		(GetMaterialTexture(material, material.metallicRoughnessTextureIndex) != TEXTURE_STREAMING_INVALID_HANDLE ? MaterialFlags_MetallicRoughnessMap : 0);
+	pushData.feedbackSlot = material.feedbackSlot;
+	pushData.baseColor = material.baseColorFactor;
+	pushData.emmisiveColorAndStrength = material.emissiveColorAndStrenght;
+
+	vkCmdPushConstants(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE_PTR(pipelineLayout), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &pushData);
+
+	if (lod.indexCount == 0) 
+	{
+		return;
+	}
+
+	BindIndexBuffer(commandBuffer, primitive.use16BitIndices, bound16BitIndices);
+
+	//TODO: decrease num of descriptor set binding to number of different materials
+	//sort primitives by materialIndexNumber
+	VulkanDescriptorSet* materialDescriptorSet = material.materialDescriptorSet[backBufferIndex];
+	// Bind the descriptor for the current primitive's texture
+	vkCmdBindDescriptorSets(GET_VK_HANDLE(commandBuffer), VK_PIPELINE_BIND_POINT_GRAPHICS, GET_VK_HANDLE_PTR(pipelineLayout), 0, 1, GET_VK_HANDLE_PTR(materialDescriptorSet), 0, nullptr);
+
+	rabbitMat3f coneMatrix = rabbitMat3f(nodeMatrix);
+	uint64_t command = draw.firstCommand;
+	for (const Meshlet& meshlet : lod.meshlets)
+	{
+		IndexIndirectDrawData indexIndirectDrawCommand{};
+		indexIndirectDrawCommand.firstIndex = meshlet.firstIndex;
+		indexIndirectDrawCommand.firstInstance = 0;
+		indexIndirectDrawCommand.indexCount = meshlet.indexCount;
+		indexIndirectDrawCommand.instanceCount = 1;
+		indexIndirectDrawCommand.vertexOffset = static_cast<int32_t>(primitive.firstVertex);
+
+		AABB worldBounds = meshlet.bbox.Transform(nodeMatrix);
+		IndirectDrawBounds drawBounds{};
+		drawBounds.boundsMin = rabbitVec4f(worldBounds.bounds[0], 1.f);
+		drawBounds.boundsMax = rabbitVec4f(worldBounds.bounds[1], 1.f);
+		drawBounds.coneApex = nodeMatrix * rabbitVec4f(meshlet.coneApex, 1.f);
+		drawBounds.coneAxisAndCutoff = rabbitVec4f(glm::normalize(coneMatrix * meshlet.coneAxis), draw.coneCullingValid ? meshlet.coneCutoff : MESHLET_NO_CONE_CUTOFF);
+
+		indirectBuffer->SetIndirectDrawCommand(command++, indexIndirectDrawCommand, drawBounds);
+	}
+
+	indirectBuffer->DrawIndirectCommands(commandBuffer, draw.firstCommand, static_cast<uint32_t>(lod.meshlets.size()));
+}
+
+void VulkanglTFModel::BindBuffers(VulkanCommandBuffer& commandBuffer) const
 {
 	VkDeviceSize offsets[1] = { 0 };
 	VkBuffer vertexBuffer = GET_VK_HANDLE_PTR(m_VertexBuffer);
 	vkCmdBindVertexBuffers(GET_VK_HANDLE(commandBuffer), 0, 1, &vertexBuffer, offsets);
-	vkCmdBindIndexBuffer(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE_PTR(m_IndexBuffer), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE_PTR(m_IndexBuffer), 0, VK_INDEX_TYPE_UINT16);
+}
+
+void VulkanglTFModel::BindIndexBuffer(VulkanCommandBuffer& commandBuffer, bool use16BitIndices, bool& bound16BitIndices) const
+{
+	if (bound16BitIndices == use16BitIndices)
+	{
+		return;
+	}
+
+	VkDeviceSize offset = use16BitIndices ? 0 : m_Index32Offset;
+	vkCmdBindIndexBuffer(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE_PTR(m_IndexBuffer), offset, use16BitIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+	bound16BitIndices = use16BitIndices;
 }
@@ -6,13 +6,19 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 
+#include <memory>
 #include <vector>
 #include <type_traits>
 #include <unordered_map>
 #include <glm/gtx/hash.hpp>
 #include "tinygltf/tiny_gltf.h"
 
+#include "Core/JobSystem.h"
+#include "Core/LoadProfiler.h"
+#include "Render/Model/KTX2.h"
+#include "Render/Model/TextureCompression.h"
 #include "TextureLoading.h"
+#include "Utils/utils.h"
 
 class VulkanImage;
 class VulkanImageView;
@@ -31,15 +37,34 @@ struct IndexIndirectDrawData
 	uint32_t    firstInstance;
 };
 
+//world space bounds of a single indirect draw, used for gpu culling
+struct IndirectDrawBounds
+{
+	rabbitVec4f boundsMin;
+	rabbitVec4f boundsMax;
+	rabbitVec4f coneApex;
+	rabbitVec4f coneAxisAndCutoff; //cutoff > 1 disables backface cone test
+};
+
+//keep in sync with MATERIAL_FLAG_* in gbuffer shaders
+enum MaterialFlags : uint32_t
+{
+	MaterialFlags_AlbedoMap = 1 << 0,
+	MaterialFlags_NormalMap = 1 << 1,
+	MaterialFlags_MetallicRoughnessMap = 1 << 2
+};
+
 struct SimplePushConstantData
 {
 	rabbitMat4f modelMatrix;
 	uint32_t	id;
-	uint32_t	useAlbedoMap;
-	uint32_t	useNormalMap;
-	uint32_t	useMetallicRoughnessMap;
+	uint32_t	materialFlags;
+	uint32_t	feedbackSlot;	//texture streaming feedback of material, UINT32_MAX if it has no textures
+	uint32_t	padding;
 	rabbitVec4f baseColor;
 	rabbitVec4f emmisiveColorAndStrength;
+	rabbitVec3f positionScale;	//size of quantization box, undoes its scale on normals
+	uint32_t	vertexLayout;
 };
 
 struct Vertex
@@ -62,6 +87,64 @@ struct AABB
 {
 	rabbitVec3f bounds[2];
 	inline rabbitVec3f centroid() const { return (bounds[0] + bounds[1]) * 0.5f; }
+	AABB Transform(const rabbitMat4f& matrix) const;
+};
+
+//20 bytes instead of 44, position is quantized to primitive bounds and decoded by the model matrix
+struct CompressedVertex
+{
+	uint16_t	position[4];	//unorm, w unused
+	uint32_t	normal;			//snorm octahedral
+	uint32_t	tangent;		//snorm octahedral
+	uint32_t	uv;				//half
+
+	static CompressedVertex	Encode(const Vertex& vertex, const AABB& bounds);
+	rabbitVec3f				DecodePosition(const AABB& bounds) const;
+
+	static std::vector<VkVertexInputBindingDescription>		GetBindingDescriptions();
+	static std::vector<VkVertexInputAttributeDescription>	GetAttributeDescriptions();
+};
+
+//flat primitives are clamped to a minimal thickness, normal matrix is inverse of this scale
+rabbitVec3f GetPositionQuantizationScale(const AABB& bounds);
+
+#define MESHLET_MAX_VERTICES	64
+#define MESHLET_MAX_TRIANGLES	124
+#define MESHLET_NO_CONE_CUTOFF	2.f
+
+//cluster of triangles that is culled and drawn as a single indirect command,
+//its triangles are contiguous in the index buffer
+struct Meshlet
+{
+	uint32_t	firstIndex;
+	uint32_t	indexCount;
+	AABB		bbox;
+	rabbitVec3f	coneApex;
+	rabbitVec3f	coneAxis;
+	float		coneCutoff;
+};
+
+void BuildMeshlets(const std::vector<uint32_t>& indexBuffer, const std::vector<Vertex>& vertexBuffer, uint32_t firstIndex, uint32_t indexCount, std::vector<Meshlet>& meshlets);
+
+#define MAX_LOD_COUNT					4
+//simplification stops when it can't drop at least this fraction of the previous LOD
+#define LOD_MIN_REDUCTION				0.15f
+//max simplification error relative to primitive size
+#define LOD_MAX_RELATIVE_ERROR			0.05f
+#define LOD_MIN_TRIANGLE_COUNT			64
+//coarser LOD is picked once its error projects to less than this many pixels
+#define LOD_MAX_SCREEN_ERROR_PIXELS		1.f
+
+//textures of a loading model created in one frame, each one uploads only its tail mips
+#define MODEL_LOADING_TEXTURES_PER_FRAME	8
+
+//single level of detail of a primitive, every LOD indexes the same vertices
+struct PrimitiveLod
+{
+	uint32_t				firstIndex;
+	uint32_t				indexCount;
+	float					error; //object space distance from the full detail surface
+	std::vector<Meshlet>	meshlets;
 };
 
 template <>
@@ -72,7 +155,7 @@ struct std::hash<Vertex>
 		size_t res = 17;
 		res = res * 31 + std::hash<rabbitVec3f>()(k.position);
 		res = res * 31 + std::hash<rabbitVec3f>()(k.normal);
-		res = res * 31 + std::hash<rabbitVec2f>()(k.tangent);
+		res = res * 31 + std::hash<rabbitVec3f>()(k.tangent);
 		res = res * 31 + std::hash<rabbitVec2f>()(k.uv);
 		return res;
 	}
@@ -158,35 +241,64 @@ unsigned CountTriangles(BVHNode* root);
 void CountDepth(BVHNode* root, int depth, int& maxDepth);
 void PopulateCacheFriendlyBVH(const Triangle* pFirstTriangle, BVHNode* root, unsigned& idxBoxes, unsigned& idxTriList, uint32_t* triIndexList, CacheFriendlyBVHNode* nodeList);
 
+enum class ModelLoadState : uint8_t
+{
+	LoadingCPU,			//file is parsed and processed on a job
+	UploadingGeometry,
+	LoadingTextures,	//geometry is drawn, materials use placeholders until all of their textures are uploaded
+	Loaded,
+	Failed
+};
+
+const char* GetModelLoadStateName(ModelLoadState state);
+
 class VulkanglTFModel
 {
 public:
-	VulkanglTFModel(Renderer* renderer, std::string filename);
+	//only starts loading on a job, UpdateLoading has to be called every frame until model is loaded
+	VulkanglTFModel(Renderer* renderer, std::string filename, VertexLayout vertexLayout = VertexLayout::Compressed);
 	~VulkanglTFModel();
 
 	static uint32_t ms_CurrentDrawId;
 	
-	VulkanglTFModel(const VulkanglTFModel& other) = delete;
-	VulkanglTFModel(VulkanglTFModel&& other) = default;
+	NonCopyableAndMovable(VulkanglTFModel);
 private:
 	Renderer*		m_Renderer;
+	std::string		m_Name;
 
 	VulkanBuffer*	m_VertexBuffer;
 	VulkanBuffer*	m_IndexBuffer;
 	uint32_t		m_IndexCount;
+	uint64_t		m_Index32Offset; //16 bit indices are at the start of index buffer, 32 bit ones follow
+	VertexLayout	m_VertexLayout;
 
 public:
 	inline VulkanBuffer*	GetVertexBuffer() const	{ return m_VertexBuffer; }
 	inline VulkanBuffer*	GetIndexBuffer() const { return m_IndexBuffer; }
 	uint32_t				GetIndexCount()		{ return m_IndexCount; }
+	inline VertexLayout		GetVertexLayout() const { return m_VertexLayout; }
+	inline const std::string& GetName() const { return m_Name; }
+
+	//main thread part of loading, creates gpu resources of finished steps. returns true when materials
+	//got their textures, their descriptor sets have to be looked up again
+	bool					UpdateLoading();
+	inline ModelLoadState	GetLoadState() const { return m_LoadState; }
+	inline bool				IsLoading() const { return m_LoadState != ModelLoadState::Loaded && m_LoadState != ModelLoadState::Failed; }
+	//nodes, materials and buffers can be used only once this is true
+	inline bool				IsGeometryReady() const { return m_LoadState == ModelLoadState::LoadingTextures || m_LoadState == ModelLoadState::Loaded; }
+	inline uint32_t			GetLoadedTextureCount() const { return m_LoadedTextureCount; }
+	inline uint32_t			GetTextureLoadCount() const { return static_cast<uint32_t>(m_TextureLoadOrder.size()); }
 
 private:
 	// A primitive contains the data for a single draw call
 	struct Primitive 
 	{
-		uint32_t firstIndex;
-		uint32_t indexCount;
 		int32_t	 materialIndex;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		bool	 use16BitIndices; //indices of every LOD are relative to firstVertex
+		AABB	 bbox;
+		std::vector<PrimitiveLod> lods; //lods[0] is full detail
 	};
 
 	struct Mesh 
@@ -195,6 +307,17 @@ private:
 	};
 
 public:
+	//one primitive of an instance with lod, draw id and indirect commands resolved, so it can be recorded on any thread
+	struct PrimitiveDraw
+	{
+		const Primitive*		primitive;
+		const PrimitiveLod*		lod;
+		rabbitMat4f				nodeMatrix;
+		uint32_t				drawId;
+		uint64_t				firstCommand;
+		bool					coneCullingValid;
+	};
+
 	struct Node 
 	{
 		Node* parent;
@@ -211,32 +334,94 @@ public:
 		uint32_t	baseColorTextureIndex = UINT32_MAX;
 		uint32_t	normalTextureIndex = UINT32_MAX;
 		uint32_t	metallicRoughnessTextureIndex = UINT32_MAX;
+		uint32_t	feedbackSlot = UINT32_MAX;
+		bool		texturesLoaded = false; //placeholder factors are used until every texture of material is uploaded
 
 		//TODO: split descriptors into 3 levels PER_OBJECT, PER_PASS and PER_FRAME, then you should get rid of this
-		VulkanDescriptorSet* materialDescriptorSet[MAX_FRAMES_IN_FLIGHT];
+		VulkanDescriptorSet* materialDescriptorSet[MAX_FRAMES_IN_FLIGHT] = {};
 	};
 
 private:
-	std::vector<VulkanTexture*>		m_Textures;
+	//gpu resources are created on the main thread, job leaves their sources here
+	struct TextureSource
+	{
+		std::string							name;
+		std::unique_ptr<Utils::MappedFile>	file;		//baked KTX2 file textures are streamed from
+		KTX2::TextureView					view;
+		TextureCompression::MipChain		mipChain;	//only without a baked file, whole chain stays resident
+		Utils::Hash128						contentHash;	//same for images that bake to the same mips, they are shared between models
+	};
+
+	struct GeometrySource
+	{
+		std::unique_ptr<Utils::MappedFile>	file;		//baked blobs are uploaded straight from the mapping
+		std::vector<uint8_t>				vertexBlob;
+		std::vector<uint8_t>				indexBlob;
+		const uint8_t*						vertexData = nullptr;
+		size_t								vertexDataSize = 0;
+		const uint8_t*						indexData = nullptr;
+		size_t								indexDataSize = 0;
+	};
+
+	std::vector<uint32_t>			m_Textures;	//handles of renderer's TextureStreamer
 	std::vector<uint32_t>			m_TextureIndices;
 	std::vector<Material>			m_Materials;
 	std::vector<Node>				m_Nodes;
 
+	ModelLoadState					m_LoadState = ModelLoadState::LoadingCPU;
+	JobCounter						m_LoadJob;
+	bool							m_LoadFailed = false; //written by the job
+	uint64_t						m_UploadSubmission = 0;
+	uint32_t						m_UploadPhase = LOAD_PROFILER_NO_PHASE; //spans from geometry upload until the last texture is published
+	GeometrySource					m_GeometrySource;
+	std::vector<TextureSource>		m_TextureSources;
+	std::vector<uint32_t>			m_TextureLoadOrder;	//images used by materials, in order of the first material using them
+	uint32_t						m_LoadedTextureCount = 0;
+	std::vector<uint32_t>			m_PendingTextures;	//next textures in load order, published once their upload is handed over
+
 public:
 	std::vector<Node>&				GetNodes() { return m_Nodes; }
-	std::vector<VulkanTexture*>&	GetTextures() { return m_Textures; }
 	std::vector<Material>&			GetMaterials() { return m_Materials; }
-	std::vector<uint32_t>&			GetTextureIndices() { return m_TextureIndices; }
+	//streamer handle of the texture, invalid until material has all of its textures
+	uint32_t						GetMaterialTexture(const Material& material, uint32_t textureIndex) const;
 
 private:
-	void LoadImages(tinygltf::Model& input);
+	void LoadImages(tinygltf::Model& input, const std::string& bakeName);
 	void LoadTextures(tinygltf::Model& input);
 	void LoadMaterials(tinygltf::Model& input);
 	void LoadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, VulkanglTFModel::Node* parent, std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer);
+	void GenerateLods(VulkanglTFModel::Node& node, std::vector<uint32_t>& indexBuffer, const std::vector<Vertex>& vertexBuffer);
+	uint32_t SelectLod(const Primitive& primitive, const rabbitMat4f& nodeMatrix) const;
+	void PackIndices(VulkanglTFModel::Node& node, const std::vector<uint32_t>& indexBuffer, std::vector<uint16_t>& indices16, std::vector<uint32_t>& indices32);
+	void CompressVertices(const VulkanglTFModel::Node& node, const std::vector<Vertex>& vertexBuffer, std::vector<CompressedVertex>& compressedVertexBuffer) const;
 	void LoadModelFromFile(std::string filename);
+	void CreateGeometryBuffers();
+	VulkanTexture* CreateModelTexture(TextureData* textureData, Format format, const std::string& name);
+	uint32_t CreateModelTexture(TextureSource& source);
+	void StartTextureLoading();
+	bool PublishLoadedMaterials();
+	void LinkNodeParents();
+
+	//baked scene, implemented in SceneBake.cpp
+	bool LoadBakedScene(const std::string& bakedScenePath, uint32_t sourceHash);
+	void WriteBakedScene(const std::string& bakedScenePath, uint32_t sourceHash, const tinygltf::Model& input, const std::string& bakeName,
+		const void* vertexData, size_t vertexDataSize, const void* indexData, size_t indexDataSize) const;
+
+	void CollectNodeDraws(const VulkanglTFModel::Node& node, const rabbitMat4f& instanceMatrix, std::vector<PrimitiveDraw>& draws, IndexedIndirectBuffer* indirectBuffer) const;
 
 public:
-	void DrawNode(VulkanCommandBuffer& commandBuffer, const VulkanPipelineLayout* pipelineLayout, VulkanglTFModel::Node node, uint8_t backBufferIndex, IndexedIndirectBuffer* indirectBuffer);
-	void Draw(VulkanCommandBuffer& commandBuffer, const VulkanPipelineLayout* pipeLayout, uint8_t backBufferIndex, IndexedIndirectBuffer* indirectBuffer);
-	void BindBuffers(VulkanCommandBuffer& commandBuffer);
-};
\ No newline at end of file
+	//draw ids and indirect commands are taken in order, must be called on the main thread
+	void CollectDraws(const rabbitMat4f& instanceMatrix, std::vector<PrimitiveDraw>& draws, IndexedIndirectBuffer* indirectBuffer) const;
+	//fills indirect commands of the draw and records it, draws of different command buffers can be recorded in parallel.
+	//index type bound in command buffer is tracked by caller, BindBuffers binds 16 bit indices
+	void RecordDraw(VulkanCommandBuffer& commandBuffer, const VulkanPipelineLayout* pipelineLayout, const PrimitiveDraw& draw, uint8_t backBufferIndex, IndexedIndirectBuffer* indirectBuffer, bool& bound16BitIndices) const;
+	void BindBuffers(VulkanCommandBuffer& commandBuffer) const;
+	void BindIndexBuffer(VulkanCommandBuffer& commandBuffer, bool use16BitIndices, bool& bound16BitIndices) const;
+	uint32_t GetVertexIndex(const void* indexBufferData, const Primitive& primitive, uint32_t index) const;
+};
+//placement of a shared model in the scene, instances of the same model cost only their transforms
+struct ModelInstance
+{
+	std::shared_ptr<VulkanglTFModel>	model;
+	rabbitMat4f							transform = rabbitMat4f(1.f);
+};
@@ -0,0 +1,409 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "SceneBake.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <type_traits>
+
+#include <crc32/Crc32.h>
+#include "tinygltf/json.hpp"
+
+#include "KTX2.h"
+#include "Model.h"
+#include "Utils/utils.h"
+
+static_assert(std::is_trivially_copyable_v<Meshlet>, "Meshlets are baked as raw memory");
+
+namespace SceneBake
+{
+	//uris of external buffers and images, embedded data is part of the glTF bytes already
+	static std::vector<std::string> GetReferencedUris(const Utils::MappedFile& source)
+	{
+		const uint8_t* json = source.GetData();
+		size_t jsonSize = source.GetSize();
+
+		//binary glTF has a 12 byte header followed by the json chunk
+		if (jsonSize >= 20 && memcmp(json, "glTF", 4) == 0)
+		{
+			uint32_t chunkLength = 0;
+			memcpy(&chunkLength, json + 12, sizeof(uint32_t));
+			json += 20;
+			jsonSize = std::min<size_t>(chunkLength, jsonSize - 20);
+		}
+
+		std::vector<std::string> uris;
+
+		nlohmann::json document = nlohmann::json::parse(json, json + jsonSize, nullptr, false);
+		if (document.is_discarded())
+		{
+			return uris;
+		}
+
+		for (const char* section : { "buffers", "images" })
+		{
+			auto entries = document.find(section);
+			if (entries == document.end() || !entries->is_array())
+			{
+				continue;
+			}
+
+			for (const nlohmann::json& entry : *entries)
+			{
+				auto uri = entry.find("uri");
+				if (uri != entry.end() && uri->is_string() && uri->get<std::string>().rfind("data:", 0) != 0)
+				{
+					uris.push_back(uri->get<std::string>());
+				}
+			}
+		}
+
+		return uris;
+	}
+
+	uint32_t ComputeSourceHash(const std::string& sourcePath)
+	{
+		Utils::MappedFile source(sourcePath);
+		if (!source.IsValid())
+		{
+			return 0;
+		}
+
+		uint32_t hash = crc32_fast(source.GetData(), source.GetSize());
+
+		//uris resolve against directory of the glTF the same way loader resolves them
+		const std::filesystem::path sourceDirectory = std::filesystem::path(sourcePath).parent_path();
+		for (const std::string& uri : GetReferencedUris(source))
+		{
+			//missing file changes the hash once it shows up
+			Utils::MappedFile file((sourceDirectory / uri).string());
+			if (file.IsValid())
+			{
+				hash = crc32_fast(file.GetData(), file.GetSize(), hash);
+			}
+		}
+
+		return hash;
+	}
+
+	std::string GetBakeName(const std::string& sourcePath)
+	{
+		const std::filesystem::path path = std::filesystem::absolute(sourcePath).lexically_normal();
+		const std::string key = path.generic_string();
+
+		return std::format("{}_{:08x}", path.stem().string(), crc32_fast(key.data(), key.size()));
+	}
+
+	std::string GetBakedScenePath(const std::string& bakeName)
+	{
+		return std::format("res/bakedscenes/{}.bin", bakeName);
+	}
+
+	std::string GetBakedTexturePath(const std::string& bakeName, uint32_t imageIndex)
+	{
+		return std::format("res/bakedscenes/{}_{}.ktx2", bakeName, imageIndex);
+	}
+
+	void Writer::WriteBytes(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		m_Data.insert(m_Data.end(), bytes, bytes + size);
+	}
+
+	uint64_t Writer::Align(uint64_t alignment)
+	{
+		m_Data.resize((m_Data.size() + alignment - 1) & ~(alignment - 1), 0);
+		return m_Data.size();
+	}
+
+	bool Writer::SaveToFile(const std::string& path) const
+	{
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+
+		FILE* file = nullptr;
+		if (fopen_s(&file, path.c_str(), "wb") != 0)
+		{
+			return false;
+		}
+
+		bool written = std::fwrite(m_Data.data(), 1, m_Data.size(), file) == m_Data.size();
+		std::fclose(file);
+		return written;
+	}
+
+	const uint8_t* Reader::ReadBytes(size_t size)
+	{
+		if (!m_Valid || size > m_Size - m_Offset)
+		{
+			m_Valid = false;
+			return nullptr;
+		}
+
+		const uint8_t* bytes = m_Data + m_Offset;
+		m_Offset += size;
+		return bytes;
+	}
+
+	std::string Reader::ReadString(size_t length)
+	{
+		const uint8_t* bytes = ReadBytes(length);
+		return bytes ? std::string(reinterpret_cast<const char*>(bytes), length) : std::string();
+	}
+}
+
+void VulkanglTFModel::WriteBakedScene(const std::string& bakedScenePath, uint32_t sourceHash, const tinygltf::Model& input, const std::string& bakeName,
+	const void* vertexData, size_t vertexDataSize, const void* indexData, size_t indexDataSize) const
+{
+	SceneBake::Writer writer;
+
+	SceneBake::Header header{};
+	header.magic = SceneBake::Magic;
+	header.version = SceneBake::Version;
+	header.sourceHash = sourceHash;
+	header.vertexLayout = static_cast<uint32_t>(m_VertexLayout);
+	header.indexCount = m_IndexCount;
+	header.imageCount = static_cast<uint32_t>(input.images.size());
+	header.textureCount = static_cast<uint32_t>(m_TextureIndices.size());
+	header.materialCount = static_cast<uint32_t>(m_Materials.size());
+	header.rootNodeCount = static_cast<uint32_t>(m_Nodes.size());
+	header.blockCompressedTextures = m_Renderer->GetVulkanDevice().IsBlockCompressionSupported();
+	header.index32Offset = m_Index32Offset;
+	writer.Write(header);
+
+	//images are already baked to KTX2 by LoadImages, scene only references them
+	for (uint32_t imageIndex = 0; imageIndex < header.imageCount; imageIndex++)
+	{
+		const std::string& imageName = input.images[imageIndex].name;
+		const std::string texturePath = SceneBake::GetBakedTexturePath(bakeName, imageIndex);
+
+		SceneBake::Image image{};
+		image.nameLength = static_cast<uint32_t>(imageName.size());
+		image.pathLength = static_cast<uint32_t>(texturePath.size());
+		image.contentHash = m_TextureSources[imageIndex].contentHash;
+		writer.Write(image);
+		writer.WriteString(imageName);
+		writer.WriteString(texturePath);
+	}
+
+	writer.WriteBytes(m_TextureIndices.data(), m_TextureIndices.size() * sizeof(uint32_t));
+
+	for (const Material& material : m_Materials)
+	{
+		SceneBake::Material bakedMaterial{};
+		bakedMaterial.baseColorFactor = material.baseColorFactor;
+		bakedMaterial.emissiveColorAndStrenght = material.emissiveColorAndStrenght;
+		bakedMaterial.baseColorTextureIndex = material.baseColorTextureIndex;
+		bakedMaterial.normalTextureIndex = material.normalTextureIndex;
+		bakedMaterial.metallicRoughnessTextureIndex = material.metallicRoughnessTextureIndex;
+		writer.Write(bakedMaterial);
+	}
+
+	auto writeNode = [&](auto& self, const Node& node) -> void
+	{
+		SceneBake::Node bakedNode{};
+		bakedNode.matrix = node.matrix;
+		bakedNode.bboxMin = node.bbox.bounds[0];
+		bakedNode.bboxMax = node.bbox.bounds[1];
+		bakedNode.childCount = static_cast<uint32_t>(node.children.size());
+		bakedNode.primitiveCount = static_cast<uint32_t>(node.mesh.primitives.size());
+		writer.Write(bakedNode);
+
+		for (const Primitive& primitive : node.mesh.primitives)
+		{
+			SceneBake::Primitive bakedPrimitive{};
+			bakedPrimitive.materialIndex = primitive.materialIndex;
+			bakedPrimitive.firstVertex = primitive.firstVertex;
+			bakedPrimitive.vertexCount = primitive.vertexCount;
+			bakedPrimitive.use16BitIndices = primitive.use16BitIndices;
+			bakedPrimitive.bboxMin = primitive.bbox.bounds[0];
+			bakedPrimitive.bboxMax = primitive.bbox.bounds[1];
+			bakedPrimitive.lodCount = static_cast<uint32_t>(primitive.lods.size());
+			writer.Write(bakedPrimitive);
+
+			for (const PrimitiveLod& lod : primitive.lods)
+			{
+				SceneBake::Lod bakedLod{};
+				bakedLod.firstIndex = lod.firstIndex;
+				bakedLod.indexCount = lod.indexCount;
+				bakedLod.error = lod.error;
+				bakedLod.meshletCount = static_cast<uint32_t>(lod.meshlets.size());
+				writer.Write(bakedLod);
+				writer.WriteBytes(lod.meshlets.data(), lod.meshlets.size() * sizeof(Meshlet));
+			}
+		}
+
+		for (const Node& child : node.children)
+		{
+			self(self, child);
+		}
+	};
+
+	for (const Node& node : m_Nodes)
+	{
+		writeNode(writeNode, node);
+	}
+
+	header.vertexDataOffset = writer.Align(SceneBake::BlobAlignment);
+	header.vertexDataSize = vertexDataSize;
+	writer.WriteBytes(vertexData, vertexDataSize);
+
+	header.indexDataOffset = writer.Align(SceneBake::BlobAlignment);
+	header.indexDataSize = indexDataSize;
+	writer.WriteBytes(indexData, indexDataSize);
+
+	writer.Patch(0, header);
+
+	if (!writer.SaveToFile(bakedScenePath))
+	{
+		LOG_WARNING("Could not write baked scene " + bakedScenePath);
+	}
+}
+
+bool VulkanglTFModel::LoadBakedScene(const std::string& bakedScenePath, uint32_t sourceHash)
+{
+	auto bakedScene = std::make_unique<Utils::MappedFile>(bakedScenePath);
+	if (!bakedScene->IsValid())
+	{
+		return false;
+	}
+
+	SceneBake::Reader reader(bakedScene->GetData(), bakedScene->GetSize());
+	SceneBake::Header header = reader.Read<SceneBake::Header>();
+
+	//textures baked without block compression are rebuilt once device supports it and the other way around
+	if (!reader.IsValid() || header.magic != SceneBake::Magic || header.version != SceneBake::Version ||
+		header.sourceHash != sourceHash || header.vertexLayout != static_cast<uint32_t>(m_VertexLayout) ||
+		(header.blockCompressedTextures != 0) != m_Renderer->GetVulkanDevice().IsBlockCompressionSupported())
+	{
+		return false;
+	}
+
+	if (header.vertexDataOffset + header.vertexDataSize > bakedScene->GetSize() || header.indexDataOffset + header.indexDataSize > bakedScene->GetSize())
+	{
+		return false;
+	}
+
+	//everything is read into locals first, so a broken file falls back to glTF without leaving half loaded model
+	struct ImageSource
+	{
+		std::string		name;
+		std::string		path;
+		Utils::Hash128	contentHash;
+	};
+
+	std::vector<ImageSource> images(header.imageCount);
+	for (ImageSource& image : images)
+	{
+		SceneBake::Image bakedImage = reader.Read<SceneBake::Image>();
+		image.name = reader.ReadString(bakedImage.nameLength);
+		image.path = reader.ReadString(bakedImage.pathLength);
+		image.contentHash = bakedImage.contentHash;
+	}
+
+	std::vector<uint32_t> textureIndices(header.textureCount);
+	for (uint32_t& textureIndex : textureIndices)
+	{
+		textureIndex = reader.Read<uint32_t>();
+	}
+
+	std::vector<Material> materials(header.materialCount);
+	for (Material& material : materials)
+	{
+		SceneBake::Material bakedMaterial = reader.Read<SceneBake::Material>();
+		material.baseColorFactor = bakedMaterial.baseColorFactor;
+		material.emissiveColorAndStrenght = bakedMaterial.emissiveColorAndStrenght;
+		material.baseColorTextureIndex = bakedMaterial.baseColorTextureIndex;
+		material.normalTextureIndex = bakedMaterial.normalTextureIndex;
+		material.metallicRoughnessTextureIndex = bakedMaterial.metallicRoughnessTextureIndex;
+	}
+
+	auto readNode = [&](auto& self, Node& node) -> void
+	{
+		SceneBake::Node bakedNode = reader.Read<SceneBake::Node>();
+		if (!reader.IsValid())
+		{
+			return;
+		}
+
+		node.parent = nullptr;
+		node.matrix = bakedNode.matrix;
+		node.bbox = { bakedNode.bboxMin, bakedNode.bboxMax };
+		node.mesh.primitives.resize(bakedNode.primitiveCount);
+
+		for (Primitive& primitive : node.mesh.primitives)
+		{
+			SceneBake::Primitive bakedPrimitive = reader.Read<SceneBake::Primitive>();
+			primitive.materialIndex = bakedPrimitive.materialIndex;
+			primitive.firstVertex = bakedPrimitive.firstVertex;
+			primitive.vertexCount = bakedPrimitive.vertexCount;
+			primitive.use16BitIndices = bakedPrimitive.use16BitIndices != 0;
+			primitive.bbox = { bakedPrimitive.bboxMin, bakedPrimitive.bboxMax };
+			primitive.lods.resize(bakedPrimitive.lodCount);
+
+			for (PrimitiveLod& lod : primitive.lods)
+			{
+				SceneBake::Lod bakedLod = reader.Read<SceneBake::Lod>();
+				lod.firstIndex = bakedLod.firstIndex;
+				lod.indexCount = bakedLod.indexCount;
+				lod.error = bakedLod.error;
+
+				if (const uint8_t* meshlets = reader.ReadBytes(static_cast<size_t>(bakedLod.meshletCount) * sizeof(Meshlet)))
+				{
+					lod.meshlets.resize(bakedLod.meshletCount);
+					memcpy(lod.meshlets.data(), meshlets, lod.meshlets.size() * sizeof(Meshlet));
+				}
+			}
+		}
+
+		node.children.resize(bakedNode.childCount);
+		for (Node& child : node.children)
+		{
+			self(self, child);
+		}
+	};
+
+	std::vector<Node> nodes(header.rootNodeCount);
+	for (Node& node : nodes)
+	{
+		readNode(readNode, node);
+	}
+
+	if (!reader.IsValid())
+	{
+		LOG_WARNING("Baked scene " + bakedScenePath + " is corrupted, loading glTF instead");
+		return false;
+	}
+
+	//textures are streamed from mapped KTX2 files, every one of them is validated before anything is created
+	std::vector<TextureSource> textureSources(images.size());
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		textureSources[i].name = images[i].name;
+		textureSources[i].contentHash = images[i].contentHash;
+		textureSources[i].file = std::make_unique<Utils::MappedFile>(images[i].path);
+		if (!textureSources[i].file->IsValid() || !KTX2::Read(textureSources[i].file->GetData(), textureSources[i].file->GetSize(), textureSources[i].view))
+		{
+			LOG_WARNING("Baked texture " + images[i].path + " is missing or corrupted, loading glTF instead");
+			return false;
+		}
+	}
+
+	m_TextureSources = std::move(textureSources);
+	m_TextureIndices = std::move(textureIndices);
+	m_Materials = std::move(materials);
+	m_Nodes = std::move(nodes);
+	m_IndexCount = header.indexCount;
+	m_Index32Offset = header.index32Offset;
+
+	//blobs are uploaded straight from the mapped file, it stays mapped until buffers are created on the main thread
+	const uint8_t* bakedData = bakedScene->GetData();
+	m_GeometrySource.vertexData = bakedData + header.vertexDataOffset;
+	m_GeometrySource.vertexDataSize = header.vertexDataSize;
+	m_GeometrySource.indexData = bakedData + header.indexDataOffset;
+	m_GeometrySource.indexDataSize = header.indexDataSize;
+	m_GeometrySource.file = std::move(bakedScene);
+
+	return true;
+}
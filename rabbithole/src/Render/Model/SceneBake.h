@@ -0,0 +1,142 @@
+#pragma once
+
+#include "common.h"
+#include "Utils/utils.h"
+
+#include <string>
+#include <vector>
+
+//baked scene is a flat binary written after the first glTF import. it holds everything the loader produces, so
+//next start maps the file and copies vertex and index blobs straight to the gpu, without parsing or processing
+namespace SceneBake
+{
+	constexpr uint32_t Magic = 0x4e435352; //"RSCN"
+	//bump whenever import processing or any baked struct changes, old files are rebuilt
+	constexpr uint32_t Version = 5;
+	//blobs are aligned so they can be read in place
+	constexpr uint64_t BlobAlignment = 16;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t sourceHash;
+		uint32_t vertexLayout;
+		uint32_t indexCount;
+		uint32_t imageCount;
+		uint32_t textureCount;
+		uint32_t materialCount;
+		uint32_t rootNodeCount;
+		//zero when textures were baked for a device without bc support and hold uncompressed mips
+		uint32_t blockCompressedTextures;
+		uint64_t index32Offset;
+		uint64_t vertexDataOffset;
+		uint64_t vertexDataSize;
+		uint64_t indexDataOffset;
+		uint64_t indexDataSize;
+	};
+
+	//followed by nameLength chars of the name and pathLength chars of the path to its baked KTX2 texture
+	struct Image
+	{
+		uint32_t nameLength;
+		uint32_t pathLength;
+		Utils::Hash128 contentHash; //textures with the same hash are shared between scenes
+	};
+
+	struct Material
+	{
+		rabbitVec4f baseColorFactor;
+		rabbitVec4f emissiveColorAndStrenght;
+		uint32_t	baseColorTextureIndex;
+		uint32_t	normalTextureIndex;
+		uint32_t	metallicRoughnessTextureIndex;
+	};
+
+	//nodes are stored depth first, every node is followed by its primitives and then by its children
+	struct Node
+	{
+		rabbitMat4f matrix;
+		rabbitVec3f bboxMin;
+		rabbitVec3f bboxMax;
+		uint32_t	childCount;
+		uint32_t	primitiveCount;
+	};
+
+	//followed by lodCount lods
+	struct Primitive
+	{
+		int32_t		materialIndex;
+		uint32_t	firstVertex;
+		uint32_t	vertexCount;
+		uint32_t	use16BitIndices;
+		rabbitVec3f bboxMin;
+		rabbitVec3f bboxMax;
+		uint32_t	lodCount;
+	};
+
+	//followed by meshletCount meshlets
+	struct Lod
+	{
+		uint32_t	firstIndex;
+		uint32_t	indexCount;
+		float		error;
+		uint32_t	meshletCount;
+	};
+
+	//hash of the source file and of every buffer and image file it references, baked scene is valid only for the exact
+	//files it was made from
+	uint32_t ComputeSourceHash(const std::string& sourcePath);
+	//file name with hash of the full source path, scenes with the same name in different directories are baked apart
+	std::string GetBakeName(const std::string& sourcePath);
+	std::string GetBakedScenePath(const std::string& bakeName);
+	std::string GetBakedTexturePath(const std::string& bakeName, uint32_t imageIndex);
+
+	class Writer
+	{
+	public:
+		template<typename T>
+		void Write(const T& value) { WriteBytes(&value, sizeof(T)); }
+		void WriteBytes(const void* data, size_t size);
+		void WriteString(const std::string& value) { WriteBytes(value.data(), value.size()); }
+		uint64_t Align(uint64_t alignment);
+
+		template<typename T>
+		void Patch(uint64_t offset, const T& value) { memcpy(m_Data.data() + offset, &value, sizeof(T)); }
+
+		bool SaveToFile(const std::string& path) const;
+
+		inline uint64_t GetSize() const { return m_Data.size(); }
+
+	private:
+		std::vector<uint8_t> m_Data;
+	};
+
+	class Reader
+	{
+	public:
+		Reader(const uint8_t* data, size_t size) : m_Data(data), m_Size(size) {}
+
+		//reads are bounds checked, reader stays invalid after the first one that would go past the end
+		template<typename T>
+		T Read()
+		{
+			T value{};
+			if (const uint8_t* bytes = ReadBytes(sizeof(T)))
+			{
+				memcpy(&value, bytes, sizeof(T));
+			}
+			return value;
+		}
+		const uint8_t* ReadBytes(size_t size);
+		std::string ReadString(size_t length);
+
+		inline bool IsValid() const { return m_Valid; }
+
+	private:
+		const uint8_t*	m_Data;
+		size_t			m_Size;
+		size_t			m_Offset = 0;
+		bool			m_Valid = true;
+	};
+}
@@ -0,0 +1,691 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+
+#include "Core/JobSystem.h"
+#include "Render/Converters.h"
+
+namespace TextureCompression
+{
+	constexpr uint32_t blockTexelCount = 16;
+	constexpr uint32_t powerIterationCount = 8;
+
+	//bc7 interpolation weights for 4 bit indices, out of 64
+	static const uint32_t bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	using BlockTexels = float[blockTexelCount][4];
+
+	//bits are written from the lowest bit of the first byte onwards, output has to be zeroed
+	struct BlockWriter
+	{
+		uint8_t*	output;
+		uint32_t	bitOffset = 0;
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; bit++, bitOffset++)
+			{
+				if ((value >> bit) & 1)
+				{
+					output[bitOffset / 8] |= static_cast<uint8_t>(1 << (bitOffset % 8));
+				}
+			}
+		}
+	};
+
+	static void LoadBlock(const uint8_t* texels, BlockTexels& output)
+	{
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				output[i][c] = static_cast<float>(texels[i * 4 + c]);
+			}
+		}
+	}
+
+	//endpoints are the extremes of the block along the direction of its largest variance
+	static void ComputeEndpoints(const BlockTexels& texels, uint32_t channelCount, float endpoint0[4], float endpoint1[4])
+	{
+		float mean[4] = {};
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				mean[c] += texels[i][c] / blockTexelCount;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			for (uint32_t c0 = 0; c0 < channelCount; c0++)
+			{
+				for (uint32_t c1 = 0; c1 < channelCount; c1++)
+				{
+					covariance[c0][c1] += (texels[i][c0] - mean[c0]) * (texels[i][c1] - mean[c1]);
+				}
+			}
+		}
+
+		//power iteration starts from the channel with the largest variance, so it can't start orthogonal to the axis
+		uint32_t largestChannel = 0;
+		for (uint32_t c = 1; c < channelCount; c++)
+		{
+			largestChannel = covariance[c][c] > covariance[largestChannel][largestChannel] ? c : largestChannel;
+		}
+
+		float axis[4] = {};
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			axis[c] = covariance[largestChannel][c];
+		}
+
+		for (uint32_t iteration = 0; iteration < powerIterationCount; iteration++)
+		{
+			float nextAxis[4] = {};
+			float length = 0.f;
+			for (uint32_t c0 = 0; c0 < channelCount; c0++)
+			{
+				for (uint32_t c1 = 0; c1 < channelCount; c1++)
+				{
+					nextAxis[c0] += covariance[c0][c1] * axis[c1];
+				}
+				length += nextAxis[c0] * nextAxis[c0];
+			}
+
+			//solid block, both endpoints end up at the mean
+			if (length < FLT_EPSILON)
+			{
+				std::fill(axis, axis + 4, 0.f);
+				break;
+			}
+
+			length = std::sqrt(length);
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				axis[c] = nextAxis[c] / length;
+			}
+		}
+
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			float projection = 0.f;
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				projection += (texels[i][c] - mean[c]) * axis[c];
+			}
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			endpoint0[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.f, 255.f);
+			endpoint1[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.f, 255.f);
+		}
+	}
+
+	//least squares fit of endpoints once indices are chosen, weights are the share of the second endpoint
+	static bool RefineEndpoints(const BlockTexels& texels, uint32_t channelCount, const float weights[blockTexelCount], float endpoint0[4], float endpoint1[4])
+	{
+		float a = 0.f, b = 0.f, c = 0.f;
+		float rhs0[4] = {};
+		float rhs1[4] = {};
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			float w = weights[i];
+			a += (1.f - w) * (1.f - w);
+			b += (1.f - w) * w;
+			c += w * w;
+			for (uint32_t channel = 0; channel < channelCount; channel++)
+			{
+				rhs0[channel] += (1.f - w) * texels[i][channel];
+				rhs1[channel] += w * texels[i][channel];
+			}
+		}
+
+		float determinant = a * c - b * b;
+		if (std::abs(determinant) < FLT_EPSILON)
+		{
+			return false;
+		}
+
+		for (uint32_t channel = 0; channel < channelCount; channel++)
+		{
+			endpoint0[channel] = std::clamp((c * rhs0[channel] - b * rhs1[channel]) / determinant, 0.f, 255.f);
+			endpoint1[channel] = std::clamp((a * rhs1[channel] - b * rhs0[channel]) / determinant, 0.f, 255.f);
+		}
+		return true;
+	}
+
+	static uint16_t PackRGB565(const float color[4])
+	{
+		uint32_t r = static_cast<uint32_t>(color[0] * 31.f / 255.f + 0.5f);
+		uint32_t g = static_cast<uint32_t>(color[1] * 63.f / 255.f + 0.5f);
+		uint32_t b = static_cast<uint32_t>(color[2] * 31.f / 255.f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRGB565(uint16_t packed, float color[3])
+	{
+		uint32_t r = (packed >> 11) & 31;
+		uint32_t g = (packed >> 5) & 63;
+		uint32_t b = packed & 31;
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+	}
+
+	//four color mode, color0 has to be larger than color1. with equal colors every texel picks index 0
+	static float FindBC1Indices(const BlockTexels& texels, uint16_t color0, uint16_t color1, uint32_t& indices)
+	{
+		float palette[4][3];
+		UnpackRGB565(color0, palette[0]);
+		UnpackRGB565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+			palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+		}
+
+		float totalError = 0.f;
+		indices = 0;
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			float bestError = FLT_MAX;
+			uint32_t bestIndex = 0;
+			for (uint32_t index = 0; index < 4; index++)
+			{
+				float error = 0.f;
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					float difference = texels[i][c] - palette[index][c];
+					error += difference * difference;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = index;
+				}
+			}
+
+			indices |= bestIndex << (i * 2);
+			totalError += bestError;
+		}
+
+		return totalError;
+	}
+
+	void EncodeBC1Block(const uint8_t* texels, uint8_t* output)
+	{
+		BlockTexels block;
+		LoadBlock(texels, block);
+
+		float endpoint0[4], endpoint1[4];
+		ComputeEndpoints(block, 3, endpoint0, endpoint1);
+
+		auto encode = [&block](const float* first, const float* second, uint16_t& color0, uint16_t& color1, uint32_t& indices)
+		{
+			color0 = PackRGB565(first);
+			color1 = PackRGB565(second);
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+			}
+			return FindBC1Indices(block, color0, color1, indices);
+		};
+
+		uint16_t color0, color1;
+		uint32_t indices;
+		float error = encode(endpoint1, endpoint0, color0, color1, indices);
+
+		//index order is 0, 1, 1/3, 2/3 of the way from color0 to color1
+		static const float bc1Weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+		float weights[blockTexelCount];
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			weights[i] = bc1Weights[(indices >> (i * 2)) & 3];
+		}
+
+		float refinedEndpoint0[4], refinedEndpoint1[4];
+		if (RefineEndpoints(block, 3, weights, refinedEndpoint0, refinedEndpoint1))
+		{
+			uint16_t refinedColor0, refinedColor1;
+			uint32_t refinedIndices;
+			if (encode(refinedEndpoint0, refinedEndpoint1, refinedColor0, refinedColor1, refinedIndices) < error)
+			{
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				indices = refinedIndices;
+			}
+		}
+
+		memcpy(output, &color0, sizeof(uint16_t));
+		memcpy(output + 2, &color1, sizeof(uint16_t));
+		memcpy(output + 4, &indices, sizeof(uint32_t));
+	}
+
+	void EncodeBC4Block(const uint8_t* texels, uint32_t channel, uint8_t* output)
+	{
+		uint8_t minValue = 255;
+		uint8_t maxValue = 0;
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			minValue = std::min(minValue, texels[i * 4 + channel]);
+			maxValue = std::max(maxValue, texels[i * 4 + channel]);
+		}
+
+		//eight value mode, first endpoint has to be larger. with equal endpoints every texel picks index 0
+		float palette[8];
+		palette[0] = maxValue;
+		palette[1] = minValue;
+		for (uint32_t step = 1; step < 7; step++)
+		{
+			palette[step + 1] = ((7 - step) * palette[0] + step * palette[1]) / 7.f;
+		}
+
+		uint64_t bits = static_cast<uint64_t>(maxValue) | (static_cast<uint64_t>(minValue) << 8);
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			float value = texels[i * 4 + channel];
+			uint32_t bestIndex = 0;
+			for (uint32_t index = 1; index < 8; index++)
+			{
+				if (std::abs(value - palette[index]) < std::abs(value - palette[bestIndex]))
+				{
+					bestIndex = index;
+				}
+			}
+			bits |= static_cast<uint64_t>(bestIndex) << (16 + i * 3);
+		}
+
+		memcpy(output, &bits, sizeof(uint64_t));
+	}
+
+	void EncodeBC5Block(const uint8_t* texels, uint8_t* output)
+	{
+		EncodeBC4Block(texels, 0, output);
+		EncodeBC4Block(texels, 1, output + 8);
+	}
+
+	//7 bit endpoint with shared lowest bit, p bit is picked per endpoint so it rounds the best
+	static void QuantizeBC7Endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t& pbit)
+	{
+		float bestError = FLT_MAX;
+		for (uint32_t candidatePbit = 0; candidatePbit < 2; candidatePbit++)
+		{
+			uint32_t candidate[4];
+			float error = 0.f;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				candidate[c] = static_cast<uint32_t>(std::clamp(std::round((endpoint[c] - candidatePbit) / 2.f), 0.f, 127.f));
+				float difference = static_cast<float>((candidate[c] << 1) | candidatePbit) - endpoint[c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pbit = candidatePbit;
+				std::copy(candidate, candidate + 4, quantized);
+			}
+		}
+	}
+
+	static float FindBC7Indices(const BlockTexels& texels, const uint32_t quantized[2][4], const uint32_t pbits[2], uint32_t indices[blockTexelCount])
+	{
+		float palette[16][4];
+		for (uint32_t index = 0; index < 16; index++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				uint32_t endpoint0 = (quantized[0][c] << 1) | pbits[0];
+				uint32_t endpoint1 = (quantized[1][c] << 1) | pbits[1];
+				palette[index][c] = static_cast<float>(((64 - bc7Weights[index]) * endpoint0 + bc7Weights[index] * endpoint1 + 32) >> 6);
+			}
+		}
+
+		float totalError = 0.f;
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			float bestError = FLT_MAX;
+			for (uint32_t index = 0; index < 16; index++)
+			{
+				float error = 0.f;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					float difference = texels[i][c] - palette[index][c];
+					error += difference * difference;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[i] = index;
+				}
+			}
+			totalError += bestError;
+		}
+
+		return totalError;
+	}
+
+	void EncodeBC7Block(const uint8_t* texels, uint8_t* output)
+	{
+		BlockTexels block;
+		LoadBlock(texels, block);
+
+		float endpoint0[4], endpoint1[4];
+		ComputeEndpoints(block, 4, endpoint0, endpoint1);
+
+		uint32_t quantized[2][4];
+		uint32_t pbits[2];
+		uint32_t indices[blockTexelCount];
+		QuantizeBC7Endpoint(endpoint0, quantized[0], pbits[0]);
+		QuantizeBC7Endpoint(endpoint1, quantized[1], pbits[1]);
+		float error = FindBC7Indices(block, quantized, pbits, indices);
+
+		float weights[blockTexelCount];
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			weights[i] = bc7Weights[indices[i]] / 64.f;
+		}
+
+		if (RefineEndpoints(block, 4, weights, endpoint0, endpoint1))
+		{
+			uint32_t refinedQuantized[2][4];
+			uint32_t refinedPbits[2];
+			uint32_t refinedIndices[blockTexelCount];
+			QuantizeBC7Endpoint(endpoint0, refinedQuantized[0], refinedPbits[0]);
+			QuantizeBC7Endpoint(endpoint1, refinedQuantized[1], refinedPbits[1]);
+
+			if (FindBC7Indices(block, refinedQuantized, refinedPbits, refinedIndices) < error)
+			{
+				memcpy(quantized, refinedQuantized, sizeof(quantized));
+				memcpy(pbits, refinedPbits, sizeof(pbits));
+				memcpy(indices, refinedIndices, sizeof(indices));
+			}
+		}
+
+		//index of the first texel is stored without its top bit, endpoints are swapped so that bit is zero
+		if (indices[0] & 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pbits[0], pbits[1]);
+			for (uint32_t& index : indices)
+			{
+				index = 15 - index;
+			}
+		}
+
+		memset(output, 0, 16);
+		BlockWriter writer{ output };
+		writer.Write(1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			writer.Write(quantized[0][c], 7);
+			writer.Write(quantized[1][c], 7);
+		}
+		writer.Write(pbits[0], 1);
+		writer.Write(pbits[1], 1);
+		for (uint32_t i = 0; i < blockTexelCount; i++)
+		{
+			writer.Write(indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	static float SRGBToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float LinearToSRGB(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+	}
+
+	//2x2 box filter, odd sizes repeat the last row and column. color is averaged in linear space, normals are
+	//renormalized after averaging
+	static void DownsampleMip(const uint8_t* source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* destination, uint32_t width, uint32_t height, TextureUsage usage)
+	{
+		static const auto srgbToLinear = []()
+			{
+				std::array<float, 256> table;
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					table[i] = SRGBToLinear(i / 255.f);
+				}
+				return table;
+			}();
+
+		const bool isColor = usage == TextureUsage::Color;
+		const bool isNormalMap = usage == TextureUsage::Normal;
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const uint32_t sourceX[2] = { std::min(x * 2, sourceWidth - 1), std::min(x * 2 + 1, sourceWidth - 1) };
+				const uint32_t sourceY[2] = { std::min(y * 2, sourceHeight - 1), std::min(y * 2 + 1, sourceHeight - 1) };
+
+				float sum[4] = {};
+				for (uint32_t sy : sourceY)
+				{
+					for (uint32_t sx : sourceX)
+					{
+						const uint8_t* texel = &source[(static_cast<size_t>(sy) * sourceWidth + sx) * 4];
+						for (uint32_t c = 0; c < 4; c++)
+						{
+							sum[c] += isColor && c < 3 ? srgbToLinear[texel[c]] * 255.f : texel[c];
+						}
+					}
+				}
+
+				uint8_t* output = &destination[(static_cast<size_t>(y) * width + x) * 4];
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					output[c] = static_cast<uint8_t>(sum[c] / 4.f + 0.5f);
+				}
+
+				if (isColor)
+				{
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						output[c] = static_cast<uint8_t>(std::clamp(LinearToSRGB(sum[c] / (4.f * 255.f)) * 255.f + 0.5f, 0.f, 255.f));
+					}
+				}
+
+				if (isNormalMap)
+				{
+					float normal[3];
+					float length = 0.f;
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						normal[c] = sum[c] / (4.f * 127.5f) - 1.f;
+						length += normal[c] * normal[c];
+					}
+
+					length = std::sqrt(length);
+					for (uint32_t c = 0; c < 3 && length > FLT_EPSILON; c++)
+					{
+						output[c] = static_cast<uint8_t>(std::clamp((normal[c] / length * 0.5f + 0.5f) * 255.f + 0.5f, 0.f, 255.f));
+					}
+				}
+			}
+		}
+	}
+
+	//part of texels that pass the alpha test with alpha scaled by scale
+	static float GetAlphaCoverage(const std::vector<uint8_t>& rgba, float alphaCutoff, float scale)
+	{
+		const size_t texelCount = rgba.size() / 4;
+		size_t coveredCount = 0;
+		for (size_t i = 0; i < texelCount; i++)
+		{
+			coveredCount += rgba[i * 4 + 3] / 255.f * scale >= alphaCutoff;
+		}
+		return static_cast<float>(coveredCount) / texelCount;
+	}
+
+	//averaged alpha fades below the cutoff and alpha tested surfaces thin out with distance, so alpha is scaled until
+	//mip passes the test for the same part of texels as mip 0
+	static void PreserveAlphaCoverage(std::vector<uint8_t>& rgba, float alphaCutoff, float coverage)
+	{
+		float minScale = 0.f;
+		float maxScale = 4.f;
+		for (uint32_t i = 0; i < ALPHA_COVERAGE_SEARCH_STEPS; i++)
+		{
+			const float scale = (minScale + maxScale) * 0.5f;
+			if (GetAlphaCoverage(rgba, alphaCutoff, scale) < coverage)
+			{
+				minScale = scale;
+			}
+			else
+			{
+				maxScale = scale;
+			}
+		}
+
+		const float scale = (minScale + maxScale) * 0.5f;
+		for (size_t i = 3; i < rgba.size(); i += 4)
+		{
+			rgba[i] = static_cast<uint8_t>(std::min(rgba[i] * scale + 0.5f, 255.f));
+		}
+	}
+
+	static void EncodeMip(const uint8_t* rgba, uint32_t width, uint32_t height, Format format, uint8_t* output)
+	{
+		const uint32_t blockCountX = (width + 3) / 4;
+		const uint32_t blockCountY = (height + 3) / 4;
+		const uint64_t blockSize = GetImageSizeFrom(format, 4, 4);
+
+		//rows of blocks are independent, so one large texture keeps every worker busy
+		JobSystem::instance().ParallelFor(blockCountY, [&](uint32_t blockY)
+			{
+				uint8_t texels[blockTexelCount * 4];
+				for (uint32_t blockX = 0; blockX < blockCountX; blockX++)
+				{
+					//blocks on the edge repeat the last row and column of the mip
+					for (uint32_t texelY = 0; texelY < 4; texelY++)
+					{
+						for (uint32_t texelX = 0; texelX < 4; texelX++)
+						{
+							uint32_t x = std::min(blockX * 4 + texelX, width - 1);
+							uint32_t y = std::min(blockY * 4 + texelY, height - 1);
+							memcpy(&texels[(texelY * 4 + texelX) * 4], &rgba[(static_cast<size_t>(y) * width + x) * 4], 4);
+						}
+					}
+
+					uint8_t* block = output + (static_cast<uint64_t>(blockY) * blockCountX + blockX) * blockSize;
+					switch (format)
+					{
+					case Format::BC1_UNORM:
+						EncodeBC1Block(texels, block);
+						break;
+					case Format::BC4_UNORM:
+						EncodeBC4Block(texels, 0, block);
+						break;
+					case Format::BC5_UNORM:
+						EncodeBC5Block(texels, block);
+						break;
+					case Format::BC7_UNORM:
+						EncodeBC7Block(texels, block);
+						break;
+					default:
+						ASSERT(false, "Format has no block encoder");
+						break;
+					}
+				}
+			});
+	}
+
+	uint64_t MipChain::GetMipOffset(uint32_t mip) const
+	{
+		uint64_t offset = 0;
+		for (uint32_t previousMip = 0; previousMip < mip; previousMip++)
+		{
+			offset += GetMipSize(previousMip);
+		}
+		return offset;
+	}
+
+	uint64_t MipChain::GetMipSize(uint32_t mip) const
+	{
+		return GetImageSizeFrom(format, std::max(width >> mip, 1u), std::max(height >> mip, 1u));
+	}
+
+	Format GetCompressedFormatFor(TextureUsage usage)
+	{
+		switch (usage)
+		{
+		case TextureUsage::Normal:
+			return Format::BC5_UNORM;
+		case TextureUsage::MetallicRoughness:
+			return Format::BC1_UNORM;
+		default:
+			return Format::BC7_UNORM;
+		}
+	}
+
+	void CompressTexture(const uint8_t* rgba, uint32_t width, uint32_t height, TextureUsage usage, float alphaCutoff, bool useBlockCompression, MipChain& output)
+	{
+		output.format = useBlockCompression ? GetCompressedFormatFor(usage) : Format::R8G8B8A8_UNORM;
+		output.width = width;
+		output.height = height;
+		output.mipCount = GET_MIP_LEVELS_FROM_RES(width, height);
+		output.data.assign(output.GetMipOffset(output.mipCount), 0);
+
+		std::vector<uint8_t> mip(rgba, rgba + static_cast<size_t>(width) * height * 4);
+		std::vector<uint8_t> nextMip;
+		std::vector<uint8_t> coverageMip;
+		uint32_t mipWidth = width;
+		uint32_t mipHeight = height;
+
+		const bool preserveCoverage = alphaCutoff > 0.f && usage == TextureUsage::Color;
+		const float coverage = preserveCoverage ? GetAlphaCoverage(mip, alphaCutoff, 1.f) : 0.f;
+
+		for (uint32_t mipIndex = 0; mipIndex < output.mipCount; mipIndex++)
+		{
+			if (mipIndex > 0)
+			{
+				uint32_t nextMipWidth = std::max(mipWidth >> 1, 1u);
+				uint32_t nextMipHeight = std::max(mipHeight >> 1, 1u);
+
+				nextMip.resize(static_cast<size_t>(nextMipWidth) * nextMipHeight * 4);
+				DownsampleMip(mip.data(), mipWidth, mipHeight, nextMip.data(), nextMipWidth, nextMipHeight, usage);
+				mip.swap(nextMip);
+
+				mipWidth = nextMipWidth;
+				mipHeight = nextMipHeight;
+			}
+
+			//scaled alpha is only stored, next mip is still averaged from the unscaled one
+			const std::vector<uint8_t>* storedMip = &mip;
+			if (preserveCoverage && mipIndex > 0)
+			{
+				coverageMip = mip;
+				PreserveAlphaCoverage(coverageMip, alphaCutoff, coverage);
+				storedMip = &coverageMip;
+			}
+
+			uint8_t* destination = output.data.data() + output.GetMipOffset(mipIndex);
+			if (useBlockCompression)
+			{
+				EncodeMip(storedMip->data(), mipWidth, mipHeight, output.format, destination);
+			}
+			else
+			{
+				memcpy(destination, storedMip->data(), storedMip->size());
+			}
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common.h"
+#include "Render/Vulkan/VulkanTypes.h"
+
+#include <vector>
+
+//steps of the binary search for alpha scale that keeps coverage of alpha tested textures
+#define ALPHA_COVERAGE_SEARCH_STEPS 10
+
+//import time encoding of model textures. mips are generated on cpu and every mip is encoded to the block format
+//that suits the way texture is sampled, so gpu gets a complete chain without any runtime processing
+namespace TextureCompression
+{
+	enum class TextureUsage : uint8_t
+	{
+		Color,				//bc7, keeps alpha
+		Normal,				//bc5, only xy is stored, shader reconstructs z
+		MetallicRoughness	//bc1, opaque masks that tolerate lower precision
+	};
+
+	//mips are stored one after another without padding, largest one first
+	struct MipChain
+	{
+		Format					format = Format::UNDEFINED;
+		uint32_t				width = 0;
+		uint32_t				height = 0;
+		uint32_t				mipCount = 0;
+		std::vector<uint8_t>	data;
+
+		uint64_t GetMipOffset(uint32_t mip) const;
+		uint64_t GetMipSize(uint32_t mip) const;
+	};
+
+	Format GetCompressedFormatFor(TextureUsage usage);
+
+	//input is rgba8 with srgb color, without block compression mips are kept as R8G8B8A8_UNORM. alpha tested color
+	//textures pass the cutoff, every mip keeps the alpha test coverage of mip 0. zero cutoff leaves alpha averaged
+	void CompressTexture(const uint8_t* rgba, uint32_t width, uint32_t height, TextureUsage usage, float alphaCutoff, bool useBlockCompression, MipChain& output);
+
+	//block encoders take 4x4 rgba texels, row by row
+	void EncodeBC1Block(const uint8_t* texels, uint8_t* output);
+	void EncodeBC4Block(const uint8_t* texels, uint32_t channel, uint8_t* output);
+	void EncodeBC5Block(const uint8_t* texels, uint8_t* output);
+	//mode 6 only, single subset with 7 bit endpoints and 4 bit indices is a good fit for smooth material textures
+	void EncodeBC7Block(const uint8_t* texels, uint8_t* output);
+}
@@ -51,12 +51,10 @@ namespace TextureLoading
 		if (!data)
 		{
 			// TODO: Move this on some init function and delete if at the engine stop
-			if (!TextureData::INVALID)
-			{
-				unsigned char invalid_color[] = { 0xff, 0x00, 0x33, 0xff };
-				TextureData::INVALID = new TextureData{ invalid_color, 1, 1, 4 };
-			}
-			return TextureData::INVALID;
+			//textures are decoded from worker threads, static init makes creation of fallback thread safe
+			static unsigned char invalid_color[] = { 0xff, 0x00, 0x33, 0xff };
+			static TextureData* invalidTexture = TextureData::INVALID = new TextureData{ invalid_color, 1, 1, 4 };
+			return invalidTexture;
 		}
 
 		return new TextureData{ data, width, height, numChannels };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace TextureLoading
 {
@@ -10,6 +11,8 @@ namespace TextureLoading
 		int width;
 		int height;
 		int bpp;
+		//precomputed mips, largest one first. when empty pData holds only the first mip
+		std::vector<const unsigned char*> mipData;
 
 		static TextureData* INVALID;
 	};
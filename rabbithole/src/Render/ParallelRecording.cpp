@@ -0,0 +1,100 @@
+#include "common.h"
+
+#include "ParallelRecording.h"
+#include "Core/JobSystem.h"
+#include "Logger/Logger.h"
+#include "Render/RenderPass.h"
+#include "Render/Vulkan/VulkanCommandBuffer.h"
+#include "Render/Vulkan/VulkanDevice.h"
+
+#include <algorithm>
+
+void ParallelCommandRecorder::Init(VulkanDevice& device, uint32_t imageCount)
+{
+	m_Device = &device;
+
+	//thread that waits for the jobs executes them as well
+	const uint32_t jobContextCount = std::min(JobSystem::instance().GetWorkerCount() + 1, static_cast<uint32_t>(PARALLEL_RECORDING_MAX_JOBS));
+	m_JobContexts.resize(jobContextCount);
+
+	for (JobContext& jobContext : m_JobContexts)
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = device.GetGraphicsQueueFamily();
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VULKAN_API_CALL(vkCreateCommandPool(device.GetGraphicDevice(), &poolInfo, nullptr, &jobContext.commandPool));
+
+		jobContext.commandBuffers.resize(imageCount);
+	}
+}
+
+void ParallelCommandRecorder::Destroy()
+{
+	for (JobContext& jobContext : m_JobContexts)
+	{
+		jobContext.commandBuffers.clear();
+		vkDestroyCommandPool(m_Device->GetGraphicDevice(), jobContext.commandPool, nullptr);
+	}
+	m_JobContexts.clear();
+}
+
+void ParallelCommandRecorder::BeginFrame(uint32_t imageIndex)
+{
+	m_ImageIndex = imageIndex;
+
+	for (JobContext& jobContext : m_JobContexts)
+	{
+		jobContext.usedCommandBuffers = 0;
+	}
+}
+
+uint32_t ParallelCommandRecorder::GetJobCount(uint32_t drawCount) const
+{
+	const uint32_t jobCount = drawCount / PARALLEL_RECORDING_MIN_DRAWS_PER_JOB;
+	return std::clamp(jobCount, 1u, std::max(static_cast<uint32_t>(m_JobContexts.size()), 1u));
+}
+
+void ParallelCommandRecorder::Record(VulkanCommandBuffer& primaryCommandBuffer, RenderPass& renderPass, uint32_t drawCount, const RecordFunction& record)
+{
+	const uint32_t jobCount = GetJobCount(drawCount);
+	const uint32_t drawsPerJob = (drawCount + jobCount - 1) / jobCount;
+
+	//buffers are taken here, so pools are touched only by the job that records into them
+	m_JobCommandBuffers.clear();
+	for (uint32_t job = 0; job < jobCount; job++)
+	{
+		JobContext& jobContext = m_JobContexts[job];
+		auto& commandBuffers = jobContext.commandBuffers[m_ImageIndex];
+
+		if (jobContext.usedCommandBuffers == commandBuffers.size())
+		{
+			commandBuffers.push_back(std::make_unique<VulkanCommandBuffer>(*m_Device, jobContext.commandPool, "Parallel Recording Command Buffer", VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+		}
+		m_JobCommandBuffers.push_back(commandBuffers[jobContext.usedCommandBuffers++].get());
+	}
+
+	VkRenderPass vkRenderPass = renderPass.GetVulkanRenderPass().GetVkHandle();
+	VkFramebuffer vkFramebuffer = renderPass.GetVulkanFramebuffer().GetVkHandle();
+
+	//high priority jobs are taken before loads and pipeline compiles, and render thread helps only with these
+	JobSystem::instance().ParallelFor(jobCount, [&](uint32_t job)
+		{
+			VulkanCommandBuffer& commandBuffer = *m_JobCommandBuffers[job];
+			const uint32_t firstDraw = job * drawsPerJob;
+			const uint32_t endDraw = std::min(firstDraw + drawsPerJob, drawCount);
+
+			commandBuffer.BeginSecondaryCommandBuffer(vkRenderPass, vkFramebuffer);
+			record(commandBuffer, firstDraw, endDraw);
+			commandBuffer.EndCommandBuffer();
+		}, JobPriority::High);
+
+	m_ExecutedCommandBuffers.clear();
+	for (VulkanCommandBuffer* commandBuffer : m_JobCommandBuffers)
+	{
+		m_ExecutedCommandBuffers.push_back(GET_VK_HANDLE_PTR(commandBuffer));
+	}
+
+	vkCmdExecuteCommands(GET_VK_HANDLE(primaryCommandBuffer), static_cast<uint32_t>(m_ExecutedCommandBuffers.size()), m_ExecutedCommandBuffers.data());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class RenderPass;
+class VulkanCommandBuffer;
+class VulkanDevice;
+
+#define PARALLEL_RECORDING_MAX_JOBS				8
+#define PARALLEL_RECORDING_MIN_DRAWS_PER_JOB	128
+
+//records ranges of draws inside a render pass into secondary command buffers on job system. every job has its own
+//command pool, so jobs never share one, and buffers are executed by the primary command buffer in order of their
+//ranges. secondary buffers inherit nothing but the render pass, recording has to bind its pipeline and dynamic state
+class ParallelCommandRecorder
+{
+public:
+	using RecordFunction = std::function<void(VulkanCommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t endDraw)>;
+
+	void Init(VulkanDevice& device, uint32_t imageCount);
+	void Destroy();
+	void BeginFrame(uint32_t imageIndex);
+
+	//jobs draws are split into, with one they are cheaper to record straight into the primary command buffer
+	uint32_t GetJobCount(uint32_t drawCount) const;
+	//render pass has to be begun with secondary contents
+	void Record(VulkanCommandBuffer& primaryCommandBuffer, RenderPass& renderPass, uint32_t drawCount, const RecordFunction& record);
+
+private:
+	struct JobContext
+	{
+		VkCommandPool	commandPool = VK_NULL_HANDLE;
+
+		//pooled per swapchain image, reused once the frame that used them is finished
+		std::vector<std::vector<std::unique_ptr<VulkanCommandBuffer>>>	commandBuffers;
+		uint32_t														usedCommandBuffers = 0;
+	};
+
+	VulkanDevice*					m_Device = nullptr;
+	uint32_t						m_ImageIndex = 0;
+	std::vector<JobContext>			m_JobContexts;
+	std::vector<VulkanCommandBuffer*>	m_JobCommandBuffers;
+	std::vector<VkCommandBuffer>	m_ExecutedCommandBuffers;
+};
@@ -1,49 +1,119 @@
 #include "PipelineManager.h"
 
+#include "Core/LoadProfiler.h"
 #include "Logger/Logger.h"
 #include "Render/Vulkan/VulkanPipeline.h"
 #include "Render/Converters.h"
+#include "Render/DescriptorAllocator.h"
 #include "Render/RenderPass.h"
 #include "Render/Shader.h"
 
-bool GraphicsPipelineKey::operator<(const GraphicsPipelineKey& k) const
+bool RenderPassKey::operator<(const RenderPassKey& k) const
 {
-	return memcmp(this, &k, sizeof(GraphicsPipelineKey)) < 0;
+	return memcmp(this, &k, sizeof(RenderPassKey)) < 0;
 }
 
-bool GraphicsPipelineKey::operator==(const GraphicsPipelineKey& k) const
+bool RenderPassKey::operator==(const RenderPassKey& k) const
 {
-	return memcmp(this, &k, sizeof(GraphicsPipelineKey)) == 0;
+	return memcmp(this, &k, sizeof(RenderPassKey)) == 0;
 }
 
-bool ComputePipelineKey::operator<(const ComputePipelineKey& k) const
+//fnv-1a, pipeline keys need more than 32 bits so different states don't end up sharing a pipeline
+static uint64_t HashPipelineKey(const void* key, size_t size)
 {
-	return memcmp(this, &k, sizeof(ComputePipelineKey)) < 0;
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<const uint8_t*>(key)[i];
+		hash *= 1099511628211ull;
+	}
+
+	//zero is left for stale hashes and empty slots
+	return hash != 0 ? hash : 1;
 }
 
-bool ComputePipelineKey::operator==(const ComputePipelineKey& k) const
+//viewport, scissor and blend states of a copied info still point into the original
+static std::unique_ptr<PipelineInfo> CopyPipelineInfo(const PipelineInfo& pipelineInfo)
 {
-	return memcmp(this, &k, sizeof(ComputePipelineKey)) == 0;
+	auto copy = std::make_unique<PipelineInfo>(pipelineInfo);
+	copy->viewportInfo.pViewports = &copy->viewport;
+	copy->viewportInfo.pScissors = &copy->scissor;
+	copy->colorBlendInfo.pAttachments = copy->colorBlendAttachment;
+	return copy;
 }
 
-bool RenderPassKey::operator<(const RenderPassKey& k) const
+void PipelineManager::Destroy()
 {
-	return memcmp(this, &k, sizeof(RenderPassKey)) < 0;
+	for (auto& job : m_GraphicsPipelineJobs) { JobSystem::instance().Wait(job.second->counter); }
+	for (auto& job : m_ComputePipelineJobs) { JobSystem::instance().Wait(job.second->counter); }
+
+	m_GraphicPipelines.ForEach([](GraphicsPipeline* pipeline) { delete pipeline; });
+	m_ComputePipelines.ForEach([](ComputePipeline* pipeline) { delete pipeline; });
+	for (auto object : m_RenderPasses) { delete object.second; }
+
+	m_GraphicPipelines.Clear();
+	m_ComputePipelines.Clear();
+
+	m_GraphicsPipelineJobs.clear();
+	m_ComputePipelineJobs.clear();
+	m_WarmedUpGraphicsStates.clear();
+	m_CollisionPipelineInfos.clear();
 }
 
-bool RenderPassKey::operator==(const RenderPassKey& k) const
+void PipelineManager::WarmUpComputePipelines(VulkanDevice& device, const std::unordered_map<std::string, Shader*>& shaders)
 {
-	return memcmp(this, &k, sizeof(RenderPassKey)) == 0;
+	LoadPhaseScope warmUpPhase("Pipeline warm-up");
+
+	uint32_t compiledPipelineCount = 0;
+	for (auto& [name, shader] : shaders)
+	{
+		if (shader->GetInfo().Type != ShaderType::Compute)
+		{
+			continue;
+		}
+
+		PipelineInfo pipelineInfo{};
+		pipelineInfo.computeShader = shader;
+		pipelineInfo.csEntryPoint = "main";
+
+		if (!RequestComputePipeline(device, pipelineInfo))
+		{
+			compiledPipelineCount++;
+		}
+	}
+
+	for (auto& job : m_ComputePipelineJobs)
+	{
+		JobSystem::instance().Wait(job.second->counter);
+	}
+
+	//jobs run without a load phase, compiled pipelines are counted here
+	warmUpPhase.AddItems(compiledPipelineCount);
 }
 
-void PipelineManager::Destroy()
+void PipelineManager::WarmUpGraphicsPipelines(VulkanDevice& device, const PipelineInfo& pipelineInfo)
 {
-	for (auto object : m_GraphicPipelines) { delete object.second; }
-	for (auto object : m_ComputePipelines) { delete object.second; }
-	for (auto object : m_RenderPasses) { delete object.second; }
+	if (!m_WarmedUpGraphicsStates.insert(GetGraphicsPipelineHash(pipelineInfo)).second)
+	{
+		return;
+	}
+
+	//layout is changed on a copy, state of the caller stays as it is
+	std::unique_ptr<PipelineInfo> layoutInfo = CopyPipelineInfo(pipelineInfo);
+	for (uint32_t layout = 0; layout < static_cast<uint32_t>(VertexLayout::Count); layout++)
+	{
+		layoutInfo->SetVertexLayout(static_cast<VertexLayout>(layout));
+		RequestPipeline(m_GraphicPipelines, m_GraphicsPipelineJobs, GetGraphicsPipelineHash(*layoutInfo), GetGraphicsPipelineKey(*layoutInfo), device, *layoutInfo, JobPriority::High);
+	}
+
+	//called from the render thread, it helps with these compiles and leaves model loads to workers
+	for (auto& job : m_GraphicsPipelineJobs)
+	{
+		JobSystem::instance().Wait(job.second->counter, JobPriority::High);
+	}
 }
 
-VulkanPipeline* PipelineManager::FindOrCreateGraphicsPipeline(VulkanDevice& device, PipelineInfo& pipelineInfo)
+GraphicsPipelineKey PipelineManager::GetGraphicsPipelineKey(const PipelineInfo& pipelineInfo)
 {
 	GraphicsPipelineKey key{};
 
@@ -51,51 +121,171 @@ VulkanPipeline* PipelineManager::FindOrCreateGraphicsPipeline(VulkanDevice& devi
 	key.vertexShaderEntryPointCRC = (uint32_t)crc32_fast((const void*)pipelineInfo.vsEntryPoint.c_str(), pipelineInfo.vsEntryPoint.length());
 	key.pixelShaderCRC = pipelineInfo.pixelShader ? pipelineInfo.pixelShader->GetHash() : 0;
 	key.pixelShaderEntryPointCRC = (uint32_t)crc32_fast((const void*)pipelineInfo.psEntryPoint.c_str(), pipelineInfo.psEntryPoint.length());
+	key.vertexLayout = static_cast<uint32_t>(pipelineInfo.vertexLayout);
 	key.topology = pipelineInfo.inputAssemblyInfo.topology;
+	key.primitiveRestartEnable = pipelineInfo.inputAssemblyInfo.primitiveRestartEnable;
 
-	key.polygonMode = pipelineInfo.rasterizationInfo.polygonMode;
-	key.cullMode = pipelineInfo.rasterizationInfo.cullMode;
-	key.frontface = pipelineInfo.rasterizationInfo.frontFace;
-	memcpy(&key.blendAttachmentStates, &pipelineInfo.colorBlendAttachment, sizeof(VkPipelineColorBlendAttachmentState) * MaxRenderTargetCount);
+	const VkPipelineRasterizationStateCreateInfo& rasterization = pipelineInfo.rasterizationInfo;
+	key.depthClampEnable = rasterization.depthClampEnable;
+	key.rasterizerDiscardEnable = rasterization.rasterizerDiscardEnable;
+	key.polygonMode = rasterization.polygonMode;
+	key.cullMode = rasterization.cullMode;
+	key.frontface = rasterization.frontFace;
+	key.depthBiasEnable = rasterization.depthBiasEnable;
+	key.depthBiasConstantFactor = rasterization.depthBiasConstantFactor;
+	key.depthBiasClamp = rasterization.depthBiasClamp;
+	key.depthBiasSlopeFactor = rasterization.depthBiasSlopeFactor;
+	key.lineWidth = rasterization.lineWidth;
 
-	//fill the key, find the pipeline in the map
-	//if it is not in the map, create and add to map
+	const VkPipelineMultisampleStateCreateInfo& multisample = pipelineInfo.multisampleInfo;
+	key.rasterizationSamples = multisample.rasterizationSamples;
+	key.sampleShadingEnable = multisample.sampleShadingEnable;
+	key.minSampleShading = multisample.minSampleShading;
+	key.alphaToCoverageEnable = multisample.alphaToCoverageEnable;
+	key.alphaToOneEnable = multisample.alphaToOneEnable;
 
-	auto pipelineIterator = m_GraphicPipelines.find(key);
-	if (pipelineIterator != m_GraphicPipelines.end())
-	{
-		return pipelineIterator->second;
-	}
-	else
+	const VkPipelineDepthStencilStateCreateInfo& depthStencil = pipelineInfo.depthStencilInfo;
+	key.depthTestEnable = depthStencil.depthTestEnable;
+	key.depthWriteEnable = depthStencil.depthWriteEnable;
+	key.depthCompareOp = depthStencil.depthCompareOp;
+	key.depthBoundsTestEnable = depthStencil.depthBoundsTestEnable;
+	key.stencilTestEnable = depthStencil.stencilTestEnable;
+	key.stencilFront = depthStencil.front;
+	key.stencilBack = depthStencil.back;
+	key.minDepthBounds = depthStencil.minDepthBounds;
+	key.maxDepthBounds = depthStencil.maxDepthBounds;
+
+	//blend states past attachment count are not used by the pipeline
+	const VkPipelineColorBlendStateCreateInfo& colorBlend = pipelineInfo.colorBlendInfo;
+	key.logicOpEnable = colorBlend.logicOpEnable;
+	key.logicOp = colorBlend.logicOp;
+	key.attachmentCount = colorBlend.attachmentCount;
+	memcpy(&key.blendAttachmentStates, &pipelineInfo.colorBlendAttachment, sizeof(VkPipelineColorBlendAttachmentState) * colorBlend.attachmentCount);
+	memcpy(&key.blendConstants, &colorBlend.blendConstants, sizeof(key.blendConstants));
+
+	for (uint32_t i = 0; i < MaxRenderTargetCount; i++)
 	{
-		LOG_WARNING("If you're seeing this every frame, you're doing something wrong! Check GraphicsPipelineKey!");
-		GraphicsPipeline* pipeline = new GraphicsPipeline(device, pipelineInfo);
-		m_GraphicPipelines[key] = pipeline;
-		return pipeline;
+		key.renderTargetFormats[i] = pipelineInfo.renderTargetFormats[i];
 	}
+	key.depthStencilFormat = pipelineInfo.depthStencilFormat;
+	key.subpass = pipelineInfo.subpass;
+
+	return key;
 }
 
-VulkanPipeline* PipelineManager::FindOrCreateComputePipeline(VulkanDevice& device, PipelineInfo& pipelineInfo)
+ComputePipelineKey PipelineManager::GetComputePipelineKey(const PipelineInfo& pipelineInfo)
 {
-	//for now the key is only CRC of compute shader and CRC of string of entry point
+	//compute pipeline is fully described by its shader and entry point, layout comes from the shader
 	ComputePipelineKey key{};
 
 	key.computeShaderCRC = pipelineInfo.computeShader->GetHash();
 	key.computeShaderEntryPointCRC = (uint32_t)crc32_fast((const void*)pipelineInfo.csEntryPoint.c_str(), pipelineInfo.csEntryPoint.length());
 
-	auto pipeline = m_ComputePipelines.find(key);
+	return key;
+}
+
+uint64_t PipelineManager::GetGraphicsPipelineHash(const PipelineInfo& pipelineInfo)
+{
+	if (pipelineInfo.graphicsStateHash == 0)
+	{
+		const GraphicsPipelineKey key = GetGraphicsPipelineKey(pipelineInfo);
+		pipelineInfo.graphicsStateHash = HashPipelineKey(&key, sizeof(key));
+	}
+	return pipelineInfo.graphicsStateHash;
+}
 
-	if (pipeline != m_ComputePipelines.end())
+uint64_t PipelineManager::GetComputePipelineHash(const PipelineInfo& pipelineInfo)
+{
+	if (pipelineInfo.computeStateHash == 0)
 	{
-		return pipeline->second;
+		const ComputePipelineKey key = GetComputePipelineKey(pipelineInfo);
+		pipelineInfo.computeStateHash = HashPipelineKey(&key, sizeof(key));
 	}
-	else
+	return pipelineInfo.computeStateHash;
+}
+
+template<typename PipelineT, typename KeyT>
+PipelineT* PipelineManager::FindPipeline(const PipelineHashMap<PipelineT, KeyT>& pipelines, uint64_t hash, const KeyT& key)
+{
+	std::shared_lock lock(m_PipelinesMutex);
+
+	return pipelines.Find(hash, key);
+}
+
+template<typename PipelineT, typename KeyT>
+PipelineT* PipelineManager::FindOrCreatePipeline(PipelineHashMap<PipelineT, KeyT>& pipelines, uint64_t hash, const KeyT& key, VulkanDevice& device, PipelineInfo& pipelineInfo)
+{
+	if (PipelineT* pipeline = FindPipeline(pipelines, hash, key))
+	{
+		return pipeline;
+	}
+
+	//compiled outside of the lock so other threads keep finding and compiling pipelines meanwhile
+	LOG_WARNING("If you're seeing this every frame, you're doing something wrong! Check the pipeline state!");
+	PipelineT* newPipeline = new PipelineT(device, pipelineInfo);
+	//pipelines compiled during a load phase are counted as its items
+	LoadProfiler::instance().AddItems(LoadProfiler::instance().GetCurrentPhase(), 1);
+
+	std::unique_lock lock(m_PipelinesMutex);
+
+	//another thread could compile the same pipeline meanwhile, first one is kept
+	PipelineT* pipeline = pipelines.Insert(hash, key, newPipeline);
+	if (pipeline != newPipeline)
 	{
-		LOG_WARNING("If you're seeing this every frame, you're doing something wrong! Check ComputePipelineKey!");
-		ComputePipeline* newPipeline = new ComputePipeline(device, pipelineInfo);
-		m_ComputePipelines[key] = newPipeline;
-		return newPipeline;
+		delete newPipeline;
 	}
+	return pipeline;
+}
+
+template<typename PipelineT, typename KeyT>
+PipelineT* PipelineManager::RequestPipeline(PipelineHashMap<PipelineT, KeyT>& pipelines, std::unordered_map<uint64_t, std::unique_ptr<PipelineJob>>& jobs,
+	uint64_t hash, const KeyT& key, VulkanDevice& device, const PipelineInfo& pipelineInfo, JobPriority priority)
+{
+	if (PipelineT* pipeline = FindPipeline(pipelines, hash, key))
+	{
+		return pipeline;
+	}
+
+	auto compilingJob = jobs.find(hash);
+	if (compilingJob != jobs.end())
+	{
+		//job under this hash finished without compiling this state, so it was for a colliding one. pipeline of that
+		//job references its info, so the job is kept and this rare state is compiled right here
+		if (compilingJob->second->counter.pendingJobs.load(std::memory_order_acquire) == 0)
+		{
+			auto collisionInfo = CopyPipelineInfo(pipelineInfo);
+			PipelineT* pipeline = FindOrCreatePipeline(pipelines, hash, key, device, *collisionInfo);
+			m_CollisionPipelineInfos.push_back(std::move(collisionInfo));
+			return pipeline;
+		}
+
+		//already compiling
+		return nullptr;
+	}
+
+	auto job = std::make_unique<PipelineJob>();
+	job->pipelineInfo = CopyPipelineInfo(pipelineInfo);
+
+	PipelineInfo* jobPipelineInfo = job->pipelineInfo.get();
+	JobSystem::instance().Submit([this, &pipelines, hash, key, &device, jobPipelineInfo]() { FindOrCreatePipeline(pipelines, hash, key, device, *jobPipelineInfo); }, &job->counter, priority);
+
+	jobs.emplace(hash, std::move(job));
+	return nullptr;
+}
+
+VulkanPipeline* PipelineManager::FindOrCreateGraphicsPipeline(VulkanDevice& device, PipelineInfo& pipelineInfo)
+{
+	return FindOrCreatePipeline(m_GraphicPipelines, GetGraphicsPipelineHash(pipelineInfo), GetGraphicsPipelineKey(pipelineInfo), device, pipelineInfo);
+}
+
+VulkanPipeline* PipelineManager::FindOrCreateComputePipeline(VulkanDevice& device, PipelineInfo& pipelineInfo)
+{
+	return FindOrCreatePipeline(m_ComputePipelines, GetComputePipelineHash(pipelineInfo), GetComputePipelineKey(pipelineInfo), device, pipelineInfo);
+}
+
+VulkanPipeline* PipelineManager::RequestComputePipeline(VulkanDevice& device, const PipelineInfo& pipelineInfo)
+{
+	return RequestPipeline(m_ComputePipelines, m_ComputePipelineJobs, GetComputePipelineHash(pipelineInfo), GetComputePipelineKey(pipelineInfo), device, pipelineInfo, JobPriority::Normal);
 }
 
 RenderPass* PipelineManager::FindOrCreateRenderPass(VulkanDevice& device, const std::vector<VulkanImageView*>& renderTargets, const VulkanImageView* depthStencil, RenderPassInfo& renderPassInfo)
@@ -139,9 +329,10 @@ RenderPass* PipelineManager::FindOrCreateRenderPass(VulkanDevice& device, const
 
 }
 
-VulkanDescriptorSet* PipelineManager::FindOrCreateDescriptorSet(VulkanDevice& device, const VulkanDescriptorPool* desciptorPool, const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors)
+DescriptorSetKey PipelineManager::GetDescriptorSetKey(const std::vector<VulkanDescriptor*>& descriptors)
 {
 	DescriptorSetKey key;
+	key.reserve(descriptors.size() * 3);
 
 	for (size_t i = 0; i < descriptors.size(); i++)
 	{
@@ -172,24 +363,89 @@ VulkanDescriptorSet* PipelineManager::FindOrCreateDescriptorSet(VulkanDevice& de
 			key.push_back((uint32_t)descriptors[i]->GetDescriptorInfo().Type);
 			break;
 		}
+		//frame allocations share one buffer, they differ only in offset
+		key.push_back(static_cast<uint32_t>(descriptors[i]->GetDescriptorInfo().bufferOffset));
 	}
 
+	return key;
+}
+
+VulkanDescriptorSet* PipelineManager::FindOrCreateDescriptorSet(DescriptorAllocator& descriptorAllocator, const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors)
+{
+	DescriptorSetKey key = GetDescriptorSetKey(descriptors);
+
 	auto descriptorset = m_DescriptorSets.find(key);
 	if (descriptorset != m_DescriptorSets.end())
 	{
-		return descriptorset->second;
+		return descriptorset->second.descriptorSet;
 	}
 	else
 	{
 		LOG_WARNING("If you're seeing this every frame, you're doing something wrong! Check DescriptorSetKey!");
-		VulkanDescriptorSet* newDescSet = new VulkanDescriptorSet(&device, desciptorPool, descriptorSetLayout, descriptors, "descriptorset");
-		m_DescriptorSets[key] = newDescSet;
+		VulkanDescriptorSet* newDescSet = descriptorAllocator.Allocate(descriptorSetLayout, descriptors);
+
+		CachedDescriptorSet& cachedSet = m_DescriptorSets[key];
+		cachedSet.descriptorSet = newDescSet;
+		for (const VulkanDescriptor* descriptor : descriptors)
+		{
+			cachedSet.descriptorInfos.push_back(descriptor->GetDescriptorInfo());
+		}
 		return newDescSet;
 	}
 
 	return nullptr;
 }
 
+void PipelineManager::UpdateRecreatedViews(VulkanDevice& device, const std::unordered_set<uint32_t>& viewIds)
+{
+	//descriptor key is (slot, id, type), descriptor is built again from its info to pick up the new handle
+	for (auto& [key, descriptor] : m_Descriptors)
+	{
+		if (viewIds.contains(key[1]))
+		{
+			*descriptor = VulkanDescriptor(descriptor->GetDescriptorInfo());
+		}
+	}
+
+	//set key is (id, type, offset) triples, sets of other resources may reference views that don't exist anymore
+	for (auto& [key, cachedSet] : m_DescriptorSets)
+	{
+		bool referencesView = false;
+		for (size_t i = 0; i < key.size(); i += 3)
+		{
+			referencesView |= viewIds.contains(key[i]);
+		}
+
+		if (!referencesView)
+		{
+			continue;
+		}
+
+		std::vector<VulkanDescriptor> descriptors(cachedSet.descriptorInfos.begin(), cachedSet.descriptorInfos.end());
+		std::vector<VulkanDescriptor*> descriptorPtrs;
+		for (VulkanDescriptor& descriptor : descriptors)
+		{
+			descriptorPtrs.push_back(&descriptor);
+		}
+
+		cachedSet.descriptorSet->Update(&device, descriptorPtrs);
+	}
+
+	for (auto& [key, renderPass] : m_RenderPasses)
+	{
+		bool referencesView = viewIds.contains(static_cast<uint32_t>(key.depthStencilAttachmentDescription.id));
+		for (const AttachmentDescription& attachment : key.attachmentDescriptions)
+		{
+			referencesView |= viewIds.contains(static_cast<uint32_t>(attachment.id));
+		}
+
+		if (referencesView)
+		{
+			renderPass->RecreateFramebuffer();
+		}
+	}
+}
+
 void GraphicsPipeline::Bind(VulkanCommandBuffer& commandBuffer)
 {
 	vkCmdBindPipeline(GET_VK_HANDLE(commandBuffer), VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
@@ -2,21 +2,35 @@
 
 #include "common.h"
 
+#include <deque>
+#include <memory>
+#include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "Core/JobSystem.h"
 #include "Render/Vulkan/Include/VulkanWrapper.h"
 
+class DescriptorAllocator;
+
+//compute pipelines of every loaded shader are compiled in parallel while loading instead of on the first dispatch,
+//graphics ones depend on pass state and are only warmed by the pipeline cache
+#define PIPELINE_WARM_UP
+
+//power of two
+#define PIPELINE_HASH_MAP_INITIAL_SIZE 256
+
 struct ComputePipelineKey
 {
 	ComputePipelineKey() { memset(this, 0, sizeof(ComputePipelineKey)); }
 
 	uint32_t computeShaderCRC;
 	uint32_t computeShaderEntryPointCRC;
-
-	bool operator < (const ComputePipelineKey& k) const;
-	bool operator == (const ComputePipelineKey& k) const;
 };
 
+//every field of pipeline info that ends up in vkCreateGraphicsPipelines, viewport and scissor are dynamic.
+//render pass is described by formats and samples of its attachments, pipeline works with any compatible pass
 struct GraphicsPipelineKey
 {
 	GraphicsPipelineKey() { memset(this, 0, sizeof(GraphicsPipelineKey)); }
@@ -25,14 +39,151 @@ struct GraphicsPipelineKey
 	uint32_t vertexShaderEntryPointCRC;
 	uint32_t pixelShaderCRC;
 	uint32_t pixelShaderEntryPointCRC;
+	uint32_t vertexLayout;
 	uint32_t topology;
+	uint32_t primitiveRestartEnable;
+
+	uint32_t depthClampEnable;
+	uint32_t rasterizerDiscardEnable;
 	uint32_t polygonMode;
 	uint32_t cullMode;
 	uint32_t frontface;
+	uint32_t depthBiasEnable;
+	float depthBiasConstantFactor;
+	float depthBiasClamp;
+	float depthBiasSlopeFactor;
+	float lineWidth;
+
+	uint32_t rasterizationSamples;
+	uint32_t sampleShadingEnable;
+	float minSampleShading;
+	uint32_t alphaToCoverageEnable;
+	uint32_t alphaToOneEnable;
+
+	uint32_t depthTestEnable;
+	uint32_t depthWriteEnable;
+	uint32_t depthCompareOp;
+	uint32_t depthBoundsTestEnable;
+	uint32_t stencilTestEnable;
+	VkStencilOpState stencilFront;
+	VkStencilOpState stencilBack;
+	float minDepthBounds;
+	float maxDepthBounds;
+
+	uint32_t logicOpEnable;
+	uint32_t logicOp;
+	uint32_t attachmentCount;
 	VkPipelineColorBlendAttachmentState blendAttachmentStates[MaxRenderTargetCount];
+	float blendConstants[4];
+
+	uint32_t renderTargetFormats[MaxRenderTargetCount];
+	uint32_t depthStencilFormat;
+	uint32_t subpass;
+};
+
+//open addressing map of pipelines keyed by their 64 bit state hash, a lookup is a few integer compares over one
+//contiguous array. full keys are kept aside and compared only when hashes match, so a collision never hands out
+//a pipeline of different state. zero hash marks an empty slot, pipeline manager never hands it out
+template<typename PipelineT, typename KeyT>
+class PipelineHashMap
+{
+public:
+	PipelineT* Find(uint64_t hash, const KeyT& key) const
+	{
+		if (m_Slots.empty())
+		{
+			return nullptr;
+		}
+
+		const size_t mask = m_Slots.size() - 1;
+		for (size_t slot = hash & mask; m_Slots[slot].hash != 0; slot = (slot + 1) & mask)
+		{
+			if (m_Slots[slot].hash == hash && memcmp(m_Slots[slot].key, &key, sizeof(KeyT)) == 0)
+			{
+				return m_Slots[slot].pipeline;
+			}
+		}
+		return nullptr;
+	}
+
+	//pipeline that is already in the map under the same key is kept and returned
+	PipelineT* Insert(uint64_t hash, const KeyT& key, PipelineT* pipeline)
+	{
+		if (PipelineT* existingPipeline = Find(hash, key))
+		{
+			return existingPipeline;
+		}
+
+		m_Keys.push_back(key);
+		InsertSlot(Slot{ hash, &m_Keys.back(), pipeline });
+		return pipeline;
+	}
+
+	template<typename Func>
+	void ForEach(Func&& func) const
+	{
+		for (const Slot& slot : m_Slots)
+		{
+			if (slot.hash != 0)
+			{
+				func(slot.pipeline);
+			}
+		}
+	}
+
+	void Clear()
+	{
+		m_Slots.clear();
+		m_Keys.clear();
+		m_Count = 0;
+	}
+
+private:
+	struct Slot
+	{
+		uint64_t		hash = 0;
+		const KeyT*		key = nullptr;
+		PipelineT*		pipeline = nullptr;
+	};
 
-	bool operator < (const GraphicsPipelineKey& k) const;
-	bool operator == (const GraphicsPipelineKey& k) const;
+	void InsertSlot(const Slot& newSlot)
+	{
+		//kept at most half full so probes stay short
+		if ((m_Count + 1) * 2 > m_Slots.size())
+		{
+			Rehash(m_Slots.empty() ? PIPELINE_HASH_MAP_INITIAL_SIZE : m_Slots.size() * 2);
+		}
+
+		//colliding hashes just take the next free slot
+		const size_t mask = m_Slots.size() - 1;
+		size_t slot = newSlot.hash & mask;
+		while (m_Slots[slot].hash != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		m_Slots[slot] = newSlot;
+		m_Count++;
+	}
+
+	void Rehash(size_t slotCount)
+	{
+		std::vector<Slot> slots(slotCount);
+		std::swap(slots, m_Slots);
+		m_Count = 0;
+
+		for (const Slot& slot : slots)
+		{
+			if (slot.hash != 0)
+			{
+				InsertSlot(slot);
+			}
+		}
+	}
+
+	std::vector<Slot>	m_Slots;
+	std::deque<KeyT>	m_Keys; //never moved, slots point into it
+	size_t				m_Count = 0;
 };
 
 struct AttachmentDescription
@@ -60,24 +211,6 @@ struct RenderPassKey
 typedef std::vector<uint32_t> DescriptorSetKey;
 typedef std::vector<uint32_t> DescriptorKey;
 
-template<>
-struct std::hash<GraphicsPipelineKey>
-{
-	inline uint32_t operator()(const GraphicsPipelineKey& x) const
-	{
-		return (uint32_t)crc32_fast((const void*)&x, sizeof(x));
-	}
-};
-
-template<>
-struct std::hash<ComputePipelineKey>
-{
-	inline uint32_t operator()(const ComputePipelineKey& x) const
-	{
-		return (uint32_t)crc32_fast((const void*)&x, sizeof(x));
-	}
-};
-
 template<>
 struct std::hash<RenderPassKey>
 {
@@ -126,23 +259,76 @@ public:
 	virtual void Bind(VulkanCommandBuffer& commandBuffer) override;
 };
 
+//pipelines can be looked up and compiled from any thread, only requests for async compilation and the rest of
+//the objects belong to the render thread
 class PipelineManager
 {
 public:
 	void Destroy();
+	//compiles compute pipelines of every compute shader with its main entry point on all workers, waits for them
+	void WarmUpComputePipelines(VulkanDevice& device, const std::unordered_map<std::string, Shader*>& shaders);
+	//compiles pipelines of the state with every vertex layout on all workers and waits for them, once per state.
+	//models of any layout drawn with the state then find their pipeline instead of compiling it on the render thread
+	void WarmUpGraphicsPipelines(VulkanDevice& device, const PipelineInfo& pipelineInfo);
 
 private:
-	std::unordered_map<GraphicsPipelineKey, GraphicsPipeline*>					m_GraphicPipelines;
-	std::unordered_map<ComputePipelineKey, ComputePipeline*>					m_ComputePipelines;
+	//pipeline compiled on a job references info copied here, so it lives as long as the manager
+	struct PipelineJob
+	{
+		std::unique_ptr<PipelineInfo>	pipelineInfo;
+		JobCounter						counter;
+	};
+
+	//infos are kept so the set can be written again once views it references are recreated
+	struct CachedDescriptorSet
+	{
+		VulkanDescriptorSet*				descriptorSet;
+		std::vector<VulkanDescriptorInfo>	descriptorInfos;
+	};
+
+	static GraphicsPipelineKey	GetGraphicsPipelineKey(const PipelineInfo& pipelineInfo);
+	static ComputePipelineKey	GetComputePipelineKey(const PipelineInfo& pipelineInfo);
+
+	template<typename PipelineT, typename KeyT>
+	PipelineT*	FindPipeline(const PipelineHashMap<PipelineT, KeyT>& pipelines, uint64_t hash, const KeyT& key);
+	template<typename PipelineT, typename KeyT>
+	PipelineT*	FindOrCreatePipeline(PipelineHashMap<PipelineT, KeyT>& pipelines, uint64_t hash, const KeyT& key, VulkanDevice& device, PipelineInfo& pipelineInfo);
+	template<typename PipelineT, typename KeyT>
+	PipelineT*	RequestPipeline(PipelineHashMap<PipelineT, KeyT>& pipelines, std::unordered_map<uint64_t, std::unique_ptr<PipelineJob>>& jobs,
+		uint64_t hash, const KeyT& key, VulkanDevice& device, const PipelineInfo& pipelineInfo, JobPriority priority);
+	//returns nullptr and starts compiling on a job if the pipeline doesn't exist yet, warm-up waits for the jobs
+	VulkanPipeline*		RequestComputePipeline(VulkanDevice& device, const PipelineInfo& pipelineInfo);
+
+	PipelineHashMap<GraphicsPipeline, GraphicsPipelineKey>						m_GraphicPipelines;
+	PipelineHashMap<ComputePipeline, ComputePipelineKey>						m_ComputePipelines;
 	std::unordered_map<RenderPassKey, RenderPass*>								m_RenderPasses;
-	std::unordered_map<DescriptorSetKey, VulkanDescriptorSet*, VectorHasher>	m_DescriptorSets;
+	std::unordered_map<DescriptorSetKey, CachedDescriptorSet, VectorHasher>	m_DescriptorSets;
 	std::unordered_map<DescriptorKey, VulkanDescriptor*, VectorHasher>			m_Descriptors;
 
+	//guards both pipeline maps, compilation itself runs outside of it
+	std::shared_mutex															m_PipelinesMutex;
+	std::unordered_map<uint64_t, std::unique_ptr<PipelineJob>>					m_GraphicsPipelineJobs;
+	std::unordered_map<uint64_t, std::unique_ptr<PipelineJob>>					m_ComputePipelineJobs;
+	std::unordered_set<uint64_t>												m_WarmedUpGraphicsStates;
+	//infos of requested states whose hash collided with a state already compiled on a job
+	std::vector<std::unique_ptr<PipelineInfo>>									m_CollisionPipelineInfos;
+
 public:
+	//hash of the whole pipeline state, computed once after the state changes and cached in the info
+	static uint64_t			GetGraphicsPipelineHash(const PipelineInfo& pipelineInfo);
+	static uint64_t			GetComputePipelineHash(const PipelineInfo& pipelineInfo);
+
+	//compiles the pipeline on the calling thread if it doesn't exist yet
 	VulkanPipeline*			FindOrCreateGraphicsPipeline(VulkanDevice& device, PipelineInfo& pipelineInfo);
 	VulkanPipeline*			FindOrCreateComputePipeline(VulkanDevice& device, PipelineInfo& pipelineInfo);
 	RenderPass*				FindOrCreateRenderPass(VulkanDevice& device, const std::vector<VulkanImageView*>& renderTargets, const VulkanImageView* depthStencil, RenderPassInfo& renderPassInfo);
-	VulkanDescriptorSet*	FindOrCreateDescriptorSet(VulkanDevice& device, const VulkanDescriptorPool* desciptorPool, const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors);
+	//key is (id, type, offset) triple of every descriptor
+	static DescriptorSetKey	GetDescriptorSetKey(const std::vector<VulkanDescriptor*>& descriptors);
+	//set is cached for the whole life of the manager, sets rewritten every frame come from frame descriptor allocator
+	VulkanDescriptorSet*	FindOrCreateDescriptorSet(DescriptorAllocator& descriptorAllocator, const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors);
+	//views with given ids were recreated in place, descriptors, sets and framebuffers referencing them are updated.
+	//gpu must be idle
+	void					UpdateRecreatedViews(VulkanDevice& device, const std::unordered_set<uint32_t>& viewIds);
 	
 	std::unordered_map<DescriptorKey, VulkanDescriptor*, VectorHasher>& GetDescriptors() { return m_Descriptors; }
 };
\ No newline at end of file
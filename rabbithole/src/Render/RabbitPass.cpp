@@ -4,6 +4,26 @@
 #include "Render/SuperResolutionManager.h"
 #include "Utils/utils.h"
 
+void RabbitPass::DeclareInput(ManagableResource* resource)
+{
+	m_Inputs.push_back(resource);
+}
+
+void RabbitPass::DeclareOptionalInput(ManagableResource* resource)
+{
+	m_OptionalInputs.push_back(resource);
+}
+
+void RabbitPass::DeclareOutput(ManagableResource* resource)
+{
+	m_Outputs.push_back(resource);
+}
+
+VulkanTexture* RabbitPass::GetInputOrFallback(VulkanTexture* input, VulkanTexture* fallback)
+{
+	return m_Renderer.GetRabbitPassManager().IsCulledOutput(input) ? fallback : input;
+}
+
 void RabbitPass::SetCombinedImageSampler(uint32_t slot, VulkanTexture* texture)
 {
 	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
@@ -64,6 +84,11 @@ void RabbitPass::SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer)
 	m_Renderer.GetStateManager().SetConstantBuffer(slot, buffer);
 }
 
+void RabbitPass::SetConstantBuffer(uint32_t slot, const FrameAllocation& allocation)
+{
+	m_Renderer.GetStateManager().SetConstantBuffer(slot, allocation);
+}
+
 void RabbitPass::SetStorageBufferRead(uint32_t slot, VulkanBuffer* buffer)
 {
 	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
@@ -97,6 +122,16 @@ void RabbitPass::SetStorageBufferReadWrite(uint32_t slot, VulkanBuffer* buffer)
 	stateManager.SetStorageBuffer(slot, buffer);
 }
 
+void RabbitPass::SetIndirectArgumentBuffer(VulkanBuffer* buffer)
+{
+	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
+	ResourceStateTrackingManager& rstManager = m_Renderer.GetResourceStateTrackingManager();
+	stateManager.UpdateResourceStage(buffer);
+
+	buffer->SetShouldBeResourceState(ResourceState::IndirectArgument);
+	rstManager.AddResourceForTransition(buffer);
+}
+
 void RabbitPass::SetSampler(uint32_t slot, VulkanTexture* texture)
 {
 	m_Renderer.GetStateManager().SetSampler(slot, texture->GetSampler());
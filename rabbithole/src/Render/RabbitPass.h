@@ -6,6 +6,7 @@
 #include "Render/Renderer.h"
 
 class Renderer;
+class ManagableResource;
 class VulkanTexture;
 class VulkanBuffer;
 
@@ -16,24 +17,47 @@ public:
 	virtual void Setup() = 0;
 	virtual void Render() = 0;
 	virtual const char* GetName() = 0;
+	//pass is culled while this is false, together with passes that only feed it
+	virtual bool IsEnabled() { return true; }
+	//compute only pass that can overlap graphics work, recorded to the dedicated compute queue when there is one
+	virtual bool IsAsyncCompute() { return false; }
+
+	inline const std::vector<ManagableResource*>& GetInputs() const { return m_Inputs; }
+	inline const std::vector<ManagableResource*>& GetOptionalInputs() const { return m_OptionalInputs; }
+	inline const std::vector<ManagableResource*>& GetOutputs() const { return m_Outputs; }
 
 protected:
 	RabbitPass(Renderer& renderer) : m_Renderer(renderer) {}
 
+	//declared in DeclareResources. outputs are reference counted by passes that declare them as inputs, pass with
+	//declared outputs runs only while some of them is consumed. pass is culled when its input was not produced,
+	//optional input of a culled producer is replaced with a fallback instead
+	void DeclareInput(ManagableResource* resource);
+	void DeclareOptionalInput(ManagableResource* resource);
+	void DeclareOutput(ManagableResource* resource);
+	VulkanTexture* GetInputOrFallback(VulkanTexture* input, VulkanTexture* fallback);
+
 	void SetCombinedImageSampler(uint32_t slot, VulkanTexture* texture);
 	void SetSampledImage(uint32_t slot, VulkanTexture* texture);
 	void SetStorageImageRead(uint32_t slot, VulkanTexture* texture);
 	void SetStorageImageWrite(uint32_t slot, VulkanTexture* texture);
 	void SetStorageImageReadWrite(uint32_t slot, VulkanTexture* texture);
 	void SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer);
+	void SetConstantBuffer(uint32_t slot, const FrameAllocation& allocation);
 	void SetStorageBufferRead(uint32_t slot, VulkanBuffer* buffer);
 	void SetStorageBufferWrite(uint32_t slot, VulkanBuffer* buffer);
 	void SetStorageBufferReadWrite(uint32_t slot, VulkanBuffer* buffer);
+	void SetIndirectArgumentBuffer(VulkanBuffer* buffer);
 	void SetSampler(uint32_t slot, VulkanTexture* texture);
 	void SetRenderTarget(uint32_t slot, VulkanTexture* texture);
 	void SetDepthStencil(VulkanTexture* texture);
 
 	Renderer& m_Renderer;
+
+private:
+	std::vector<ManagableResource*> m_Inputs;
+	std::vector<ManagableResource*> m_OptionalInputs;
+	std::vector<ManagableResource*> m_Outputs;
 };
 
 #define BEGIN_DECLARE_RABBITPASS(name) \
@@ -55,4 +79,8 @@ public:
 #define declareResource(name, type) static type* name
 #define declareResourceArray(name, type, slices) static type* name[slices]
 #define defineResource(pass, name, type) type* pass::name = nullptr;
-#define defineResourceArray(pass, name, type, slices) type* pass::name[slices] = { nullptr };
\ No newline at end of file
+#define defineResourceArray(pass, name, type, slices) type* pass::name[slices] = { nullptr };
+
+//data written during the frame, lives in frame allocator until the same swapchain image is recorded again
+#define declareFrameAllocation(name) static FrameAllocation name
+#define defineFrameAllocation(pass, name) FrameAllocation pass::name = {};
\ No newline at end of file
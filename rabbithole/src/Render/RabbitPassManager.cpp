@@ -2,6 +2,7 @@
 
 #include "Render/RabbitPass.h"
 #include "Render/RabbitPasses/AmbientOcclusion.h"
+#include "Render/RabbitPasses/Culling.h"
 #include "Render/RabbitPasses/GBuffer.h"
 #include "Render/RabbitPasses/Lighting.h"
 #include "Render/RabbitPasses/Postprocessing.h"
@@ -10,21 +11,28 @@
 #include "Render/RabbitPasses/Upscaling.h"
 #include "Render/RabbitPasses/Volumetric.h"
 
+#include <algorithm>
+
 //pass scheduler
 void RabbitPassManager::SchedulePasses(Renderer& renderer)
 {
 	AddPass(new Create3DNoiseTexturePass(renderer), true);
+	//async compute passes are placed right after their inputs are written, so they overlap the graphics passes that follow
+	AddPass(new VolumetricPass(renderer));
+	AddPass(new ComputeScatteringPass(renderer));
+	AddPass(new OcclusionCullingEarlyPass(renderer));
 	AddPass(new GBufferPass(renderer));
+	AddPass(new HiZPass(renderer));
+	AddPass(new OcclusionCullingLatePass(renderer));
+	AddPass(new GBufferLatePass(renderer));
 	AddPass(new SkyboxPass(renderer));
 	AddPass(new CopyDepthPass(renderer));
+	AddPass(new SSAOPass(renderer));
 	AddPass(new RTShadowsPass(renderer));
 	AddPass(new ShadowDenoisePrePass(renderer));
 	AddPass(new ShadowDenoiseTileClassificationPass(renderer));
 	AddPass(new ShadowDenoiseFilterPass(renderer));
-	AddPass(new SSAOPass(renderer));
 	AddPass(new SSAOBlurPass(renderer));
-	AddPass(new VolumetricPass(renderer));
-	AddPass(new ComputeScatteringPass(renderer));
 	AddPass(new LightingPass(renderer));
 	AddPass(new ApplyVolumetricFogPass(renderer));
 	AddPass(new TextureDebugPass(renderer));
@@ -44,17 +52,51 @@ void RabbitPassManager::DeclareResources()
 
 void RabbitPassManager::ExecutePasses(Renderer& renderer)
 {
+	ResourceStateTrackingManager& stateTracking = renderer.GetResourceStateTrackingManager();
+	AsyncComputeScheduler& asyncCompute = renderer.GetAsyncCompute();
+
+	CullPasses();
+
+	//culled passes keep their index, so transient lifetimes stay valid when they are turned back on
+	uint32_t passIndex = 0;
 	for (auto pass : m_RabbitPassesToExecute)
 	{
-		renderer.BeginLabel(pass->GetName());
+		BeginTransientLifetimes(passIndex);
+
+		if (m_CulledPasses.contains(pass))
+		{
+			passIndex++;
+			continue;
+		}
+
+		stateTracking.SetCommittedResources(&m_CommittedResources);
 
 		pass->Setup();
 
+		//queue is picked after setup, pass can change how it renders there
+		const bool isAsyncCompute = pass->IsAsyncCompute();
+		asyncCompute.SetQueue(isAsyncCompute ? QueueType::Compute : QueueType::Graphics);
+
+		//resources bound in setup are what the pass reads and writes, all of them are transitioned with one barrier.
+		//barrier can cut the batch of the queue to wait for the other one, so label starts after it
+		stateTracking.CommitBarriers(renderer);
+
+		renderer.BeginLabel(pass->GetName());
+
 		pass->Render();
 
-		renderer.RecordGPUTimeStamp(pass->GetName());
+		stateTracking.SetCommittedResources(nullptr);
+		UpdateTransientLifetimes(passIndex, isAsyncCompute && asyncCompute.IsEnabled());
+
+		//timestamps are written on graphics queue only
+		if (!asyncCompute.IsOnComputeQueue())
+		{
+			renderer.RecordGPUTimeStamp(pass->GetName());
+		}
 
 		renderer.EndLabel();
+
+		passIndex++;
 	}
 }
 
@@ -66,6 +108,8 @@ void RabbitPassManager::ExecuteOneTimePasses(Renderer& renderer)
 
 		pass->Setup();
 
+		renderer.GetResourceStateTrackingManager().CommitBarriers(renderer);
+
 		pass->Render();
 
 		renderer.RecordGPUTimeStamp(pass->GetName());
@@ -79,6 +123,150 @@ void RabbitPassManager::Destroy()
 
 }
 
+void RabbitPassManager::UpdateTransientAliasing(Renderer& renderer)
+{
+	if (!m_TransientLifetimesChanged)
+	{
+		return;
+	}
+
+	VULKAN_API_CALL(vkDeviceWaitIdle(renderer.GetVulkanDevice().GetGraphicDevice()));
+
+	std::vector<TransientTextureLifetime> lifetimes;
+	for (auto& [image, transientTexture] : m_TransientTextures)
+	{
+		lifetimes.push_back(TransientTextureLifetime{ image, transientTexture.firstPass, transientTexture.lastPass });
+	}
+
+	std::unordered_set<uint32_t> recreatedViews = renderer.GetResourceManager().AliasTransientTextures(renderer.GetVulkanDevice(), lifetimes);
+	renderer.GetPipelineManager().UpdateRecreatedViews(renderer.GetVulkanDevice(), recreatedViews);
+
+	m_TransientLifetimesChanged = false;
+	m_TransientTexturesAliased = true;
+}
+
+bool RabbitPassManager::IsCulledOutput(ManagableResource* resource) const
+{
+	return m_CulledOutputs.contains(resource);
+}
+
+void RabbitPassManager::CullPasses()
+{
+	m_CulledPasses.clear();
+	m_CulledOutputs.clear();
+
+	//going forward, pass can't run when it is disabled or when some of its inputs was not produced
+	for (auto pass : m_RabbitPassesToExecute)
+	{
+		bool canRun = pass->IsEnabled();
+		for (ManagableResource* input : pass->GetInputs())
+		{
+			canRun &= !m_CulledOutputs.contains(input);
+		}
+
+		if (!canRun)
+		{
+			m_CulledPasses.insert(pass);
+			m_CulledOutputs.insert(pass->GetOutputs().begin(), pass->GetOutputs().end());
+		}
+	}
+
+	//going backward, consumers are settled before their producers. pass whose outputs have no consumers left is culled
+	std::unordered_map<ManagableResource*, uint32_t> consumerCount;
+	for (auto pass = m_RabbitPassesToExecute.rbegin(); pass != m_RabbitPassesToExecute.rend(); pass++)
+	{
+		if (m_CulledPasses.contains(*pass))
+		{
+			continue;
+		}
+
+		const std::vector<ManagableResource*>& outputs = (*pass)->GetOutputs();
+		bool isConsumed = outputs.empty();
+		for (ManagableResource* output : outputs)
+		{
+			isConsumed |= consumerCount[output] > 0;
+		}
+
+		if (!isConsumed)
+		{
+			m_CulledPasses.insert(*pass);
+			m_CulledOutputs.insert(outputs.begin(), outputs.end());
+			continue;
+		}
+
+		for (ManagableResource* input : (*pass)->GetInputs())
+		{
+			consumerCount[input]++;
+		}
+		for (ManagableResource* input : (*pass)->GetOptionalInputs())
+		{
+			consumerCount[input]++;
+		}
+	}
+}
+
+void RabbitPassManager::BeginTransientLifetimes(uint32_t passIndex)
+{
+	if (!m_TransientTexturesAliased)
+	{
+		return;
+	}
+
+	//memory was used by other textures since, so contents are undefined and first barrier waits for their writes
+	for (auto& [image, transientTexture] : m_TransientTextures)
+	{
+		if (transientTexture.firstPass != passIndex)
+		{
+			continue;
+		}
+
+		for (VulkanTexture* texture : transientTexture.textures)
+		{
+			texture->SetResourceState(ResourceState::None);
+		}
+	}
+}
+
+void RabbitPassManager::UpdateTransientLifetimes(uint32_t passIndex, bool isAsyncCompute)
+{
+	//async pass runs next to graphics passes recorded after it, its textures can't share memory with anything
+	const uint32_t firstPass = isAsyncCompute ? 0 : passIndex;
+	const uint32_t lastPass = isAsyncCompute ? static_cast<uint32_t>(m_RabbitPassesToExecute.size() - 1) : passIndex;
+
+	for (ManagableResource* resource : m_CommittedResources)
+	{
+		if (resource->GetType() != ResourceType::Texture)
+		{
+			continue;
+		}
+
+		VulkanTexture* texture = static_cast<VulkanTexture*>(resource);
+		if (!IsFlagSet(texture->GetFlags() & TextureFlags::Transient))
+		{
+			continue;
+		}
+
+		auto [transientTexture, inserted] = m_TransientTextures.try_emplace(texture->GetResource(), TransientTexture{ firstPass, lastPass });
+		TransientTexture& lifetime = transientTexture->second;
+		if (firstPass < lifetime.firstPass || lastPass > lifetime.lastPass)
+		{
+			//texture debug view or a pass that was off can use a texture outside of the lifetime it was aliased with
+			lifetime.firstPass = std::min(lifetime.firstPass, firstPass);
+			lifetime.lastPass = std::max(lifetime.lastPass, lastPass);
+			m_TransientLifetimesChanged = true;
+		}
+
+		m_TransientLifetimesChanged |= inserted;
+
+		if (std::find(lifetime.textures.begin(), lifetime.textures.end(), texture) == lifetime.textures.end())
+		{
+			lifetime.textures.push_back(texture);
+		}
+	}
+
+	m_CommittedResources.clear();
+}
+
 void RabbitPassManager::AddPass(RabbitPass* pass, bool executeOnce /*= false*/)
 {
 	m_RabbitPasses[pass->GetName()] = pass;
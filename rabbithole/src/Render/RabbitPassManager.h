@@ -2,9 +2,14 @@
 
 class Renderer;
 class RabbitPass;
+class ManagableResource;
+class VulkanImage;
+class VulkanTexture;
 
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class RabbitPassManager
 {
@@ -15,11 +20,38 @@ public:
 	void ExecutePasses(Renderer& renderer);
 	void ExecuteOneTimePasses(Renderer& renderer);
 	void Destroy();
+	//transient textures are placed into shared memory once passes that use them are known, and again when a texture
+	//gets used outside of its lifetime. called before the frame is recorded
+	void UpdateTransientAliasing(Renderer& renderer);
+	//output of a pass that does not run this frame, consumers bind a fallback instead
+	bool IsCulledOutput(ManagableResource* resource) const;
 
 public:
 	void AddPass(RabbitPass* pass, bool executeOnce = false);
 
 private:
+	//first and last pass in which the image is bound, by index in execution order
+	struct TransientTexture
+	{
+		uint32_t					firstPass;
+		uint32_t					lastPass;
+		std::vector<VulkanTexture*>	textures;	//bound textures with a view of the image
+	};
+
+	//disabled passes, passes whose inputs were not produced and passes whose outputs nobody consumes
+	void CullPasses();
+
+	void BeginTransientLifetimes(uint32_t passIndex);
+	void UpdateTransientLifetimes(uint32_t passIndex, bool isAsyncCompute);
+
+	std::unordered_map<VulkanImage*, TransientTexture> m_TransientTextures;
+	std::vector<ManagableResource*> m_CommittedResources;
+	bool m_TransientLifetimesChanged = false;
+	bool m_TransientTexturesAliased = false;
+
+	std::unordered_set<RabbitPass*> m_CulledPasses;
+	std::unordered_set<ManagableResource*> m_CulledOutputs;
+
 	std::unordered_map<const char*, RabbitPass*> m_RabbitPasses;
 	std::list<RabbitPass*> m_RabbitPassesToExecute;
 	std::list<RabbitPass*> m_RabbitPassesOneTimeExecute;
@@ -7,27 +7,22 @@
 defineResource(SSAOPass, Output, VulkanTexture);
 defineResource(SSAOPass, Noise, VulkanTexture);
 defineResource(SSAOPass, Samples, VulkanBuffer);
-defineResource(SSAOPass, ParamsGPU, VulkanBuffer);
+defineFrameAllocation(SSAOPass, ParamsGPU);
 SSAOPass::SSAOParams SSAOPass::ParamsCPU = {};
 
 defineResource(SSAOBlurPass, BluredOutput, VulkanTexture);
 
 void SSAOPass::DeclareResources()
 {
-	ParamsGPU = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(SSAOParams)},
-			.name = {"SSAO Params"}
-		});
-
 	Output = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth, GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Storage},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R8_UNORM},
 			.name = {"SSAO Main"}
 		});
 
+	DeclareOutput(Output);
+
 	std::uniform_real_distribution<float> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
 	std::default_random_engine generator;
 	std::vector<glm::vec4> ssaoKernel;
@@ -72,8 +67,6 @@ void SSAOPass::Setup()
 	{
 		ImGui::Begin("SSAOParams");
 
-		ImGui::Checkbox("SSSAO On: ", &ParamsCPU.ssaoOn);
-		ImGui::SameLine();
 		ImGui::Checkbox("Compute SSAO: ", &ComputeSSAO);
 		ImGui::SliderFloat("Radius: ", &ParamsCPU.radius, 0.1f, 1.f);
 		ImGui::SliderFloat("Bias:", &ParamsCPU.bias, 0.0f, 0.0625f);
@@ -82,7 +75,8 @@ void SSAOPass::Setup()
 		ImGui::End();
 	}
 
-    ParamsGPU->FillBuffer(&ParamsCPU, sizeof(SSAOParams));
+	//blur pass reads the same params later in the frame
+	ParamsGPU = m_Renderer.GetFrameAllocator().Write(ParamsCPU);
 	SetConstantBuffer(3, SSAOPass::Samples);
 	SetConstantBuffer(4, SSAOPass::ParamsGPU);
 
@@ -127,10 +121,13 @@ void SSAOBlurPass::DeclareResources()
 {
 	BluredOutput = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth, GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Transient},
 			.format = {Format::R8_UNORM},
 			.name = {"SSAO Blured"}
 		});
+
+	DeclareInput(SSAOPass::Output);
+	DeclareOutput(BluredOutput);
 }
 void SSAOBlurPass::Setup()
 {
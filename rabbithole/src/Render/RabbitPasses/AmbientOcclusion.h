@@ -30,9 +30,12 @@ BEGIN_DECLARE_RABBITPASS(SSAOPass);
 	declareResource(Output, VulkanTexture);
 	declareResource(Noise, VulkanTexture);
 	declareResource(Samples, VulkanBuffer);
-	declareResource(ParamsGPU, VulkanBuffer);
+	declareFrameAllocation(ParamsGPU);
 	static SSAOParams ParamsCPU;
 
+	virtual bool IsEnabled() override { return ParamsCPU.ssaoOn; }
+	virtual bool IsAsyncCompute() override { return ComputeSSAO; }
+
 END_DECLARE_RABBITPASS
 
 BEGIN_DECLARE_RABBITPASS(SSAOBlurPass);
@@ -0,0 +1,213 @@
+#include "Culling.h"
+
+#include "Render/RabbitPasses/GBuffer.h"
+
+defineResource(HiZPass, HiZ, VulkanTexture);
+defineResource(HiZPass, SPDAtomicCounter, VulkanBuffer);
+
+defineResource(OcclusionCullingEarlyPass, Visibility, VulkanBuffer);
+defineFrameAllocation(OcclusionCullingEarlyPass, ParamsGPU);
+OcclusionCullingEarlyPass::OcclusionCullingParams OcclusionCullingEarlyPass::ParamsCPU = {};
+
+//keep in sync with CS_OcclusionCulling
+enum OcclusionCullingPhase : uint32_t
+{
+	OcclusionCullingPhase_Early = 0,
+	OcclusionCullingPhase_Late = 1
+};
+
+constexpr uint32_t cullingThreadGroupSize = 64;
+
+static uint32_t NextPowerOfTwo(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+void HiZPass::DeclareResources()
+{
+	//pyramid is kept power of two so every texel of a mip is an exact 2x2 reduction of the previous one,
+	//mip 0 is already half of the (padded) depth resolution
+	const uint32_t hizWidth = std::max(NextPowerOfTwo(GetNativeWidth) / 2, 1u);
+	const uint32_t hizHeight = std::max(NextPowerOfTwo(GetNativeHeight) / 2, 1u);
+	const uint32_t mipCount = std::min(GET_MIP_LEVELS_FROM_RES(hizWidth, hizHeight), static_cast<uint32_t>(HIZ_MAX_MIP_COUNT));
+
+	HiZ = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
+			.dimensions = {hizWidth, hizHeight, 1},
+			.flags = {TextureFlags::Storage | TextureFlags::Read},
+			.format = {Format::R32G32_FLOAT},
+			.name = {"HiZ Depth Pyramid"},
+			.arraySize = {1},
+			.isCube = {false},
+			.multisampleType = {MultisampleType::Sample_1},
+			.samplerType = {SamplerType::Point},
+			.addressMode = {AddressMode::Clamp},
+			.mipCount = {mipCount}
+		});
+
+	for (uint32_t i = 0; i < mipCount; i++)
+	{
+		m_HiZMipChain.push_back(m_Renderer.GetResourceManager().CreateSingleMipFromTexture(m_Renderer.GetVulkanDevice(), HiZ, i));
+	}
+
+	SPDAtomicCounter = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
+			.flags = {BufferUsageFlags::StorageBuffer},
+			.memoryAccess = {MemoryAccess::GPU},
+			.size = {sizeof(uint32_t)},
+			.name = {"HiZ SPD Atomic Counter"}
+		});
+
+	//last SPD workgroup resets the counter, it only has to start from zero
+	uint32_t atomicCounterInitValue = 0;
+	SPDAtomicCounter->FillBuffer(&atomicCounterInitValue, sizeof(uint32_t));
+}
+
+void HiZPass::Setup()
+{
+	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
+
+	stateManager.SetComputeShader(m_Renderer.GetShader("CS_HiZ"));
+
+	SetCombinedImageSampler(0, GBufferPass::Depth);
+	SetStorageBufferReadWrite(1, HiZPass::SPDAtomicCounter);
+
+	//shader always declares max number of mips, slots above mip count get the last mip which is never written
+	const uint32_t lastMip = static_cast<uint32_t>(m_HiZMipChain.size()) - 1;
+	for (uint32_t i = 0; i < HIZ_MAX_MIP_COUNT; i++)
+	{
+		SetStorageImageWrite(2 + i, m_HiZMipChain[std::min(i, lastMip)]);
+	}
+
+	//SPD reads mip 5 back in the same dispatch to build the rest of the chain
+	if (lastMip >= 5)
+	{
+		SetStorageImageReadWrite(7, m_HiZMipChain[5]);
+	}
+}
+
+void HiZPass::Render()
+{
+	//every SPD workgroup reduces 64x64 tile of the source depth
+	const uint32_t dispatchX = GetCSDispatchCount(HiZ->GetWidth() * 2, 64);
+	const uint32_t dispatchY = GetCSDispatchCount(HiZ->GetHeight() * 2, 64);
+
+	SPDPushConstants pushConstants{};
+	pushConstants.mipCount = static_cast<uint32_t>(m_HiZMipChain.size());
+	pushConstants.numWorkGroups = dispatchX * dispatchY;
+	pushConstants.depthWidth = GetNativeWidth;
+	pushConstants.depthHeight = GetNativeHeight;
+	m_Renderer.BindPushConst(pushConstants);
+
+	m_Renderer.Dispatch(dispatchX, dispatchY, 1);
+
+	//culling samples the whole pyramid, so move all mips to read state with a single barrier
+	m_Renderer.ResourceBarrier(HiZ, ResourceState::GeneralComputeWrite, ResourceState::GenericRead, ResourceStage::Compute, ResourceStage::Compute);
+	for (auto mip : m_HiZMipChain)
+	{
+		mip->SetResourceState(ResourceState::GenericRead);
+		mip->SetCurrentResourceStage(ResourceStage::Compute);
+	}
+}
+
+void OcclusionCullingEarlyPass::DeclareResources()
+{
+	Visibility = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
+			.flags = {BufferUsageFlags::StorageBuffer},
+			.memoryAccess = {MemoryAccess::GPU},
+			.size = {sizeof(uint32_t) * MAX_NUM_OF_INDIRECT_DRAWS},
+			.name = {"Occlusion Culling Visibility"}
+		});
+
+	//nothing is known in the first frame, mark everything as visible so early phase draws the whole scene
+	std::vector<uint32_t> initialVisibility(MAX_NUM_OF_INDIRECT_DRAWS, 1);
+	Visibility->FillBuffer(initialVisibility.data(), sizeof(uint32_t) * MAX_NUM_OF_INDIRECT_DRAWS);
+}
+
+void OcclusionCullingEarlyPass::Setup()
+{
+	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
+
+	if (m_Renderer.IsImguiReady())
+	{
+		ImGui::Begin("Occlusion Culling");
+
+		static bool cullingEnabled = true;
+		ImGui::Checkbox("Enable Occlusion Culling: ", &cullingEnabled);
+		ParamsCPU.enabled = static_cast<uint32_t>(cullingEnabled);
+
+		ImGui::Text("Draws per phase: %u", ParamsCPU.drawCount);
+
+		ImGui::End();
+	}
+
+	const float hizWidth = static_cast<float>(HiZPass::HiZ->GetWidth());
+	const float hizHeight = static_cast<float>(HiZPass::HiZ->GetHeight());
+
+	ParamsCPU.hizSize = { hizWidth, hizHeight };
+	ParamsCPU.hizUVScale = { GetNativeWidth / (2.f * hizWidth), GetNativeHeight / (2.f * hizHeight) };
+	ParamsCPU.hizMipCount = HiZPass::HiZ->GetMipCount();
+
+	IndexedIndirectBuffer* indirectBuffer = m_Renderer.m_GeometryIndirectDrawBuffer;
+
+	//both phases bind these params, late phase writes them again once it knows its offset
+	OcclusionCullingEarlyPass::ParamsGPU = m_Renderer.GetFrameAllocator().Write(ParamsCPU);
+
+	stateManager.SetComputeShader(m_Renderer.GetShader("CS_OcclusionCulling"));
+
+	SetConstantBuffer(0, m_Renderer.GetMainConstBuffer());
+	SetCombinedImageSampler(1, HiZPass::HiZ);
+	SetStorageBufferRead(2, indirectBuffer->boundsBuffer);
+	SetStorageBufferReadWrite(3, indirectBuffer->gpuBuffer);
+	SetStorageBufferReadWrite(4, OcclusionCullingEarlyPass::Visibility);
+	SetConstantBuffer(5, OcclusionCullingEarlyPass::ParamsGPU);
+
+	uint32_t cullingPhase = OcclusionCullingPhase_Early;
+	m_Renderer.BindPushConst(cullingPhase);
+}
+
+void OcclusionCullingEarlyPass::Render()
+{
+	//draw count of this frame is known only after gbuffer is recorded, shader discards slots above it
+	m_Renderer.Dispatch(GetCSDispatchCount(MAX_NUM_OF_INDIRECT_DRAWS, cullingThreadGroupSize), 1, 1);
+}
+
+void OcclusionCullingLatePass::DeclareResources()
+{
+}
+
+void OcclusionCullingLatePass::Setup()
+{
+	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
+
+	IndexedIndirectBuffer* indirectBuffer = m_Renderer.m_GeometryIndirectDrawBuffer;
+
+	//late gbuffer records the same draws right after this pass, so its commands start at current offset.
+	//params are read on gpu only after the whole frame is submitted, so early phase sees them as well
+	auto& cullingParams = OcclusionCullingEarlyPass::ParamsCPU;
+	cullingParams.lateDrawOffset = static_cast<uint32_t>(indirectBuffer->currentOffset);
+	memcpy(OcclusionCullingEarlyPass::ParamsGPU.data, &cullingParams, sizeof(cullingParams));
+
+	stateManager.SetComputeShader(m_Renderer.GetShader("CS_OcclusionCulling"));
+
+	SetConstantBuffer(0, m_Renderer.GetMainConstBuffer());
+	SetCombinedImageSampler(1, HiZPass::HiZ);
+	SetStorageBufferRead(2, indirectBuffer->boundsBuffer);
+	SetStorageBufferReadWrite(3, indirectBuffer->gpuBuffer);
+	SetStorageBufferReadWrite(4, OcclusionCullingEarlyPass::Visibility);
+	SetConstantBuffer(5, OcclusionCullingEarlyPass::ParamsGPU);
+
+	uint32_t cullingPhase = OcclusionCullingPhase_Late;
+	m_Renderer.BindPushConst(cullingPhase);
+}
+
+void OcclusionCullingLatePass::Render()
+{
+	m_Renderer.Dispatch(GetCSDispatchCount(MAX_NUM_OF_INDIRECT_DRAWS, cullingThreadGroupSize), 1, 1);
+
+	//visibility written here is what next frame's early phase reads
+	m_Renderer.ResourceBarrier(OcclusionCullingEarlyPass::Visibility, ResourceState::BufferReadWrite, ResourceState::BufferReadWrite, ResourceStage::Compute, ResourceStage::Compute);
+}
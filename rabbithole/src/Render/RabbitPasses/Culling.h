@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Render/RabbitPass.h"
+
+//SPD can output at most 12 mips in a single dispatch
+#define HIZ_MAX_MIP_COUNT (12)
+
+BEGIN_DECLARE_RABBITPASS(HiZPass)
+
+	struct SPDPushConstants
+	{
+		uint32_t mipCount;
+		uint32_t numWorkGroups;
+		uint32_t depthWidth;
+		uint32_t depthHeight;
+	};
+
+	declareResource(HiZ, VulkanTexture);
+	declareResource(SPDAtomicCounter, VulkanBuffer);
+
+private:
+	std::vector<VulkanTexture*> m_HiZMipChain;
+
+END_DECLARE_RABBITPASS
+
+BEGIN_DECLARE_RABBITPASS(OcclusionCullingEarlyPass)
+
+	struct OcclusionCullingParams
+	{
+		uint32_t	enabled = true;
+		uint32_t	drawCount = 0;
+		uint32_t	earlyDrawOffset = 0;
+		uint32_t	lateDrawOffset = 0;
+		rabbitVec2f	hizSize;
+		rabbitVec2f	hizUVScale;
+		uint32_t	hizMipCount;
+	};
+
+	declareResource(Visibility, VulkanBuffer);
+	declareFrameAllocation(ParamsGPU);
+
+	static OcclusionCullingParams ParamsCPU;
+
+END_DECLARE_RABBITPASS
+
+BEGIN_DECLARE_RABBITPASS(OcclusionCullingLatePass)
+END_DECLARE_RABBITPASS
@@ -1,5 +1,7 @@
 #include "GBuffer.h"
 
+#include "Render/RabbitPasses/Culling.h"
+
 defineResource(GBufferPass, Albedo, VulkanTexture);
 defineResource(GBufferPass, Normals, VulkanTexture);
 defineResource(GBufferPass, Velocity, VulkanTexture);
@@ -15,14 +17,14 @@ void GBufferPass::DeclareResources()
 {
 	Albedo = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth , GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Transient},
 			.format = {Format::R8G8B8A8_UNORM},
 			.name = {"GBuffer Albedo"}
 		});
 
 	Emissive = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth , GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Transient},
 			.format = {Format::R8G8B8A8_UNORM},
 			.name = {"GBuffer Emissive"},
 			.arraySize = {1},
@@ -36,14 +38,14 @@ void GBufferPass::DeclareResources()
 
 	Normals = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth , GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Storage},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"GBuffer Normal"}
 		});
 
 	WorldPosition = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth , GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Storage},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"GBuffer World Position"}
 		});
@@ -57,7 +59,7 @@ void GBufferPass::DeclareResources()
 
 	Depth = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth , GetNativeHeight, 1},
-			.flags = {TextureFlags::DepthStencil | TextureFlags::Read | TextureFlags::TransferSrc},
+			.flags = {TextureFlags::DepthStencil | TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Transient},
 			.format = {Format::D32_SFLOAT},
 			.name = {"GBuffer Depth"}
 		});
@@ -103,11 +105,78 @@ void GBufferPass::Setup()
 	renderPassInfo->FinalDepthStencilState =	ResourceState::DepthStencilWrite;
 
 	stateManager.SetCullMode(CullMode::Front);
+
+	SetIndirectArgumentBuffer(m_Renderer.m_GeometryIndirectDrawBuffer->gpuBuffer);
 }
 
 void GBufferPass::Render()
 {
-	m_Renderer.DrawGeometryGLTF(m_Renderer.gltfModels);
+	const uint32_t firstDraw = static_cast<uint32_t>(m_Renderer.m_GeometryIndirectDrawBuffer->currentOffset);
+
+	m_Renderer.DrawGeometryGLTF(m_Renderer.modelInstances);
+
+	//culling passes patch instance count of the commands recorded here
+	OcclusionCullingEarlyPass::ParamsCPU.earlyDrawOffset = firstDraw;
+	OcclusionCullingEarlyPass::ParamsCPU.drawCount = static_cast<uint32_t>(m_Renderer.m_GeometryIndirectDrawBuffer->currentOffset) - firstDraw;
+}
+
+void GBufferLatePass::DeclareResources()
+{
+}
+
+void GBufferLatePass::Setup()
+{
+	VulkanStateManager& stateManager = m_Renderer.GetStateManager();
+
+	stateManager.SetVertexShader(m_Renderer.GetShader("VS_GBuffer"));
+	stateManager.SetPixelShader(m_Renderer.GetShader("FS_GBuffer"));
+
+	m_Renderer.BindViewport(0, 0, static_cast<float>(GetNativeWidth), static_cast<float>(GetNativeHeight));
+	stateManager.SetRenderPassExtent({ GetNativeWidth , GetNativeHeight });
+
+	//keep everything early phase has drawn
+	stateManager.ShouldCleanColor(LoadOp::Load);
+	stateManager.ShouldCleanDepth(LoadOp::Load);
+
+	auto pipelineInfo = stateManager.GetPipelineInfo();
+
+	SetConstantBuffer(0, m_Renderer.GetMainConstBuffer());
+
+	pipelineInfo->SetAttachmentCount(5);
+	pipelineInfo->SetColorWriteMask(0, ColorWriteMaskFlags::RGBA);
+	pipelineInfo->SetColorWriteMask(1, ColorWriteMaskFlags::RGBA);
+	pipelineInfo->SetColorWriteMask(2, ColorWriteMaskFlags::RGBA);
+	pipelineInfo->SetColorWriteMask(3, ColorWriteMaskFlags::RGBA);
+	pipelineInfo->SetColorWriteMask(4, ColorWriteMaskFlags::RGBA);
+
+	SetRenderTarget(0, GBufferPass::Albedo);
+	SetRenderTarget(1, GBufferPass::Normals);
+	SetRenderTarget(2, GBufferPass::WorldPosition);
+	SetRenderTarget(3, GBufferPass::Velocity);
+	SetRenderTarget(4, GBufferPass::Emissive);
+	SetDepthStencil(GBufferPass::Depth);
+
+	auto renderPassInfo = stateManager.GetRenderPassInfo();
+
+	stateManager.GetPipelineInfo()->SetDepthTestEnabled(true);
+	renderPassInfo->InitialRenderTargetState =	ResourceState::RenderTarget;
+	renderPassInfo->FinalRenderTargetState =	ResourceState::RenderTarget;
+	renderPassInfo->InitialDepthStencilState =	ResourceState::DepthStencilWrite;
+	renderPassInfo->FinalDepthStencilState =	ResourceState::DepthStencilWrite;
+
+	stateManager.SetCullMode(CullMode::Front);
+
+	SetIndirectArgumentBuffer(m_Renderer.m_GeometryIndirectDrawBuffer->gpuBuffer);
+}
+
+void GBufferLatePass::Render()
+{
+	const uint32_t firstDraw = static_cast<uint32_t>(m_Renderer.m_GeometryIndirectDrawBuffer->currentOffset);
+
+	m_Renderer.DrawGeometryGLTF(m_Renderer.modelInstances);
+
+	const uint32_t drawCount = static_cast<uint32_t>(m_Renderer.m_GeometryIndirectDrawBuffer->currentOffset) - firstDraw;
+	ASSERT(drawCount == OcclusionCullingEarlyPass::ParamsCPU.drawCount, "Early and late geometry passes must record the same draws!");
 }
 
 void CopyDepthPass::DeclareResources()
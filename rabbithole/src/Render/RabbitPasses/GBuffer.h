@@ -19,6 +19,10 @@ BEGIN_DECLARE_RABBITPASS(GBufferPass)
 
 END_DECLARE_RABBITPASS
 
+//draws objects that became visible after occlusion culling against this frame's depth
+BEGIN_DECLARE_RABBITPASS(GBufferLatePass)
+END_DECLARE_RABBITPASS
+
 BEGIN_DECLARE_RABBITPASS(CopyDepthPass)
 
 	declareResource(DepthR32, VulkanTexture);
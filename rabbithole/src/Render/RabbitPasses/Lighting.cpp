@@ -5,13 +5,12 @@
 #include "Render/RabbitPasses/Shadows.h"
 
 defineResource(LightingPass, MainLighting, VulkanTexture);
-defineResource(LightingPass, LightParamsGPU, VulkanBuffer);
 
 void LightingPass::DeclareResources()
 {
 	MainLighting = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {GetNativeWidth, GetNativeHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Storage},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"Lighting Main"},
 			.arraySize = 1,
@@ -21,12 +20,7 @@ void LightingPass::DeclareResources()
 			.addressMode = AddressMode::Clamp
 		});
 
-	LightParamsGPU = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(LightParams) * MAX_NUM_OF_LIGHTS},
-			.name = {"Light params"}
-		});
+	DeclareOptionalInput(SSAOBlurPass::BluredOutput);
 }
 
 void LightingPass::Setup()
@@ -36,7 +30,7 @@ void LightingPass::Setup()
 	stateManager.SetVertexShader(m_Renderer.GetShader("VS_PassThrough"));
 	stateManager.SetPixelShader(m_Renderer.GetShader("FS_PBR"));
 
-	//fill the light buffer
+	//lights are written to frame allocator by renderer, changes are seen from the next frame
 	if (m_Renderer.IsImguiReady())
 	{
 		ImGui::Begin("Light params");
@@ -71,16 +65,19 @@ void LightingPass::Setup()
 		ImGui::SliderFloat("size3: ", &lightParams[3].size, 0.1f, 10.f);
 
 		ImGui::End();
-	}
 
-	LightingPass::LightParamsGPU->FillBuffer(m_Renderer.lights.data(), sizeof(LightParams) * numOfLights);
+		//ssao passes are culled while it is off, so it is turned on and off from here
+		ImGui::Begin("SSAOParams");
+		ImGui::Checkbox("SSSAO On: ", &SSAOPass::ParamsCPU.ssaoOn);
+		ImGui::End();
+	}
 
 	SetCombinedImageSampler(0, GBufferPass::Albedo);
 	SetCombinedImageSampler(1, GBufferPass::Normals);
 	SetCombinedImageSampler(2, GBufferPass::WorldPosition);
 	SetConstantBuffer(3, m_Renderer.GetMainConstBuffer());
-	SetConstantBuffer(4, LightingPass::LightParamsGPU);
-	SetCombinedImageSampler(5, SSAOBlurPass::BluredOutput);
+	SetConstantBuffer(4, m_Renderer.GetLightParams());
+	SetCombinedImageSampler(5, GetInputOrFallback(SSAOBlurPass::BluredOutput, m_Renderer.g_DefaultWhiteTexture));
 	SetCombinedImageSampler(6, RTShadowsPass::ShadowMask);
 	SetCombinedImageSampler(7, GBufferPass::Velocity);
 	SetCombinedImageSampler(8, CopyDepthPass::DepthR32);
@@ -5,6 +5,5 @@
 BEGIN_DECLARE_RABBITPASS(LightingPass)
 
 	declareResource(MainLighting, VulkanTexture);
-	declareResource(LightParamsGPU, VulkanBuffer);
 
 END_DECLARE_RABBITPASS
\ No newline at end of file
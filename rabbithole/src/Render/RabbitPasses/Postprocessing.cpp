@@ -6,7 +6,7 @@
 defineResource(TonemappingPass, Output, VulkanTexture);
 
 defineResource(BloomCompute, Downsampled, VulkanTexture);
-defineResource(BloomCompute, BloomParamsGPU, VulkanBuffer);
+defineFrameAllocation(BloomCompute, BloomParamsGPU);
 defineResource(BloomCompute, BloomApplied, VulkanTexture);
 
 BloomCompute::BloomParams BloomCompute::BloomParamsCPU = {};
@@ -15,7 +15,7 @@ void BloomCompute::DeclareResources()
 {
 	BloomApplied = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = { GetUpscaledWidth, GetUpscaledHeight, 1},
-			.flags = {TextureFlags::RenderTarget | TextureFlags::Read},
+			.flags = {TextureFlags::RenderTarget | TextureFlags::Read | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"Applied Bloom Output"},
 			.arraySize = {1},
@@ -28,7 +28,7 @@ void BloomCompute::DeclareResources()
 
 	Downsampled = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = { GetUpscaledWidth, GetUpscaledHeight, 1},
-			.flags = {TextureFlags::Storage | TextureFlags::Read},
+			.flags = {TextureFlags::Storage | TextureFlags::Read | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"Bloom Downsampled"},
 			.arraySize = {1},
@@ -43,13 +43,6 @@ void BloomCompute::DeclareResources()
 	{
 		m_DownsampledMipChain.push_back(m_Renderer.GetResourceManager().CreateSingleMipFromTexture(m_Renderer.GetVulkanDevice(), Downsampled, i));
 	}
-
-	BloomParamsGPU = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(BloomParams)},
-			.name = {"Bloom Params"}
-		});
 }
 
 void BloomCompute::Setup()
@@ -68,7 +61,7 @@ void BloomCompute::Setup()
 	uint32_t width = BloomCompute::Downsampled->GetWidth();
 	uint32_t height = BloomCompute::Downsampled->GetHeight();
 
-	BloomParamsGPU->FillBuffer(&BloomParamsCPU);
+	BloomParamsGPU = m_Renderer.GetFrameAllocator().Write(BloomParamsCPU);
 
 	//DOWNSAMPLE
 	stateManager.SetComputeShader(m_Renderer.GetShader("CS_Downsample"));
@@ -14,7 +14,7 @@ BEGIN_DECLARE_RABBITPASS(BloomCompute)
 	};
 	
 	declareResource(Downsampled, VulkanTexture);
-	declareResource(BloomParamsGPU, VulkanBuffer);
+	declareFrameAllocation(BloomParamsGPU);
 	declareResource(BloomApplied, VulkanTexture);
 	
 	static BloomParams BloomParamsCPU;
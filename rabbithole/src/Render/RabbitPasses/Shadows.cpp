@@ -1,13 +1,12 @@
 #include "Shadows.h"
 
 #include "Render/RabbitPasses/GBuffer.h"
-#include "Render/RabbitPasses/Lighting.h"
 
 defineResource(RTShadowsPass, ShadowMask, VulkanTexture);
 uint32_t RTShadowsPass::ShadowResX = 0;
 uint32_t RTShadowsPass::ShadowResY = 0;
 
-defineResource(ShadowDenoisePrePass, BufferDimensions, VulkanBuffer);
+defineFrameAllocation(ShadowDenoisePrePass, BufferDimensions);
 defineResourceArray(ShadowDenoisePrePass, ShadowData, VulkanBuffer, MAX_NUM_OF_LIGHTS);
 
 defineResource(ShadowDenoiseTileClassificationPass, LastFrameDepth, VulkanTexture);
@@ -16,9 +15,9 @@ defineResourceArray(ShadowDenoiseTileClassificationPass, Moments1, VulkanTexture
 defineResourceArray(ShadowDenoiseTileClassificationPass, Reprojection0, VulkanTexture, MAX_NUM_OF_LIGHTS);
 defineResourceArray(ShadowDenoiseTileClassificationPass, Reprojection1, VulkanTexture, MAX_NUM_OF_LIGHTS);
 defineResourceArray(ShadowDenoiseTileClassificationPass, TileMetadata, VulkanBuffer, MAX_NUM_OF_LIGHTS);
-defineResource(ShadowDenoiseTileClassificationPass, ReprojectionInfo, VulkanBuffer);
+defineFrameAllocation(ShadowDenoiseTileClassificationPass, ReprojectionInfo);
 
-defineResource(ShadowDenoiseFilterPass, FilterData, VulkanBuffer);
+defineFrameAllocation(ShadowDenoiseFilterPass, FilterData);
 defineResource(ShadowDenoiseFilterPass, ShadowMask, VulkanTexture);
 
 void RTShadowsPass::DeclareResources()
@@ -30,7 +29,7 @@ void RTShadowsPass::DeclareResources()
 
 	ShadowMask = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {ShadowResX, ShadowResY, 1},
-			.flags = {TextureFlags::Read | TextureFlags::Storage},
+			.flags = {TextureFlags::Read | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R8_UNORM},
 			.name = {"Shadow Mask"},
 			.arraySize = {MAX_NUM_OF_LIGHTS},
@@ -50,7 +49,7 @@ void RTShadowsPass::Setup()
 	SetStorageImageRead(4, GBufferPass::WorldPosition);
 	SetStorageImageRead(5, GBufferPass::Normals);
 	SetStorageImageWrite(6, RTShadowsPass::ShadowMask);
-	SetConstantBuffer(7, LightingPass::LightParamsGPU);
+	SetConstantBuffer(7, m_Renderer.GetLightParams());
 	SetStorageImageRead(8, m_Renderer.blueNoise2DTexture);
 	SetConstantBuffer(9, m_Renderer.GetMainConstBuffer());
 }
@@ -75,13 +74,6 @@ void ShadowDenoisePrePass::DeclareResources()
 
 	const uint32_t tileSize = tileH * tileW;
 
-	BufferDimensions = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(DenoiseBufferDimensions)},
-			.name = {"Denoise Dimensions buffer"}
-		});
-
 	for (uint32_t i = 0; i < MAX_NUM_OF_LIGHTS; i++)
 	{
 		ShadowData[i] = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
@@ -103,7 +95,7 @@ void ShadowDenoisePrePass::Setup()
 	bufferDim.dimensions[0] = RTShadowsPass::ShadowResX;
 	bufferDim.dimensions[1] = RTShadowsPass::ShadowResY;
 
-	ShadowDenoisePrePass::BufferDimensions->FillBuffer(&bufferDim);
+	ShadowDenoisePrePass::BufferDimensions = m_Renderer.GetFrameAllocator().Write(bufferDim);
 }
 
 void ShadowDenoisePrePass::Render()
@@ -143,13 +135,6 @@ void ShadowDenoiseTileClassificationPass::DeclareResources()
             .name = {"Last Frame DepthR32"}
         });
 
-	ReprojectionInfo = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(DenoiseShadowData)},
-			.name = {"Denoise Shadow Data Buffer"}
-		});
-
 	for (uint32_t i = 0; i < MAX_NUM_OF_LIGHTS; i++)
 	{
 
@@ -209,7 +194,7 @@ void ShadowDenoiseTileClassificationPass::Setup()
 	shadowData.ProjectionInverse = cameraState.ProjectionInverseMatrix;
 	shadowData.ViewProjectionInverse = cameraState.ViewProjInverseMatrix;
 	shadowData.ReprojectionMatrix = cameraState.ProjectionMatrix * (cameraState.PrevViewMatrix * cameraState.ViewProjInverseMatrix);
-	ReprojectionInfo->FillBuffer(&shadowData);
+	ReprojectionInfo = m_Renderer.GetFrameAllocator().Write(shadowData);
 }
 
 void ShadowDenoiseTileClassificationPass::Render()
@@ -243,16 +228,9 @@ void ShadowDenoiseTileClassificationPass::ClassifyTiles(uint32_t shadowSlice)
 
 void ShadowDenoiseFilterPass::DeclareResources()
 {
-	FilterData = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(DenoiseShadowFilterData)},
-			.name = {"Denoise Shadow Filter Data Buffer"}
-		});
-
 	ShadowMask = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {RTShadowsPass::ShadowResX, RTShadowsPass::ShadowResY, 1},
-			.flags = {TextureFlags::Read | TextureFlags::Storage},
+			.flags = {TextureFlags::Read | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_UNORM},
 			.name = {"Shadow Mask Denoised"},
 			.arraySize = {MAX_NUM_OF_LIGHTS},
@@ -276,7 +254,7 @@ void ShadowDenoiseFilterPass::Setup()
 	shadowFilterData.InvBufferDimensions[0] = 1.f / float(GetNativeWidth);
 	shadowFilterData.InvBufferDimensions[1] = 1.f / float(GetNativeHeight);
 
-	ShadowDenoiseFilterPass::FilterData->FillBuffer(&shadowFilterData);
+	ShadowDenoiseFilterPass::FilterData = m_Renderer.GetFrameAllocator().Write(shadowFilterData);
 
 	m_Renderer.CopyImage(CopyDepthPass::DepthR32, ShadowDenoiseTileClassificationPass::LastFrameDepth);
 }
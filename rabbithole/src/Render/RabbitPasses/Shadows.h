@@ -19,7 +19,7 @@ BEGIN_DECLARE_RABBITPASS(ShadowDenoisePrePass);
 
 	void PrepareDenoisePass(uint32_t shadowSlice);
 
-	declareResource(BufferDimensions, VulkanBuffer);
+	declareFrameAllocation(BufferDimensions);
 	declareResourceArray(ShadowData, VulkanBuffer, MAX_NUM_OF_LIGHTS);
 
 END_DECLARE_RABBITPASS
@@ -47,7 +47,7 @@ BEGIN_DECLARE_RABBITPASS(ShadowDenoiseTileClassificationPass);
 	declareResourceArray(Reprojection1, VulkanTexture, MAX_NUM_OF_LIGHTS);
 	
 	declareResourceArray(TileMetadata, VulkanBuffer, MAX_NUM_OF_LIGHTS);
-	declareResource(ReprojectionInfo, VulkanBuffer);
+	declareFrameAllocation(ReprojectionInfo);
 
 END_DECLARE_RABBITPASS
 
@@ -65,7 +65,7 @@ BEGIN_DECLARE_RABBITPASS(ShadowDenoiseFilterPass);
 	void RenderFilterPass1(uint32_t shadowSlice);
 	void RenderFilterPass2(uint32_t shadowSlice);
 	
-	declareResource(FilterData, VulkanBuffer);
+	declareFrameAllocation(FilterData);
 	declareResource(ShadowMask, VulkanTexture);
 
 END_DECLARE_RABBITPASS
@@ -4,7 +4,7 @@
 #include "Render/RabbitPasses/Postprocessing.h"
 
 defineResource(TextureDebugPass, Output, VulkanTexture);
-defineResource(TextureDebugPass, ParamsGPU, VulkanBuffer);
+defineFrameAllocation(TextureDebugPass, ParamsGPU);
 TextureDebugPass::DebugTextureParams TextureDebugPass::ParamsCPU = {};
 
 defineResource(OutlineEntityPass, Main, VulkanTexture);
@@ -101,13 +101,6 @@ void TextureDebugPass::DeclareResources()
 		.format = {Format::R16G16B16A16_FLOAT},
 		.name = {"Debug Texture"}
 		});
-
-	ParamsGPU = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(DebugTextureParams)},
-			.name = {"Debug Texture Params"}
-		});
 }
 
 void TextureDebugPass::Setup()
@@ -117,6 +110,7 @@ void TextureDebugPass::Setup()
 	stateManager.SetVertexShader(m_Renderer.GetShader("VS_PassThrough"));
 	stateManager.SetPixelShader(m_Renderer.GetShader("FS_TextureDebug"));
 
+	TextureDebugPass::ParamsGPU = m_Renderer.GetFrameAllocator().Write(TextureDebugPass::ParamsCPU);
 	SetConstantBuffer(0, TextureDebugPass::ParamsGPU);
 
 	auto textureToBind = m_Renderer.g_DefaultWhiteTexture;
@@ -146,8 +140,6 @@ void TextureDebugPass::Setup()
 	SetCombinedImageSampler(2, textureArrayToBind);
 	SetCombinedImageSampler(3, texture3DToBind);
 
-	TextureDebugPass::ParamsGPU->FillBuffer(&TextureDebugPass::ParamsCPU);
-
 	SetRenderTarget(0, TextureDebugPass::Output);
 
 }
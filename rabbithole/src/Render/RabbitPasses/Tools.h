@@ -24,10 +24,12 @@ BEGIN_DECLARE_RABBITPASS(TextureDebugPass);
 	};
 	
 	declareResource(Output, VulkanTexture);
-	declareResource(ParamsGPU, VulkanBuffer);
+	declareFrameAllocation(ParamsGPU);
 	
 	static DebugTextureParams ParamsCPU;
 
+	virtual bool IsEnabled() override { return m_Renderer.IsTextureDebuggerVisible(); }
+
 END_DECLARE_RABBITPASS
 
 BEGIN_DECLARE_RABBITPASS(OutlineEntityPass)
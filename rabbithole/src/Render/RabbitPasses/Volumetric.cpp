@@ -4,7 +4,7 @@
 #include "Render/RabbitPasses/Lighting.h"
 
 defineResource(VolumetricPass, MediaDensity, VulkanTexture);
-defineResource(VolumetricPass, ParamsGPU, VulkanBuffer)
+defineFrameAllocation(VolumetricPass, ParamsGPU)
 VolumetricPass::VolumetricFogParams VolumetricPass::ParamsCPU = {};
 
 defineResource(ComputeScatteringPass, LightScattering, VulkanTexture);
@@ -15,17 +15,12 @@ void VolumetricPass::DeclareResources()
 {
 	MediaDensity = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {160, 90, 128},
-			.flags = {TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Storage},
+			.flags = {TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"Media Density"},
 		});
 
-	ParamsGPU = m_Renderer.GetResourceManager().CreateBuffer(m_Renderer.GetVulkanDevice(), BufferCreateInfo{
-			.flags = {BufferUsageFlags::UniformBuffer},
-			.memoryAccess = {MemoryAccess::CPU2GPU},
-			.size = {sizeof(VolumetricFogParams)},
-			.name = {"Volumetric Fog Params"}
-		});
+	DeclareOutput(MediaDensity);
 }
 
 void VolumetricPass::Setup()
@@ -34,26 +29,12 @@ void VolumetricPass::Setup()
 
 	stateManager.SetComputeShader(m_Renderer.GetShader("CS_Volumetric"));
 
-	SetStorageBufferRead(0, m_Renderer.vertexBuffer);
-	SetStorageBufferRead(1, m_Renderer.trianglesBuffer);
-	SetStorageBufferRead(2, m_Renderer.triangleIndxsBuffer);
-	SetStorageBufferRead(3, m_Renderer.cfbvhNodesBuffer);
-	SetConstantBuffer(4, VolumetricPass::ParamsGPU);
-	SetStorageImageWrite(5, VolumetricPass::MediaDensity);
-	SetCombinedImageSampler(6, m_Renderer.noise3DLUT);
-	SetConstantBuffer(7, LightingPass::LightParamsGPU);
-	SetConstantBuffer(8, m_Renderer.GetMainConstBuffer());
-
 	if (m_Renderer.IsImguiReady())
 	{
 		ImGui::Begin("Volumetric Fog:");
 
 		auto& fogParams = VolumetricPass::ParamsCPU;
 
-		static bool fogEnabled;
-		ImGui::Checkbox("Enable Fog: ", &fogEnabled);
-		fogParams.isEnabled = (uint32_t)fogEnabled;
-
 		ImGui::SliderFloat("Fog Amount: ", &(fogParams.fogAmount), 0.0001f, 0.1f);
 		ImGui::SliderFloat("Depth Scale Debug: ", &(fogParams.depthScale_debug), 0.1f, 5.f);
 		ImGui::SliderFloat("Fog Start Distance ", &(fogParams.fogStartDistance), 0.01f, 20.f);
@@ -62,7 +43,18 @@ void VolumetricPass::Setup()
 		ImGui::End();
 	}
 
-	VolumetricPass::ParamsGPU->FillBuffer(&VolumetricPass::ParamsCPU);
+	//scattering and apply passes read the same params later in the frame
+	VolumetricPass::ParamsGPU = m_Renderer.GetFrameAllocator().Write(VolumetricPass::ParamsCPU);
+
+	SetStorageBufferRead(0, m_Renderer.vertexBuffer);
+	SetStorageBufferRead(1, m_Renderer.trianglesBuffer);
+	SetStorageBufferRead(2, m_Renderer.triangleIndxsBuffer);
+	SetStorageBufferRead(3, m_Renderer.cfbvhNodesBuffer);
+	SetConstantBuffer(4, VolumetricPass::ParamsGPU);
+	SetStorageImageWrite(5, VolumetricPass::MediaDensity);
+	SetCombinedImageSampler(6, m_Renderer.noise3DLUT);
+	SetConstantBuffer(7, m_Renderer.GetLightParams());
+	SetConstantBuffer(8, m_Renderer.GetMainConstBuffer());
 }
 
 void VolumetricPass::Render()
@@ -102,10 +94,13 @@ void ComputeScatteringPass::DeclareResources()
 {
 	LightScattering = m_Renderer.GetResourceManager().CreateTexture(m_Renderer.GetVulkanDevice(), RWTextureCreateInfo{
 			.dimensions = {160, 90, 64},
-			.flags = {TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Storage},
+			.flags = {TextureFlags::Read | TextureFlags::TransferSrc | TextureFlags::Storage | TextureFlags::Transient},
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"Scattering Calculation"},
 		});
+
+	DeclareInput(VolumetricPass::MediaDensity);
+	DeclareOutput(LightScattering);
 }
 
 
@@ -141,6 +136,8 @@ void ApplyVolumetricFogPass::DeclareResources()
 			.format = {Format::R16G16B16A16_FLOAT},
 			.name = {"Volumetric Fog Output"},
 		});
+
+	DeclareOptionalInput(ComputeScatteringPass::LightScattering);
 }
 
 void ApplyVolumetricFogPass::Setup()
@@ -152,7 +149,26 @@ void ApplyVolumetricFogPass::Setup()
 
 	SetCombinedImageSampler(0, LightingPass::MainLighting);
 	SetCombinedImageSampler(1, CopyDepthPass::DepthR32);
-	SetCombinedImageSampler(2, ComputeScatteringPass::LightScattering);
+	//volumetric passes are culled while fog is off, so it is turned on and off from here
+	if (m_Renderer.IsImguiReady())
+	{
+		ImGui::Begin("Volumetric Fog:");
+
+		bool fogEnabled = VolumetricPass::ParamsCPU.isEnabled;
+		ImGui::Checkbox("Enable Fog: ", &fogEnabled);
+		VolumetricPass::ParamsCPU.isEnabled = fogEnabled;
+
+		ImGui::End();
+	}
+
+	VulkanTexture* lightScattering = GetInputOrFallback(ComputeScatteringPass::LightScattering, m_Renderer.g_Default3DTexture);
+	if (lightScattering != ComputeScatteringPass::LightScattering)
+	{
+		//params are filled by volumetric pass, without it shader still has to see that fog is off
+		VolumetricPass::ParamsGPU = m_Renderer.GetFrameAllocator().Write(VolumetricPass::ParamsCPU);
+	}
+
+	SetCombinedImageSampler(2, lightScattering);
 	SetConstantBuffer(3, m_Renderer.GetMainConstBuffer());
 	SetConstantBuffer(4, VolumetricPass::ParamsGPU);
 
@@ -6,7 +6,7 @@ BEGIN_DECLARE_RABBITPASS(VolumetricPass);
 
 	struct VolumetricFogParams
 	{
-		uint32_t	isEnabled = true;
+		uint32_t	isEnabled = false;
 		float		fogAmount = 0.006f;
 		float		depthScale_debug = 2.f;
 		float		fogStartDistance = 0.1f;
@@ -14,16 +14,21 @@ BEGIN_DECLARE_RABBITPASS(VolumetricPass);
 	};
 
 	declareResource(MediaDensity, VulkanTexture);
-	declareResource(ParamsGPU, VulkanBuffer);
+	declareFrameAllocation(ParamsGPU);
 
 	static VolumetricFogParams ParamsCPU;
 
+	virtual bool IsEnabled() override { return ParamsCPU.isEnabled; }
+	virtual bool IsAsyncCompute() override { return true; }
+
 END_DECLARE_RABBITPASS
 
 BEGIN_DECLARE_RABBITPASS(ComputeScatteringPass);
 
 	declareResource(LightScattering, VulkanTexture);
 
+	virtual bool IsAsyncCompute() override { return true; }
+
 END_DECLARE_RABBITPASS
 
 BEGIN_DECLARE_RABBITPASS(Create3DNoiseTexturePass);
@@ -5,6 +5,8 @@
 
 RenderPass::RenderPass(VulkanDevice& device, const std::vector<VulkanImageView*> renderTargetViews, const VulkanImageView* depthStencilView, const RenderPassInfo& info, const char* name)
 	: m_Device(device)
+	, m_RenderTargetViews(renderTargetViews)
+	, m_DepthStencilView(depthStencilView)
 	, m_Extent({ info.extent })
 {
 	m_RenderPass = new VulkanRenderPass(&device, renderTargetViews, depthStencilView, VulkanRenderPassInfo{
@@ -37,7 +39,7 @@ RenderPass::RenderPass(VulkanDevice& device, const std::vector<VulkanImageView*>
 	}
 }
 
-void RenderPass::BeginRenderPass(VulkanCommandBuffer& commandBuffer)
+void RenderPass::BeginRenderPass(VulkanCommandBuffer& commandBuffer, bool secondaryContents)
 {
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -49,7 +51,7 @@ void RenderPass::BeginRenderPass(VulkanCommandBuffer& commandBuffer)
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(m_RTCount);
 	renderPassInfo.pClearValues = reinterpret_cast<VkClearValue*>(m_ClearValues.data());
 
-	vkCmdBeginRenderPass(GET_VK_HANDLE(commandBuffer), &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(GET_VK_HANDLE(commandBuffer), &renderPassInfo, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 }
 
 void RenderPass::EndRenderPass(VulkanCommandBuffer& commandBuffer)
@@ -57,6 +59,16 @@ void RenderPass::EndRenderPass(VulkanCommandBuffer& commandBuffer)
 	vkCmdEndRenderPass(GET_VK_HANDLE(commandBuffer));
 }
 
+void RenderPass::RecreateFramebuffer()
+{
+	delete(m_Framebuffer);
+
+	m_Framebuffer = new VulkanFramebuffer(&m_Device, VulkanFramebufferInfo{
+			.width = m_Extent.width,
+			.height = m_Extent.height
+		}, m_RenderPass, m_RenderTargetViews, m_DepthStencilView);
+}
+
 RenderPass::~RenderPass()
 {
 	delete(m_Framebuffer);
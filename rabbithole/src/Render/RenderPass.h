@@ -34,8 +34,11 @@ public:
 
 	static void DefaultRenderPassInfo(RenderPassInfo& info, uint32_t width, uint32_t height);
 
-	void BeginRenderPass(VulkanCommandBuffer& commandBuffer);
+	//with secondary contents the pass is recorded only by executing secondary command buffers
+	void BeginRenderPass(VulkanCommandBuffer& commandBuffer, bool secondaryContents = false);
 	void EndRenderPass(VulkanCommandBuffer& commandBuffer);
+	//views of attachments were recreated, render pass must not be in use by the gpu
+	void RecreateFramebuffer();
 
 	VulkanRenderPass&	GetVulkanRenderPass() { return *m_RenderPass; }
 	VulkanFramebuffer&	GetVulkanFramebuffer() { return *m_Framebuffer; }
@@ -45,6 +48,9 @@ private:
 	VulkanRenderPass*	m_RenderPass;
 	VulkanFramebuffer*	m_Framebuffer;
 
+	std::vector<VulkanImageView*>	m_RenderTargetViews;
+	const VulkanImageView*			m_DepthStencilView;
+
 	Extent2D						m_Extent;
 	uint32_t						m_RTCount = 0;
 	bool							m_HasDepth = false;
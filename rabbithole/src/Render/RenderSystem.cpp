@@ -1,5 +1,6 @@
 #include "RenderSystem.h"
 
+#include "Core/LoadProfiler.h"
 #include "Render/Renderer.h"
 #include "Render/Window.h"
 
@@ -10,6 +11,8 @@
 
 bool RenderSystem::Init()
 {
+	LoadPhaseScope initPhase("RenderSystem init");
+
 	if (Renderer::instance().Init())
 	{
 		LOG_INFO("Renderer successfully initialized.");
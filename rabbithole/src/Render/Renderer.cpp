@@ -1,6 +1,7 @@
 #include "Renderer.h"
 
 #include "Core/Application.h"
+#include "Core/JobSystem.h"
 #include "ECS/EntityManager.h"
 #include "Input/InputManager.h"
 #include "Model/Model.h"
@@ -39,29 +40,45 @@ bool Renderer::Init()
 	m_MainCamera.Init();
 	SuperResolutionManager::instance().Init(&m_VulkanDevice);
 
-	InitDefaultTextures();
-	LoadModels();
+	m_TextureStreamer.Init(m_VulkanDevice, m_ResourceManager);
+	m_AssetRegistry.Init(this);
+
+	//shaders go first, textures can generate their mips with compute
 	LoadAndCreateShaders();
+	m_VulkanDevice.GetUploadContext().GetMipGenerator().Init(GetShader("CS_GenerateMips"));
+#ifdef PIPELINE_WARM_UP
+	m_PipelineManager.WarmUpComputePipelines(m_VulkanDevice, m_ResourceManager.GetShaders());
+#endif
+
+	//startup textures are uploaded together, with a single wait at the end. models only start loading on jobs,
+	//first frame doesn't wait for them
+	{
+		LoadPhaseScope texturesPhase("Default textures");
+		m_VulkanDevice.GetUploadContext().BeginBatch();
+		InitDefaultTextures();
+		m_VulkanDevice.GetUploadContext().EndBatch();
+	}
+	LoadModels();
 	RecreateSwapchain();
 
 	CreateUniformBuffers();
-	CreateDescriptorPool();
+	CreateDescriptorAllocators();
 	CreateCommandBuffers();
+	m_AsyncCompute.Init(m_VulkanDevice, m_VulkanSwapchain->GetImageCount());
+	m_ParallelRecorder.Init(m_VulkanDevice, m_VulkanSwapchain->GetImageCount());
+	m_FrameAllocator.Init(m_VulkanDevice, m_ResourceManager, m_VulkanSwapchain->GetImageCount());
 
-	m_RabbitPassManager.SchedulePasses(*this);
-	m_RabbitPassManager.DeclareResources();
-
-	m_GPUTimeStamps.OnCreate(&m_VulkanDevice, m_VulkanSwapchain->GetImageCount());
-
-	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
-		CreateGeometryDescriptors(gltfModels, i);
+		LoadPhaseScope passesPhase("Pass resources");
+		m_RabbitPassManager.SchedulePasses(*this);
+		m_RabbitPassManager.DeclareResources();
 	}
 
-	//for now max 10240 commands
-	m_GeometryIndirectDrawBuffer = new IndexedIndirectBuffer(m_VulkanDevice, 10240);
+	m_GPUTimeStamps.OnCreate(&m_VulkanDevice, m_VulkanSwapchain->GetImageCount());
+
+	m_GeometryIndirectDrawBuffer = new IndexedIndirectBuffer(m_VulkanDevice, MAX_NUM_OF_INDIRECT_DRAWS, m_VulkanSwapchain->GetImageCount());
 
-	//init acceleration structure
+	//init acceleration structure, placeholder until scene geometry is loaded
 	ConstructBVH();
 	InitLights();
 
@@ -73,8 +90,17 @@ bool Renderer::Shutdown()
 	VULKAN_API_CALL(vkDeviceWaitIdle(m_VulkanDevice.GetGraphicDevice()));
 
 	delete(m_GeometryIndirectDrawBuffer);
-	gltfModels.clear();
+	if (m_ShadowBVHBuild)
+	{
+		JobSystem::instance().Wait(m_ShadowBVHBuild->job);
+		m_ShadowBVHBuild.reset();
+	}
+	modelInstances.clear();
+	m_AssetRegistry.Shutdown();
+	m_TextureStreamer.Shutdown();
 	m_GPUTimeStamps.OnDestroy();
+	m_AsyncCompute.Destroy();
+	m_ParallelRecorder.Destroy();
 	SuperResolutionManager::instance().Destroy();
 	m_PipelineManager.Destroy();
 
@@ -90,6 +116,17 @@ void Renderer::Draw(float dt)
 {
 	m_CurrentDeltaTime = dt;
 
+	//pipelines are created on first use
+	std::optional<LoadPhaseScope> firstFramePhase;
+	if (m_CurrentFrameIndex == 0)
+	{
+		firstFramePhase.emplace("First frame");
+	}
+
+	m_VulkanDevice.GetUploadContext().Update();
+
+	UpdateSceneLoading();
+
 	m_MainCamera.Update(dt);
 
     DrawFrame();
@@ -113,9 +150,26 @@ void Renderer::DrawFrame()
 		return;
 	}
 
+	//per image descriptors and streaming feedback can be touched only once gpu is done with the image
+	m_VulkanSwapchain->WaitForImageInFlight(m_CurrentImageIndex);
+	const bool texturesSwapped = m_TextureStreamer.Update(m_CurrentImageIndex);
+	if (m_GeometryDescriptorsDirty[m_CurrentImageIndex])
+	{
+		//sets are looked up by current textures, so this covers textures streamer swapped as well
+		CreateGeometryDescriptors(m_CurrentImageIndex);
+		m_GeometryDescriptorsDirty[m_CurrentImageIndex] = false;
+	}
+	else if (texturesSwapped)
+	{
+		UpdateGeometryDescriptors(m_CurrentImageIndex);
+	}
+
+	//lifetimes are known after the first frame, passes are recorded with the textures already placed
+	m_RabbitPassManager.UpdateTransientAliasing(*this);
+
 	RecordCommandBuffer();
 
-	result = m_VulkanSwapchain->SubmitCommandBufferAndPresent(GetCurrentCommandBuffer(), &m_CurrentImageIndex);
+	result = m_VulkanSwapchain->SubmitCommandBufferAndPresent(GetCurrentCommandBuffer(), &m_CurrentImageIndex, m_AsyncCompute.GetFrameSync());
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_FramebufferResized)
 	{
@@ -124,76 +178,106 @@ void Renderer::DrawFrame()
 	}
 }
 
-void Renderer::CreateGeometryDescriptors(std::vector<VulkanglTFModel>& models, uint32_t imageIndex)
+void Renderer::GetGeometryDescriptorInfos(VulkanglTFModel& model, const VulkanglTFModel::Material& material, uint32_t imageIndex, std::vector<VulkanDescriptorInfo>& descriptorInfos)
 {
-	VulkanDescriptorSetLayout descrSetLayout(&m_VulkanDevice, { GetShader("VS_GBuffer"), GetShader("FS_GBuffer") }, "GeometryDescSetLayout");
+	descriptorInfos.clear();
 
 	VulkanDescriptorInfo descriptorinfo{};
 	descriptorinfo.Type = DescriptorType::UniformBuffer;
 	descriptorinfo.Binding = 0;
 	descriptorinfo.buffer = m_MainConstBuffer[imageIndex];
+	descriptorInfos.push_back(descriptorinfo);
+
+	//albedo, normal, metallicRoughness, placeholder material gets default ones
+	const uint32_t textureIndices[] = { material.baseColorTextureIndex, material.normalTextureIndex, material.metallicRoughnessTextureIndex };
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		//streamer returns texture with mips that are resident right now
+		const uint32_t textureHandle = model.GetMaterialTexture(material, textureIndices[i]);
+		VulkanTexture* texture;
+		if (textureHandle != TEXTURE_STREAMING_INVALID_HANDLE)
+			texture = m_TextureStreamer.GetTexture(textureHandle);
+		else
+			texture = g_DefaultWhiteTexture;
+
+		VulkanDescriptorInfo textureDescriptorInfo{};
+		textureDescriptorInfo.Type = DescriptorType::CombinedSampler;
+		textureDescriptorInfo.Binding = i + 1;
+		textureDescriptorInfo.imageView = texture->GetView();
+		textureDescriptorInfo.imageSampler = texture->GetSampler();
+		descriptorInfos.push_back(textureDescriptorInfo);
+	}
 
-	VulkanDescriptor* bufferDescr = new VulkanDescriptor(descriptorinfo);
+	VulkanDescriptorInfo feedbackDescriptorInfo{};
+	feedbackDescriptorInfo.Type = DescriptorType::StorageBuffer;
+	feedbackDescriptorInfo.Binding = 4;
+	feedbackDescriptorInfo.buffer = m_TextureStreamer.GetFeedbackBuffer(imageIndex);
+	descriptorInfos.push_back(feedbackDescriptorInfo);
+}
 
-	for (auto& model : models)
+void Renderer::CreateGeometryDescriptors(uint32_t imageIndex)
+{
+	if (!m_GeometryDescriptorSetLayout)
 	{
-		for (size_t i = 0; i < model.GetMaterials().size(); i++)
+		m_GeometryDescriptorSetLayout = std::make_unique<VulkanDescriptorSetLayout>(&m_VulkanDevice, std::vector<Shader*>{ GetShader("VS_GBuffer"), GetShader("FS_GBuffer") }, "GeometryDescSetLayout");
+	}
+
+	std::vector<VulkanDescriptorInfo> descriptorInfos;
+
+	//instances share materials of their model, so sets are made per model
+	m_AssetRegistry.ForEachModel([&](VulkanglTFModel& model)
 		{
-			VulkanglTFModel::Material& modelMaterial = model.GetMaterials()[i];
-			auto& modelTextures = model.GetTextures();
-			auto& modelTexureIndices = model.GetTextureIndices();
-
-			//albedo
-			VulkanTexture* albedo;
-			if (modelMaterial.baseColorTextureIndex != 0xFFFFFFFF && modelTextures.size() > 0)
-				albedo = modelTextures[modelTexureIndices[modelMaterial.baseColorTextureIndex]];
-			else
-				albedo = g_DefaultWhiteTexture;
+			if (!model.IsGeometryReady())
+			{
+				return;
+			}
 
-			VulkanDescriptorInfo descriptorinfo2{};
-			descriptorinfo2.Type = DescriptorType::CombinedSampler;
-			descriptorinfo2.Binding = 1;
-			descriptorinfo2.imageView = albedo->GetView();
-			descriptorinfo2.imageSampler = albedo->GetSampler();
+			for (size_t i = 0; i < model.GetMaterials().size(); i++)
+			{
+				VulkanglTFModel::Material& modelMaterial = model.GetMaterials()[i];
 
-			VulkanDescriptor* cisDescr = new VulkanDescriptor(descriptorinfo2);
+				GetGeometryDescriptorInfos(model, modelMaterial, imageIndex, descriptorInfos);
 
-			//normal
-			//TODO: do something with useNormalMap bool in shaders
-			VulkanTexture* normal;
-			if (modelMaterial.normalTextureIndex != 0xFFFFFFFF && modelTextures.size() > 0)
-				normal = modelTextures[modelTexureIndices[modelMaterial.normalTextureIndex]];
-			else
-				normal = g_DefaultWhiteTexture;
+				std::vector<VulkanDescriptor> descriptors(descriptorInfos.begin(), descriptorInfos.end());
+				std::vector<VulkanDescriptor*> descriptorPtrs;
+				for (VulkanDescriptor& descriptor : descriptors)
+				{
+					descriptorPtrs.push_back(&descriptor);
+				}
 
-			VulkanDescriptorInfo descriptorinfo3{};
-			descriptorinfo3.Type = DescriptorType::CombinedSampler;
-			descriptorinfo3.Binding = 2;
-			descriptorinfo3.imageView = normal->GetView();
-			descriptorinfo3.imageSampler = normal->GetSampler();
+				VulkanDescriptorSet* descriptorSet = m_PipelineManager.FindOrCreateDescriptorSet(*m_PersistentDescriptorAllocator, m_GeometryDescriptorSetLayout.get(), descriptorPtrs);
 
-			VulkanDescriptor* cis2Descr = new VulkanDescriptor(descriptorinfo3);
+				modelMaterial.materialDescriptorSet[imageIndex] = descriptorSet;
+			}
+		});
+}
 
-			//metallicRoughness
-			VulkanTexture* metallicRoughness;
-			if (modelMaterial.metallicRoughnessTextureIndex != 0xFFFFFFFF && modelTextures.size() > 0)
-				metallicRoughness = modelTextures[modelTexureIndices[modelMaterial.metallicRoughnessTextureIndex]];
-			else
-				metallicRoughness = g_DefaultWhiteTexture;
+void Renderer::UpdateGeometryDescriptors(uint32_t imageIndex)
+{
+	std::vector<VulkanDescriptorInfo> descriptorInfos;
 
-			VulkanDescriptorInfo descriptorinfo4{};
-			descriptorinfo4.Type = DescriptorType::CombinedSampler;
-			descriptorinfo4.Binding = 3;
-			descriptorinfo4.imageView = metallicRoughness->GetView();
-			descriptorinfo4.imageSampler = metallicRoughness->GetSampler();
+	//materials that share a set also share textures, so rewriting it for each of them gives the same result
+	m_AssetRegistry.ForEachModel([&](VulkanglTFModel& model)
+		{
+			if (!model.IsGeometryReady())
+			{
+				return;
+			}
 
-			VulkanDescriptor* cis3Descr = new VulkanDescriptor(descriptorinfo4);
+			for (VulkanglTFModel::Material& modelMaterial : model.GetMaterials())
+			{
+				GetGeometryDescriptorInfos(model, modelMaterial, imageIndex, descriptorInfos);
 
-			VulkanDescriptorSet* descriptorSet = m_PipelineManager.FindOrCreateDescriptorSet(m_VulkanDevice, m_DescriptorPool.get(), &descrSetLayout, { bufferDescr, cisDescr, cis2Descr, cis3Descr });
+				std::vector<VulkanDescriptor> descriptors(descriptorInfos.begin(), descriptorInfos.end());
+				std::vector<VulkanDescriptor*> descriptorPtrs;
+				for (VulkanDescriptor& descriptor : descriptors)
+				{
+					descriptorPtrs.push_back(&descriptor);
+				}
 
-			modelMaterial.materialDescriptorSet[imageIndex] = descriptorSet;
-		}
-	}
+				modelMaterial.materialDescriptorSet[imageIndex]->Update(&m_VulkanDevice, descriptorPtrs);
+			}
+		});
 }
 
 void Renderer::InitDefaultTextures()
@@ -247,10 +331,50 @@ void Renderer::InitDefaultTextures()
 
 void Renderer::LoadModels()
 {
-	//gltfModels.emplace_back(this, "res/meshes/separateObjects.gltf");
-	//gltfModels.emplace_back(this, "res/meshes/cottage.gltf");
-	gltfModels.emplace_back(this, "res/meshes/sponza/sponza.gltf");
-	//gltfModels.emplace_back(this, "res/meshes/sponzaNovaOpti.gltf");
+	//modelInstances.push_back({ m_AssetRegistry.AcquireModel("res/meshes/separateObjects.gltf", VertexLayout::Compressed) });
+	//modelInstances.push_back({ m_AssetRegistry.AcquireModel("res/meshes/cottage.gltf", VertexLayout::Compressed) });
+	m_SceneLoadPhase = LoadProfiler::instance().BeginPhase("Scene loading", LOAD_PROFILER_NO_PHASE);
+
+	modelInstances.push_back({ m_AssetRegistry.AcquireModel("res/meshes/sponza/sponza.gltf", VertexLayout::Compressed) });
+	//modelInstances.push_back({ m_AssetRegistry.AcquireModel("res/meshes/sponzaNovaOpti.gltf", VertexLayout::Compressed) });
+
+	m_SceneGeometryLoading = true;
+}
+
+void Renderer::UpdateSceneLoading()
+{
+	bool geometryLoading = false;
+	bool modelsLoading = false;
+	m_AssetRegistry.ForEachModel([&](VulkanglTFModel& model)
+		{
+			if (model.UpdateLoading())
+			{
+				std::fill(std::begin(m_GeometryDescriptorsDirty), std::end(m_GeometryDescriptorsDirty), true);
+			}
+
+			geometryLoading |= model.GetLoadState() == ModelLoadState::LoadingCPU || model.GetLoadState() == ModelLoadState::UploadingGeometry;
+			modelsLoading |= model.IsLoading();
+		});
+
+	//shadows use placeholder BVH until geometry of the whole scene is there, textures don't affect it
+	if (m_SceneGeometryLoading && !geometryLoading)
+	{
+		m_SceneGeometryLoading = false;
+		ConstructBVH();
+	}
+
+	if (m_ShadowBVHBuild && m_ShadowBVHBuild->job.pendingJobs.load(std::memory_order_acquire) == 0)
+	{
+		CreateBVHBuffers(*m_ShadowBVHBuild);
+		m_ShadowBVHBuild.reset();
+	}
+
+	if (m_SceneLoadPhase != LOAD_PROFILER_NO_PHASE && !modelsLoading && !m_SceneGeometryLoading && !m_ShadowBVHBuild)
+	{
+		LoadProfiler::instance().EndPhase(m_SceneLoadPhase);
+		LoadProfiler::instance().Report();
+		m_SceneLoadPhase = LOAD_PROFILER_NO_PHASE;
+	}
 }
 
 void Renderer::BeginLabel(const char* name)
@@ -269,28 +393,106 @@ void Renderer::RecordGPUTimeStamp(const char* label)
 		m_GPUTimeStamps.GetTimeStamp(GetCurrentCommandBuffer(), label);
 }
 
-void Renderer::DrawGeometryGLTF(std::vector<VulkanglTFModel>& bucket)
+void Renderer::DrawGeometryGLTF(std::vector<ModelInstance>& bucket)
 {
-	BindPipeline<GraphicsPipeline>();
+	//start with the layout of the first model so pipeline is not switched right away
+	if (!bucket.empty())
+	{
+		m_StateManager.SetVertexLayout(bucket[0].model->GetVertexLayout());
+	}
 
-	m_StateManager.GetRenderPass()->BeginRenderPass(GetCurrentCommandBuffer());
+	//models of a layout seen for the first time would stall the frame on their pipeline, so pipelines of every
+	//layout are compiled together the first time the pass draws, while scene is still loading
+	BindRenderPass();
+	m_PipelineManager.WarmUpGraphicsPipelines(m_VulkanDevice, *m_StateManager.GetPipelineInfo());
+
+	BindPipeline<GraphicsPipeline>();
 
+	//draws are resolved in order here, so draw ids and indirect commands don't depend on which thread records them
+	m_GeometryDraws.clear();
 	VulkanglTFModel::ms_CurrentDrawId = 0;
 
-	for (auto& model : bucket)
+	for (ModelInstance& instance : bucket)
 	{
-		model.BindBuffers(GetCurrentCommandBuffer());
+		VulkanglTFModel& model = *instance.model;
+
+		//model is not drawn until its geometry is uploaded
+		if (!model.IsGeometryReady())
+		{
+			continue;
+		}
 
-		model.Draw(GetCurrentCommandBuffer(), m_StateManager.GetPipeline()->GetPipelineLayout(), m_CurrentImageIndex, m_GeometryIndirectDrawBuffer);
+		//every vertex layout needs its own pipeline, all of them are compatible with the same render pass
+		m_StateManager.SetVertexLayout(model.GetVertexLayout());
+		const uint64_t pipelineHash = PipelineManager::GetGraphicsPipelineHash(*m_StateManager.GetPipelineInfo());
+		if (!m_StateManager.IsPipelineBound(pipelineHash))
+		{
+			VulkanPipeline* pipeline = m_PipelineManager.FindOrCreateGraphicsPipeline(m_VulkanDevice, *m_StateManager.GetPipelineInfo());
+			m_StateManager.SetPipeline(pipeline, pipelineHash);
+		}
+
+		m_InstanceDraws.clear();
+		model.CollectDraws(instance.transform, m_InstanceDraws, m_GeometryIndirectDrawBuffer);
+		for (const VulkanglTFModel::PrimitiveDraw& primitiveDraw : m_InstanceDraws)
+		{
+			m_GeometryDraws.push_back(GeometryDraw{ &model, m_StateManager.GetPipeline(), primitiveDraw });
+		}
 	}
 
-	m_GeometryIndirectDrawBuffer->SubmitToGPU();
+	const uint32_t drawCount = static_cast<uint32_t>(m_GeometryDraws.size());
+	RenderPass& renderPass = *m_StateManager.GetRenderPass();
 
-	m_StateManager.GetRenderPass()->EndRenderPass(GetCurrentCommandBuffer());
+	//big scenes are split into ranges recorded on job system, small ones are cheaper to record right here
+	if (m_ParallelRecorder.GetJobCount(drawCount) > 1)
+	{
+		renderPass.BeginRenderPass(GetCurrentCommandBuffer(), true);
+		m_ParallelRecorder.Record(GetCurrentCommandBuffer(), renderPass, drawCount, [this](VulkanCommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t endDraw)
+			{
+				RecordViewport(commandBuffer);
+				RecordGeometryDraws(commandBuffer, firstDraw, endDraw);
+			});
+	}
+	else
+	{
+		renderPass.BeginRenderPass(GetCurrentCommandBuffer());
+		RecordGeometryDraws(GetCurrentCommandBuffer(), 0, drawCount);
+	}
+
+	renderPass.EndRenderPass(GetCurrentCommandBuffer());
+
+	m_TextureStreamer.RecordFeedbackBarrier(GetCurrentCommandBuffer());
 
 	m_StateManager.Reset();
 }
 
+void Renderer::RecordGeometryDraws(VulkanCommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t endDraw)
+{
+	//state bound by this command buffer only, ranges recorded in parallel never share it
+	const VulkanPipeline* boundPipeline = nullptr;
+	const VulkanglTFModel* boundModel = nullptr;
+	bool bound16BitIndices = false;
+
+	for (uint32_t drawIndex = firstDraw; drawIndex < endDraw; drawIndex++)
+	{
+		const GeometryDraw& draw = m_GeometryDraws[drawIndex];
+
+		if (draw.pipeline != boundPipeline)
+		{
+			draw.pipeline->Bind(commandBuffer);
+			boundPipeline = draw.pipeline;
+		}
+
+		if (draw.model != boundModel)
+		{
+			draw.model->BindBuffers(commandBuffer);
+			boundModel = draw.model;
+			bound16BitIndices = true;
+		}
+
+		draw.model->RecordDraw(commandBuffer, draw.pipeline->GetPipelineLayout(), draw.primitiveDraw, m_CurrentImageIndex, m_GeometryIndirectDrawBuffer, bound16BitIndices);
+	}
+}
+
 void Renderer::DrawFullScreenQuad()
 {
 	BindPipeline<GraphicsPipeline>();
@@ -444,7 +646,7 @@ void Renderer::BindUBO()
 
 void Renderer::BindDescriptorSets()
 {
-	VulkanDescriptorSet* descriptorSet = m_StateManager.FinalizeDescriptorSet(m_VulkanDevice, m_DescriptorPool.get());
+	VulkanDescriptorSet* descriptorSet = m_StateManager.FinalizeDescriptorSet(GetFrameDescriptorAllocator());
 	VulkanPipeline* pipeline = m_StateManager.GetPipeline();
 
 	vkCmdBindDescriptorSets(
@@ -459,6 +661,8 @@ void Renderer::BindDescriptorSets()
 
 void Renderer::LoadAndCreateShaders()
 {
+	LoadPhaseScope shadersPhase("Shaders");
+
 	//TODO: implement real shader compiler and stuff
 	std::filesystem::path currentPath = std::filesystem::current_path();
 	currentPath += "\\res\\shaders";
@@ -504,6 +708,9 @@ void Renderer::LoadAndCreateShaders()
 					}
 
 					m_ResourceManager.CreateShader(m_VulkanDevice, createInfo, shaderCode, fileNameFinal.c_str());
+
+					shadersPhase.AddBytes(shaderCode.size());
+					shadersPhase.AddItems(1);
 				}
 			}
 		}
@@ -549,8 +756,18 @@ void Renderer::ResourceBarrier(VulkanBuffer* buffer, ResourceState oldLayout, Re
 	m_VulkanDevice.ResourceBarrier(GetCurrentCommandBuffer(), buffer, oldLayout, newLayout, srcStage, dstStage);
 }
 
+void Renderer::ResourceBarriers(const std::vector<VkImageMemoryBarrier2>& imageBarriers, const std::vector<VkBufferMemoryBarrier2>& bufferBarriers)
+{
+	m_VulkanDevice.ResourceBarriers(GetCurrentCommandBuffer(), imageBarriers, bufferBarriers);
+}
+
 void Renderer::RecordCommandBuffer()
 {
+	m_AsyncCompute.BeginFrame(*m_MainRenderCommandBuffers[m_CurrentImageIndex], m_CurrentImageIndex);
+	m_ParallelRecorder.BeginFrame(m_CurrentImageIndex);
+	m_FrameAllocator.BeginFrame(m_CurrentImageIndex);
+	GetFrameDescriptorAllocator().Reset();
+	m_GeometryIndirectDrawBuffer->BeginFrame(m_CurrentImageIndex);
 	GetCurrentCommandBuffer().BeginCommandBuffer();
 
 	std::vector<TimeStamp> timeStamps{};
@@ -570,6 +787,7 @@ void Renderer::RecordCommandBuffer()
 		ImGui::End();
 
 		ImGuiTextureDebugger();
+		ImGuiSceneLoading();
 
 		if (m_RecordGPUTimeStamps)
 		{
@@ -583,9 +801,11 @@ void Renderer::RecordCommandBuffer()
 	UpdateConstantBuffer();
 	BindCameraMatrices(&m_MainCamera);
 	BindUBO();
+	m_LightParams = m_FrameAllocator.Write(lights.data(), sizeof(LightParams) * numOfLights);
 
 	EXECUTE_ONCE(m_RabbitPassManager.ExecuteOneTimePasses(*this));
 	m_RabbitPassManager.ExecutePasses(*this);
+	m_AsyncCompute.EndFrame();
 
 	if (m_RecordGPUTimeStamps)
 	{
@@ -616,40 +836,14 @@ void Renderer::CreateUniformBuffers()
 		});
 }
 
-void Renderer::CreateDescriptorPool()
+void Renderer::CreateDescriptorAllocators()
 {
-	//TODO: see what to do with this, now its hard coded number of descriptors
-	VulkanDescriptorPoolSize uboPoolSize{};
-	uboPoolSize.Count = 400;
-	uboPoolSize.Type = DescriptorType::UniformBuffer;
-
-	VulkanDescriptorPoolSize samImgPoolSize{};
-	samImgPoolSize.Count = 400;
-	samImgPoolSize.Type = DescriptorType::SampledImage;
-
-	VulkanDescriptorPoolSize sPoolSize{};
-	sPoolSize.Count = 400;
-	sPoolSize.Type = DescriptorType::Sampler;
-
-	VulkanDescriptorPoolSize cisPoolSize{};
-	cisPoolSize.Count = 400;
-	cisPoolSize.Type = DescriptorType::CombinedSampler;
-
-	VulkanDescriptorPoolSize siPoolSize{};
-	siPoolSize.Count = 400;
-	siPoolSize.Type = DescriptorType::StorageImage;
-
-	VulkanDescriptorPoolSize sbPoolSize{};
-	sbPoolSize.Count = 400;
-	sbPoolSize.Type = DescriptorType::StorageBuffer;
-
-	VulkanDescriptorPoolInfo vulkanDescriptorPoolInfo{};
-
-	vulkanDescriptorPoolInfo.DescriptorSizes = { uboPoolSize, cisPoolSize, siPoolSize, sbPoolSize, samImgPoolSize, sPoolSize };
-
-	vulkanDescriptorPoolInfo.MaxSets = 2000;
+	for (uint32_t i = 0; i < m_VulkanSwapchain->GetImageCount(); i++)
+	{
+		m_FrameDescriptorAllocators.push_back(std::make_unique<DescriptorAllocator>(m_VulkanDevice));
+	}
 
-	m_DescriptorPool = std::make_unique<VulkanDescriptorPool>(&m_VulkanDevice, vulkanDescriptorPoolInfo);
+	m_PersistentDescriptorAllocator = std::make_unique<DescriptorAllocator>(m_VulkanDevice);
 }
 
 void Renderer::InitLights()
@@ -695,15 +889,37 @@ void Renderer::InitLights()
 		});
 }
 
+Renderer::ShadowBVHBuild::~ShadowBVHBuild()
+{
+	if (triIndices)
+	{
+		RABBIT_FREE(triIndices);
+	}
+	if (root)
+	{
+		RABBIT_FREE(root);
+	}
+}
+
 void Renderer::ConstructBVH()
 {
-	std::vector<Triangle> triangles;
-	std::vector<rabbitVec4f> verticesFinal;
+	LoadPhaseScope gatherPhase("Gather BVH triangles", m_SceneLoadPhase);
+
+	auto build = std::make_unique<ShadowBVHBuild>();
+	std::vector<Triangle>& triangles = build->triangles;
+	std::vector<rabbitVec4f>& verticesFinal = build->vertices;
 
 	uint32_t vertexOffset = 0;
 
-	for (auto& model : gltfModels)
+	//every instance gets its own triangles, shadow rays need them in world space
+	for (ModelInstance& instance : modelInstances)
 	{
+		VulkanglTFModel& model = *instance.model;
+		if (!model.IsGeometryReady())
+		{
+			continue;
+		}
+
 		std::vector<bool> verticesMultipliedWithMatrix;
 
 		auto modelVertexBuffer = model.GetVertexBuffer();
@@ -716,102 +932,220 @@ void Renderer::ConstructBVH()
 		VulkanBuffer stagingBuffer(m_VulkanDevice, BufferUsageFlags::TransferDst, MemoryAccess::CPU, modelVertexBuffer->GetSize(), "StagingBuffer");
 		m_VulkanDevice.CopyBuffer(tempCommandBuffer, *modelVertexBuffer, stagingBuffer, modelVertexBuffer->GetSize());
 
-		Vertex* vertexBufferCpu = (Vertex*)stagingBuffer.Map();
-		uint32_t vertexCount = static_cast<uint32_t>(modelVertexBuffer->GetSize() / sizeof(Vertex));
+		//compressed positions are relative to primitive bounds, so they are decoded while walking the primitives
+		const bool compressedVertices = model.GetVertexLayout() == VertexLayout::Compressed;
+		const uint64_t vertexStride = compressedVertices ? sizeof(CompressedVertex) : sizeof(Vertex);
+
+		void* vertexBufferCpu = stagingBuffer.Map();
+		uint32_t vertexCount = static_cast<uint32_t>(modelVertexBuffer->GetSize() / vertexStride);
 		verticesMultipliedWithMatrix.resize(vertexCount);
+		std::vector<rabbitVec3f> worldPositions(vertexCount);
 
 		VulkanBuffer stagingBuffer2(m_VulkanDevice, BufferUsageFlags::TransferDst, MemoryAccess::CPU, modelIndexBuffer->GetSize(), "StagingBuffer");
 		m_VulkanDevice.CopyBuffer(tempCommandBuffer, *modelIndexBuffer, stagingBuffer2, modelIndexBuffer->GetSize());
 
 		tempCommandBuffer.EndAndSubmitCommandBuffer();
+		gatherPhase.AddBytes(modelVertexBuffer->GetSize() + modelIndexBuffer->GetSize());
 
-		uint32_t* indexBufferCpu = (uint32_t*)stagingBuffer2.Map();
-		uint32_t indexCount = static_cast<uint32_t>(modelIndexBuffer->GetSize() / sizeof(uint32_t));
-		
-		for (auto node : model.GetNodes())
-		{ 
-			glm::mat4 nodeMatrix = node.matrix;
-			VulkanglTFModel::Node* currentParent = node.parent;
-		
-			while (currentParent)
-			{
-				nodeMatrix = currentParent->matrix * nodeMatrix;
-			    currentParent = currentParent->parent;
-			}
+		void* indexBufferCpu = stagingBuffer2.Map();
+
+		//shadow rays don't need full detail, coarser LOD keeps the BVH small
+		auto gatherNodeTriangles = [&](auto& self, const VulkanglTFModel::Node& node, const rabbitMat4f& parentMatrix) -> void
+		{
+			rabbitMat4f nodeMatrix = parentMatrix * node.matrix;
 
 			for (auto& primitive : node.mesh.primitives)
 			{
-				for (uint32_t i = primitive.firstIndex; i < primitive.firstIndex + primitive.indexCount; i++)
+				const PrimitiveLod& lod = primitive.lods[std::min<size_t>(m_ShadowBVHLod, primitive.lods.size() - 1)];
+
+				for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; i++)
 				{
-					auto currentIndex = indexBufferCpu[i];
+					auto currentIndex = model.GetVertexIndex(indexBufferCpu, primitive, i);
 					if (!verticesMultipliedWithMatrix[currentIndex])
 					{
-						vertexBufferCpu[currentIndex].position = nodeMatrix * rabbitVec4f { vertexBufferCpu[currentIndex].position, 1 };
+						rabbitVec3f position = compressedVertices
+							? static_cast<CompressedVertex*>(vertexBufferCpu)[currentIndex].DecodePosition(primitive.bbox)
+							: static_cast<Vertex*>(vertexBufferCpu)[currentIndex].position;
+						worldPositions[currentIndex] = nodeMatrix * rabbitVec4f { position, 1 };
 						verticesMultipliedWithMatrix[currentIndex] = true;
 					}
 				}
+
+				for (uint32_t j = lod.firstIndex; j + 2 < lod.firstIndex + lod.indexCount; j += 3)
+				{
+					Triangle tri;
+					tri.indices[0] = vertexOffset + model.GetVertexIndex(indexBufferCpu, primitive, j);
+					tri.indices[1] = vertexOffset + model.GetVertexIndex(indexBufferCpu, primitive, j + 1);
+					tri.indices[2] = vertexOffset + model.GetVertexIndex(indexBufferCpu, primitive, j + 2);
+
+					triangles.push_back(tri);
+				}
 			}
+
+			for (auto& child : node.children)
+			{
+				self(self, child, nodeMatrix);
+			}
+		};
+
+		for (auto& node : model.GetNodes())
+		{
+			gatherNodeTriangles(gatherNodeTriangles, node, instance.transform);
 		}
 
 		for (uint32_t k = 0; k < vertexCount; k++)
 		{
-			rabbitVec4f position = rabbitVec4f{ vertexBufferCpu[k].position, 1.f };
+			rabbitVec4f position = rabbitVec4f{ worldPositions[k], 1.f };
 			verticesFinal.push_back(position);
 		}
 
-		for (uint32_t j = 0; j < indexCount; j += 3)
-		{
-			Triangle tri;
-			tri.indices[0] = vertexOffset + indexBufferCpu[j];
-			tri.indices[1] = vertexOffset + indexBufferCpu[j + 1];
-			tri.indices[2] = vertexOffset + indexBufferCpu[j + 2];
+		vertexOffset += vertexCount;
+	}
 
-			triangles.push_back(tri);
-		}
+	gatherPhase.AddItems(triangles.size());
+	build->loadPhase = m_SceneLoadPhase;
 
-		vertexOffset += vertexCount;
+	if (triangles.empty())
+	{
+		//shadow passes need a valid BVH, single degenerate triangle is never hit
+		verticesFinal.push_back(rabbitVec4f{ 0.f, 0.f, 0.f, 1.f });
+		triangles.push_back(Triangle{ { 0, 0, 0 } });
+
+		BuildBVH(*build);
+		CreateBVHBuffers(*build);
+		return;
 	}
 
-	std::cout << triangles.size() << " triangles!" << std::endl;
+	//cache file is keyed by the gathered geometry, hashing it is left to the job
+	build->useCache = true;
 
-	uint32_t* triIndices;
-	uint32_t indicesNum = 0;
-		
-	CacheFriendlyBVHNode* root;
-	uint32_t nodeNum = 0;
+	//placeholder stays in use until the job is done
+	ShadowBVHBuild* buildPtr = build.get();
+	JobSystem::instance().Submit([buildPtr]() { BuildBVH(*buildPtr); }, &build->job);
+	m_ShadowBVHBuild = std::move(build);
+}
 
-	bool createBVH = false;
-	if (createBVH)
-	{
-		//create and store BVH data in file
-		auto node = CreateBVH(verticesFinal, triangles);
-		CreateCFBVH(triangles.data(), node, &triIndices, &indicesNum, &root, &nodeNum);
+//bump when layout of cache file or BVH nodes changes
+#define BVH_CACHE_VERSION 2
 
-		FILE* dat;
-		fopen_s(&dat, "res/bvhdata/separateObjects.bin", "wb");
+struct BVHCacheHeader
+{
+	uint32_t version;
+	uint32_t triangleCount;
+	uint64_t geometryHash;
+};
 
-		std::fwrite(&indicesNum, sizeof(uint32_t), 1, dat);
-		std::fwrite(triIndices, sizeof(uint32_t) * indicesNum, 1, dat);
-		std::fwrite(&nodeNum, sizeof(uint32_t), 1, dat);
-		std::fwrite(root, sizeof(CacheFriendlyBVHNode), nodeNum, dat);
+void Renderer::BuildBVH(ShadowBVHBuild& build)
+{
+	//vertices are already in world space, so the hash covers instance transforms as well
+	BVHCacheHeader header{ BVH_CACHE_VERSION, static_cast<uint32_t>(build.triangles.size()), 0 };
+	std::string cachePath;
+	if (build.useCache)
+	{
+		header.geometryHash = Utils::Hash64(build.vertices.data(), build.vertices.size() * sizeof(rabbitVec4f));
+		header.geometryHash = Utils::Hash64(build.triangles.data(), build.triangles.size() * sizeof(Triangle), header.geometryHash);
+		cachePath = std::format("res/bvhdata/shadow_{:016x}.bin", header.geometryHash);
+	}
 
+	//file is used only when every field of its header matches, anything else is rebuilt and overwritten
+	FILE* dat = nullptr;
+	BVHCacheHeader cachedHeader{};
+	bool createBVH = cachePath.empty() || fopen_s(&dat, cachePath.c_str(), "rb") != 0;
+	if (!createBVH && (std::fread(&cachedHeader, sizeof(BVHCacheHeader), 1, dat) != 1 || memcmp(&cachedHeader, &header, sizeof(BVHCacheHeader)) != 0))
+	{
+		LOG_WARNING("BVH cache file doesn't match scene geometry, rebuilding it!");
 		std::fclose(dat);
+		createBVH = true;
 	}
-	else
+
+	LoadPhaseScope buildPhase(createBVH ? "Build BVH" : "Load BVH cache", build.loadPhase);
+	buildPhase.AddItems(build.triangles.size());
+
+	if (!createBVH)
 	{
 		//load BVH data from file
-		FILE* dat;
-		fopen_s(&dat, "res/bvhdata/sponza.bin", "rb");
+		bool valid = std::fread(&build.indicesNum, sizeof uint32_t, 1, dat) == 1;
+		if (valid)
+		{
+			build.triIndices = RABBIT_ALLOC(uint32_t, build.indicesNum);
+			valid = std::fread(build.triIndices, sizeof uint32_t, build.indicesNum, dat) == build.indicesNum;
+		}
+		valid = valid && std::fread(&build.nodeNum, sizeof uint32_t, 1, dat) == 1;
+		if (valid)
+		{
+			build.root = RABBIT_ALLOC(CacheFriendlyBVHNode, build.nodeNum);
+			valid = std::fread(build.root, sizeof CacheFriendlyBVHNode, build.nodeNum, dat) == build.nodeNum;
+		}
 
-		std::fread(&indicesNum, sizeof uint32_t, 1, dat);
-		triIndices = RABBIT_ALLOC(uint32_t, indicesNum);
-		std::fread(triIndices, sizeof uint32_t * indicesNum, 1, dat);
-		std::fread(&nodeNum, sizeof uint32_t, 1, dat);
-		root = RABBIT_ALLOC(CacheFriendlyBVHNode, nodeNum);
-		std::fread(root, sizeof CacheFriendlyBVHNode, nodeNum, dat);
+		std::fclose(dat);
+
+		//truncated file is rebuilt like a mismatched one
+		for (uint32_t i = 0; valid && i < build.indicesNum; i++)
+		{
+			valid = build.triIndices[i] < header.triangleCount;
+		}
+
+		if (valid)
+		{
+			buildPhase.AddBytes(sizeof(BVHCacheHeader) + 2 * sizeof(uint32_t) + sizeof(uint32_t) * build.indicesNum + sizeof(CacheFriendlyBVHNode) * build.nodeNum);
+			return;
+		}
+
+		LOG_WARNING("BVH cache file is corrupted, rebuilding it!");
+		if (build.triIndices)
+		{
+			RABBIT_FREE(build.triIndices);
+			build.triIndices = nullptr;
+		}
+		if (build.root)
+		{
+			RABBIT_FREE(build.root);
+			build.root = nullptr;
+		}
+	}
+
+	//create and store BVH data in file
+	auto node = CreateBVH(build.vertices, build.triangles);
+	CreateCFBVH(build.triangles.data(), node, &build.triIndices, &build.indicesNum, &build.root, &build.nodeNum);
+
+	if (cachePath.empty())
+	{
+		return;
+	}
+
+	if (fopen_s(&dat, cachePath.c_str(), "wb") == 0)
+	{
+		std::fwrite(&header, sizeof(BVHCacheHeader), 1, dat);
+		std::fwrite(&build.indicesNum, sizeof(uint32_t), 1, dat);
+		std::fwrite(build.triIndices, sizeof(uint32_t) * build.indicesNum, 1, dat);
+		std::fwrite(&build.nodeNum, sizeof(uint32_t), 1, dat);
+		std::fwrite(build.root, sizeof(CacheFriendlyBVHNode), build.nodeNum, dat);
 
 		std::fclose(dat);
 	}
+	else
+	{
+		LOG_WARNING("Could not write BVH cache file!");
+	}
+}
+
+void Renderer::CreateBVHBuffers(ShadowBVHBuild& build)
+{
+	//replaced only once per scene load, waiting for frames that use the old BVH is simpler than deferring deletes
+	if (vertexBuffer)
+	{
+		VULKAN_API_CALL(vkDeviceWaitIdle(m_VulkanDevice.GetGraphicDevice()));
+
+		m_ResourceManager.DeleteBuffer(vertexBuffer);
+		m_ResourceManager.DeleteBuffer(trianglesBuffer);
+		m_ResourceManager.DeleteBuffer(triangleIndxsBuffer);
+		m_ResourceManager.DeleteBuffer(cfbvhNodesBuffer);
+	}
+
+	std::vector<Triangle>& triangles = build.triangles;
+	std::vector<rabbitVec4f>& verticesFinal = build.vertices;
+	const uint32_t indicesNum = build.indicesNum;
+	const uint32_t nodeNum = build.nodeNum;
 
 	vertexBuffer = m_ResourceManager.CreateBuffer(m_VulkanDevice, BufferCreateInfo{
 			.flags = {BufferUsageFlags::StorageBuffer},
@@ -843,11 +1177,8 @@ void Renderer::ConstructBVH()
    
 	vertexBuffer->FillBuffer(verticesFinal.data(), static_cast<uint32_t>(verticesFinal.size()) * sizeof(rabbitVec4f));
 	trianglesBuffer->FillBuffer(triangles.data(), static_cast<uint32_t>(triangles.size()) * sizeof(Triangle));
-	triangleIndxsBuffer->FillBuffer(triIndices, indicesNum * sizeof(uint32_t));
-	cfbvhNodesBuffer->FillBuffer(root, nodeNum * sizeof(CacheFriendlyBVHNode));
-
-	RABBIT_FREE(triIndices);
-	RABBIT_FREE(root);
+	triangleIndxsBuffer->FillBuffer(build.triIndices, indicesNum * sizeof(uint32_t));
+	cfbvhNodesBuffer->FillBuffer(build.root, nodeNum * sizeof(CacheFriendlyBVHNode));
 }
 
 void Renderer::UpdateConstantBuffer()
@@ -936,9 +1267,37 @@ void Renderer::ImguiProfilerWindow(std::vector<TimeStamp>& timeStamps)
 	ImGui::End(); // PROFILER
 }
 
+void Renderer::ImGuiSceneLoading()
+{
+	ImGui::Begin("Scene Loading");
+
+	m_AssetRegistry.ForEachModel([&](VulkanglTFModel& model)
+		{
+			ImGui::Text("%-24s: %s", model.GetName().c_str(), GetModelLoadStateName(model.GetLoadState()));
+
+			//texture count is known only once geometry is there
+			if (model.IsGeometryReady())
+			{
+				const uint32_t textureCount = model.GetTextureLoadCount();
+				const uint32_t loadedTextureCount = model.GetLoadedTextureCount();
+				const float progress = textureCount > 0 ? static_cast<float>(loadedTextureCount) / static_cast<float>(textureCount) : 1.f;
+
+				std::string progressLabel = std::format("{}/{} textures", loadedTextureCount, textureCount);
+				ImGui::ProgressBar(progress, ImVec2(-1.f, 0.f), progressLabel.c_str());
+			}
+		});
+
+	const char* shadowBVHState = m_ShadowBVHBuild ? "Building" : (m_SceneGeometryLoading ? "Placeholder" : "Ready");
+	ImGui::Text("%-24s: %s", "Shadow BVH", shadowBVHState);
+	ImGui::Text("%-24s: %.2f MB", "Streamed texture memory", static_cast<float>(m_TextureStreamer.GetStreamedMemory()) / (1024.f * 1024.f));
+
+	ImGui::End();
+}
+
 void Renderer::ImGuiTextureDebugger()
 {
-	ImGui::Begin("Texture Debugger");
+	const bool isWindowVisible = ImGui::Begin("Texture Debugger");
+	m_TextureDebuggerVisible = false;
 
 	auto& texturesMap = m_ResourceManager.GetTextures();
 	std::vector<std::pair<uint32_t, VulkanTexture*>> textures(texturesMap.begin(), texturesMap.end());
@@ -1027,6 +1386,7 @@ void Renderer::ImGuiTextureDebugger()
 		float textureHeight = static_cast<float>(currentSelectedTexture->GetHeight());
 
 		ImGui::Image(m_ImGuiManager.GetImGuiTextureFrom(TextureDebugPass::Output), GetScaledSizeWithAspectRatioKept(ImVec2(textureWidth, textureHeight)));
+		m_TextureDebuggerVisible = isWindowVisible;
 	}
 
 	ImGui::End();
@@ -1072,12 +1432,18 @@ void Renderer::BindViewport(float x, float y, float width, float height)
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
+	m_Viewport = viewport;
+	RecordViewport(GetCurrentCommandBuffer());
+}
+
+void Renderer::RecordViewport(VulkanCommandBuffer& commandBuffer)
+{
 	VkRect2D scissor{};
 	scissor.offset = { 0, 0 };
-	scissor.extent = { static_cast<uint32_t>(viewport.width), static_cast<uint32_t>(viewport.height) };
+	scissor.extent = { static_cast<uint32_t>(m_Viewport.width), static_cast<uint32_t>(m_Viewport.height) };
 
-	vkCmdSetViewport(GET_VK_HANDLE(GetCurrentCommandBuffer()), 0, 1, &viewport);
-	vkCmdSetScissor(GET_VK_HANDLE(GetCurrentCommandBuffer()), 0, 1, &scissor);
+	vkCmdSetViewport(GET_VK_HANDLE(commandBuffer), 0, 1, &m_Viewport);
+	vkCmdSetScissor(GET_VK_HANDLE(commandBuffer), 0, 1, &scissor);
 }
 
 void Renderer::BindVertexData(size_t offset)
@@ -1133,29 +1499,54 @@ void Renderer::CopyBuffer(VulkanBuffer& src, VulkanBuffer& dst, uint64_t size /*
 	m_VulkanDevice.CopyBuffer(GetCurrentCommandBuffer(), src, dst, size, srcOffset, dstOffset);
 }
 
-IndexedIndirectBuffer::IndexedIndirectBuffer(VulkanDevice& device, uint32_t numCommands)
-	: gpuBuffer(device, BufferUsageFlags::IndirectBuffer | BufferUsageFlags::TransferSrc, MemoryAccess::CPU2GPU, sizeof(IndexIndirectDrawData)* numCommands, "GeomDataIndirectDraw")
+IndexedIndirectBuffer::IndexedIndirectBuffer(VulkanDevice& device, uint32_t numCommands, uint32_t imageCount)
 {
-	localBuffer = RABBIT_ALLOC(IndexIndirectDrawData, numCommands);
+	for (uint32_t i = 0; i < imageCount; i++)
+	{
+		gpuBuffers.push_back(std::make_unique<VulkanBuffer>(device, BufferUsageFlags::IndirectBuffer | BufferUsageFlags::StorageBuffer | BufferUsageFlags::TransferSrc, MemoryAccess::CPU2GPU, sizeof(IndexIndirectDrawData) * numCommands, "GeomDataIndirectDraw"));
+		boundsBuffers.push_back(std::make_unique<VulkanBuffer>(device, BufferUsageFlags::StorageBuffer, MemoryAccess::CPU2GPU, sizeof(IndirectDrawBounds) * numCommands, "GeomDataIndirectDrawBounds"));
+	}
+	currentSize = numCommands;
+
+	BeginFrame(0);
 }
 
-IndexedIndirectBuffer::~IndexedIndirectBuffer()
+void IndexedIndirectBuffer::BeginFrame(uint32_t imageIndex)
 {
-	RABBIT_FREE(localBuffer);
+	gpuBuffer = gpuBuffers[imageIndex].get();
+	mappedCommands = static_cast<IndexIndirectDrawData*>(gpuBuffer->Map());
+	boundsBuffer = boundsBuffers[imageIndex].get();
+	mappedBounds = static_cast<IndirectDrawBounds*>(boundsBuffer->Map());
 }
 
-void IndexedIndirectBuffer::SubmitToGPU()
+
+uint64_t IndexedIndirectBuffer::ReserveIndirectDrawCommands(uint32_t commandCount)
 {
-	gpuBuffer.FillBuffer(localBuffer, currentOffset * sizeof(IndexIndirectDrawData));
+	ASSERT(currentOffset + commandCount <= currentSize, "Reached max number of indirect draw commands!");
+
+	const uint64_t firstCommand = currentOffset;
+	currentOffset += commandCount;
+	return firstCommand;
 }
 
+void IndexedIndirectBuffer::SetIndirectDrawCommand(uint64_t command, const IndexIndirectDrawData& drawData, const IndirectDrawBounds& drawBounds)
+{
+	ASSERT(command < currentOffset, "Setting indirect draw command that is not reserved!");
+
+	mappedCommands[command] = drawData;
+	mappedBounds[command] = drawBounds;
+}
 
-void IndexedIndirectBuffer::AddIndirectDrawCommand(VulkanCommandBuffer& commandBuffer, IndexIndirectDrawData& drawData)
+void IndexedIndirectBuffer::DrawIndirectCommands(VulkanCommandBuffer& commandBuffer, uint64_t firstCommand, uint32_t commandCount)
 {
-    vkCmdDrawIndexedIndirect(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE(gpuBuffer), currentOffset * sizeof(IndexIndirectDrawData), 1, sizeof(IndexIndirectDrawData));
-	
-	localBuffer[currentOffset] = drawData;
-	currentOffset++;
+	ASSERT(firstCommand + commandCount <= currentOffset, "Drawing indirect commands that are not added!");
+
+	if (commandCount == 0)
+	{
+		return;
+	}
+
+	vkCmdDrawIndexedIndirect(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE_PTR(gpuBuffer), firstCommand * sizeof(IndexIndirectDrawData), commandCount, sizeof(IndexIndirectDrawData));
 }
 
 void IndexedIndirectBuffer::Reset()
@@ -1163,12 +1554,8 @@ void IndexedIndirectBuffer::Reset()
 	currentOffset = 0;
 }
 
-template<>
-void Renderer::BindPipeline<GraphicsPipeline>()
+void Renderer::BindRenderPass()
 {
-	m_ResourceStateTrackingManager.CommitBarriers(*this);
-
-	//renderpass
 	std::vector<VulkanImageView*>& attachments = m_StateManager.GetRenderTargets();
 	VulkanImageView* depthStencil = m_StateManager.GetDepthStencil();
 	RenderPassInfo* renderPassInfo = m_StateManager.GetRenderPassInfo();
@@ -1180,16 +1567,27 @@ void Renderer::BindPipeline<GraphicsPipeline>()
 
 	m_StateManager.SetRenderPass(renderpass);
 
+	m_StateManager.GetPipelineInfo()->renderPass = &m_StateManager.GetRenderPass()->GetVulkanRenderPass();
+}
+
+template<>
+void Renderer::BindPipeline<GraphicsPipeline>()
+{
+	m_ResourceStateTrackingManager.CommitBarriers(*this);
+
+	BindRenderPass();
+
 	//pipeline
 	PipelineInfo* pipelineInfo = m_StateManager.GetPipelineInfo();
 
-	pipelineInfo->renderPass = &m_StateManager.GetRenderPass()->GetVulkanRenderPass();
+	//bound pipeline is kept while the state is unchanged, map is searched only when the state really changed
+	const uint64_t pipelineHash = PipelineManager::GetGraphicsPipelineHash(*pipelineInfo);
 	VulkanPipeline* pipeline =
-		m_StateManager.GetPipelineDirty()
+		!m_StateManager.IsPipelineBound(pipelineHash)
 		? m_PipelineManager.FindOrCreateGraphicsPipeline(m_VulkanDevice, *pipelineInfo)
 		: m_StateManager.GetPipeline();
 
-	m_StateManager.SetPipeline(pipeline);
+	m_StateManager.SetPipeline(pipeline, pipelineHash);
 
 	pipeline->Bind(GetCurrentCommandBuffer());
 
@@ -1205,11 +1603,12 @@ void Renderer::BindPipeline<ComputePipeline>()
 
 	PipelineInfo* pipelineInfo = m_StateManager.GetPipelineInfo();
 
-	VulkanPipeline* computePipeline = m_StateManager.GetPipelineDirty()
+	const uint64_t pipelineHash = PipelineManager::GetComputePipelineHash(*pipelineInfo);
+	VulkanPipeline* computePipeline = !m_StateManager.IsPipelineBound(pipelineHash)
 		? m_PipelineManager.FindOrCreateComputePipeline(m_VulkanDevice, *pipelineInfo)
 		: m_StateManager.GetPipeline();
 
-	m_StateManager.SetPipeline(computePipeline);
+	m_StateManager.SetPipeline(computePipeline, pipelineHash);
 
 	computePipeline->Bind(GetCurrentCommandBuffer());
 
@@ -1,10 +1,16 @@
 #pragma once
 #include "common.h"
 
+#include "Core/LoadProfiler.h"
+#include "Render/AsyncCompute.h"
+#include "Render/AssetRegistry.h"
 #include "Logger/Logger.h"
 #include "Render/BVH.h"
 #include "Render/Camera.h"
+#include "Render/DescriptorAllocator.h"
+#include "Render/FrameAllocator.h"
 #include "Render/ImGuiManager.h"
+#include "Render/ParallelRecording.h"
 #include "Render/Model/Model.h"
 #include "Render/PipelineManager.h"
 #include "Render/RenderPass.h"
@@ -12,6 +18,7 @@
 #include "Render/ResourceStateTracking.h"
 #include "Render/RabbitPassManager.h"
 #include "Render/SuperResolutionManager.h"
+#include "Render/TextureStreamer.h"
 #include "Render/Vulkan/Include/VulkanWrapper.h"
 #include "Render/Window.h"
 
@@ -89,19 +96,32 @@ struct UniformBufferObject
 	rabbitVec4f currentFrameInfo;
 };
 
+#define MAX_NUM_OF_INDIRECT_DRAWS 65536
+
 struct IndexedIndirectBuffer
 {
-	IndexedIndirectBuffer(VulkanDevice& device, uint32_t numCommands);
-	~IndexedIndirectBuffer();
+	IndexedIndirectBuffer(VulkanDevice& device, uint32_t numCommands, uint32_t imageCount);
+
+	//commands are rewritten every frame, so every swapchain image has its own buffers and frames in flight keep theirs
+	std::vector<std::unique_ptr<VulkanBuffer>> gpuBuffers;
+	std::vector<std::unique_ptr<VulkanBuffer>> boundsBuffers;
 
-	VulkanBuffer gpuBuffer;
-	IndexIndirectDrawData* localBuffer;
+	//buffers of the frame that is recorded, commands are written straight to their mapped memory
+	VulkanBuffer* gpuBuffer = nullptr;
+	IndexIndirectDrawData* mappedCommands = nullptr;
+
+	//bounds are stored per command so gpu culling can patch instanceCount in gpuBuffer
+	VulkanBuffer* boundsBuffer = nullptr;
+	IndirectDrawBounds* mappedBounds = nullptr;
 
 	uint64_t currentSize = 0;
 	uint64_t currentOffset = 0;
 
-	void SubmitToGPU();
-	void AddIndirectDrawCommand(VulkanCommandBuffer& commandBuffer, IndexIndirectDrawData& drawData);
+	void BeginFrame(uint32_t imageIndex);
+	//commands are reserved in draw order on the main thread, filled later by whichever thread records the draw
+	uint64_t ReserveIndirectDrawCommands(uint32_t commandCount);
+	void SetIndirectDrawCommand(uint64_t command, const IndexIndirectDrawData& drawData, const IndirectDrawBounds& drawBounds);
+	void DrawIndirectCommands(VulkanCommandBuffer& commandBuffer, uint64_t firstCommand, uint32_t commandCount);
 	void Reset();
 };
 
@@ -117,15 +137,60 @@ private:
 	RabbitPassManager									m_RabbitPassManager{};
 	PipelineManager										m_PipelineManager{};
 	ImGuiManager										m_ImGuiManager{};
+	TextureStreamer										m_TextureStreamer{};
+	AssetRegistry										m_AssetRegistry{};
+	AsyncComputeScheduler								m_AsyncCompute{};
+	ParallelCommandRecorder								m_ParallelRecorder{};
+	FrameAllocator										m_FrameAllocator{};
 
 	std::unique_ptr<VulkanSwapchain>					m_VulkanSwapchain;
-	std::unique_ptr<VulkanDescriptorPool>				m_DescriptorPool;
+	//sets of pass binds are allocated per swapchain image and reset once the image is out of flight,
+	//material sets are cached for the whole run and come from persistent allocator
+	std::vector<std::unique_ptr<DescriptorAllocator>>	m_FrameDescriptorAllocators;
+	std::unique_ptr<DescriptorAllocator>				m_PersistentDescriptorAllocator;
+	std::unique_ptr<VulkanDescriptorSetLayout>			m_GeometryDescriptorSetLayout; //material sets are updated through its template
 	std::vector<std::unique_ptr<VulkanCommandBuffer>>	m_MainRenderCommandBuffers;
 	uint32_t											m_CurrentImageIndex = 0;
 	uint64_t											m_CurrentFrameIndex = 0;
+	bool												m_TextureDebuggerVisible = false;
+	VkViewport											m_Viewport{}; //last bound, secondary command buffers don't inherit it
 
 	VulkanBuffer*	m_MainConstBuffer[MAX_FRAMES_IN_FLIGHT];
+	FrameAllocation	m_LightParams{}; //read by passes before lighting as well, so it is written once per frame
 	VulkanBuffer*	m_VertexUploadBuffer;
+
+	//models got new material textures, sets of every image are looked up again once it is out of flight
+	bool			m_GeometryDescriptorsDirty[MAX_FRAMES_IN_FLIGHT] = {};
+	bool			m_SceneGeometryLoading = false;
+	//load profile is reported once the whole scene is loaded
+	uint32_t		m_SceneLoadPhase = LOAD_PROFILER_NO_PHASE;
+
+	//shadow BVH is built on a job from geometry of loaded models, buffers are replaced once it is done
+	struct ShadowBVHBuild
+	{
+		~ShadowBVHBuild();
+
+		JobCounter					job;
+		std::vector<Triangle>		triangles;
+		std::vector<rabbitVec4f>	vertices;
+		bool						useCache = false; //placeholder is never cached
+		uint32_t*					triIndices = nullptr;
+		uint32_t					indicesNum = 0;
+		CacheFriendlyBVHNode*		root = nullptr;
+		uint32_t					nodeNum = 0;
+		uint32_t					loadPhase = LOAD_PROFILER_NO_PHASE;
+	};
+	std::unique_ptr<ShadowBVHBuild>	m_ShadowBVHBuild;
+
+	//primitive draws of geometry pass with pipeline resolved, recorded in ranges on any thread
+	struct GeometryDraw
+	{
+		const VulkanglTFModel*			model;
+		VulkanPipeline*					pipeline;
+		VulkanglTFModel::PrimitiveDraw	primitiveDraw;
+	};
+	std::vector<GeometryDraw>						m_GeometryDraws;
+	std::vector<VulkanglTFModel::PrimitiveDraw>		m_InstanceDraws;
 	
 	Camera			m_MainCamera{};
 	CameraState		m_CurrentCameraState{};
@@ -137,10 +202,16 @@ private:
 	void CreateCommandBuffers();
 	void RecreateSwapchain();
 	void CreateUniformBuffers();
-	void CreateDescriptorPool();
+	void CreateDescriptorAllocators();
 
 	void InitLights();
+	//without loaded geometry placeholder BVH is created right away, otherwise build is started on a job
 	void ConstructBVH();
+	static void BuildBVH(ShadowBVHBuild& build);
+	void CreateBVHBuffers(ShadowBVHBuild& build);
+	//advances loading of every model, once scene geometry is loaded shadow BVH is rebuilt
+	void UpdateSceneLoading();
+	void ImGuiSceneLoading();
 	void UpdateConstantBuffer();
 	void UpdateUIStateAndFSR2PreDraw();
 	void ImguiProfilerWindow(std::vector<TimeStamp>& timestamps);
@@ -148,8 +219,12 @@ private:
 	ImVec2 GetScaledSizeWithAspectRatioKept(ImVec2 currentSize);
 
 	void RecordCommandBuffer();
+	void RecordGeometryDraws(VulkanCommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t endDraw);
+	void RecordViewport(VulkanCommandBuffer& commandBuffer);
 
 	void BindPushConstInternal();
+	//finds render pass of the bound targets, pipeline state is made compatible with it
+	void BindRenderPass();
 	template<class T = Pipeline> void BindPipeline();
 	template<> void BindPipeline<GraphicsPipeline>();
 	template<> void BindPipeline<ComputePipeline>();
@@ -163,16 +238,25 @@ public:
 	inline ResourceStateTrackingManager&	GetResourceStateTrackingManager() { return m_ResourceStateTrackingManager; }
 	inline ResourceManager&					GetResourceManager() { return m_ResourceManager; }
 	inline RabbitPassManager&				GetRabbitPassManager() { return m_RabbitPassManager; }
+	inline AsyncComputeScheduler&			GetAsyncCompute() { return m_AsyncCompute; }
+	//constants written during the frame, they live until the same swapchain image is recorded again
+	inline FrameAllocator&					GetFrameAllocator() { return m_FrameAllocator; }
+	//debug texture pass runs only while its output is shown
+	inline bool								IsTextureDebuggerVisible() const { return m_TextureDebuggerVisible; }
 	inline PipelineManager&					GetPipelineManager() { return m_PipelineManager; }
+	inline TextureStreamer&					GetTextureStreamer() { return m_TextureStreamer; }
+	inline AssetRegistry&					GetAssetRegistry() { return m_AssetRegistry; }
 
 	inline VulkanSwapchain*					GetSwapchain() const { return m_VulkanSwapchain.get(); }
 	inline VulkanImageView*					GetSwapchainImage() { return m_VulkanSwapchain->GetImageView(m_CurrentImageIndex); }
-	inline VulkanDescriptorPool&			GetDescriptorPool() { return *m_DescriptorPool; }
+	inline DescriptorAllocator&				GetFrameDescriptorAllocator() { return *m_FrameDescriptorAllocators[m_CurrentImageIndex]; }
 	inline VulkanBuffer*					GetVertexUploadBuffer() { return m_VertexUploadBuffer; }
 	inline VulkanBuffer*					GetMainConstBuffer() { return m_MainConstBuffer[m_CurrentImageIndex]; }
+	inline const FrameAllocation&			GetLightParams() const { return m_LightParams; }
 
 	void ResourceBarrier(VulkanTexture* texture, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage, uint32_t mipLevel = 0, uint32_t mipCount = UINT32_MAX);
 	void ResourceBarrier(VulkanBuffer* buffer, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage);
+	void ResourceBarriers(const std::vector<VkImageMemoryBarrier2>& imageBarriers, const std::vector<VkBufferMemoryBarrier2>& bufferBarriers);
     void CopyImageToBuffer(VulkanTexture* texture, VulkanBuffer* buffer);
     void CopyBufferToImage( VulkanBuffer* buffer, VulkanTexture* texture);
 	void CopyImage(VulkanTexture* src, VulkanTexture* dst);
@@ -202,13 +286,15 @@ public:
 	void DrawVertices(uint32_t count);
 	void Dispatch(uint32_t x, uint32_t y, uint32_t z);
 	void CopyToSwapChain();
-	void DrawGeometryGLTF(std::vector<VulkanglTFModel>& bucket);
+	void DrawGeometryGLTF(std::vector<ModelInstance>& bucket);
 	void DrawFullScreenQuad();
 
 	uint32_t	GetCurrentImageIndex() { return m_CurrentImageIndex; }
 	uint64_t	GetCurrentFrameIndex() { return m_CurrentFrameIndex; }
+	uint32_t	GetSceneLoadPhase() const { return m_SceneLoadPhase; }
 	
-	VulkanCommandBuffer& GetCurrentCommandBuffer() { return *m_MainRenderCommandBuffers[m_CurrentImageIndex]; }
+	//batch of the queue current pass is recorded to when passes are split between graphics and async compute
+	VulkanCommandBuffer& GetCurrentCommandBuffer() { VulkanCommandBuffer* batch = m_AsyncCompute.GetCommandBuffer(); return batch ? *batch : *m_MainRenderCommandBuffers[m_CurrentImageIndex]; }
 
 	//debugging
 	void RecordGPUTimeStamp(const char* label);
@@ -216,7 +302,8 @@ public:
 	void EndLabel();
 
 public:
-	std::vector<VulkanglTFModel> gltfModels;
+	//models are shared through asset registry, instances only place them in the scene
+	std::vector<ModelInstance> modelInstances;
 	std::vector<LightParams> lights;
 
 	//default textures;
@@ -233,10 +320,12 @@ public:
 	uint32_t currentTextureSelectedID;
 	
 	//BVH Construction
-	VulkanBuffer* vertexBuffer;
-	VulkanBuffer* trianglesBuffer;
-	VulkanBuffer* triangleIndxsBuffer;
-	VulkanBuffer* cfbvhNodesBuffer;
+	VulkanBuffer* vertexBuffer = nullptr;
+	VulkanBuffer* trianglesBuffer = nullptr;
+	VulkanBuffer* triangleIndxsBuffer = nullptr;
+	VulkanBuffer* cfbvhNodesBuffer = nullptr;
+	//LOD used for shadow BVH geometry, clamped to the coarsest LOD of every primitive
+	uint32_t m_ShadowBVHLod = 1;
 
 	//frustrum 3d map
 	VulkanTexture* noise3DLUT;
@@ -255,7 +344,11 @@ public:
     void DrawFrame();
 
 private:
-	void CreateGeometryDescriptors(std::vector<VulkanglTFModel>& models, uint32_t imageIndex);
+	//materials are given sets matching their current textures, models without geometry are skipped
+	void CreateGeometryDescriptors(uint32_t imageIndex);
+	//streamed textures were swapped, existing sets of the image get their current views
+	void UpdateGeometryDescriptors(uint32_t imageIndex);
+	void GetGeometryDescriptorInfos(VulkanglTFModel& model, const VulkanglTFModel::Material& material, uint32_t imageIndex, std::vector<VulkanDescriptorInfo>& descriptorInfos);
 	void InitDefaultTextures();
 	float m_CurrentDeltaTime;
 
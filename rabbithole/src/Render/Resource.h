@@ -69,6 +69,7 @@ struct ROTextureCreateInfo
 	std::string		name = "ROTexture";
 	bool			isCube = false;
 	bool			generateMips = false;
+	MipGenerationFlags mipGenerationFlags = MipGenerationFlags::None;
 	SamplerType     samplerType = SamplerType::Bilinear;
 	AddressMode		addressMode = AddressMode::Repeat;
 };
@@ -1,10 +1,20 @@
 #include "ResourceManager.h"
 
+#include "Render/Converters.h"
 #include "Render/Vulkan/VulkanTexture.h"
 #include "Render/Vulkan/VulkanBuffer.h"
 #include "Logger/Logger.h"
 #include "Utils/utils.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <format>
+
+static double GetMegabytes(uint64_t bytes)
+{
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
 ResourceManager::~ResourceManager()
 {
 	//TODO: since VulkanTexture can have reference to some other's texture Resource and Sampler
@@ -12,10 +22,13 @@ ResourceManager::~ResourceManager()
 	for (auto texture : m_Textures) { delete(texture.second); }
 	for (auto shader : m_Shaders) { delete(shader.second); }
 	for (auto buffer : m_Buffers) { delete(buffer.second); }
+	for (auto heap : m_TransientHeaps) { vmaFreeMemory(m_TransientAllocator, heap); }
 
 	m_Textures.clear();
 	m_Shaders.clear();
 	m_Buffers.clear();
+	m_TexturesByPath.clear();
+	m_PathTextures.clear();
 }
 
 VulkanTexture* ResourceManager::CreateSingleMipFromTexture(VulkanDevice& device, const VulkanTexture* texture, uint32_t mipSlice)
@@ -29,6 +42,18 @@ VulkanTexture* ResourceManager::CreateSingleMipFromTexture(VulkanDevice& device,
 
 VulkanTexture* ResourceManager::CreateTexture(VulkanDevice& device, std::string path, ROTextureCreateInfo createInfo)
 {
+	//everything but the debug name decides what gets created, sampler is owned by the texture as well
+	const std::string key = std::format("{}:{}:{}:{}:{}:{}:{}", std::filesystem::path(path).lexically_normal().generic_string(),
+		static_cast<uint32_t>(createInfo.format), static_cast<uint32_t>(createInfo.flags), createInfo.generateMips,
+		static_cast<uint32_t>(createInfo.mipGenerationFlags), static_cast<uint32_t>(createInfo.samplerType), static_cast<uint32_t>(createInfo.addressMode));
+
+	auto cachedTexture = m_TexturesByPath.find(key);
+	if (cachedTexture != m_TexturesByPath.end())
+	{
+		m_PathTextures[cachedTexture->second->GetID()].refCount++;
+		return cachedTexture->second;
+	}
+
 	bool isCubeMap = IsFlagSet(createInfo.flags & TextureFlags::CubeMap);
 
 	TextureData* texData = nullptr;
@@ -62,6 +87,8 @@ VulkanTexture* ResourceManager::CreateTexture(VulkanDevice& device, std::string
 	TextureLoading::FreeTexture(texData);
 
 	m_Textures[newTexture->GetID()] = newTexture;
+	m_TexturesByPath[key] = newTexture;
+	m_PathTextures[newTexture->GetID()] = PathTexture{ key, 1 };
 
 	return newTexture;
 }
@@ -84,6 +111,30 @@ VulkanTexture* ResourceManager::CreateTexture(VulkanDevice& device, const Textur
 	return newTexture;
 }
 
+void ResourceManager::DeleteTexture(VulkanTexture* texture)
+{
+	auto pathTexture = m_PathTextures.find(texture->GetID());
+	if (pathTexture != m_PathTextures.end())
+	{
+		if (--pathTexture->second.refCount > 0)
+		{
+			return;
+		}
+
+		m_TexturesByPath.erase(pathTexture->second.key);
+		m_PathTextures.erase(pathTexture);
+	}
+
+	m_Textures.erase(texture->GetID());
+	delete(texture);
+}
+
+void ResourceManager::DeleteBuffer(VulkanBuffer* buffer)
+{
+	m_Buffers.erase(buffer->GetID());
+	delete(buffer);
+}
+
 VulkanBuffer* ResourceManager::CreateBuffer(VulkanDevice& device, BufferCreateInfo createInfo)
 {
 	VulkanBuffer* newBuffer = new VulkanBuffer(device, createInfo);
@@ -93,6 +144,118 @@ VulkanBuffer* ResourceManager::CreateBuffer(VulkanDevice& device, BufferCreateIn
 	return newBuffer;
 }
 
+std::unordered_set<uint32_t> ResourceManager::AliasTransientTextures(VulkanDevice& device, const std::vector<TransientTextureLifetime>& lifetimes)
+{
+	struct TransientImage
+	{
+		const TransientTextureLifetime*	lifetime;
+		VkMemoryRequirements			requirements;
+	};
+
+	struct TransientHeap
+	{
+		VkMemoryRequirements			requirements;
+		std::vector<TransientImage>		images;
+	};
+
+	std::vector<TransientImage> images;
+	for (const TransientTextureLifetime& lifetime : lifetimes)
+	{
+		images.push_back(TransientImage{ &lifetime, lifetime.image->GetMemoryRequirements() });
+	}
+
+	//largest images open the heaps, smaller ones fill them
+	std::sort(images.begin(), images.end(), [](const TransientImage& a, const TransientImage& b) { return a.requirements.size > b.requirements.size; });
+
+	std::vector<TransientHeap> heaps;
+	uint64_t dedicatedSize = 0;
+	for (const TransientImage& image : images)
+	{
+		dedicatedSize += image.requirements.size;
+
+		auto heap = std::find_if(heaps.begin(), heaps.end(), [&image](const TransientHeap& heap)
+			{
+				if ((heap.requirements.memoryTypeBits & image.requirements.memoryTypeBits) == 0)
+				{
+					return false;
+				}
+
+				return std::none_of(heap.images.begin(), heap.images.end(), [&image](const TransientImage& other)
+					{
+						return image.lifetime->firstPass <= other.lifetime->lastPass && other.lifetime->firstPass <= image.lifetime->lastPass;
+					});
+			});
+
+		if (heap == heaps.end())
+		{
+			heaps.push_back(TransientHeap{ image.requirements, { image } });
+			continue;
+		}
+
+		heap->requirements.size = std::max(heap->requirements.size, image.requirements.size);
+		heap->requirements.alignment = std::max(heap->requirements.alignment, image.requirements.alignment);
+		heap->requirements.memoryTypeBits &= image.requirements.memoryTypeBits;
+		heap->images.push_back(image);
+	}
+
+	//previous heaps are freed only after images on them are destroyed
+	std::vector<VmaAllocation> previousHeaps = std::move(m_TransientHeaps);
+	m_TransientHeaps.clear();
+	m_TransientAllocator = device.GetVmaAllocator();
+
+	VmaAllocationCreateInfo allocationCreateInfo = {};
+	allocationCreateInfo.usage = GetVmaMemoryUsageFrom(MemoryAccess::GPU);
+
+	std::unordered_set<const VulkanImage*> aliasedImages;
+	uint64_t aliasedSize = 0;
+	for (const TransientHeap& heap : heaps)
+	{
+		VmaAllocation allocation;
+		VULKAN_API_CALL(vmaAllocateMemory(m_TransientAllocator, &heap.requirements, &allocationCreateInfo, &allocation, nullptr));
+		m_TransientHeaps.push_back(allocation);
+		aliasedSize += heap.requirements.size;
+
+		for (const TransientImage& image : heap.images)
+		{
+			VulkanImage* vulkanImage = image.lifetime->image;
+			vulkanImage->BindToAliasedMemory(allocation);
+			device.SetObjectName((uint64_t)GET_VK_HANDLE_PTR(vulkanImage), VK_OBJECT_TYPE_IMAGE, vulkanImage->GetName().c_str());
+			aliasedImages.insert(vulkanImage);
+		}
+	}
+
+	for (VmaAllocation heap : previousHeaps)
+	{
+		vmaFreeMemory(m_TransientAllocator, heap);
+	}
+
+	//single mip textures have views of the same images
+	std::unordered_set<uint32_t> recreatedViews;
+	for (auto& [id, texture] : m_Textures)
+	{
+		if (aliasedImages.contains(texture->GetResource()))
+		{
+			texture->GetView()->Recreate();
+			device.SetObjectName((uint64_t)GET_VK_HANDLE_PTR(texture->GetView()), VK_OBJECT_TYPE_IMAGE_VIEW, texture->GetName().c_str());
+			recreatedViews.insert(texture->GetView()->GetID());
+		}
+	}
+
+	LOG_INFO(std::format("Transient textures: {} images in {} heaps, {:.2f} MB instead of {:.2f} MB, saved {:.2f} MB",
+		images.size(), heaps.size(), GetMegabytes(aliasedSize), GetMegabytes(dedicatedSize), GetMegabytes(dedicatedSize - aliasedSize)));
+	for (const TransientHeap& heap : heaps)
+	{
+		std::string heapImages = std::format("  heap {:.2f} MB:", GetMegabytes(heap.requirements.size));
+		for (const TransientImage& image : heap.images)
+		{
+			heapImages += std::format(" {} [{}-{}]", image.lifetime->image->GetName(), image.lifetime->firstPass, image.lifetime->lastPass);
+		}
+		LOG_INFO(heapImages);
+	}
+
+	return recreatedViews;
+}
+
 void ResourceManager::CreateShader(VulkanDevice& device, ShaderInfo& createInfo, const std::vector<char>& code, const char* name)
 {
 	Shader* shader = new Shader(device, code.size(), code.data(), createInfo, name);
@@ -4,8 +4,18 @@
 #include "Render/Shader.h"
 #include "Render/Model/TextureLoading.h"
 
+#include <unordered_set>
+
 using TextureData = TextureLoading::TextureData;
 
+//passes in which image of a transient texture is used, by index in pass order
+struct TransientTextureLifetime
+{
+	VulkanImage*	image;
+	uint32_t		firstPass;
+	uint32_t		lastPass;
+};
+
 class ResourceManager
 {
 public:
@@ -14,16 +24,36 @@ public:
 public:
 	VulkanTexture*	CreateSingleMipFromTexture(VulkanDevice& device, const VulkanTexture* texture, uint32_t mipSlice);
 	VulkanTexture*	CreateTexture(VulkanDevice& device, const TextureData* data, ROTextureCreateInfo createInfo);
+	//texture from the same path and create info is shared, it is deleted together with its last user
 	VulkanTexture*	CreateTexture(VulkanDevice& device, std::string path, ROTextureCreateInfo createInfo);
 	VulkanTexture*	CreateTexture(VulkanDevice& device, RWTextureCreateInfo createInfo);
 	VulkanBuffer*	CreateBuffer(VulkanDevice& device, BufferCreateInfo createInfo);
 	void			CreateShader(VulkanDevice& device, ShaderInfo& createInfo, const std::vector<char>& code, const char* name);
+	//texture must not be in use by the gpu anymore
+	void			DeleteTexture(VulkanTexture* texture);
+	//buffer must not be in use by the gpu anymore
+	void			DeleteBuffer(VulkanBuffer* buffer);
+	//images whose lifetimes don't overlap are placed into the same memory, views of all textures on them are recreated.
+	//gpu must be idle, contents of transient textures are lost. returns ids of recreated views
+	std::unordered_set<uint32_t> AliasTransientTextures(VulkanDevice& device, const std::vector<TransientTextureLifetime>& lifetimes);
 
 	Shader*											GetShader(const std::string& name);
 	std::unordered_map<uint32_t, VulkanTexture*>&	GetTextures() { return m_Textures; }
+	std::unordered_map<std::string, Shader*>&		GetShaders() { return m_Shaders; }
 private:
+	struct PathTexture
+	{
+		std::string	key;
+		uint32_t	refCount;
+	};
 
 	std::unordered_map<std::string, Shader*>		m_Shaders;
 	std::unordered_map<uint32_t, VulkanTexture*>	m_Textures;
 	std::unordered_map<uint32_t, VulkanBuffer*>		m_Buffers;
+	std::unordered_map<std::string, VulkanTexture*>	m_TexturesByPath;
+	std::unordered_map<uint32_t, PathTexture>		m_PathTextures;	//by texture id
+
+	//memory shared by transient textures
+	VmaAllocator									m_TransientAllocator = VK_NULL_HANDLE;
+	std::vector<VmaAllocation>						m_TransientHeaps;
 };
\ No newline at end of file
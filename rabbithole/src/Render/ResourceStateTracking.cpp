@@ -4,32 +4,93 @@
 #include "Renderer.h"
 #include "Resource.h"
 
+#include <algorithm>
+
+//next access of a written resource has to wait for the write even when its layout stays the same
+static bool IsWriteResourceState(ResourceState state)
+{
+	return state == ResourceState::RenderTarget || state == ResourceState::DepthStencilWrite || state == ResourceState::TransferDst ||
+		state == ResourceState::GeneralComputeWrite || state == ResourceState::GeneralComputeReadWrite ||
+		state == ResourceState::BufferWrite || state == ResourceState::BufferReadWrite;
+}
+
 void ResourceStateTrackingManager::CommitBarriers(Renderer& renderer)
 {
+	//resource bound to several slots gets one barrier
+	std::sort(m_ResourcesForTransition.begin(), m_ResourcesForTransition.end());
+	m_ResourcesForTransition.erase(std::unique(m_ResourcesForTransition.begin(), m_ResourcesForTransition.end()), m_ResourcesForTransition.end());
+
+	if (m_CommittedResources)
+	{
+		m_CommittedResources->insert(m_CommittedResources->end(), m_ResourcesForTransition.begin(), m_ResourcesForTransition.end());
+	}
+
+	//accesses are known before anything is recorded, so a wait for the other queue cuts the batch ahead of the barrier
+	AsyncComputeScheduler& asyncCompute = renderer.GetAsyncCompute();
+	m_CrossQueueResources.clear();
 	for (auto resource : m_ResourcesForTransition)
 	{
+		const bool isWrite = IsWriteResourceState(resource->GetShouldBeResourceState()) || resource->GetResourceState() != resource->GetShouldBeResourceState();
+		m_CrossQueueResources.push_back(asyncCompute.AddAccess(resource, isWrite));
+	}
+	asyncCompute.SyncAccesses();
+
+	for (size_t resourceIndex = 0; resourceIndex < m_ResourcesForTransition.size(); resourceIndex++)
+	{
+		ManagableResource* resource = m_ResourcesForTransition[resourceIndex];
+		const bool isCrossQueue = m_CrossQueueResources[resourceIndex];
+
 		ResourceState resourceState = resource->GetResourceState();
 		ResourceState resourceShouldBe = resource->GetShouldBeResourceState();
 		ResourceStage resourcePreviousStage = resource->GetPreviousResourceStage();
 		ResourceStage resourceCurrentStage = resource->GetCurrentResourceStage();
 
-		if (!(resourceState == resourceShouldBe))
+		if (resourceState == resourceShouldBe && !IsWriteResourceState(resourceState))
 		{
-			if (resource->GetType() == ResourceType::Texture)
-			{
-				VulkanTexture* textureResource = static_cast<VulkanTexture*>(resource);
-				uint32_t mipSlice = textureResource->GetRegion().Subresource.MipSlice;
-				uint32_t mipCount = textureResource->GetRegion().Subresource.MipSize;
+			continue;
+		}
+
+		if (resource->GetType() == ResourceType::Texture)
+		{
+			VulkanTexture* textureResource = static_cast<VulkanTexture*>(resource);
+			uint32_t mipSlice = textureResource->GetRegion().Subresource.MipSlice;
+			uint32_t mipCount = textureResource->GetRegion().Subresource.MipSize;
 
-				renderer.ResourceBarrier(textureResource, resourceState, resourceShouldBe, resourcePreviousStage, resourceCurrentStage, mipSlice,mipCount);
+			VkImageMemoryBarrier2 barrier = VulkanDevice::GetImageBarrier(textureResource, resourceState, resourceShouldBe, resourcePreviousStage, resourceCurrentStage, mipSlice, mipCount);
+			if (resourceState == ResourceState::None && IsFlagSet(textureResource->GetFlags() & TextureFlags::Transient))
+			{
+				//memory is shared with other transient textures, their writes have to finish before the layout changes
+				barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				barrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+			}
+			else if (isCrossQueue)
+			{
+				//previous access was on the other queue, semaphore wait already made it available
+				barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				barrier.srcAccessMask = VK_ACCESS_2_NONE;
 			}
-			else if (resource->GetType() == ResourceType::Buffer)
+			m_ImageBarriers.push_back(barrier);
+		}
+		else if (resource->GetType() == ResourceType::Buffer && resourceState != ResourceState::None)
+		{
+			VkBufferMemoryBarrier2 barrier = VulkanDevice::GetBufferBarrier(static_cast<VulkanBuffer*>(resource), resourceState, resourceShouldBe, resourcePreviousStage, resourceCurrentStage);
+			if (isCrossQueue)
 			{
-				renderer.ResourceBarrier(static_cast<VulkanBuffer*>(resource), resourceState, resourceShouldBe, resourcePreviousStage, resourceCurrentStage);
+				barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				barrier.srcAccessMask = VK_ACCESS_2_NONE;
 			}
+			m_BufferBarriers.push_back(barrier);
 		}
+
+		resource->SetResourceState(resourceShouldBe);
+		resource->SetCurrentResourceStage(resourceCurrentStage);
 	}
 
+	renderer.ResourceBarriers(m_ImageBarriers, m_BufferBarriers);
+
+	m_ImageBarriers.clear();
+	m_BufferBarriers.clear();
+
 	Reset();
 }
 
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <vector>
+#include <vulkan/vulkan.h>
 
 class ManagableResource;
 class Renderer;
 
+//resources bound since the last commit are moved to the state they are bound with, transitions of all of them are
+//recorded as a single barrier. pass manager commits after pass setup, so every pass boundary gets one barrier
 class ResourceStateTrackingManager
 {
 public:
@@ -12,7 +15,16 @@ public:
 	void AddResourceForTransition(ManagableResource* resource);
 	void Reset();
 
+	//every committed resource is appended while set, pass manager learns from it which passes use which textures
+	void SetCommittedResources(std::vector<ManagableResource*>* committedResources) { m_CommittedResources = committedResources; }
+
 private:
 
 	std::vector<ManagableResource*> m_ResourcesForTransition;
-};
\ No newline at end of file
+	std::vector<ManagableResource*>* m_CommittedResources = nullptr;
+
+	//kept between commits so recording barriers doesn't allocate
+	std::vector<VkImageMemoryBarrier2>	m_ImageBarriers;
+	std::vector<VkBufferMemoryBarrier2>	m_BufferBarriers;
+	std::vector<bool>					m_CrossQueueResources;	//per resource for transition, last used on the other queue
+};
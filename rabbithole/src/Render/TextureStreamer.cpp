@@ -0,0 +1,414 @@
+#include "Render/Vulkan/precomp.h"
+
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Render/Converters.h"
+#include "Render/ResourceManager.h"
+
+bool TextureStreamer::Init(VulkanDevice& device, ResourceManager& resourceManager)
+{
+	m_Device = &device;
+	m_ResourceManager = &resourceManager;
+
+	//read back on cpu every frame, so it lives in host memory and stays mapped
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_FeedbackBuffers[i] = resourceManager.CreateBuffer(device, BufferCreateInfo{
+				.flags = {BufferUsageFlags::StorageBuffer},
+				.memoryAccess = {MemoryAccess::CPU},
+				.size = {static_cast<uint32_t>(TEXTURE_STREAMING_FEEDBACK_SLOTS * sizeof(uint32_t))},
+				.name = {"TextureStreamingFeedback"}
+			});
+
+		m_FeedbackData[i] = static_cast<uint32_t*>(m_FeedbackBuffers[i]->Map());
+		memset(m_FeedbackData[i], 0xFF, TEXTURE_STREAMING_FEEDBACK_SLOTS * sizeof(uint32_t));
+		m_DescriptorsDirty[i] = false;
+	}
+
+	return true;
+}
+
+bool TextureStreamer::Shutdown()
+{
+	//textures are owned by resource manager, only their sources are released here
+	m_Textures.clear();
+	m_Materials.clear();
+	m_RetiredTextures.clear();
+	m_FreeTextures.clear();
+	m_FreeMaterials.clear();
+
+	return true;
+}
+
+uint32_t TextureStreamer::RegisterTexture(std::unique_ptr<Utils::MappedFile> file, const KTX2::TextureView& view, const ROTextureCreateInfo& createInfo)
+{
+	const uint32_t handle = AllocateTexture();
+	StreamedTexture& streamedTexture = m_Textures[handle];
+	streamedTexture.file = std::move(file);
+	streamedTexture.view = view;
+	streamedTexture.createInfo = createInfo;
+
+	const uint32_t mipCount = static_cast<uint32_t>(view.mipData.size());
+	while (streamedTexture.tailMip + 1 < mipCount &&
+		std::max(view.width >> streamedTexture.tailMip, view.height >> streamedTexture.tailMip) > TEXTURE_STREAMING_TAIL_MIP_SIZE)
+	{
+		streamedTexture.tailMip++;
+	}
+
+	streamedTexture.residentMip = streamedTexture.tailMip;
+	streamedTexture.requestedMip = streamedTexture.tailMip;
+	streamedTexture.texture = CreateTexture(streamedTexture, streamedTexture.residentMip);
+
+	return handle;
+}
+
+uint32_t TextureStreamer::RegisterTexture(VulkanTexture* texture)
+{
+	const uint32_t handle = AllocateTexture();
+	m_Textures[handle].texture = texture;
+
+	return handle;
+}
+
+uint32_t TextureStreamer::RegisterMaterial(uint32_t albedo, uint32_t normal, uint32_t metallicRoughness)
+{
+	MaterialTextures material{ { albedo, normal, metallicRoughness } };
+
+	if (std::all_of(std::begin(material.handles), std::end(material.handles), [](uint32_t handle) { return handle == TEXTURE_STREAMING_INVALID_HANDLE; }))
+	{
+		return TEXTURE_STREAMING_INVALID_HANDLE;
+	}
+
+	if (!m_FreeMaterials.empty())
+	{
+		const uint32_t feedbackSlot = m_FreeMaterials.back();
+		m_FreeMaterials.pop_back();
+		m_Materials[feedbackSlot] = material;
+		return feedbackSlot;
+	}
+
+	if (m_Materials.size() >= TEXTURE_STREAMING_FEEDBACK_SLOTS)
+	{
+		//nothing would ever request more than the tail, so textures are kept whole instead
+		LOG_WARNING("Out of texture streaming feedback slots, textures of material will be fully resident");
+		for (uint32_t handle : material.handles)
+		{
+			if (handle != TEXTURE_STREAMING_INVALID_HANDLE)
+			{
+				m_Textures[handle].pinned = true;
+			}
+		}
+		return TEXTURE_STREAMING_INVALID_HANDLE;
+	}
+
+	m_Materials.push_back(material);
+	return static_cast<uint32_t>(m_Materials.size() - 1);
+}
+
+void TextureStreamer::UnregisterTexture(uint32_t handle)
+{
+	StreamedTexture& texture = m_Textures[handle];
+
+	//memory of a pending upload is already counted
+	if (texture.file)
+	{
+		m_StreamedMemory -= GetMipChainSize(texture, texture.pendingTexture ? texture.pendingMip : texture.residentMip);
+	}
+
+	if (texture.pendingTexture)
+	{
+		m_ResourceManager->DeleteTexture(texture.pendingTexture);
+	}
+	m_ResourceManager->DeleteTexture(texture.texture);
+
+	//empty slot has no file, so feedback and uploads skip it until it is reused
+	texture = StreamedTexture{};
+	m_FreeTextures.push_back(handle);
+}
+
+void TextureStreamer::UnregisterMaterial(uint32_t feedbackSlot)
+{
+	for (uint32_t& handle : m_Materials[feedbackSlot].handles)
+	{
+		handle = TEXTURE_STREAMING_INVALID_HANDLE;
+	}
+
+	//feedback of finished frames that was not read yet would go to the next material in the slot
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_FeedbackData[i][feedbackSlot] = UINT32_MAX;
+	}
+
+	m_FreeMaterials.push_back(feedbackSlot);
+}
+
+bool TextureStreamer::Update(uint32_t imageIndex)
+{
+	m_FrameCount++;
+
+	//descriptors of every image stopped pointing to these and frames that still could are done
+	std::erase_if(m_RetiredTextures, [this](const RetiredTexture& retiredTexture)
+		{
+			if (retiredTexture.imagesToUpdate != 0 || retiredTexture.deleteFrame > m_FrameCount)
+			{
+				return false;
+			}
+
+			m_ResourceManager->DeleteTexture(retiredTexture.texture);
+			return true;
+		});
+
+	CompletePendingUploads();
+	ReadFeedback(imageIndex);
+	ScheduleUploads();
+
+	if (!m_DescriptorsDirty[imageIndex])
+	{
+		return false;
+	}
+
+	//caller writes descriptors of the image right after this
+	m_DescriptorsDirty[imageIndex] = false;
+	for (RetiredTexture& retiredTexture : m_RetiredTextures)
+	{
+		if (retiredTexture.imagesToUpdate == 0)
+		{
+			continue;
+		}
+
+		retiredTexture.imagesToUpdate &= ~(1u << imageIndex);
+		if (retiredTexture.imagesToUpdate == 0)
+		{
+			//frames recorded with old descriptors can still be in flight
+			retiredTexture.deleteFrame = m_FrameCount + MAX_FRAMES_IN_FLIGHT;
+		}
+	}
+
+	return true;
+}
+
+void TextureStreamer::RecordFeedbackBarrier(VulkanCommandBuffer& commandBuffer)
+{
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(GET_VK_HANDLE(commandBuffer), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+VulkanTexture* TextureStreamer::GetTexture(uint32_t handle) const
+{
+	return m_Textures[handle].texture;
+}
+
+uint32_t TextureStreamer::AllocateTexture()
+{
+	if (!m_FreeTextures.empty())
+	{
+		const uint32_t handle = m_FreeTextures.back();
+		m_FreeTextures.pop_back();
+		return handle;
+	}
+
+	m_Textures.emplace_back();
+	return static_cast<uint32_t>(m_Textures.size() - 1);
+}
+
+uint64_t TextureStreamer::GetMipChainSize(const StreamedTexture& texture, uint32_t firstMip) const
+{
+	uint64_t size = 0;
+	for (uint32_t mip = firstMip; mip < texture.tailMip; mip++)
+	{
+		size += GetImageSizeFrom(texture.view.format, std::max(texture.view.width >> mip, 1u), std::max(texture.view.height >> mip, 1u));
+	}
+	return size;
+}
+
+void TextureStreamer::CompletePendingUploads()
+{
+	VulkanUploadContext& uploadContext = m_Device->GetUploadContext();
+
+	for (StreamedTexture& texture : m_Textures)
+	{
+		if (!texture.pendingTexture || !uploadContext.IsSubmissionHandedOver(texture.pendingSubmission))
+		{
+			continue;
+		}
+
+		m_RetiredTextures.push_back(RetiredTexture{ texture.texture, (1u << MAX_FRAMES_IN_FLIGHT) - 1, UINT64_MAX });
+
+		texture.texture = texture.pendingTexture;
+		texture.residentMip = texture.pendingMip;
+		texture.pendingTexture = nullptr;
+		//new mips get the whole delay before they can be dropped again
+		texture.lastNeededFrame = m_FrameCount;
+
+		std::fill(std::begin(m_DescriptorsDirty), std::end(m_DescriptorsDirty), true);
+	}
+}
+
+void TextureStreamer::ReadFeedback(uint32_t imageIndex)
+{
+	for (StreamedTexture& texture : m_Textures)
+	{
+		texture.requestedMip = texture.pinned ? 0 : texture.tailMip;
+	}
+
+	uint32_t* feedback = m_FeedbackData[imageIndex];
+	for (size_t slot = 0; slot < m_Materials.size(); slot++)
+	{
+		if (feedback[slot] == UINT32_MAX)
+		{
+			continue;
+		}
+
+		const float uvLod = static_cast<float>(feedback[slot]) / TEXTURE_FEEDBACK_LOD_STEPS - TEXTURE_FEEDBACK_LOD_BIAS;
+
+		for (uint32_t handle : m_Materials[slot].handles)
+		{
+			if (handle == TEXTURE_STREAMING_INVALID_HANDLE || !m_Textures[handle].file)
+			{
+				continue;
+			}
+
+			//lod in uv space becomes lod of the full size mip once it is scaled by texture size
+			StreamedTexture& texture = m_Textures[handle];
+			const float lod = uvLod + std::log2(static_cast<float>(std::max(texture.view.width, texture.view.height)));
+			const uint32_t mip = lod <= 0.f ? 0 : std::min(static_cast<uint32_t>(lod), texture.tailMip);
+
+			texture.requestedMip = std::min(texture.requestedMip, mip);
+		}
+	}
+
+	//gpu is done with this buffer, next frame that renders to the image starts from scratch
+	memset(feedback, 0xFF, m_Materials.size() * sizeof(uint32_t));
+
+	for (StreamedTexture& texture : m_Textures)
+	{
+		if (texture.requestedMip <= texture.residentMip)
+		{
+			texture.lastNeededFrame = m_FrameCount;
+		}
+	}
+}
+
+void TextureStreamer::ScheduleUploads()
+{
+	std::vector<StreamedTexture*> upgrades;
+	std::vector<StreamedTexture*> downgrades;
+
+	for (StreamedTexture& texture : m_Textures)
+	{
+		if (!texture.file || texture.pendingTexture)
+		{
+			continue;
+		}
+
+		if (texture.requestedMip < texture.residentMip)
+		{
+			upgrades.push_back(&texture);
+		}
+		else if (texture.requestedMip > texture.residentMip)
+		{
+			downgrades.push_back(&texture);
+		}
+	}
+
+	if (upgrades.empty() && downgrades.empty())
+	{
+		return;
+	}
+
+	//textures missing the most mips go first
+	std::sort(upgrades.begin(), upgrades.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			return a->residentMip - a->requestedMip > b->residentMip - b->requestedMip;
+		});
+	//mips that were not needed for the longest time are dropped first
+	std::sort(downgrades.begin(), downgrades.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			return a->lastNeededFrame < b->lastNeededFrame;
+		});
+
+	std::vector<StreamedTexture*> startedUploads;
+	auto startUpload = [this, &startedUploads](StreamedTexture& texture, uint32_t firstMip)
+		{
+			m_StreamedMemory = m_StreamedMemory - GetMipChainSize(texture, texture.residentMip) + GetMipChainSize(texture, firstMip);
+			texture.pendingTexture = CreateTexture(texture, firstMip);
+			texture.pendingMip = firstMip;
+			startedUploads.push_back(&texture);
+		};
+
+	VulkanUploadContext& uploadContext = m_Device->GetUploadContext();
+	uploadContext.BeginBatch();
+
+	//hysteresis keeps mips around while camera moves back and forth
+	size_t nextDowngrade = 0;
+	for (; nextDowngrade < downgrades.size() && startedUploads.size() < TEXTURE_STREAMING_MAX_UPLOADS_PER_FRAME; nextDowngrade++)
+	{
+		StreamedTexture* texture = downgrades[nextDowngrade];
+		if (m_FrameCount - texture->lastNeededFrame <= TEXTURE_STREAMING_DOWNGRADE_DELAY)
+		{
+			break;
+		}
+		startUpload(*texture, texture->requestedMip);
+	}
+
+	for (StreamedTexture* texture : upgrades)
+	{
+		if (startedUploads.size() >= TEXTURE_STREAMING_MAX_UPLOADS_PER_FRAME)
+		{
+			break;
+		}
+
+		const uint64_t residentSize = GetMipChainSize(*texture, texture->residentMip);
+		auto fitsBudget = [&](uint32_t firstMip)
+			{
+				return m_StreamedMemory - residentSize + GetMipChainSize(*texture, firstMip) <= TEXTURE_STREAMING_BUDGET;
+			};
+
+		//over budget, mips nobody asked for are dropped before their delay runs out
+		while (!fitsBudget(texture->requestedMip) && nextDowngrade < downgrades.size() &&
+			startedUploads.size() + 1 < TEXTURE_STREAMING_MAX_UPLOADS_PER_FRAME)
+		{
+			StreamedTexture* evictedTexture = downgrades[nextDowngrade++];
+			startUpload(*evictedTexture, evictedTexture->requestedMip);
+		}
+
+		//whatever still doesn't fit stays at a coarser mip
+		uint32_t firstMip = texture->requestedMip;
+		while (firstMip < texture->residentMip && !fitsBudget(firstMip))
+		{
+			firstMip++;
+		}
+
+		if (firstMip < texture->residentMip)
+		{
+			startUpload(*texture, firstMip);
+		}
+	}
+
+	//batch can be nested in a longer one, uploads have to be submitted to know when textures can be swapped
+	uploadContext.EndBatch(false);
+	uploadContext.Flush();
+
+	const uint64_t submissionId = uploadContext.GetLastSubmissionId();
+	for (StreamedTexture* texture : startedUploads)
+	{
+		texture->pendingSubmission = submissionId;
+	}
+}
+
+VulkanTexture* TextureStreamer::CreateTexture(const StreamedTexture& texture, uint32_t firstMip)
+{
+	TextureData textureData{};
+	textureData.width = static_cast<int>(std::max(texture.view.width >> firstMip, 1u));
+	textureData.height = static_cast<int>(std::max(texture.view.height >> firstMip, 1u));
+	textureData.mipData.assign(texture.view.mipData.begin() + firstMip, texture.view.mipData.end());
+
+	return m_ResourceManager->CreateTexture(*m_Device, &textureData, texture.createInfo);
+}
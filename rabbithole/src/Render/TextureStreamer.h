@@ -0,0 +1,114 @@
+#pragma once
+
+#include "common.h"
+#include "Render/Resource.h"
+#include "Render/Model/KTX2.h"
+#include "Utils/utils.h"
+
+#include <memory>
+#include <vector>
+
+class ResourceManager;
+class VulkanBuffer;
+class VulkanCommandBuffer;
+class VulkanDevice;
+class VulkanTexture;
+
+//memory streamed mips of all textures can take, tail mips are always resident and are not counted
+#define TEXTURE_STREAMING_BUDGET				(4 * MB_64)
+//mips up to this size are resident for the whole lifetime of a texture
+#define TEXTURE_STREAMING_TAIL_MIP_SIZE			64
+#define TEXTURE_STREAMING_MAX_UPLOADS_PER_FRAME	4
+//mips that are not requested for this many frames are dropped, unless budget needs them sooner
+#define TEXTURE_STREAMING_DOWNGRADE_DELAY		120
+#define TEXTURE_STREAMING_FEEDBACK_SLOTS		1024
+#define TEXTURE_STREAMING_INVALID_HANDLE		UINT32_MAX
+
+//keep in sync with FS_GBuffer, feedback stores (uv space lod + bias) * steps, UINT32_MAX if material was not rendered
+#define TEXTURE_FEEDBACK_LOD_BIAS				32
+#define TEXTURE_FEEDBACK_LOD_STEPS				4
+
+//model textures start with only their tail mips resident. gbuffer pass writes the finest lod every material is sampled
+//with into a feedback buffer, that is read back once the frame is done and the rest of mips is streamed from mapped KTX2
+//files under a memory budget. texture is recreated with its new mip range and swapped in once the upload reaches the
+//graphics queue, old one is deleted when no frame in flight can use it anymore
+class TextureStreamer
+{
+public:
+	bool Init(VulkanDevice& device, ResourceManager& resourceManager);
+	bool Shutdown();
+
+	//created with only tail mips resident, file stays mapped as a source of the rest
+	uint32_t	RegisterTexture(std::unique_ptr<Utils::MappedFile> file, const KTX2::TextureView& view, const ROTextureCreateInfo& createInfo);
+	//texture without a streaming source, it stays fully resident
+	uint32_t	RegisterTexture(VulkanTexture* texture);
+	//returns feedback slot of material, texture handles can be invalid
+	uint32_t	RegisterMaterial(uint32_t albedo, uint32_t normal, uint32_t metallicRoughness);
+	//texture must not be in use by the gpu anymore, it is deleted together with its pending upload and handle is reused
+	void		UnregisterTexture(uint32_t handle);
+	//materials using the slot must not be rendered anymore, slot is reused
+	void		UnregisterMaterial(uint32_t feedbackSlot);
+
+	//image has to be out of flight. reads its feedback and schedules uploads, returns true when descriptors of the image
+	//have to be written again because some textures were swapped
+	bool		Update(uint32_t imageIndex);
+	//makes feedback written by the gbuffer pass visible to the host
+	void		RecordFeedbackBarrier(VulkanCommandBuffer& commandBuffer);
+
+	VulkanTexture*	GetTexture(uint32_t handle) const;
+	VulkanBuffer*	GetFeedbackBuffer(uint32_t imageIndex) const { return m_FeedbackBuffers[imageIndex]; }
+	uint64_t		GetStreamedMemory() const { return m_StreamedMemory; }
+
+private:
+	struct StreamedTexture
+	{
+		VulkanTexture*						texture = nullptr;
+		std::unique_ptr<Utils::MappedFile>	file;
+		KTX2::TextureView					view;
+		ROTextureCreateInfo					createInfo;
+		uint32_t							residentMip = 0;	//first mip of texture
+		uint32_t							tailMip = 0;		//first mip that is never streamed out
+		uint32_t							requestedMip = 0;	//finest mip the last feedback asked for
+		uint64_t							lastNeededFrame = 0;//last frame all resident mips were requested
+		bool								pinned = false;		//used by material without feedback slot, wants every mip
+
+		VulkanTexture*						pendingTexture = nullptr;
+		uint32_t							pendingMip = 0;
+		uint64_t							pendingSubmission = 0;
+	};
+
+	struct RetiredTexture
+	{
+		VulkanTexture*	texture;
+		uint32_t		imagesToUpdate;	//bit per image whose descriptors still point to texture
+		uint64_t		deleteFrame;
+	};
+
+	struct MaterialTextures
+	{
+		uint32_t handles[3];
+	};
+
+	uint32_t	AllocateTexture();
+	uint64_t	GetMipChainSize(const StreamedTexture& texture, uint32_t firstMip) const;
+	void		CompletePendingUploads();
+	void		ReadFeedback(uint32_t imageIndex);
+	void		ScheduleUploads();
+	VulkanTexture*	CreateTexture(const StreamedTexture& texture, uint32_t firstMip);
+
+	VulkanDevice*					m_Device = nullptr;
+	ResourceManager*				m_ResourceManager = nullptr;
+
+	std::vector<StreamedTexture>	m_Textures;
+	std::vector<MaterialTextures>	m_Materials;
+	std::vector<RetiredTexture>		m_RetiredTextures;
+	std::vector<uint32_t>			m_FreeTextures;
+	std::vector<uint32_t>			m_FreeMaterials;
+
+	VulkanBuffer*					m_FeedbackBuffers[MAX_FRAMES_IN_FLIGHT];
+	uint32_t*						m_FeedbackData[MAX_FRAMES_IN_FLIGHT];
+	bool							m_DescriptorsDirty[MAX_FRAMES_IN_FLIGHT];
+
+	uint64_t						m_StreamedMemory = 0;
+	uint64_t						m_FrameCount = 0;
+};
@@ -7,11 +7,13 @@
 #include "../VulkanFramebuffer.h"
 #include "../VulkanGPUProfiler.h"
 #include "../VulkanImage.h"
+#include "../VulkanMipGenerator.h"
 #include "../VulkanPipeline.h"
 #include "../VulkanRenderPass.h"
 #include "../VulkanStateManager.h"
 #include "../VulkanSwapchain.h"
 #include "../VulkanTexture.h"
 #include "../VulkanTypes.h"
+#include "../VulkanUploadContext.h"
 
 
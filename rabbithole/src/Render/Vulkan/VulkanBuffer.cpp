@@ -52,31 +52,16 @@ VulkanBuffer::VulkanBuffer(VulkanDevice& device, BufferCreateInfo& createInfo)
 
 VulkanBuffer::~VulkanBuffer()
 {
-	Unmap();
 	vmaDestroyBuffer(m_Device.GetVmaAllocator(), m_Buffer, m_VmaAllocation);
 }
 
 void* VulkanBuffer::Map()
 {
-	ASSERT(m_HostVisibleData == nullptr, "Host Visible data pointer is pointing to something!!!");
-
-	if (m_Info.memoryAccess == MemoryAccess::CPU || m_Info.memoryAccess == MemoryAccess::CPU2GPU)
-	{
-		vmaMapMemory(m_Device.GetVmaAllocator(), m_VmaAllocation, &m_HostVisibleData);
-	}
+	ASSERT(m_Info.memoryAccess != MemoryAccess::GPU, "Only host visible buffers can be mapped!");
 
 	return m_HostVisibleData;
 }
 
-void VulkanBuffer::Unmap()
-{
-	if (m_HostVisibleData)
-	{
-		vmaUnmapMemory(m_Device.GetVmaAllocator(), m_VmaAllocation);
-		m_HostVisibleData = nullptr;
-	}
-}
-
 void VulkanBuffer::FillBuffer(void* inputData, uint64_t size, uint64_t offset)
 {
 	ASSERT(offset + size <= m_Size, "Trying to reach outside buffer's bounds!");
@@ -85,23 +70,11 @@ void VulkanBuffer::FillBuffer(void* inputData, uint64_t size, uint64_t offset)
 	{
 		if (m_Info.memoryAccess != MemoryAccess::GPU)
 		{
-			void* data = Map();
-			memcpy(data, (char*)inputData + offset, size);
-			Unmap();
+			memcpy((char*)m_HostVisibleData + offset, inputData, size);
 		}
 		else
 		{
-			VulkanBuffer stagingBuffer = VulkanBuffer(m_Device, BufferUsageFlags::TransferSrc, MemoryAccess::CPU, size, "StagingBuffer");
-
-			stagingBuffer.FillBuffer(inputData);
-
-			//TODO: no way! Temp Command Buffers should be used only in init phases!!!
-			VulkanCommandBuffer tempCommandBuffer(m_Device, "Temp command buffer!");
-			tempCommandBuffer.BeginCommandBuffer();
-
-			m_Device.CopyBuffer(tempCommandBuffer, stagingBuffer, *this, size, 0, offset);
-
-			tempCommandBuffer.EndAndSubmitCommandBuffer();
+			m_Device.GetUploadContext().UploadBuffer(this, inputData, size, offset);
 		}
 	}
 }
@@ -117,10 +90,20 @@ void VulkanBuffer::CreateBufferResource()
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = m_Info.size;
 	bufferInfo.usage = GetVkBufferUsageFlags(m_Info.usageFlags);
-	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	const std::vector<uint32_t>& queueFamilies = m_Device.GetConcurrentQueueFamilies();
+	bufferInfo.sharingMode = queueFamilies.empty() ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT;
+	bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+	bufferInfo.pQueueFamilyIndices = queueFamilies.data();
 
 	VmaAllocationCreateInfo allocationCreateInfo = {};
 	allocationCreateInfo.usage = GetVmaMemoryUsageFrom(m_Info.memoryAccess);
+	//host visible buffers are mapped for their whole life, writes are plain memcpy
+	if (m_Info.memoryAccess != MemoryAccess::GPU)
+	{
+		allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	}
 
-	vmaCreateBuffer(m_Device.GetVmaAllocator(), &bufferInfo, &allocationCreateInfo, &m_Buffer, &m_VmaAllocation, nullptr);
+	VmaAllocationInfo allocationInfo{};
+	vmaCreateBuffer(m_Device.GetVmaAllocator(), &bufferInfo, &allocationCreateInfo, &m_Buffer, &m_VmaAllocation, &allocationInfo);
+	m_HostVisibleData = allocationInfo.pMappedData;
 }
@@ -24,8 +24,8 @@ private:
 	VulkanBuffer(VulkanDevice& device, BufferCreateInfo& createInfo);
 
 public:
+	//host visible buffers stay mapped, this only returns their memory
 	void* Map();
-	void  Unmap();
 	void  FillBuffer(void* data);
 	void  FillBuffer(void* data, uint64_t size, uint64_t offset = 0);
 
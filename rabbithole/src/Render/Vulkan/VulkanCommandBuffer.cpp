@@ -3,13 +3,19 @@
 #include "VulkanCommandBuffer.h"
 
 VulkanCommandBuffer::VulkanCommandBuffer(const VulkanDevice& device, const char* name)
+	: VulkanCommandBuffer(device, device.GetCommandPool(), name)
+{
+}
+
+VulkanCommandBuffer::VulkanCommandBuffer(const VulkanDevice& device, VkCommandPool commandPool, const char* name, VkCommandBufferLevel level)
 	: m_Device(device)
+	, m_CommandPool(commandPool)
 	, m_Name(name)
 {
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = device.GetCommandPool();
+	allocInfo.level = level;
+	allocInfo.commandPool = m_CommandPool;
 	allocInfo.commandBufferCount = 1;
 
 	VULKAN_API_CALL(vkAllocateCommandBuffers(device.GetGraphicDevice(), &allocInfo, &m_CommandBuffer));
@@ -17,7 +23,7 @@ VulkanCommandBuffer::VulkanCommandBuffer(const VulkanDevice& device, const char*
 
 VulkanCommandBuffer::~VulkanCommandBuffer()
 {
-	vkFreeCommandBuffers(m_Device.GetGraphicDevice(), m_Device.GetCommandPool(), 1, &m_CommandBuffer);
+	vkFreeCommandBuffers(m_Device.GetGraphicDevice(), m_CommandPool, 1, &m_CommandBuffer);
 }
 
 void VulkanCommandBuffer::BeginCommandBuffer(bool isSingleTimeCommandBuffer)
@@ -31,6 +37,22 @@ void VulkanCommandBuffer::BeginCommandBuffer(bool isSingleTimeCommandBuffer)
 	VULKAN_API_CALL(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
 }
 
+void VulkanCommandBuffer::BeginSecondaryCommandBuffer(VkRenderPass renderPass, VkFramebuffer framebuffer)
+{
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	VULKAN_API_CALL(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
+}
+
 void VulkanCommandBuffer::EndCommandBuffer()
 {
 	VULKAN_API_CALL(vkEndCommandBuffer(m_CommandBuffer));
@@ -6,6 +6,7 @@ class VulkanCommandBuffer
 {
 public:
 	VulkanCommandBuffer(const VulkanDevice& device, const char* name);
+	VulkanCommandBuffer(const VulkanDevice& device, VkCommandPool commandPool, const char* name, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 	~VulkanCommandBuffer();
 
 	NonCopyableAndMovable(VulkanCommandBuffer);
@@ -14,11 +15,14 @@ public:
 	const char*		GetName() const { return m_Name; }
 	
 	void BeginCommandBuffer(bool isSingleTimeCommandBuffer = false);
+	//secondary command buffer that continues the render pass primary one has begun
+	void BeginSecondaryCommandBuffer(VkRenderPass renderPass, VkFramebuffer framebuffer);
 	void EndCommandBuffer();
 	void EndAndSubmitCommandBuffer();
 
 private:
 	const VulkanDevice&		m_Device;
+	VkCommandPool			m_CommandPool;
 	VkCommandBuffer			m_CommandBuffer;
 	const char*				m_Name;
 };
\ No newline at end of file
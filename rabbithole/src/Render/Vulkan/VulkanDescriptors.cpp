@@ -32,8 +32,8 @@ VulkanDescriptor::VulkanDescriptor(const VulkanDescriptorInfo& info)
 	case DescriptorType::UniformBuffer:
 	{
 		m_ResourceInfo.m_ResourceInfo.BufferInfo.buffer = GET_VK_HANDLE_PTR(m_Info.buffer);
-		m_ResourceInfo.m_ResourceInfo.BufferInfo.offset = 0;
-		m_ResourceInfo.m_ResourceInfo.BufferInfo.range = m_Info.buffer->GetInfo().size;
+		m_ResourceInfo.m_ResourceInfo.BufferInfo.offset = m_Info.bufferOffset;
+		m_ResourceInfo.m_ResourceInfo.BufferInfo.range = m_Info.bufferRange ? m_Info.bufferRange : m_Info.buffer->GetInfo().size;
 		break;
 	}
 	case DescriptorType::StorageImage:
@@ -84,14 +84,13 @@ VulkanDescriptorPool::~VulkanDescriptorPool()
 VulkanDescriptorSetLayout::VulkanDescriptorSetLayout(const VulkanDevice* device, const std::vector<Shader*> shaders, const char* name)
 	: m_Device(device)
 {
-	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
 	std::vector<VkPushConstantRange> descritorSetPushConstants;
 
 	for (const Shader* shader : shaders)
 	{
 		for (const VkDescriptorSetLayoutBinding& binding : shader->GetDescriptorSetLayoutBindings())
 		{
-			descriptorSetLayoutBindings.push_back(binding);
+			m_Bindings.push_back(binding);
 		}
 		for (const VkPushConstantRange& pushConst : shader->GetPushConstants())
 		{
@@ -100,29 +99,116 @@ VulkanDescriptorSetLayout::VulkanDescriptorSetLayout(const VulkanDevice* device,
 	}
 
 	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings.size());
-	descriptorSetLayoutCreateInfo.pBindings = descriptorSetLayoutBindings.data();
+	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(m_Bindings.size());
+	descriptorSetLayoutCreateInfo.pBindings = m_Bindings.data();
 
 	VULKAN_API_CALL(vkCreateDescriptorSetLayout(m_Device->GetGraphicDevice(), &descriptorSetLayoutCreateInfo, nullptr, &m_Layout));
+
+	if (m_Bindings.empty())
+	{
+		return;
+	}
+
+	//entry i reads i-th resource info, only the first element of arrays is written, same as with write structures
+	std::vector<VkDescriptorUpdateTemplateEntry> templateEntries(m_Bindings.size());
+	for (uint32_t i = 0; i < m_Bindings.size(); ++i)
+	{
+		const VkDescriptorSetLayoutBinding& binding = m_Bindings[i];
+
+		VkDescriptorUpdateTemplateEntry& templateEntry = templateEntries[i];
+		templateEntry.dstBinding = binding.binding;
+		templateEntry.dstArrayElement = 0;
+		templateEntry.descriptorCount = 1;
+		templateEntry.descriptorType = binding.descriptorType;
+		templateEntry.offset = i * sizeof(DescriptorResourceInfo);
+		templateEntry.stride = sizeof(DescriptorResourceInfo);
+
+		if (binding.binding >= m_TemplateEntries.size())
+		{
+			m_TemplateEntries.resize(binding.binding + 1, UINT32_MAX);
+		}
+		m_TemplateEntries[binding.binding] = i;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfo updateTemplateCreateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO };
+	updateTemplateCreateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(templateEntries.size());
+	updateTemplateCreateInfo.pDescriptorUpdateEntries = templateEntries.data();
+	updateTemplateCreateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	updateTemplateCreateInfo.descriptorSetLayout = m_Layout;
+
+	VULKAN_API_CALL(vkCreateDescriptorUpdateTemplate(m_Device->GetGraphicDevice(), &updateTemplateCreateInfo, nullptr, &m_UpdateTemplate));
 }
 
 VulkanDescriptorSetLayout::~VulkanDescriptorSetLayout()
 {
+	if (m_UpdateTemplate != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplate(m_Device->GetGraphicDevice(), m_UpdateTemplate, nullptr);
+	}
 	vkDestroyDescriptorSetLayout(m_Device->GetGraphicDevice(), m_Layout, nullptr);
 }
 
 VulkanDescriptorSet::VulkanDescriptorSet(const VulkanDevice* device,const VulkanDescriptorPool* desciptorPool,const VulkanDescriptorSetLayout* descriptorSetLayout, const std::vector<VulkanDescriptor*>& descriptors, const char* name)
+{
+	const bool allocated = TryAllocate(device, desciptorPool, descriptorSetLayout);
+	ASSERT(allocated, "Descriptor pool is out of memory!");
+
+	Update(device, descriptors);
+}
+
+bool VulkanDescriptorSet::TryAllocate(const VulkanDevice* device, const VulkanDescriptorPool* desciptorPool, const VulkanDescriptorSetLayout* descriptorSetLayout)
 {
 	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
 	descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayout->GetLayout();
 	descriptorSetAllocateInfo.descriptorSetCount = 1;
 	descriptorSetAllocateInfo.descriptorPool = GET_VK_HANDLE_PTR(desciptorPool);
-	VULKAN_API_CALL(vkAllocateDescriptorSets(device->GetGraphicDevice(), &descriptorSetAllocateInfo, &m_DescriptorSet));
-	
 
+	m_DescriptorSet = VK_NULL_HANDLE;
+	m_Layout = descriptorSetLayout;
+
+	VkResult result = vkAllocateDescriptorSets(device->GetGraphicDevice(), &descriptorSetAllocateInfo, &m_DescriptorSet);
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+	{
+		return false;
+	}
+
+	VULKAN_API_CALL(result);
+	return true;
+}
+
+void VulkanDescriptorSet::Update(const VulkanDevice* device, const std::vector<VulkanDescriptor*>& descriptors)
+{
+	//set written as a whole goes through the template, infos are packed in order of layout bindings
+	if (m_Layout && m_Layout->GetUpdateTemplate() != VK_NULL_HANDLE && descriptors.size() == m_Layout->GetBindings().size())
+	{
+		std::vector<DescriptorResourceInfo> resourceInfos(descriptors.size());
+
+		bool coversLayout = true;
+		for (const VulkanDescriptor* descriptor : descriptors)
+		{
+			const uint32_t templateEntry = m_Layout->GetTemplateEntry(descriptor->GetDescriptorInfo().Binding);
+			if (templateEntry == UINT32_MAX)
+			{
+				coversLayout = false;
+				break;
+			}
+			resourceInfos[templateEntry] = descriptor->GetDescriptorResourceInfo();
+		}
+
+		if (coversLayout)
+		{
+			vkUpdateDescriptorSetWithTemplate(device->GetGraphicDevice(), m_DescriptorSet, m_Layout->GetUpdateTemplate(), resourceInfos.data());
+			return;
+		}
+	}
+
+	//partial updates only touch given bindings, write structures point into infos so they have to outlive the update
+	std::vector<DescriptorResourceInfo> resourceInfos(descriptors.size());
 	std::vector<VkWriteDescriptorSet> writeDescriptorSets(descriptors.size());
 	for (uint32_t i = 0; i < descriptors.size(); ++i)
 	{
+		resourceInfos[i] = descriptors[i]->GetDescriptorResourceInfo();
+
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets[i];
 		writeDescriptorSet = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
 		writeDescriptorSet.dstSet = m_DescriptorSet;
@@ -134,27 +220,27 @@ VulkanDescriptorSet::VulkanDescriptorSet(const VulkanDevice* device,const Vulkan
 		{
 		case DescriptorType::CombinedSampler:
  			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
- 			writeDescriptorSet.pImageInfo = new VkDescriptorImageInfo(descriptors[i]->GetDescriptorResourceInfo().m_ResourceInfo.ImageInfo);
+ 			writeDescriptorSet.pImageInfo = &resourceInfos[i].m_ResourceInfo.ImageInfo;
 			break;
 		case DescriptorType::SampledImage:
 			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-			writeDescriptorSet.pImageInfo = new VkDescriptorImageInfo(descriptors[i]->GetDescriptorResourceInfo().m_ResourceInfo.ImageInfo);
+			writeDescriptorSet.pImageInfo = &resourceInfos[i].m_ResourceInfo.ImageInfo;
 			break;
 		case DescriptorType::Sampler:
 			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-			writeDescriptorSet.pImageInfo = new VkDescriptorImageInfo(descriptors[i]->GetDescriptorResourceInfo().m_ResourceInfo.ImageInfo);
+			writeDescriptorSet.pImageInfo = &resourceInfos[i].m_ResourceInfo.ImageInfo;
 			break;
 		case DescriptorType::UniformBuffer:
 			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			writeDescriptorSet.pBufferInfo = new VkDescriptorBufferInfo(descriptors[i]->GetDescriptorResourceInfo().m_ResourceInfo.BufferInfo);
+			writeDescriptorSet.pBufferInfo = &resourceInfos[i].m_ResourceInfo.BufferInfo;
 			break;
 		case DescriptorType::StorageImage:
 			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-			writeDescriptorSet.pImageInfo = new VkDescriptorImageInfo(descriptors[i]->GetDescriptorResourceInfo().m_ResourceInfo.ImageInfo);
+			writeDescriptorSet.pImageInfo = &resourceInfos[i].m_ResourceInfo.ImageInfo;
 			break;
 		case DescriptorType::StorageBuffer:
 			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-			writeDescriptorSet.pBufferInfo = new VkDescriptorBufferInfo(descriptors[i]->GetDescriptorResourceInfo().m_ResourceInfo.BufferInfo);
+			writeDescriptorSet.pBufferInfo = &resourceInfos[i].m_ResourceInfo.BufferInfo;
 			break;
 		default:
 			ASSERT(false, "Not supported DescriptorType.");
@@ -12,6 +12,8 @@ struct VulkanDescriptorInfo
 	uint32_t		Binding;
 
 	VulkanBuffer*			buffer; 
+	uint64_t				bufferOffset = 0;
+	uint64_t				bufferRange = 0; //whole buffer when not set
 	VulkanImageView*		imageView;
 	VulkanImageSampler*		imageSampler;
 };
@@ -73,11 +75,20 @@ public:
 	~VulkanDescriptorSetLayout();
 
 	inline const VkDescriptorSetLayout* GetLayout() const { return &m_Layout; }
+	inline const std::vector<VkDescriptorSetLayoutBinding>& GetBindings() const { return m_Bindings; }
+	inline VkDescriptorUpdateTemplate	GetUpdateTemplate() const { return m_UpdateTemplate; }
+	//index of binding's resource info in data the template reads, UINT32_MAX when layout doesn't have the binding
+	inline uint32_t						GetTemplateEntry(uint32_t binding) const { return binding < m_TemplateEntries.size() ? m_TemplateEntries[binding] : UINT32_MAX; }
 	
 private:
 	const VulkanDevice*		m_Device;
 
 	VkDescriptorSetLayout	m_Layout;
+
+	//reflected bindings, template writes all of them from one packed array of resource infos
+	std::vector<VkDescriptorSetLayoutBinding>	m_Bindings;
+	std::vector<uint32_t>						m_TemplateEntries;
+	VkDescriptorUpdateTemplate					m_UpdateTemplate = VK_NULL_HANDLE;
 };
 
 class VulkanDescriptorSet
@@ -89,10 +100,18 @@ public:
 		const VulkanDescriptorSetLayout* descriptorSetLayout,
 		const std::vector<VulkanDescriptor*>& descriptors,
 		const char* name);
+	//set is allocated later with TryAllocate, pools that run out are handled by the caller
+	VulkanDescriptorSet() = default;
 
 public:
 	const VkDescriptorSet* GetVkHandle() const { return &m_DescriptorSet; }
+	//returns false when pool is out of memory or fragmented, previous handle is forgotten either way
+	bool TryAllocate(const VulkanDevice* device, const VulkanDescriptorPool* desciptorPool, const VulkanDescriptorSetLayout* descriptorSetLayout);
+	//rewrites given bindings in place, set must not be in use by the gpu
+	void Update(const VulkanDevice* device, const std::vector<VulkanDescriptor*>& descriptors);
 
 private:
-	VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+	VkDescriptorSet						m_DescriptorSet = VK_NULL_HANDLE;
+	//layout has to outlive the set, its template is used for updates
+	const VulkanDescriptorSetLayout*	m_Layout = nullptr;
 };
\ No newline at end of file
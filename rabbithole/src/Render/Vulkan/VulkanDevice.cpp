@@ -1,12 +1,16 @@
 #include "precomp.h"
 
+#include "Core/LoadProfiler.h"
 #include "Render/Converters.h"
 #include "Render/Window.h"
+#include "Utils/utils.h"
 
 #include "vk_mem_alloc.h"
 // std headers
 #include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <map>
 #include <set>
 #include <unordered_set>
 
@@ -62,6 +66,8 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 
 VulkanDevice::VulkanDevice() 
 {
+	LoadPhaseScope createPhase("VulkanDevice creation");
+
 	CreateInstance();
 	SetupDebugMessenger();
 	CreateSurface();
@@ -69,11 +75,27 @@ VulkanDevice::VulkanDevice()
 	CreateLogicalDevice();
 	CreateVmaAllocator();
 	CreateCommandPool();
+	CreatePipelineCache();
 	InitializeFunctionsThroughProcAddr();
+
+	m_UploadContext = new VulkanUploadContext(*this);
 }
 
 VulkanDevice::~VulkanDevice() 
 {
+	delete m_UploadContext;
+
+	SavePipelineCache();
+	vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+
+	if (HasDedicatedTransferQueue())
+	{
+		vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+	}
+	if (HasDedicatedComputeQueue())
+	{
+		vkDestroyCommandPool(m_Device, m_ComputeCommandPool, nullptr);
+	}
 	vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
 	vmaDestroyAllocator(m_VmaAllocator);
 	vkDestroyDevice(m_Device, nullptr);
@@ -176,25 +198,47 @@ void VulkanDevice::CreateLogicalDevice()
 	QueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+	std::map<uint32_t, uint32_t> queueCounts = { { indices.graphicsFamily, 1 }, { indices.presentFamily, 1 }, { indices.transferFamily, 1 } };
+	queueCounts[indices.computeFamily] = std::max(queueCounts[indices.computeFamily], indices.computeQueueIndex + 1);
 
-	float queuePriority = 1.0f;
-	for (uint32_t queueFamily : uniqueQueueFamilies) 
+	float queuePriorities[] = { 1.0f, 1.0f };
+	for (auto [queueFamily, queueCount] : queueCounts) 
 	{
 		VkDeviceQueueCreateInfo queueCreateInfo = {};
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queueCreateInfo.queueFamilyIndex = queueFamily;
-		queueCreateInfo.queueCount = 1;
-		queueCreateInfo.pQueuePriorities = &queuePriority;
+		queueCreateInfo.queueCount = queueCount;
+		queueCreateInfo.pQueuePriorities = queuePriorities;
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.robustBufferAccess = VK_TRUE;
+	deviceFeatures.multiDrawIndirect = VK_TRUE;
+	//texture streaming feedback is written from the gbuffer fragment shader
+	deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
+
+	//optional, model textures fall back to uncompressed formats without it
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	m_BlockCompressionSupported = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+	//uploads on transfer queue are waited on by graphics queue through timeline semaphore
+	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12Features.timelineSemaphore = VK_TRUE;
+
+	//resource transitions are recorded with vkCmdPipelineBarrier2
+	VkPhysicalDeviceVulkan13Features vulkan13Features = {};
+	vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	vulkan13Features.synchronization2 = VK_TRUE;
+	vulkan12Features.pNext = &vulkan13Features;
 
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = &vulkan12Features;
 
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -210,6 +254,30 @@ void VulkanDevice::CreateLogicalDevice()
 
 	vkGetDeviceQueue(m_Device, indices.graphicsFamily, 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(m_Device, indices.presentFamily, 0, &m_PresentQueue);
+	vkGetDeviceQueue(m_Device, indices.transferFamily, 0, &m_TransferQueue);
+	vkGetDeviceQueue(m_Device, indices.computeFamily, indices.computeQueueIndex, &m_ComputeQueue);
+
+	m_GraphicsQueueFamily = indices.graphicsFamily;
+	m_TransferQueueFamily = indices.transferFamily;
+	m_ComputeQueueFamily = indices.computeFamily;
+
+	if (HasDedicatedTransferQueue())
+	{
+		LOG_INFO("Using dedicated transfer queue family {} for uploads", m_TransferQueueFamily);
+	}
+
+	//inputs like depth are read on both queues in the same frame, handing them over back and forth would serialize
+	//the queues, so resources are concurrent between every family that uses them
+	if (HasDedicatedComputeQueue())
+	{
+		LOG_INFO("Using dedicated compute queue family {} for async compute", m_ComputeQueueFamily);
+
+		m_ConcurrentQueueFamilies = { m_GraphicsQueueFamily, m_ComputeQueueFamily };
+		if (m_TransferQueueFamily != m_GraphicsQueueFamily && m_TransferQueueFamily != m_ComputeQueueFamily)
+		{
+			m_ConcurrentQueueFamilies.push_back(m_TransferQueueFamily);
+		}
+	}
 }
 
 void VulkanDevice::CreateVmaAllocator()
@@ -237,6 +305,94 @@ void VulkanDevice::CreateCommandPool()
 	{
 		LOG_ERROR("failed to create command pool!");
 	}
+
+	m_TransferCommandPool = m_CommandPool;
+	if (HasDedicatedTransferQueue())
+	{
+		poolInfo.queueFamilyIndex = m_TransferQueueFamily;
+
+		if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_TransferCommandPool) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create transfer command pool!");
+		}
+	}
+
+	m_ComputeCommandPool = m_CommandPool;
+	if (HasDedicatedComputeQueue())
+	{
+		poolInfo.queueFamilyIndex = m_ComputeQueueFamily;
+
+		if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_ComputeCommandPool) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create compute command pool!");
+		}
+	}
+}
+
+void VulkanDevice::CreatePipelineCache()
+{
+	LoadPhaseScope cachePhase("Pipeline cache");
+
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	//driver would reject foreign data as well, checking it here keeps a bad file from being passed in at all
+	Utils::MappedFile cacheFile(PIPELINE_CACHE_PATH);
+	if (cacheFile.IsValid() && IsPipelineCacheCompatible(cacheFile.GetData(), cacheFile.GetSize()))
+	{
+		cacheInfo.initialDataSize = cacheFile.GetSize();
+		cacheInfo.pInitialData = cacheFile.GetData();
+		cachePhase.AddBytes(cacheFile.GetSize());
+	}
+
+	if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+	{
+		//cache is only an optimization, creating it empty is the last resort
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		VULKAN_API_CALL(vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache));
+	}
+}
+
+bool VulkanDevice::IsPipelineCacheCompatible(const uint8_t* data, size_t size) const
+{
+	VkPipelineCacheHeaderVersionOne header{};
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	return header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header.vendorID == m_Properties.vendorID && header.deviceID == m_Properties.deviceID &&
+		memcmp(header.pipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void VulkanDevice::SavePipelineCache()
+{
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+	{
+		return;
+	}
+
+	std::vector<uint8_t> data(dataSize);
+	if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	std::filesystem::create_directories(std::filesystem::path(PIPELINE_CACHE_PATH).parent_path());
+
+	FILE* file = nullptr;
+	if (fopen_s(&file, PIPELINE_CACHE_PATH, "wb") != 0)
+	{
+		LOG_WARNING("Could not write pipeline cache " PIPELINE_CACHE_PATH);
+		return;
+	}
+
+	std::fwrite(data.data(), 1, dataSize, file);
+	std::fclose(file);
 }
 
 void VulkanDevice::CreateSurface() 
@@ -264,7 +420,7 @@ bool VulkanDevice::IsDeviceSuitable(VkPhysicalDevice device)
 	vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
 	return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-		supportedFeatures.samplerAnisotropy;
+		supportedFeatures.samplerAnisotropy && supportedFeatures.multiDrawIndirect && supportedFeatures.fragmentStoresAndAtomics;
 }
 
 void VulkanDevice::PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) 
@@ -420,6 +576,49 @@ QueueFamilyIndices VulkanDevice::FindQueueFamilies(VkPhysicalDevice device)
 		i++;
 	}
 
+	//family without graphics is usually backed by copy engines that run alongside graphics work,
+	//transfer only family is preferred over async compute one
+	indices.transferFamily = indices.graphicsFamily;
+	bool transferFamilyHasCompute = true;
+	for (uint32_t family = 0; family < queueFamilyCount; family++)
+	{
+		VkQueueFlags queueFlags = queueFamilies[family].queueFlags;
+		if (queueFamilies[family].queueCount == 0 || !(queueFlags & VK_QUEUE_TRANSFER_BIT) || (queueFlags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			continue;
+		}
+
+		bool hasCompute = (queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+		if (indices.transferFamily == indices.graphicsFamily || (transferFamilyHasCompute && !hasCompute))
+		{
+			indices.transferFamily = family;
+			transferFamilyHasCompute = hasCompute;
+		}
+	}
+
+	//async compute gets a family without graphics, the one uploads use only when it has a second queue
+	indices.computeFamily = indices.graphicsFamily;
+	for (uint32_t family = 0; family < queueFamilyCount; family++)
+	{
+		VkQueueFlags queueFlags = queueFamilies[family].queueFlags;
+		if (!(queueFlags & VK_QUEUE_COMPUTE_BIT) || (queueFlags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			continue;
+		}
+
+		uint32_t queueIndex = family == indices.transferFamily ? 1 : 0;
+		if (queueFamilies[family].queueCount <= queueIndex)
+		{
+			continue;
+		}
+
+		if (indices.computeFamily == indices.graphicsFamily || queueIndex < indices.computeQueueIndex)
+		{
+			indices.computeFamily = family;
+			indices.computeQueueIndex = queueIndex;
+		}
+	}
+
 	return indices;
 }
 
@@ -504,12 +703,12 @@ void VulkanDevice::CopyBuffer(VulkanCommandBuffer& commandBuffer, VulkanBuffer&
 	vkCmdCopyBuffer(GET_VK_HANDLE(commandBuffer), GET_VK_HANDLE(srcBuffer), GET_VK_HANDLE(dstBuffer), 1, &copyRegion);
 }
 
-void VulkanDevice::CopyBufferToImage(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, bool copyFirstMipOnly)
+void VulkanDevice::CopyBufferToImage(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, bool copyFirstMipOnly, uint64_t bufferOffset)
 {
 	ImageRegion texRegion = texture->GetRegion();
 
 	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
+	region.bufferOffset = bufferOffset;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 
@@ -532,7 +731,7 @@ void VulkanDevice::CopyBufferToImage(VulkanCommandBuffer& commandBuffer, VulkanB
 	texture->SetCurrentResourceStage(ResourceStage::Transfer);
 }
 
-void VulkanDevice::CopyBufferToImageCubeMap(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture)
+void VulkanDevice::CopyBufferToImageCubeMap(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, uint64_t bufferOffset)
 {
 	ImageRegion texRegion = texture->GetRegion();
 	auto width = texRegion.Extent.Width;
@@ -552,7 +751,7 @@ void VulkanDevice::CopyBufferToImageCubeMap(VulkanCommandBuffer& commandBuffer,
 			bufferCopyRegion.imageExtent.width = width;
 			bufferCopyRegion.imageExtent.height = height;
 			bufferCopyRegion.imageExtent.depth = 1;
-			bufferCopyRegion.bufferOffset = face * width * height * 4;
+			bufferCopyRegion.bufferOffset = bufferOffset + face * width * height * 4;
 			bufferCopyRegions.push_back(bufferCopyRegion);
 		}
 	}
@@ -568,6 +767,43 @@ void VulkanDevice::CopyBufferToImageCubeMap(VulkanCommandBuffer& commandBuffer,
 	texture->SetCurrentResourceStage(ResourceStage::Transfer);
 }
 
+void VulkanDevice::CopyBufferToImageMips(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, uint64_t bufferOffset)
+{
+	ImageRegion texRegion = texture->GetRegion();
+
+	std::vector<VkBufferImageCopy> bufferCopyRegions;
+	uint64_t offset = bufferOffset;
+
+	for (uint32_t mip = 0; mip < texRegion.Subresource.MipSize; mip++)
+	{
+		uint32_t mipWidth = std::max(texRegion.Extent.Width >> mip, 1u);
+		uint32_t mipHeight = std::max(texRegion.Extent.Height >> mip, 1u);
+
+		VkBufferImageCopy bufferCopyRegion = {};
+		bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		bufferCopyRegion.imageSubresource.mipLevel = mip;
+		bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+		bufferCopyRegion.imageSubresource.layerCount = 1;
+		bufferCopyRegion.imageExtent.width = mipWidth;
+		bufferCopyRegion.imageExtent.height = mipHeight;
+		bufferCopyRegion.imageExtent.depth = 1;
+		bufferCopyRegion.bufferOffset = offset;
+		bufferCopyRegions.push_back(bufferCopyRegion);
+
+		offset += GetImageSizeFrom(texture->GetFormat(), mipWidth, mipHeight);
+	}
+
+	vkCmdCopyBufferToImage(
+		GET_VK_HANDLE(commandBuffer),
+		GET_VK_HANDLE_PTR(buffer),
+		GET_VK_HANDLE_PTR(texture->GetResource()),
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(bufferCopyRegions.size()),
+		bufferCopyRegions.data());
+
+	texture->SetCurrentResourceStage(ResourceStage::Transfer);
+}
+
 void VulkanDevice::CopyImage(VulkanCommandBuffer& commandBuffer, VulkanTexture* src, VulkanTexture* dst)
 {
 	VkImageCopy imageCopyRegion{};
@@ -612,6 +848,7 @@ void VulkanDevice::InitImguiForVulkan(ImGui_ImplVulkan_InitInfo& info)
 	info.PhysicalDevice = m_PhysicalDevice;
 	info.Device = m_Device;
 	info.Queue = m_GraphicsQueue;
+	info.PipelineCache = m_PipelineCache;
 }
 
 void VulkanDevice::SetObjectName(uint64_t object, VkObjectType objectType, const char* name)
@@ -653,10 +890,9 @@ void VulkanDevice::EndLabel(VulkanCommandBuffer& commandBuffer)
 #endif // RABBITHOLE_DEBUG
 }
 
-void VulkanDevice::ResourceBarrier(VulkanCommandBuffer& commandBuffer, VulkanTexture* texture, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage, uint32_t mipLevel, uint32_t mipCount)
+VkImageMemoryBarrier2 VulkanDevice::GetImageBarrier(VulkanTexture* texture, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage, uint32_t mipLevel, uint32_t mipCount)
 {
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	VkImageMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
 	barrier.oldLayout = GetVkImageLayoutFrom(oldLayout);
 	barrier.newLayout = GetVkImageLayoutFrom(newLayout);
 	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -668,20 +904,49 @@ void VulkanDevice::ResourceBarrier(VulkanCommandBuffer& commandBuffer, VulkanTex
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = texture->GetResource()->GetInfo().ArraySize;
 
-	barrier.srcAccessMask = GetVkAccessFlagsFromResourceState(oldLayout);
-	barrier.dstAccessMask = GetVkAccessFlagsFromResourceState(newLayout);
+	barrier.srcStageMask = GetVkPipelineStage2FromResourceStageAndState(srcStage, oldLayout);
+	barrier.srcAccessMask = GetVkAccess2FlagsFromResourceState(oldLayout);
+	barrier.dstStageMask = GetVkPipelineStage2FromResourceStageAndState(dstStage, newLayout);
+	barrier.dstAccessMask = GetVkAccess2FlagsFromResourceState(newLayout);
 
-	VkPipelineStageFlags sourceStage = GetVkPipelineStageFromResourceStageAndState(srcStage, oldLayout, true);
-	VkPipelineStageFlags destinationStage = GetVkPipelineStageFromResourceStageAndState(dstStage, newLayout, false);
+	return barrier;
+}
 
-	vkCmdPipelineBarrier(
-		GET_VK_HANDLE(commandBuffer),
-		sourceStage, destinationStage,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
+VkBufferMemoryBarrier2 VulkanDevice::GetBufferBarrier(VulkanBuffer* buffer, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage)
+{
+	VkBufferMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = GET_VK_HANDLE_PTR(buffer);
+	barrier.size = buffer->GetSize();
+
+	barrier.srcStageMask = GetVkPipelineStage2FromResourceStageAndState(srcStage, oldLayout);
+	barrier.srcAccessMask = GetVkAccess2FlagsFromResourceState(oldLayout);
+	barrier.dstStageMask = GetVkPipelineStage2FromResourceStageAndState(dstStage, newLayout);
+	barrier.dstAccessMask = GetVkAccess2FlagsFromResourceState(newLayout);
+
+	return barrier;
+}
+
+void VulkanDevice::ResourceBarriers(VulkanCommandBuffer& commandBuffer, const std::vector<VkImageMemoryBarrier2>& imageBarriers, const std::vector<VkBufferMemoryBarrier2>& bufferBarriers)
+{
+	if (imageBarriers.empty() && bufferBarriers.empty())
+	{
+		return;
+	}
+
+	VkDependencyInfo dependencyInfo{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+	dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+	dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+	dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+	dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+
+	vkCmdPipelineBarrier2(GET_VK_HANDLE(commandBuffer), &dependencyInfo);
+}
+
+void VulkanDevice::ResourceBarrier(VulkanCommandBuffer& commandBuffer, VulkanTexture* texture, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage, uint32_t mipLevel, uint32_t mipCount)
+{
+	ResourceBarriers(commandBuffer, { GetImageBarrier(texture, oldLayout, newLayout, srcStage, dstStage, mipLevel, mipCount) }, {});
 
 	texture->SetResourceState(newLayout);
 	texture->SetCurrentResourceStage(dstStage);
@@ -693,24 +958,7 @@ void VulkanDevice::ResourceBarrier(VulkanCommandBuffer& commandBuffer, VulkanBuf
 
 	if (oldLayout != ResourceState::None)
 	{
-		VkBufferMemoryBarrier bufferBarrier{};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		bufferBarrier.srcAccessMask = GetVkAccessFlagsFromResourceState(oldLayout);
-		bufferBarrier.dstAccessMask = GetVkAccessFlagsFromResourceState(newLayout);
-		bufferBarrier.size = buffer->GetSize();
-		bufferBarrier.buffer = GET_VK_HANDLE_PTR(buffer);
-
-		vkCmdPipelineBarrier(
-			GET_VK_HANDLE(commandBuffer),
-			GetVkPipelineStageFromResourceStageAndState(srcStage, oldLayout, true),
-			GetVkPipelineStageFromResourceStageAndState(dstStage, newLayout, false),
-			0,
-			0, nullptr,
-			1, &bufferBarrier,
-			0, nullptr
-		);
+		ResourceBarriers(commandBuffer, {}, { GetBufferBarrier(buffer, oldLayout, newLayout, srcStage, dstStage) });
 	}
 
 	buffer->SetResourceState(newLayout);
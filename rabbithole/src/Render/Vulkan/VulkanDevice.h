@@ -13,13 +13,20 @@ class VulkanBuffer;
 class VulkanRenderPass;
 class VulkanPipeline;
 class VulkanCommandBuffer;
+class VulkanUploadContext;
 
 //#define MUTE_VALIDATION_ERROR_SPAM
 
+//pipelines compiled on previous runs, cache written by other driver or device is ignored
+#define PIPELINE_CACHE_PATH "res/cache/pipelines.bin"
+
 struct QueueFamilyIndices 
 {
 	uint32_t graphicsFamily;
 	uint32_t presentFamily;
+	uint32_t transferFamily; //same as graphics family when device has no separate transfer family
+	uint32_t computeFamily; //same as graphics family when device has no separate compute family
+	uint32_t computeQueueIndex = 0; //compute family shared with transfer one uses its second queue
 	bool	 graphicsFamilyHasValue = false;
 	bool	 presentFamilyHasValue = false;
 
@@ -54,9 +61,24 @@ public:
 	VkSurfaceKHR				GetPresentingSurface() const { return m_PresetingSurface; }
 	VkQueue						GetGraphicsQueue() const { return m_GraphicsQueue; }
 	VkQueue						GetPresentQueue() const { return m_PresentQueue; }
+	VkQueue						GetTransferQueue() const { return m_TransferQueue; }
+	VkCommandPool				GetTransferCommandPool() const { return m_TransferCommandPool; }
+	uint32_t					GetGraphicsQueueFamily() const { return m_GraphicsQueueFamily; }
+	uint32_t					GetTransferQueueFamily() const { return m_TransferQueueFamily; }
+	bool						HasDedicatedTransferQueue() const { return m_TransferQueueFamily != m_GraphicsQueueFamily; }
+	//graphics queue and pool when device has no separate compute family
+	VkQueue						GetComputeQueue() const { return m_ComputeQueue; }
+	VkCommandPool				GetComputeCommandPool() const { return m_ComputeCommandPool; }
+	uint32_t					GetComputeQueueFamily() const { return m_ComputeQueueFamily; }
+	bool						HasDedicatedComputeQueue() const { return m_ComputeQueueFamily != m_GraphicsQueueFamily; }
+	//families images and buffers are shared between without ownership transfers, empty when they are exclusive
+	const std::vector<uint32_t>& GetConcurrentQueueFamilies() const { return m_ConcurrentQueueFamilies; }
+	bool						IsBlockCompressionSupported() const { return m_BlockCompressionSupported; }
 	VmaAllocator				GetVmaAllocator() const { return m_VmaAllocator; }
 	VkPhysicalDevice			GetPhysicalDevice() const { return m_PhysicalDevice; }
 	VkPhysicalDeviceProperties	GetPhysicalDeviceProperties() const { return m_Properties; }
+	VkPipelineCache				GetPipelineCache() const { return m_PipelineCache; }
+	VulkanUploadContext&		GetUploadContext() { return *m_UploadContext; }
 	SwapChainSupportDetails		GetSwapChainSupport() { return QuerySwapChainSupport(m_PhysicalDevice); }
 	QueueFamilyIndices			FindPhysicalQueueFamilies() { return FindQueueFamilies(m_PhysicalDevice); }
 	VkFormat					FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
@@ -64,14 +86,22 @@ public:
 
 	// Buffer Helper Functions
 	void					CopyBuffer(VulkanCommandBuffer& commandBuffer, VulkanBuffer& srcBuffer, VulkanBuffer& dstBuffer, uint64_t size, uint64_t srcOffset = 0, uint64_t dstOffset = 0);
-	void					CopyBufferToImage(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, bool copyFirstMipOnly = false);
-	void					CopyBufferToImageCubeMap(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture);
+	void					CopyBufferToImage(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, bool copyFirstMipOnly = false, uint64_t bufferOffset = 0);
+	void					CopyBufferToImageCubeMap(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, uint64_t bufferOffset = 0);
+	//mips are tightly packed one after another, starting with the largest one
+	void					CopyBufferToImageMips(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, VulkanTexture* texture, uint64_t bufferOffset = 0);
 	void					CopyImageToBuffer(VulkanCommandBuffer& commandBuffer, VulkanTexture* texture, VulkanBuffer* buffer);
 	void					CopyImage(VulkanCommandBuffer& commandBuffer, VulkanTexture* src, VulkanTexture* dst);
 	void					ResourceBarrier(VulkanCommandBuffer& commandBuffer, VulkanTexture* texture, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage, uint32_t mipLevel = 0, uint32_t mipCount = UINT32_MAX);
 	void					ResourceBarrier(VulkanCommandBuffer& commandBuffer, VulkanBuffer* buffer, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage);
+	//all transitions go out as one vkCmdPipelineBarrier2, barriers are made by functions below
+	void					ResourceBarriers(VulkanCommandBuffer& commandBuffer, const std::vector<VkImageMemoryBarrier2>& imageBarriers, const std::vector<VkBufferMemoryBarrier2>& bufferBarriers);
+	static VkImageMemoryBarrier2	GetImageBarrier(VulkanTexture* texture, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage, uint32_t mipLevel = 0, uint32_t mipCount = UINT32_MAX);
+	static VkBufferMemoryBarrier2	GetBufferBarrier(VulkanBuffer* buffer, ResourceState oldLayout, ResourceState newLayout, ResourceStage srcStage, ResourceStage dstStage);
 	
 	void					InitImguiForVulkan(ImGui_ImplVulkan_InitInfo& info);
+	//writes pipelines compiled so far to disk, next run starts with them
+	void					SavePipelineCache();
 
 	//debug utils
 	void SetObjectName(uint64_t object, VkObjectType objectType, const char* name);
@@ -86,9 +116,11 @@ private:
 	void CreateLogicalDevice();
 	void CreateVmaAllocator();
 	void CreateCommandPool();
+	void CreatePipelineCache();
 
 	//helper fuctions
 	bool						IsDeviceSuitable(VkPhysicalDevice device);
+	bool						IsPipelineCacheCompatible(const uint8_t* data, size_t size) const;
 	void						InitializeFunctionsThroughProcAddr();
 	std::vector<const char*>	GetRequiredExtensions();
 	bool						CheckValidationLayerSupport();
@@ -108,8 +140,19 @@ private:
 	VmaAllocator				m_VmaAllocator;
 	VkQueue						m_GraphicsQueue;
 	VkQueue						m_PresentQueue;
+	VkQueue						m_TransferQueue;
+	VkCommandPool				m_TransferCommandPool;
+	VkQueue						m_ComputeQueue;
+	VkCommandPool				m_ComputeCommandPool;
+	VkPipelineCache				m_PipelineCache = VK_NULL_HANDLE;
+	uint32_t					m_GraphicsQueueFamily;
+	uint32_t					m_TransferQueueFamily;
+	uint32_t					m_ComputeQueueFamily;
+	std::vector<uint32_t>		m_ConcurrentQueueFamilies;
+	bool						m_BlockCompressionSupported = false;
 	VkDebugUtilsMessengerEXT	m_DebugMessenger;
 	VkPhysicalDeviceProperties	m_Properties;
+	VulkanUploadContext*		m_UploadContext;
 
 	const std::vector<const char*> m_ValidationLayers = { "VK_LAYER_KHRONOS_validation" };
 	const std::vector<const char*> m_DeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_GOOGLE_HLSL_FUNCTIONALITY_1_EXTENSION_NAME, VK_GOOGLE_USER_TYPE_EXTENSION_NAME };
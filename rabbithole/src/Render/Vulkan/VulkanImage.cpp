@@ -7,10 +7,22 @@ VulkanImage::VulkanImage(const VulkanDevice* device, const VulkanImageInfo& info
 	, m_Info(info)
 	, m_Format(GetVkFormatFrom(m_Info.Format))
 	, m_ImageType(GetVkImageTypeFrom(m_Info.Extent.Depth))
+	, m_Name(name)
+{
+	VkImageCreateInfo imageCreateInfo = GetImageCreateInfo();
+
+	VmaAllocationCreateInfo allocationCreateInfo = {};
+	allocationCreateInfo.usage = GetVmaMemoryUsageFrom(m_Info.MemoryAccess);
+
+	VULKAN_API_CALL(vmaCreateImage(m_VulkanDevice->GetVmaAllocator(), &imageCreateInfo, &allocationCreateInfo, &m_Image, &m_Allocation, nullptr));
+}
+
+VkImageCreateInfo VulkanImage::GetImageCreateInfo() const
 {
 	VkImageCreateInfo imageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 
 	imageCreateInfo.flags |= IsFlagSet(m_Info.Flags & ImageFlags::CubeMap) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	imageCreateInfo.flags |= IsFlagSet(m_Info.Flags & ImageFlags::MutableFormat) ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT : 0;
 	imageCreateInfo.imageType = m_Info.Extent.Depth == 1 ? VK_IMAGE_TYPE_2D : VK_IMAGE_TYPE_3D;
 	imageCreateInfo.format = m_Format;
 	imageCreateInfo.extent.width = m_Info.Extent.Width;
@@ -22,13 +34,13 @@ VulkanImage::VulkanImage(const VulkanDevice* device, const VulkanImageInfo& info
 	imageCreateInfo.tiling = IsFlagSet(m_Info.Flags & ImageFlags::LinearTiling) ?
 		VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
 	imageCreateInfo.usage = GetVkImageUsageFlagsFrom(m_Info.UsageFlags);
-	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	const std::vector<uint32_t>& queueFamilies = m_VulkanDevice->GetConcurrentQueueFamilies();
+	imageCreateInfo.sharingMode = queueFamilies.empty() ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT;
+	imageCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+	imageCreateInfo.pQueueFamilyIndices = queueFamilies.data();
 	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-	VmaAllocationCreateInfo allocationCreateInfo = {};
-	allocationCreateInfo.usage = GetVmaMemoryUsageFrom(m_Info.MemoryAccess);
-
-	VULKAN_API_CALL(vmaCreateImage(m_VulkanDevice->GetVmaAllocator(), &imageCreateInfo, &allocationCreateInfo, &m_Image, &m_Allocation, nullptr));
+	return imageCreateInfo;
 }
 
 VulkanImage::VulkanImage(const VulkanDevice* device, const VulkanSwapchain* swapchain, const uint32_t backBufferIndex)
@@ -61,6 +73,36 @@ VulkanImage::~VulkanImage()
 	{
 		vmaDestroyImage(m_VulkanDevice->GetVmaAllocator(), m_Image, m_Allocation);
 	}
+	else if (m_VulkanDevice != nullptr)
+	{
+		//aliased image, memory belongs to the resource manager
+		vkDestroyImage(m_VulkanDevice->GetGraphicDevice(), m_Image, nullptr);
+	}
+}
+
+VkMemoryRequirements VulkanImage::GetMemoryRequirements() const
+{
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(m_VulkanDevice->GetGraphicDevice(), m_Image, &memoryRequirements);
+	return memoryRequirements;
+}
+
+void VulkanImage::BindToAliasedMemory(VmaAllocation memory)
+{
+	if (m_Allocation != VK_NULL_HANDLE)
+	{
+		vmaDestroyImage(m_VulkanDevice->GetVmaAllocator(), m_Image, m_Allocation);
+		m_Allocation = VK_NULL_HANDLE;
+	}
+	else
+	{
+		vkDestroyImage(m_VulkanDevice->GetGraphicDevice(), m_Image, nullptr);
+	}
+
+	//memory can be bound only once, so the image itself is created again
+	VkImageCreateInfo imageCreateInfo = GetImageCreateInfo();
+	VULKAN_API_CALL(vkCreateImage(m_VulkanDevice->GetGraphicDevice(), &imageCreateInfo, nullptr, &m_Image));
+	VULKAN_API_CALL(vmaBindImageMemory(m_VulkanDevice->GetVmaAllocator(), memory, m_Image));
 }
 
 VulkanImageView::VulkanImageView(const VulkanDevice* device, const VulkanImageViewInfo& info, const char* name)
@@ -69,6 +111,23 @@ VulkanImageView::VulkanImageView(const VulkanDevice* device, const VulkanImageVi
 {
 	m_Image = m_Info.Resource;
 
+	CreateImageView();
+}
+
+VulkanImageView::~VulkanImageView()
+{
+	vkDestroyImageView(m_VulkanDevice->GetGraphicDevice(), m_ImageView, nullptr);
+}
+
+void VulkanImageView::Recreate()
+{
+	vkDestroyImageView(m_VulkanDevice->GetGraphicDevice(), m_ImageView, nullptr);
+
+	CreateImageView();
+}
+
+void VulkanImageView::CreateImageView()
+{
 	VkImageViewCreateInfo imageViewCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
 	imageViewCreateInfo.format = GetVkFormatFrom(m_Info.Format);
 
@@ -97,12 +156,16 @@ VulkanImageView::VulkanImageView(const VulkanDevice* device, const VulkanImageVi
 	imageViewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 	imageViewCreateInfo.image = GET_VK_HANDLE_PTR(m_Image);
 
-	VULKAN_API_CALL(vkCreateImageView(m_VulkanDevice->GetGraphicDevice(), &imageViewCreateInfo, nullptr, &m_ImageView));
-}
+	//usage the image was created with may not be supported by the format of view, e.g. storage for srgb
+	VkImageViewUsageCreateInfo viewUsageInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO };
+	if (IsFlagSet(m_Image->GetInfo().Flags & ImageFlags::MutableFormat))
+	{
+		viewUsageInfo.usage = IsFlagSet(m_Info.Flags & ImageViewFlags::Storage) ?
+			VK_IMAGE_USAGE_STORAGE_BIT : GetVkImageUsageFlagsFrom(m_Image->GetInfo().UsageFlags) & ~VK_IMAGE_USAGE_STORAGE_BIT;
+		imageViewCreateInfo.pNext = &viewUsageInfo;
+	}
 
-VulkanImageView::~VulkanImageView()
-{
-	vkDestroyImageView(m_VulkanDevice->GetGraphicDevice(), m_ImageView, nullptr);
+	VULKAN_API_CALL(vkCreateImageView(m_VulkanDevice->GetGraphicDevice(), &imageViewCreateInfo, nullptr, &m_ImageView));
 }
 
 VulkanImageSampler::VulkanImageSampler(const VulkanDevice* device, const VulkanImageSamplerInfo& info, const char* name)
@@ -35,17 +35,26 @@ private:
 		const uint32_t backBufferIndex);
 
 public:
-	inline VulkanImageInfo GetInfo() const { return m_Info; }
-	inline VkImageType	   GetImageType() const { return m_ImageType; }
-	inline VkImage		   GetVkHandle() const { return m_Image; }
+	inline VulkanImageInfo		GetInfo() const { return m_Info; }
+	inline VkImageType			GetImageType() const { return m_ImageType; }
+	inline VkImage				GetVkHandle() const { return m_Image; }
+	inline const std::string&	GetName() const { return m_Name; }
+
+	VkMemoryRequirements		GetMemoryRequirements() const;
+	//recreates the image on memory shared with other images, contents are lost and views of it have to be recreated.
+	//image must not be in use by the gpu, memory is freed by the caller
+	void						BindToAliasedMemory(VmaAllocation memory);
 
 private:
+	VkImageCreateInfo GetImageCreateInfo() const;
+
 	const VulkanDevice* m_VulkanDevice;
 	VulkanImageInfo		m_Info;
 	VkFormat			m_Format;
 	VkImageType			m_ImageType;
 	VkImage				m_Image;
-	VmaAllocation		m_Allocation;
+	VmaAllocation		m_Allocation;	//null for swapchain and aliased images
+	std::string			m_Name;
 };
 
 struct VulkanImageViewInfo
@@ -70,7 +79,12 @@ public:
 	VkImageView						 GetVkHandle() const { return m_ImageView; }
 	Format							 GetFormat() const { return m_Info.Format; }
 
+	//image was created again, view keeps its id so caches keyed by it stay valid
+	void							 Recreate();
+
 private:
+	void CreateImageView();
+
 	const VulkanDevice*			m_VulkanDevice;
 	const VulkanImageViewInfo	m_Info;
 	const VulkanImage*			m_Image;
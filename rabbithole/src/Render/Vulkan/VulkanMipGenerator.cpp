@@ -0,0 +1,285 @@
+#include "precomp.h"
+
+#include "VulkanMipGenerator.h"
+
+#include <algorithm>
+#include <format>
+
+#include "Render/Converters.h"
+#include "Render/Shader.h"
+
+//keep in sync with CS_GenerateMips
+#define MIP_GENERATION_SHADER_SRGB				0x1
+#define MIP_GENERATION_SHADER_NORMAL_MAP		0x2
+#define MIP_GENERATION_SHADER_ALPHA_COVERAGE	0x4
+
+struct MipGenerationPushConstants
+{
+	uint32_t sourceWidth;
+	uint32_t sourceHeight;
+	uint32_t mipCount;
+	uint32_t numWorkGroups;
+	uint32_t counterIndex;
+	uint32_t flags;
+};
+
+static bool IsSRGBFormat(Format format)
+{
+	return format == Format::R8G8B8A8_UNORM_SRGB || format == Format::B8G8R8A8_UNORM_SRGB;
+}
+
+VulkanMipGenerator::VulkanMipGenerator(VulkanDevice& device)
+	: m_Device(device)
+{
+	m_AtomicCounters = new VulkanBuffer(m_Device, BufferUsageFlags::StorageBuffer | BufferUsageFlags::TransferDst, MemoryAccess::GPU, MIP_GENERATOR_MAX_TEXTURES_PER_BATCH * sizeof(uint32_t), "MipGeneratorAtomicCounters");
+}
+
+VulkanMipGenerator::~VulkanMipGenerator()
+{
+	Retire(UINT64_MAX);
+
+	for (VulkanDescriptorPool* descriptorPool : m_FreeDescriptorPools)
+	{
+		delete descriptorPool;
+	}
+
+	delete m_Pipeline;
+	delete m_PipelineInfo;
+	delete m_AtomicCounters;
+}
+
+void VulkanMipGenerator::Init(Shader* computeShader)
+{
+	ASSERT(!m_Pipeline, "Mip generator is already initialized");
+
+	m_PipelineInfo = new PipelineInfo();
+	m_PipelineInfo->computeShader = computeShader;
+
+	m_Pipeline = new VulkanPipeline(m_Device, *m_PipelineInfo, PipelineType::Compute);
+}
+
+Format VulkanMipGenerator::GetStorageFormat(Format format)
+{
+	switch (format)
+	{
+	case Format::R8G8B8A8_UNORM:
+	case Format::R8G8B8A8_UNORM_SRGB:
+		return Format::R8G8B8A8_UNORM;
+	default:
+		return Format::UNDEFINED;
+	}
+}
+
+bool VulkanMipGenerator::CanGenerateMips(Format format, uint32_t width, uint32_t height) const
+{
+	const uint32_t mipCount = GET_MIP_LEVELS_FROM_RES(width, height);
+
+	return m_Pipeline && GetStorageFormat(format) != Format::UNDEFINED && mipCount > 1 && mipCount - 1 <= MIP_GENERATOR_MAX_MIP_COUNT;
+}
+
+void VulkanMipGenerator::QueueTexture(VulkanTexture* texture, MipGenerationFlags flags, ResourceState stateAfter)
+{
+	ASSERT(CanGenerateMips(texture->GetFormat(), texture->GetWidth(), texture->GetHeight()), "Mips of this texture can't be generated on gpu");
+	ASSERT(stateAfter != ResourceState::None, "Texture with generated mips has to end up in a readable state");
+
+	m_QueuedTextures.push_back(QueuedTexture{ texture, flags, stateAfter });
+}
+
+void VulkanMipGenerator::Record(VulkanCommandBuffer& commandBuffer, uint64_t submissionId)
+{
+	for (size_t firstTexture = 0; firstTexture < m_QueuedTextures.size(); firstTexture += MIP_GENERATOR_MAX_TEXTURES_PER_BATCH)
+	{
+		const uint32_t textureCount = static_cast<uint32_t>(std::min<size_t>(MIP_GENERATOR_MAX_TEXTURES_PER_BATCH, m_QueuedTextures.size() - firstTexture));
+
+		m_Batches.push_back(Batch{ submissionId, AcquireDescriptorPool(), {}, {} });
+		RecordBatch(commandBuffer, m_Batches.back(), m_QueuedTextures.data() + firstTexture, textureCount);
+	}
+
+	m_QueuedTextures.clear();
+}
+
+void VulkanMipGenerator::RecordBatch(VulkanCommandBuffer& commandBuffer, Batch& batch, const QueuedTexture* textures, uint32_t textureCount)
+{
+	VkCommandBuffer vkCommandBuffer = GET_VK_HANDLE(commandBuffer);
+
+	//counters can still be in use by the previous batch, spd resets them itself but clear keeps batches independent
+	VkBufferMemoryBarrier counterBarrier{};
+	counterBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	counterBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	counterBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	counterBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	counterBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	counterBarrier.buffer = GET_VK_HANDLE_PTR(m_AtomicCounters);
+	counterBarrier.offset = 0;
+	counterBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(vkCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &counterBarrier, 0, nullptr);
+	vkCmdFillBuffer(vkCommandBuffer, GET_VK_HANDLE_PTR(m_AtomicCounters), 0, VK_WHOLE_SIZE, 0);
+
+	counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	//mip 0 is read by every dispatch, the rest of the chain is written, their previous content is discarded
+	std::vector<VkImageMemoryBarrier> imageBarriers(textureCount * 2);
+	for (uint32_t i = 0; i < textureCount; i++)
+	{
+		VulkanTexture* texture = textures[i].texture;
+
+		VkImageMemoryBarrier& sourceBarrier = imageBarriers[i * 2];
+		sourceBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		sourceBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		sourceBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		sourceBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		sourceBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		sourceBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		sourceBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		sourceBarrier.image = GET_VK_HANDLE_PTR(texture->GetResource());
+		sourceBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		VkImageMemoryBarrier& mipsBarrier = imageBarriers[i * 2 + 1];
+		mipsBarrier = sourceBarrier;
+		mipsBarrier.srcAccessMask = 0;
+		mipsBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		mipsBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		mipsBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		mipsBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 1, texture->GetMipCount() - 1, 0, 1 };
+	}
+
+	vkCmdPipelineBarrier(vkCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &counterBarrier, textureCount * 2, imageBarriers.data());
+
+	vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline->GetVkHandle());
+
+	for (uint32_t i = 0; i < textureCount; i++)
+	{
+		VulkanTexture* texture = textures[i].texture;
+		const uint32_t mipCount = texture->GetMipCount() - 1;
+
+		VulkanImageViewInfo viewInfo{};
+		viewInfo.Resource = texture->GetResource();
+		viewInfo.Flags = ImageViewFlags::None;
+		viewInfo.Format = texture->GetFormat();
+		viewInfo.Subresource.MipSlice = 0;
+		viewInfo.Subresource.MipSize = 1;
+		viewInfo.Subresource.ArraySlice = 0;
+		viewInfo.Subresource.ArraySize = 1;
+
+		//srgb source view decodes texels, chain is written through unorm views and encoded by the shader
+		VulkanImageView* sourceView = new VulkanImageView(&m_Device, viewInfo, std::format("{}_MipSource", texture->GetName()).c_str());
+		batch.views.push_back(sourceView);
+
+		std::vector<VulkanDescriptor> descriptors;
+		descriptors.reserve(2 + MIP_GENERATOR_MAX_MIP_COUNT);
+		descriptors.emplace_back(VulkanDescriptorInfo{ DescriptorType::CombinedSampler, 0, nullptr, sourceView, texture->GetSampler() });
+		descriptors.emplace_back(VulkanDescriptorInfo{ DescriptorType::StorageBuffer, 1, m_AtomicCounters, nullptr, nullptr });
+
+		viewInfo.Flags = ImageViewFlags::Storage;
+		viewInfo.Format = GetStorageFormat(texture->GetFormat());
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+		{
+			viewInfo.Subresource.MipSlice = mip + 1;
+
+			VulkanImageView* mipView = new VulkanImageView(&m_Device, viewInfo, std::format("{}_Mip{}", texture->GetName(), mip + 1).c_str());
+			batch.views.push_back(mipView);
+
+			descriptors.emplace_back(VulkanDescriptorInfo{ DescriptorType::StorageImage, 2 + mip, nullptr, mipView, nullptr });
+		}
+
+		//unused bindings still have to be valid, shader never writes them
+		for (uint32_t mip = mipCount; mip < MIP_GENERATOR_MAX_MIP_COUNT; mip++)
+		{
+			descriptors.emplace_back(VulkanDescriptorInfo{ DescriptorType::StorageImage, 2 + mip, nullptr, batch.views.back(), nullptr });
+		}
+
+		std::vector<VulkanDescriptor*> descriptorPtrs;
+		for (VulkanDescriptor& descriptor : descriptors)
+		{
+			descriptorPtrs.push_back(&descriptor);
+		}
+
+		VulkanDescriptorSet* descriptorSet = new VulkanDescriptorSet(&m_Device, batch.descriptorPool, m_Pipeline->GetDescriptorSetLayout(), descriptorPtrs, "MipGeneratorDescriptorSet");
+		batch.descriptorSets.push_back(descriptorSet);
+
+		VkPipelineLayout pipelineLayout = GET_VK_HANDLE_PTR(m_Pipeline->GetPipelineLayout());
+		vkCmdBindDescriptorSets(vkCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, descriptorSet->GetVkHandle(), 0, nullptr);
+
+		//every workgroup reduces 64x64 tile of mip 0
+		const uint32_t dispatchX = GetCSDispatchCount(texture->GetWidth(), 64);
+		const uint32_t dispatchY = GetCSDispatchCount(texture->GetHeight(), 64);
+
+		MipGenerationPushConstants pushConstants{};
+		pushConstants.sourceWidth = texture->GetWidth();
+		pushConstants.sourceHeight = texture->GetHeight();
+		pushConstants.mipCount = mipCount;
+		pushConstants.numWorkGroups = dispatchX * dispatchY;
+		pushConstants.counterIndex = i;
+		pushConstants.flags =
+			(IsSRGBFormat(texture->GetFormat()) ? MIP_GENERATION_SHADER_SRGB : 0) |
+			(IsFlagSet(textures[i].flags & MipGenerationFlags::NormalMap) ? MIP_GENERATION_SHADER_NORMAL_MAP : 0) |
+			(IsFlagSet(textures[i].flags & MipGenerationFlags::AlphaCoverage) ? MIP_GENERATION_SHADER_ALPHA_COVERAGE : 0);
+
+		vkCmdPushConstants(vkCommandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MipGenerationPushConstants), &pushConstants);
+		vkCmdDispatch(vkCommandBuffer, dispatchX, dispatchY, 1);
+	}
+
+	//whole batch goes to its final state at once
+	for (uint32_t i = 0; i < textureCount; i++)
+	{
+		const ResourceState stateAfter = textures[i].stateAfter;
+
+		VkImageMemoryBarrier& sourceBarrier = imageBarriers[i * 2];
+		sourceBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		sourceBarrier.dstAccessMask = GetVkAccessFlagsFromResourceState(stateAfter);
+		sourceBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		sourceBarrier.newLayout = GetVkImageLayoutFrom(stateAfter);
+
+		VkImageMemoryBarrier& mipsBarrier = imageBarriers[i * 2 + 1];
+		mipsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		mipsBarrier.dstAccessMask = GetVkAccessFlagsFromResourceState(stateAfter);
+		mipsBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		mipsBarrier.newLayout = GetVkImageLayoutFrom(stateAfter);
+	}
+
+	vkCmdPipelineBarrier(vkCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, textureCount * 2, imageBarriers.data());
+}
+
+void VulkanMipGenerator::Retire(uint64_t submissionId)
+{
+	while (!m_Batches.empty() && m_Batches.front().submissionId <= submissionId)
+	{
+		Batch& batch = m_Batches.front();
+
+		for (VulkanDescriptorSet* descriptorSet : batch.descriptorSets)
+		{
+			delete descriptorSet;
+		}
+		for (VulkanImageView* view : batch.views)
+		{
+			delete view;
+		}
+
+		//sets are freed all at once
+		VULKAN_API_CALL(vkResetDescriptorPool(m_Device.GetGraphicDevice(), GET_VK_HANDLE_PTR(batch.descriptorPool), 0));
+		m_FreeDescriptorPools.push_back(batch.descriptorPool);
+
+		m_Batches.pop_front();
+	}
+}
+
+VulkanDescriptorPool* VulkanMipGenerator::AcquireDescriptorPool()
+{
+	if (!m_FreeDescriptorPools.empty())
+	{
+		VulkanDescriptorPool* descriptorPool = m_FreeDescriptorPools.back();
+		m_FreeDescriptorPools.pop_back();
+		return descriptorPool;
+	}
+
+	VulkanDescriptorPoolInfo poolInfo{};
+	poolInfo.DescriptorSizes = {
+		{ DescriptorType::CombinedSampler, MIP_GENERATOR_MAX_TEXTURES_PER_BATCH },
+		{ DescriptorType::StorageBuffer, MIP_GENERATOR_MAX_TEXTURES_PER_BATCH },
+		{ DescriptorType::StorageImage, MIP_GENERATOR_MAX_TEXTURES_PER_BATCH * MIP_GENERATOR_MAX_MIP_COUNT } };
+	poolInfo.MaxSets = MIP_GENERATOR_MAX_TEXTURES_PER_BATCH;
+
+	return new VulkanDescriptorPool(&m_Device, poolInfo);
+}
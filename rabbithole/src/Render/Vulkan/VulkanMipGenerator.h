@@ -0,0 +1,80 @@
+#pragma once
+
+#include "common.h"
+#include "VulkanPipeline.h"
+
+#include <deque>
+#include <vector>
+
+class VulkanBuffer;
+class VulkanCommandBuffer;
+class VulkanDescriptorPool;
+class VulkanDescriptorSet;
+class VulkanDevice;
+class VulkanImageView;
+class VulkanTexture;
+class Shader;
+
+//keep in sync with CS_GenerateMips, single pass downsampler writes at most 12 mips below the source one
+#define MIP_GENERATOR_MAX_MIP_COUNT			12
+//textures of a batch share one barrier before and one after their dispatches
+#define MIP_GENERATOR_MAX_TEXTURES_PER_BATCH	64
+
+//generates mip chains of uploaded textures on gpu with single pass downsampler, every texture is a single dispatch.
+//textures are queued while their uploads are recorded and generated together on graphics part of the upload
+//submission, views and descriptor sets they need are released once the submission is retired
+class VulkanMipGenerator
+{
+public:
+	VulkanMipGenerator(VulkanDevice& device);
+	~VulkanMipGenerator();
+
+	NonCopyableAndMovable(VulkanMipGenerator);
+
+	//textures created before shaders are loaded fall back to blits
+	void Init(Shader* computeShader);
+
+	//format of views mips are written through, undefined when format is not supported
+	static Format GetStorageFormat(Format format);
+	//format has to have a rgba8 storage view and chain has to fit into a single dispatch
+	bool CanGenerateMips(Format format, uint32_t width, uint32_t height) const;
+	//image has to be in transfer dst state with mip 0 written on graphics queue
+	void QueueTexture(VulkanTexture* texture, MipGenerationFlags flags, ResourceState stateAfter);
+	//records every queued texture, it is in stateAfter after the command buffer executes
+	void Record(VulkanCommandBuffer& commandBuffer, uint64_t submissionId);
+	//frees resources of every submission up to this one
+	void Retire(uint64_t submissionId);
+
+	inline bool HasQueuedTextures() const { return !m_QueuedTextures.empty(); }
+
+private:
+	struct QueuedTexture
+	{
+		VulkanTexture*		texture;
+		MipGenerationFlags	flags;
+		ResourceState		stateAfter;
+	};
+
+	struct Batch
+	{
+		uint64_t							submissionId;
+		VulkanDescriptorPool*				descriptorPool;
+		std::vector<VulkanDescriptorSet*>	descriptorSets;
+		std::vector<VulkanImageView*>		views;
+	};
+
+	void RecordBatch(VulkanCommandBuffer& commandBuffer, Batch& batch, const QueuedTexture* textures, uint32_t textureCount);
+	VulkanDescriptorPool* AcquireDescriptorPool();
+
+	VulkanDevice&						m_Device;
+
+	//pipeline keeps a reference to its info
+	PipelineInfo*						m_PipelineInfo = nullptr;
+	VulkanPipeline*						m_Pipeline = nullptr;
+	//one spd counter per texture of a batch, cleared before every batch
+	VulkanBuffer*						m_AtomicCounters = nullptr;
+
+	std::vector<QueuedTexture>			m_QueuedTextures;
+	std::deque<Batch>					m_Batches;
+	std::vector<VulkanDescriptorPool*>	m_FreeDescriptorPools;
+};
@@ -63,6 +63,7 @@ void VulkanPipeline::DefaultPipelineInfo(PipelineInfo*& pipelineInfo, uint32_t w
 	pipelineInfo->SetCullMode(CullMode::Back);
 	pipelineInfo->SetWindingOrder(WindingOrder::Clockwise);
 	pipelineInfo->SetDepthBias(0.0f, 0.0f, 0.0f);
+	pipelineInfo->SetVertexLayout(VertexLayout::Full);
 
 	pipelineInfo->multisampleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	pipelineInfo->multisampleInfo.sampleShadingEnable = VK_FALSE;
@@ -95,6 +96,11 @@ void VulkanPipeline::DefaultPipelineInfo(PipelineInfo*& pipelineInfo, uint32_t w
 	pipelineInfo->depthStencilInfo.stencilTestEnable = VK_FALSE;
 	pipelineInfo->depthStencilInfo.front = {};  // Optional
 	pipelineInfo->depthStencilInfo.back = {};   // Optional
+
+	memset(pipelineInfo->renderTargetFormats, 0, sizeof(pipelineInfo->renderTargetFormats));
+	pipelineInfo->depthStencilFormat = VK_FORMAT_UNDEFINED;
+
+	pipelineInfo->InvalidateStateHash();
 }
 
 void VulkanPipeline::CreateComputePipeline()
@@ -121,7 +127,7 @@ void VulkanPipeline::CreateComputePipeline()
 	computePipelineInfo.layout = GET_VK_HANDLE_PTR(m_PipelineLayout);
 	computePipelineInfo.flags = 0;
 
-	VULKAN_API_CALL(vkCreateComputePipelines(m_VulkanDevice.GetGraphicDevice(), VK_NULL_HANDLE, 1, &computePipelineInfo, nullptr, &m_Pipeline));
+	VULKAN_API_CALL(vkCreateComputePipelines(m_VulkanDevice.GetGraphicDevice(), m_VulkanDevice.GetPipelineCache(), 1, &computePipelineInfo, nullptr, &m_Pipeline));
 
 }
 
@@ -162,8 +168,9 @@ void VulkanPipeline::CreateGraphicsPipeline()
 
 	m_PipelineLayout = new VulkanPipelineLayout(m_VulkanDevice, descSetLayouts, pushConsts);
 
-	auto bindingDescriptions = Vertex::GetBindingDescriptions();		//TODO: abstract this
-	auto attributeDescriptions = Vertex::GetAttributeDescriptions();	//TODO: abstract this
+	const bool compressedVertices = m_PipelineInfo.vertexLayout == VertexLayout::Compressed;
+	auto bindingDescriptions = compressedVertices ? CompressedVertex::GetBindingDescriptions() : Vertex::GetBindingDescriptions();
+	auto attributeDescriptions = compressedVertices ? CompressedVertex::GetAttributeDescriptions() : Vertex::GetAttributeDescriptions();
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -203,7 +210,7 @@ void VulkanPipeline::CreateGraphicsPipeline()
 	pipelineInfo.basePipelineIndex = -1;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	VULKAN_API_CALL(vkCreateGraphicsPipelines(m_VulkanDevice.GetGraphicDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline));
+	VULKAN_API_CALL(vkCreateGraphicsPipelines(m_VulkanDevice.GetGraphicDevice(), m_VulkanDevice.GetPipelineCache(), 1, &pipelineInfo, nullptr, &m_Pipeline));
 }
 
 // void PipelineInfo::SetVertexBinding(const VertexBinding* vertexBinding)
@@ -217,27 +224,37 @@ void VulkanPipeline::CreateGraphicsPipeline()
 void PipelineInfo::SetTopology(const Topology topology)
 {
 	inputAssemblyInfo.topology = GetVkPrimitiveTopologyFrom(topology);
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetMultisampleType(const MultisampleType multiSampleType)
 {
 	multisampleInfo.rasterizationSamples = GetVkSampleFlagsFrom(multiSampleType);
 	multisampleInfo.sampleShadingEnable = multiSampleType == MultisampleType::Sample_1 ? VK_FALSE : VK_TRUE;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetDepthWriteEnabled(const bool enabled)
 {
 	depthStencilInfo.depthWriteEnable = enabled;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetDepthTestEnabled(const bool enabled)
 {
 	depthStencilInfo.depthTestEnable = enabled;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetDepthCompare(const CompareOperation compareFunction)
 {
 	depthStencilInfo.depthCompareOp = GetVkCompareOperationFrom(compareFunction);
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetDepthBias(const float depthBiasSlope, const float depthBias, const float depthBiasClamp)
@@ -246,11 +263,15 @@ void PipelineInfo::SetDepthBias(const float depthBiasSlope, const float depthBia
 	rasterizationInfo.depthBiasSlopeFactor = depthBiasSlope;
 	rasterizationInfo.depthBiasConstantFactor = depthBias;
 	rasterizationInfo.depthBiasClamp = depthBiasClamp;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetStencilEnable(const bool enabled)
 {
 	depthStencilInfo.stencilTestEnable = enabled;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetStencilOperation(const StencilOperation stencilFail, const StencilOperation depthFail, const StencilOperation stencilPass)
@@ -266,6 +287,8 @@ void PipelineInfo::SetStencilOperation(const StencilOperation stencilFail, const
 	depthStencilInfo.back.failOp = stencilFailOp;
 	depthStencilInfo.back.depthFailOp = depthFailOp;
 	depthStencilInfo.back.passOp = stencilPassOp;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetStencilFunction(const CompareOperation compareOperation, const uint8_t compareMask)
@@ -277,28 +300,61 @@ void PipelineInfo::SetStencilFunction(const CompareOperation compareOperation, c
 
 	depthStencilInfo.front.compareMask = compareMask;
 	depthStencilInfo.back.compareMask = compareMask;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetStencilWriteMask(const uint8_t mask)
 {
 	depthStencilInfo.front.writeMask = mask;
 	depthStencilInfo.back.writeMask = mask;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetWireFrameEnabled(const bool enable)
 {
 	rasterizationInfo.polygonMode = enable ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetCullMode(const CullMode mode)
 {
 	rasterizationInfo.cullMode = mode == CullMode::None ? VK_CULL_MODE_NONE :
 		mode == CullMode::Front ? VK_CULL_MODE_FRONT_BIT : VK_CULL_MODE_BACK_BIT;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetWindingOrder(const WindingOrder winding)
 {
 	rasterizationInfo.frontFace = winding == WindingOrder::Clockwise ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	InvalidateStateHash();
+}
+
+void PipelineInfo::SetVertexLayout(const VertexLayout layout)
+{
+	vertexLayout = layout;
+
+	InvalidateStateHash();
+}
+
+void PipelineInfo::SetRenderTargetFormat(const uint32_t mrtIndex, const Format format)
+{
+	ASSERT(mrtIndex < MaxRenderTargetCount, "mrtIndex must be lower then MaxRenderTargetCount");
+
+	renderTargetFormats[mrtIndex] = GetVkFormatFrom(format);
+
+	InvalidateStateHash();
+}
+
+void PipelineInfo::SetDepthStencilFormat(const Format format)
+{
+	depthStencilFormat = GetVkFormatFrom(format);
+
+	InvalidateStateHash();
 }
 
  void PipelineInfo::SetColorWriteMask(const uint32_t mrtIndex, const ColorWriteMaskFlags mask)
@@ -306,6 +362,8 @@ void PipelineInfo::SetWindingOrder(const WindingOrder winding)
 	ASSERT(mrtIndex < MaxRenderTargetCount, "mrtIndex must be lower then MaxRenderTargetCount");
 
  	colorBlendAttachment[mrtIndex].colorWriteMask = VkColorComponentFlags(mask);
+
+	InvalidateStateHash();
  }
  
  void PipelineInfo::SetColorWriteMask(const uint32_t mrtIndex, const uint32_t mrtCount, const ColorWriteMaskFlags masks[])
@@ -316,6 +374,8 @@ void PipelineInfo::SetWindingOrder(const WindingOrder winding)
  	{
  		colorBlendAttachment[mrtIndex].colorWriteMask = VkColorComponentFlags(masks[mrtIndex]);
  	}
+
+	InvalidateStateHash();
  }
 
  PipelineInfo::PipelineInfo()
@@ -352,6 +412,7 @@ void PipelineInfo::SetWindingOrder(const WindingOrder winding)
 	 SetCullMode(CullMode::Back);
 	 SetWindingOrder(WindingOrder::Clockwise);
 	 SetDepthBias(0.0f, 0.0f, 0.0f);
+	 SetVertexLayout(VertexLayout::Full);
 
 	 multisampleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	 multisampleInfo.sampleShadingEnable = VK_FALSE;
@@ -391,6 +452,8 @@ void PipelineInfo::SetAttachmentCount(const uint32_t attachmentCount)
 	ASSERT(attachmentCount <= MaxRenderTargetCount, "mrtIndex must be lower then MaxRenderTargetCount");
 
 	colorBlendInfo.attachmentCount = attachmentCount;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetAlphaBlendEnabled(const uint32_t mrtIndex, const bool enabled)
@@ -398,6 +461,8 @@ void PipelineInfo::SetAlphaBlendEnabled(const uint32_t mrtIndex, const bool enab
 	ASSERT(mrtIndex < MaxRenderTargetCount, "mrtIndex must be lower then MaxRenderTargetCount");
 
 	colorBlendAttachment[mrtIndex].blendEnable = enabled;
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetAlphaBlendFunction(const uint32_t mrtIndex, const BlendValue srcBlend, const BlendValue dstBlend)
@@ -406,6 +471,8 @@ void PipelineInfo::SetAlphaBlendFunction(const uint32_t mrtIndex, const BlendVal
 
 	colorBlendAttachment[mrtIndex].srcColorBlendFactor = GetVkBlendFactorFrom(srcBlend);
 	colorBlendAttachment[mrtIndex].dstColorBlendFactor = GetVkBlendFactorFrom(dstBlend);
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetAlphaBlendFunction(const uint32_t mrtIndex, const BlendValue srcColorBlend,
@@ -417,6 +484,8 @@ void PipelineInfo::SetAlphaBlendFunction(const uint32_t mrtIndex, const BlendVal
 	colorBlendAttachment[mrtIndex].dstColorBlendFactor = GetVkBlendFactorFrom(dstColorBlend);
 	colorBlendAttachment[mrtIndex].srcAlphaBlendFactor = GetVkBlendFactorFrom(srcAlphaBlend);
 	colorBlendAttachment[mrtIndex].dstAlphaBlendFactor = GetVkBlendFactorFrom(dstAlphablend);
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetAlphaBlendOperation(const uint32_t mrtIndex, const BlendOperation colorOperation)
@@ -424,6 +493,8 @@ void PipelineInfo::SetAlphaBlendOperation(const uint32_t mrtIndex, const BlendOp
 	ASSERT(mrtIndex < MaxRenderTargetCount, "mrtIndex must be lower then MaxRenderTargetCount");
 
 	colorBlendAttachment[mrtIndex].colorBlendOp = GetVkBlendOpFrom(colorOperation);
+
+	InvalidateStateHash();
 }
 
 void PipelineInfo::SetAlphaBlendOperation(const uint32_t mrtIndex, const BlendOperation colorOperation, const BlendOperation alphaOperation)
@@ -432,6 +503,8 @@ void PipelineInfo::SetAlphaBlendOperation(const uint32_t mrtIndex, const BlendOp
 
 	colorBlendAttachment[mrtIndex].colorBlendOp = GetVkBlendOpFrom(colorOperation);
 	colorBlendAttachment[mrtIndex].alphaBlendOp = GetVkBlendOpFrom(alphaOperation);
+
+	InvalidateStateHash();
 }
 
 
@@ -37,7 +37,7 @@ class PipelineInfo
 {
 public:
 	PipelineInfo();
-	//void SetVertexBinding(const VertexBinding* vertexBinding);
+	void SetVertexLayout(const VertexLayout layout);
 	void SetTopology(const Topology topology);
 	void SetMultisampleType(const MultisampleType multisampleType);
 	void SetDepthWriteEnabled(const bool enabled);
@@ -59,6 +59,11 @@ public:
 	void SetAlphaBlendOperation(const uint32_t mrtIndex, const BlendOperation colorOperation, const BlendOperation alphaOperation);
 	void SetColorWriteMask(const uint32_t mrtIndex, const ColorWriteMaskFlags mask);
 	void SetColorWriteMask(const uint32_t mrtIndex, const uint32_t mrtCount, const ColorWriteMaskFlags masks[]);
+	void SetRenderTargetFormat(const uint32_t mrtIndex, const Format format);
+	void SetDepthStencilFormat(const Format format);
+
+	//fields that are written directly have to be followed by this, cached hashes are stale otherwise
+	inline void InvalidateStateHash() { graphicsStateHash = 0; computeStateHash = 0; stateVersion++; }
 
 	Shader*									vertexShader;
 	std::string								vsEntryPoint = "main";
@@ -76,9 +81,19 @@ public:
 	VkPipelineColorBlendAttachmentState		colorBlendAttachment[MaxRenderTargetCount];
 	VkPipelineColorBlendStateCreateInfo		colorBlendInfo;
 	VkPipelineDepthStencilStateCreateInfo	depthStencilInfo;
+	VertexLayout							vertexLayout = VertexLayout::Full;
 	VkPipelineLayout						pipelineLayout = nullptr;
 	VulkanRenderPass*						renderPass = nullptr;
 	uint32_t								subpass = 0;
+	//pipeline is used with every render pass compatible with these, so the pass itself is not part of its state
+	VkFormat								renderTargetFormats[MaxRenderTargetCount] = {};
+	VkFormat								depthStencilFormat = VK_FORMAT_UNDEFINED;
+
+	//computed by pipeline manager on the first lookup after a change, zero while stale
+	mutable uint64_t						graphicsStateHash = 0;
+	mutable uint64_t						computeStateHash = 0;
+	//changes with every invalidation, pipeline bound for an older version has to be looked up again
+	uint32_t								stateVersion = 0;
 };
 
 class VulkanPipeline 
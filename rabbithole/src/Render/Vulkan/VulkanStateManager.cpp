@@ -1,5 +1,6 @@
 #include "precomp.h"
 
+#include "Render/DescriptorAllocator.h"
 #include "Render/RenderPass.h"
 #include "Render/PipelineManager.h"
 #include "Render/Renderer.h"
@@ -47,6 +48,15 @@ void VulkanStateManager::SetWindingOrder(const WindingOrder wo)
     m_DirtyPipeline = true;
 }
 
+void VulkanStateManager::SetVertexLayout(const VertexLayout layout)
+{
+	if (m_PipelineInfo->vertexLayout != layout)
+	{
+		m_PipelineInfo->SetVertexLayout(layout);
+		m_DirtyPipeline = true;
+	}
+}
+
 void VulkanStateManager::SetRenderPassExtent(Extent2D extent)
 {
 	m_RenderPassInfo->extent = extent;
@@ -64,6 +74,7 @@ void VulkanStateManager::UpdateUBOElement(UBOElement element, uint32_t count, vo
 void VulkanStateManager::SetDepthStencil(VulkanImageView* ds)
 {
     m_DepthStencil = ds;
+	m_PipelineInfo->SetDepthStencilFormat(ds->GetFormat());
     m_DirtyPipeline = true;
 	m_DirtyRenderPass = true;
 }
@@ -116,10 +127,22 @@ void VulkanStateManager::SetCombinedImageSampler(uint32_t slot, VulkanTexture* t
 
 void VulkanStateManager::SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer)
 {
-	DescriptorKey k(3);
+	SetConstantBuffer(slot, buffer, 0, 0);
+}
+
+void VulkanStateManager::SetConstantBuffer(uint32_t slot, const FrameAllocation& allocation)
+{
+	SetConstantBuffer(slot, allocation.buffer, allocation.offset, allocation.size);
+}
+
+// constant buffers have offset appended to the key, frame allocations are parts of the same buffer
+void VulkanStateManager::SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer, uint64_t offset, uint64_t range)
+{
+	DescriptorKey k(4);
 	k[0] = slot;
 	k[1] = buffer->GetID();
 	k[2] = static_cast<uint32_t>(DescriptorType::UniformBuffer);
+	k[3] = static_cast<uint32_t>(offset);
 
 	//TODO: remove this ugly Singleton call
 	auto& descriptorsMap = Renderer::instance().GetPipelineManager().GetDescriptors();
@@ -134,6 +157,8 @@ void VulkanStateManager::SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer)
 	    VulkanDescriptorInfo info{};
 	    info.Binding = slot;
 	    info.buffer = buffer;
+	    info.bufferOffset = offset;
+	    info.bufferRange = range;
 	    info.Type = DescriptorType::UniformBuffer;
 
 	    VulkanDescriptor* descriptor = new VulkanDescriptor(info);
@@ -267,11 +292,9 @@ void VulkanStateManager::SetSampler(uint32_t slot, VulkanImageSampler* sampler)
 	}
 }
 
-VulkanDescriptorSet* VulkanStateManager::FinalizeDescriptorSet(VulkanDevice& device, const VulkanDescriptorPool* pool)
+VulkanDescriptorSet* VulkanStateManager::FinalizeDescriptorSet(DescriptorAllocator& descriptorAllocator)
 {
-	//TODO: remove this ugly Singleton call
-	auto& pipelineManager = Renderer::instance().GetPipelineManager();
-    VulkanDescriptorSet* descriptorset = pipelineManager.FindOrCreateDescriptorSet(device, pool, m_Pipeline->GetDescriptorSetLayout(), m_Descriptors);
+    VulkanDescriptorSet* descriptorset = descriptorAllocator.FindOrAllocate(m_Pipeline->GetDescriptorSetLayout(), m_Descriptors);
     m_Descriptors.clear();
     return descriptorset;
 }
@@ -295,6 +318,7 @@ void VulkanStateManager::SetRenderTarget(uint32_t slot, VulkanImageView* rt)
 	ASSERT(slot < MaxRenderTargetCount, "Reached out max number of RTs!");
 	ASSERT(slot == m_RenderTargets.size(), "Slot must be current equal to current size!");
 	m_RenderTargets.push_back(rt);
+	m_PipelineInfo->SetRenderTargetFormat(slot, rt->GetFormat());
 
 	m_DirtyPipeline = true;
 	m_DirtyRenderPass = true;
@@ -315,6 +339,7 @@ void VulkanStateManager::SetVertexShader(Shader* shader, std::string entryPoint)
 	m_CurrentPipelinetype = PipelineType::Graphics;
 	m_PipelineInfo->vertexShader = shader;
 	m_PipelineInfo->vsEntryPoint = entryPoint.c_str();
+	m_PipelineInfo->InvalidateStateHash();
 	m_DirtyPipeline = true;
 }
 
@@ -323,6 +348,7 @@ void VulkanStateManager::SetPixelShader(Shader* shader, std::string entryPoint)
 	m_CurrentPipelinetype = PipelineType::Graphics;
 	m_PipelineInfo->pixelShader = shader;
 	m_PipelineInfo->psEntryPoint = entryPoint.c_str();
+	m_PipelineInfo->InvalidateStateHash();
 	m_DirtyPipeline = true;
 }
 
@@ -331,5 +357,6 @@ void VulkanStateManager::SetComputeShader(Shader* shader, std::string entryPoint
 	m_CurrentPipelinetype = PipelineType::Compute;
 	m_PipelineInfo->computeShader = shader;
 	m_PipelineInfo->csEntryPoint = entryPoint.c_str();
+	m_PipelineInfo->InvalidateStateHash();
 	m_DirtyPipeline = true;
 }
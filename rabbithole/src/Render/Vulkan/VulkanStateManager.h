@@ -1,8 +1,10 @@
 #pragma once
 
+class DescriptorAllocator;
 class VulkanPipeline;
 class VulkanRenderPass;
 struct UniformBufferObject;
+struct FrameAllocation;
 class RenderPass;
 struct RenderPassInfo;
 
@@ -45,7 +47,10 @@ public:
 	//pipeline
 	PipelineInfo*		GetPipelineInfo() const { return m_PipelineInfo; }
 	VulkanPipeline*		GetPipeline() const { return m_Pipeline; }
-	void SetPipeline(VulkanPipeline* pipeline) { m_Pipeline = pipeline; m_DirtyPipeline = false; }
+	//bound pipeline is kept without a lookup only while state it was looked up for is unchanged, changed state
+	//that hashes the same goes through pipeline map, which compares full keys
+	bool				IsPipelineBound(uint64_t pipelineHash) const { return m_Pipeline && m_PipelineHash == pipelineHash && m_PipelineStateVersion == m_PipelineInfo->stateVersion; }
+	void SetPipeline(VulkanPipeline* pipeline, uint64_t pipelineHash) { m_Pipeline = pipeline; m_PipelineHash = pipelineHash; m_PipelineStateVersion = m_PipelineInfo->stateVersion; m_DirtyPipeline = false; }
 	bool GetPipelineDirty() { return m_DirtyPipeline; }
 	void SetPipelineDirty(bool dirty) { m_DirtyPipeline = dirty; }
 
@@ -55,6 +60,7 @@ public:
 	void EnableWireframe(bool enable);
 	void SetCullMode(const CullMode mode);
 	void SetWindingOrder(const WindingOrder wo);
+	void SetVertexLayout(const VertexLayout layout);
 
 	//renderpass
 	RenderPass*				GetRenderPass() const { return m_RenderPass; }
@@ -91,12 +97,14 @@ public:
 
 	void SetCombinedImageSampler(uint32_t slot, VulkanTexture* texture);
 	void SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer);
+	void SetConstantBuffer(uint32_t slot, const FrameAllocation& allocation);
 	void SetStorageImage(uint32_t slot, VulkanImageView* view);
 	void SetStorageBuffer(uint32_t slot, VulkanBuffer* buffer);
 	void SetSampledImage(uint32_t slot, VulkanImageView* view);
 	void SetSampler(uint32_t slot, VulkanImageSampler* sampler);
 
-	VulkanDescriptorSet* FinalizeDescriptorSet(VulkanDevice& device, const VulkanDescriptorPool* pool);
+	//set is valid until the allocator is reset
+	VulkanDescriptorSet* FinalizeDescriptorSet(DescriptorAllocator& descriptorAllocator);
 	uint8_t GetRenderTargetCount();
 	bool HasDepthStencil() { return m_DepthStencil ? true : false; }
 
@@ -106,8 +114,12 @@ public:
 	void UpdateResourceStage(ManagableResource* texture);
 
 private:
+	void SetConstantBuffer(uint32_t slot, VulkanBuffer* buffer, uint64_t offset, uint64_t range);
+
 	PipelineInfo*			m_PipelineInfo;
 	VulkanPipeline*		    m_Pipeline;
+	uint64_t				m_PipelineHash = 0;
+	uint32_t				m_PipelineStateVersion = 0;
     RenderPassInfo*			m_RenderPassInfo;
 	RenderPass*				m_RenderPass;
 	UniformBufferObject*    m_UBO;
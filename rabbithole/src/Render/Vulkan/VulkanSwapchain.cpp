@@ -54,7 +54,15 @@ VkResult VulkanSwapchain::AcquireNextImage(uint32_t* imageIndex)
 	return result;
 }
 
-VkResult VulkanSwapchain::SubmitCommandBufferAndPresent(VulkanCommandBuffer& buffer, uint32_t* imageIndex)
+void VulkanSwapchain::WaitForImageInFlight(uint32_t imageIndex)
+{
+	if (m_ImagesInFlight[imageIndex] != VK_NULL_HANDLE)
+	{
+		vkWaitForFences(m_VulkanDevice.GetGraphicDevice(), 1, &m_ImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+	}
+}
+
+VkResult VulkanSwapchain::SubmitCommandBufferAndPresent(VulkanCommandBuffer& buffer, uint32_t* imageIndex, const TimelineSemaphoreSync& timelineSync)
 {
 	if (m_ImagesInFlight[*imageIndex] != VK_NULL_HANDLE) 
 	{
@@ -65,9 +73,10 @@ VkResult VulkanSwapchain::SubmitCommandBufferAndPresent(VulkanCommandBuffer& buf
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphores[m_CurrentFrame] };
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount = 1;
+	VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphores[m_CurrentFrame], timelineSync.waitSemaphore };
+	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+	uint64_t waitValues[] = { 0, timelineSync.waitValue };
+	submitInfo.waitSemaphoreCount = timelineSync.waitSemaphore != VK_NULL_HANDLE ? 2 : 1;
 	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 
@@ -75,10 +84,19 @@ VkResult VulkanSwapchain::SubmitCommandBufferAndPresent(VulkanCommandBuffer& buf
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphores[m_CurrentFrame] };
-	submitInfo.signalSemaphoreCount = 1;
+	VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphores[m_CurrentFrame], timelineSync.signalSemaphore };
+	uint64_t signalValues[] = { 0, timelineSync.signalValue };
+	submitInfo.signalSemaphoreCount = timelineSync.signalSemaphore != VK_NULL_HANDLE ? 2 : 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
+	//values of binary semaphores are ignored
+	VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+	timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+	timelineInfo.pWaitSemaphoreValues = waitValues;
+	timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+	timelineInfo.pSignalSemaphoreValues = signalValues;
+	submitInfo.pNext = &timelineInfo;
+
 	vkResetFences(m_VulkanDevice.GetGraphicDevice(), 1, &m_InFlightFences[m_CurrentFrame]);
 	VULKAN_API_CALL(vkQueueSubmit(m_VulkanDevice.GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]));
 
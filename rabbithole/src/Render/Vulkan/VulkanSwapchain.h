@@ -15,6 +15,15 @@ class VulkanRenderPass;
 class VulkanFramebuffer;
 class VulkanTexture;
 
+//timeline semaphores frame submission waits on and signals next to the swapchain ones, unused while handles are null
+struct TimelineSemaphoreSync
+{
+	VkSemaphore	waitSemaphore = VK_NULL_HANDLE;
+	uint64_t	waitValue = 0;
+	VkSemaphore	signalSemaphore = VK_NULL_HANDLE;
+	uint64_t	signalValue = 0;
+};
+
 class VulkanSwapchain {
 public:
 	VulkanSwapchain(VulkanDevice& deviceRef, VkExtent2D windowExtent);
@@ -33,7 +42,9 @@ public:
 	float			ExtentAspectRatio() { return static_cast<float>(m_SwapChainExtent.width) / static_cast<float>(m_SwapChainExtent.height); }
 
 	VkResult		AcquireNextImage(uint32_t* imageIndex);
-	VkResult		SubmitCommandBufferAndPresent(VulkanCommandBuffer& buffer, uint32_t* imageIndex);
+	//after this everything previously submitted for the image is done, so its per image resources can be rewritten
+	void			WaitForImageInFlight(uint32_t imageIndex);
+	VkResult		SubmitCommandBufferAndPresent(VulkanCommandBuffer& buffer, uint32_t* imageIndex, const TimelineSemaphoreSync& timelineSync = {});
 
 private:
 	void CreateSwapChain();
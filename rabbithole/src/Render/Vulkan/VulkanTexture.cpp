@@ -25,7 +25,7 @@ VulkanTexture::VulkanTexture(VulkanDevice& device, const TextureData* data, ROTe
 	, m_Flags(createInfo.flags)
 	, m_Name(createInfo.name)
 {
-	CreateResource(&device, data, createInfo.generateMips);
+	CreateResource(&device, data, createInfo.generateMips, createInfo.mipGenerationFlags);
 	CreateView(&device);
 	CreateSampler(&device, createInfo.samplerType, createInfo.addressMode);
 
@@ -87,27 +87,54 @@ VulkanTexture::~VulkanTexture()
 	if (m_Resource) { delete(m_Resource); m_Resource = nullptr; }
 }
 
-void VulkanTexture::CreateResource(VulkanDevice* device, const TextureData* texData, bool generateMips)
+void VulkanTexture::CreateResource(VulkanDevice* device, const TextureData* texData, bool generateMips, MipGenerationFlags mipGenerationFlags)
 {
 	bool isCubeMap = IsFlagSet(m_Flags & TextureFlags::CubeMap);
 
-	uint32_t mipCount = generateMips ? GET_MIP_LEVELS_FROM_RES(texData->width, texData->height) : 1;
+	//precomputed mips are uploaded as they are, block compressed formats can't be blitted anyway
+	bool hasPrecomputedMips = !texData->mipData.empty();
+	generateMips = generateMips && !hasPrecomputedMips;
+
+	uint32_t mipCount = hasPrecomputedMips ? static_cast<uint32_t>(texData->mipData.size()) :
+		(generateMips ? GET_MIP_LEVELS_FROM_RES(texData->width, texData->height) : 1);
 	uint32_t arraySize = isCubeMap ? 6 : 1;
 
 	InitializeRegion(Extent3D{ static_cast<uint32_t>(texData->width), static_cast<uint32_t>(texData->height), 1 }, arraySize, mipCount);
 
-	uint32_t textureSize = texData->height * texData->width * GetBPPFrom(m_Format) * arraySize;
+	uint64_t textureSize = 0;
+	for (uint32_t mip = 0; mip < (hasPrecomputedMips ? mipCount : 1); mip++)
+	{
+		textureSize += GetImageSizeFrom(m_Format, std::max(m_Region.Extent.Width >> mip, 1u), std::max(m_Region.Extent.Height >> mip, 1u)) * arraySize;
+	}
+
+	VulkanUploadContext& uploadContext = device->GetUploadContext();
+	VulkanMipGenerator& mipGenerator = uploadContext.GetMipGenerator();
 
-	VulkanBuffer stagingBuffer(*device, BufferUsageFlags::TransferSrc, MemoryAccess::CPU, textureSize, "StagingBuffer");
+	//whole chain is generated by a single compute dispatch when format allows it, blits are the fallback
+	bool useMipGenerator = generateMips && !isCubeMap && mipGenerator.CanGenerateMips(m_Format, m_Region.Extent.Width, m_Region.Extent.Height);
 
-	void* data = stagingBuffer.Map();
-	memcpy(data, texData->pData, textureSize);
-	stagingBuffer.Unmap();
+	StagingAllocation staging = uploadContext.AllocateStaging(textureSize);
+	if (hasPrecomputedMips)
+	{
+		uint8_t* stagingData = static_cast<uint8_t*>(staging.data);
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+		{
+			uint64_t mipSize = GetImageSizeFrom(m_Format, std::max(m_Region.Extent.Width >> mip, 1u), std::max(m_Region.Extent.Height >> mip, 1u));
+			memcpy(stagingData, texData->mipData[mip], mipSize);
+			stagingData += mipSize;
+		}
+	}
+	else
+	{
+		memcpy(staging.data, texData->pData, textureSize);
+	}
 
 	VulkanImageInfo textureResourceInfo;
 	textureResourceInfo.Flags = (isCubeMap ? ImageFlags::CubeMap : ImageFlags::None) |
-								(IsFlagSet(m_Flags & TextureFlags::LinearTiling) ? ImageFlags::LinearTiling : ImageFlags::None);
+								(IsFlagSet(m_Flags & TextureFlags::LinearTiling) ? ImageFlags::LinearTiling : ImageFlags::None) |
+								(useMipGenerator && VulkanMipGenerator::GetStorageFormat(m_Format) != m_Format ? ImageFlags::MutableFormat : ImageFlags::None);
 	textureResourceInfo.UsageFlags = ImageUsageFlags::Resource |
+		(useMipGenerator ? ImageUsageFlags::Storage : ImageUsageFlags::None) |
 		(IsFlagSet(m_Flags & TextureFlags::TransferDst) ? ImageUsageFlags::TransferDst : ImageUsageFlags::None) | 
 		(IsFlagSet(m_Flags & TextureFlags::TransferSrc) ? ImageUsageFlags::TransferSrc : ImageUsageFlags::None) | 
 		(IsFlagSet(m_Flags & TextureFlags::DepthStencil) ? ImageUsageFlags::DepthStencil : ImageUsageFlags::None) | 
@@ -138,32 +165,45 @@ void VulkanTexture::CreateResource(VulkanDevice* device, const TextureData* texD
 		stateAfter = ResourceState::RenderTarget;
 	}
 
-	VulkanCommandBuffer tempCommandBuffer(*device, "Temp Texture Creation Command Buffer");
-	tempCommandBuffer.BeginCommandBuffer(true);
+	//recorded into shared upload command buffer, submitted together with other uploads when inside of a batch
+	VulkanCommandBuffer& uploadCommandBuffer = uploadContext.GetCommandBuffer();
 
-	device->ResourceBarrier(tempCommandBuffer, this, ResourceState::None, ResourceState::TransferDst, ResourceStage::Undefined, ResourceStage::Transfer, 0, mipCount);
+	device->ResourceBarrier(uploadCommandBuffer, this, ResourceState::None, ResourceState::TransferDst, ResourceStage::Undefined, ResourceStage::Transfer, 0, mipCount);
 
 	if (isCubeMap)
 	{
-		device->CopyBufferToImageCubeMap(tempCommandBuffer, &stagingBuffer, this);
+		device->CopyBufferToImageCubeMap(uploadCommandBuffer, staging.buffer, this, staging.offset);
+	}
+	else if (hasPrecomputedMips)
+	{
+		device->CopyBufferToImageMips(uploadCommandBuffer, staging.buffer, this, staging.offset);
 	}
 	else
 	{
-		device->CopyBufferToImage(tempCommandBuffer, &stagingBuffer, this, true);
+		device->CopyBufferToImage(uploadCommandBuffer, staging.buffer, this, true, staging.offset);
 	}
 
 	m_ShouldBeResourceState = m_CurrentResourceState = stateAfter;
 
-	if (generateMips)
+	//mips and final transition need graphics queue, copy could have been recorded for transfer queue
+	uploadContext.TransferOwnership(this, ResourceState::TransferDst);
+	VulkanCommandBuffer& graphicsCommandBuffer = uploadContext.GetGraphicsCommandBuffer();
+
+	if (useMipGenerator)
+	{
+		//recorded together with mips of other textures of the same submission
+		mipGenerator.QueueTexture(this, mipGenerationFlags, stateAfter);
+	}
+	else if (generateMips)
 	{
-		GenerateMips(tempCommandBuffer, device, mipCount);
+		GenerateMips(graphicsCommandBuffer, device, mipCount);
 	}
 	else
 	{
-		device->ResourceBarrier(tempCommandBuffer, this, ResourceState::TransferDst, stateAfter, ResourceStage::Transfer, ResourceStage::Undefined);
+		device->ResourceBarrier(graphicsCommandBuffer, this, ResourceState::TransferDst, stateAfter, ResourceStage::Transfer, ResourceStage::Undefined);
 	}
 
-	tempCommandBuffer.EndAndSubmitCommandBuffer();
+	uploadContext.EndUpload();
 }
 
 void VulkanTexture::CreateResource(VulkanDevice* device, RWTextureCreateInfo& createInfo)
@@ -205,14 +245,13 @@ void VulkanTexture::CreateResource(VulkanDevice* device, RWTextureCreateInfo& cr
 		stateAfter = ResourceState::RenderTarget;
 	}
 
-	VulkanCommandBuffer tempCommandBuffer(*device, "Temp Texture Creation Command Buffer");
-	tempCommandBuffer.BeginCommandBuffer(true);
+	VulkanUploadContext& uploadContext = device->GetUploadContext();
 
-	device->ResourceBarrier(tempCommandBuffer, this, ResourceState::None, stateAfter, ResourceStage::Undefined, ResourceStage::Undefined, 0, m_Region.Subresource.MipSize);
+	device->ResourceBarrier(uploadContext.GetGraphicsCommandBuffer(), this, ResourceState::None, stateAfter, ResourceStage::Undefined, ResourceStage::Undefined, 0, m_Region.Subresource.MipSize);
 
 	m_ShouldBeResourceState = m_CurrentResourceState = stateAfter;
 
-	tempCommandBuffer.EndAndSubmitCommandBuffer();
+	uploadContext.EndUpload();
 }
 
 void VulkanTexture::CreateView(VulkanDevice* device, ClearValue value)
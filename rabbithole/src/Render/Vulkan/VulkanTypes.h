@@ -81,6 +81,8 @@ enum class Format : uint8_t
 	BC2_UNORM_SRGB,
 	BC3_UNORM,
 	BC3_UNORM_SRGB,
+	BC4_UNORM,
+	BC5_UNORM,
 	BC7_UNORM,
 	BC7_UNORM_SRGB,
 	R32_UINT,
@@ -113,6 +115,7 @@ enum class ResourceState : uint8_t
 	BufferRead,
 	BufferWrite,
 	BufferReadWrite,
+	IndirectArgument,
 
 	Count
 };
@@ -207,6 +210,15 @@ enum class WindingOrder : uint8_t
 	Count
 };
 
+//keep in sync with VS_GBuffer
+enum class VertexLayout : uint8_t
+{
+	Full,
+	Compressed,
+
+	Count
+};
+
 enum class FilterType : uint8_t
 {
 	Point,
@@ -309,6 +321,7 @@ enum class ImageFlags : uint8_t
 	None = 0x0 << 0,
 	CubeMap = 0x1 << 0,
 	LinearTiling = 0x1 << 1,
+	MutableFormat = 0x1 << 2, //views can use other compatible formats, even for usage image format doesn't support
 };
 RABBITHOLE_FLAG_TYPE_SETUP(ImageFlags)
 
@@ -330,6 +343,7 @@ enum class ImageViewFlags : uint8_t
 	Color = 0x1 << 0,
 	ReadDepth = 0x1 << 1,
 	ReadStencil = 0x1 << 2,
+	Storage = 0x1 << 3, //only meaningful for mutable format images, other views of them can't be used as storage
 };
 RABBITHOLE_FLAG_TYPE_SETUP(ImageViewFlags)
 
@@ -366,10 +380,20 @@ enum class TextureFlags : uint16_t
 	LinearTiling = 0x1 << 5,
 	TransferSrc = 0x1 << 6,
 	TransferDst = 0x1 << 7,
-	Storage = 0x1 << 8
+	Storage = 0x1 << 8,
+	Transient = 0x1 << 9	//contents don't outlive the frame, memory is shared with transient textures used in other passes
 };
 RABBITHOLE_FLAG_TYPE_SETUP(TextureFlags)
 
+//srgb textures are always filtered in linear space
+enum class MipGenerationFlags : uint8_t
+{
+	None = 0x0 << 0,
+	NormalMap = 0x1 << 0,		//averaged normals are renormalized
+	AlphaCoverage = 0x1 << 1,	//alpha tested surfaces keep their coverage in smaller mips
+};
+RABBITHOLE_FLAG_TYPE_SETUP(MipGenerationFlags)
+
 
 struct Color
 {
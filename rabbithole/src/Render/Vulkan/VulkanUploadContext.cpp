@@ -0,0 +1,450 @@
+#include "precomp.h"
+
+#include "VulkanUploadContext.h"
+
+#include <algorithm>
+
+#include "Render/Converters.h"
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+VulkanUploadContext::VulkanUploadContext(VulkanDevice& device, uint64_t stagingRingSize)
+	: m_Device(device)
+	, m_HasDedicatedTransferQueue(device.HasDedicatedTransferQueue())
+	, m_StagingRingSize(stagingRingSize)
+{
+	m_MipGenerator = std::make_unique<VulkanMipGenerator>(m_Device);
+
+	m_StagingRing = new VulkanBuffer(m_Device, BufferUsageFlags::TransferSrc, MemoryAccess::CPU, m_StagingRingSize, "UploadStagingRing");
+	m_StagingRingData = static_cast<uint8_t*>(m_StagingRing->Map());
+
+	VkSemaphoreTypeCreateInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &timelineInfo;
+
+	VULKAN_API_CALL(vkCreateSemaphore(m_Device.GetGraphicDevice(), &semaphoreInfo, nullptr, &m_TransferTimeline));
+	m_Device.SetObjectName((uint64_t)m_TransferTimeline, VK_OBJECT_TYPE_SEMAPHORE, "UploadTransferTimeline");
+}
+
+VulkanUploadContext::~VulkanUploadContext()
+{
+	WaitForUploads();
+
+	for (VkFence fence : m_FreeFences)
+	{
+		vkDestroyFence(m_Device.GetGraphicDevice(), fence, nullptr);
+	}
+	for (VulkanCommandBuffer* commandBuffer : m_FreeTransferCommandBuffers)
+	{
+		delete commandBuffer;
+	}
+	for (VulkanCommandBuffer* commandBuffer : m_FreeGraphicsCommandBuffers)
+	{
+		delete commandBuffer;
+	}
+
+	vkDestroySemaphore(m_Device.GetGraphicDevice(), m_TransferTimeline, nullptr);
+	delete m_StagingRing;
+}
+
+StagingAllocation VulkanUploadContext::AllocateStaging(uint64_t size, uint64_t alignment)
+{
+	//too large for the ring, gets its own buffer that lives until the upload is finished
+	if (size > m_StagingRingSize)
+	{
+		VulkanBuffer* stagingBuffer = new VulkanBuffer(m_Device, BufferUsageFlags::TransferSrc, MemoryAccess::CPU, size, "DedicatedStagingBuffer");
+		m_DedicatedStagingBuffers.push_back(stagingBuffer);
+		return StagingAllocation{ stagingBuffer, 0, stagingBuffer->Map() };
+	}
+
+	while (true)
+	{
+		uint64_t offset = AlignUp(m_RingHead, alignment);
+
+		//allocation can't wrap around the end of the ring, skip to its start instead
+		if (offset % m_StagingRingSize + size > m_StagingRingSize)
+		{
+			offset = AlignUp(offset, m_StagingRingSize);
+		}
+
+		if (offset + size - m_RingTail <= m_StagingRingSize)
+		{
+			m_RingHead = offset + size;
+
+			uint64_t ringOffset = offset % m_StagingRingSize;
+			return StagingAllocation{ m_StagingRing, ringOffset, m_StagingRingData + ringOffset };
+		}
+
+		//ring is full, submit what is recorded and wait for the oldest upload to free its part of the ring
+		Flush();
+
+		if (m_Submissions.empty())
+		{
+			m_RingHead = m_RingTail = 0;
+			continue;
+		}
+
+		Submission& oldestSubmission = m_Submissions.front();
+		WaitForSubmission(oldestSubmission);
+		RetireSubmission(oldestSubmission);
+		m_Submissions.pop_front();
+	}
+}
+
+VulkanCommandBuffer& VulkanUploadContext::GetCommandBuffer()
+{
+	if (!IsUsingTransferQueue())
+	{
+		return GetGraphicsCommandBuffer();
+	}
+
+	if (!m_TransferCommandBuffer)
+	{
+		m_TransferCommandBuffer = AcquireCommandBuffer(true);
+	}
+
+	return *m_TransferCommandBuffer;
+}
+
+VulkanCommandBuffer& VulkanUploadContext::GetGraphicsCommandBuffer()
+{
+	if (!m_GraphicsCommandBuffer)
+	{
+		m_GraphicsCommandBuffer = AcquireCommandBuffer(false);
+	}
+
+	return *m_GraphicsCommandBuffer;
+}
+
+void VulkanUploadContext::TransferOwnership(VulkanTexture* texture, ResourceState state)
+{
+	//concurrent resources have no owner, timeline semaphore alone orders copies before their use
+	if (!IsUsingTransferQueue() || !m_Device.GetConcurrentQueueFamilies().empty())
+	{
+		return;
+	}
+
+	//release and acquire have to describe the same transition, layout stays as it is
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = GetVkImageLayoutFrom(state);
+	barrier.newLayout = GetVkImageLayoutFrom(state);
+	barrier.srcQueueFamilyIndex = m_Device.GetTransferQueueFamily();
+	barrier.dstQueueFamilyIndex = m_Device.GetGraphicsQueueFamily();
+	barrier.image = GET_VK_HANDLE_PTR(texture->GetResource());
+	barrier.subresourceRange.aspectMask = GetVkImageAspectFlagsFrom(GetVkFormatFrom(texture->GetFormat()));
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(GET_VK_HANDLE_PTR(m_TransferCommandBuffer), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(GET_VK_HANDLE(GetGraphicsCommandBuffer()), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void VulkanUploadContext::TransferOwnership(VulkanBuffer* buffer)
+{
+	//concurrent resources have no owner, timeline semaphore alone orders copies before their use
+	if (!IsUsingTransferQueue() || !m_Device.GetConcurrentQueueFamilies().empty())
+	{
+		return;
+	}
+
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = m_Device.GetTransferQueueFamily();
+	barrier.dstQueueFamilyIndex = m_Device.GetGraphicsQueueFamily();
+	barrier.buffer = GET_VK_HANDLE_PTR(buffer);
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(GET_VK_HANDLE_PTR(m_TransferCommandBuffer), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(GET_VK_HANDLE(GetGraphicsCommandBuffer()), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VulkanUploadContext::EndUpload()
+{
+	if (m_BatchDepth == 0)
+	{
+		WaitForUploads();
+	}
+}
+
+void VulkanUploadContext::UploadBuffer(VulkanBuffer* dstBuffer, const void* data, uint64_t size, uint64_t dstOffset)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	StagingAllocation staging = AllocateStaging(size);
+	memcpy(staging.data, data, size);
+
+	m_Device.CopyBuffer(GetCommandBuffer(), *staging.buffer, *dstBuffer, size, staging.offset, dstOffset);
+	TransferOwnership(dstBuffer);
+
+	EndUpload();
+}
+
+void VulkanUploadContext::BeginBatch()
+{
+	m_BatchDepth++;
+}
+
+void VulkanUploadContext::EndBatch(bool waitForUploads)
+{
+	ASSERT(m_BatchDepth > 0, "Upload batch ended without being started");
+
+	if (--m_BatchDepth > 0)
+	{
+		return;
+	}
+
+	if (waitForUploads)
+	{
+		WaitForUploads();
+	}
+	else
+	{
+		Flush();
+	}
+}
+
+void VulkanUploadContext::Flush()
+{
+	if (!m_TransferCommandBuffer && !m_GraphicsCommandBuffer)
+	{
+		return;
+	}
+
+	//graphics part always runs last, uploads are consumed by later submissions on the graphics queue,
+	//so it makes their writes visible to everything after it
+	VulkanCommandBuffer& graphicsCommandBuffer = GetGraphicsCommandBuffer();
+
+	m_MipGenerator->Record(graphicsCommandBuffer, m_LastSubmissionId + 1);
+
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	vkCmdPipelineBarrier(GET_VK_HANDLE(graphicsCommandBuffer), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+	graphicsCommandBuffer.EndCommandBuffer();
+
+	uint64_t transferTimelineValue = 0;
+	if (m_TransferCommandBuffer)
+	{
+		m_TransferCommandBuffer->EndCommandBuffer();
+		transferTimelineValue = ++m_TransferTimelineValue;
+
+		VkCommandBuffer transferCommandBuffer = GET_VK_HANDLE_PTR(m_TransferCommandBuffer);
+
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.signalSemaphoreValueCount = 1;
+		timelineSubmitInfo.pSignalSemaphoreValues = &transferTimelineValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &transferCommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &m_TransferTimeline;
+
+		VULKAN_API_CALL(vkQueueSubmit(m_Device.GetTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+	}
+
+	m_Submissions.push_back(Submission{ VK_NULL_HANDLE, ++m_LastSubmissionId, m_TransferCommandBuffer, m_GraphicsCommandBuffer, transferTimelineValue, false, m_RingHead, std::move(m_DedicatedStagingBuffers) });
+	m_DedicatedStagingBuffers.clear();
+	m_TransferCommandBuffer = nullptr;
+	m_GraphicsCommandBuffer = nullptr;
+
+	//without copies on transfer queue there is nothing to wait for
+	if (transferTimelineValue == 0)
+	{
+		SubmitGraphics(m_Submissions.back());
+	}
+}
+
+void VulkanUploadContext::SubmitGraphics(Submission& submission)
+{
+	if (m_FreeFences.empty())
+	{
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VULKAN_API_CALL(vkCreateFence(m_Device.GetGraphicDevice(), &fenceInfo, nullptr, &submission.fence));
+	}
+	else
+	{
+		submission.fence = m_FreeFences.back();
+		m_FreeFences.pop_back();
+	}
+
+	VkCommandBuffer commandBuffer = GET_VK_HANDLE_PTR(submission.graphicsCommandBuffer);
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = 1;
+	timelineSubmitInfo.pWaitSemaphoreValues = &submission.transferTimelineValue;
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	//copies are already done at this point, wait only makes their writes visible to graphics queue
+	if (submission.transferTimelineValue > 0)
+	{
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &m_TransferTimeline;
+		submitInfo.pWaitDstStageMask = &waitStage;
+	}
+
+	VULKAN_API_CALL(vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, submission.fence));
+	submission.graphicsSubmitted = true;
+}
+
+void VulkanUploadContext::WaitForSubmission(Submission& submission)
+{
+	if (!submission.graphicsSubmitted)
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_TransferTimeline;
+		waitInfo.pValues = &submission.transferTimelineValue;
+
+		VULKAN_API_CALL(vkWaitSemaphores(m_Device.GetGraphicDevice(), &waitInfo, UINT64_MAX));
+		SubmitGraphics(submission);
+	}
+
+	VULKAN_API_CALL(vkWaitForFences(m_Device.GetGraphicDevice(), 1, &submission.fence, VK_TRUE, UINT64_MAX));
+}
+
+void VulkanUploadContext::Update()
+{
+	uint64_t completedTransferValue = 0;
+	VULKAN_API_CALL(vkGetSemaphoreCounterValue(m_Device.GetGraphicDevice(), m_TransferTimeline, &completedTransferValue));
+
+	//graphics parts are submitted in order, so everything submitted before keeps its place in the queue
+	for (Submission& submission : m_Submissions)
+	{
+		if (submission.graphicsSubmitted)
+		{
+			continue;
+		}
+
+		if (submission.transferTimelineValue > completedTransferValue)
+		{
+			break;
+		}
+
+		SubmitGraphics(submission);
+	}
+
+	RetireFinishedSubmissions();
+}
+
+bool VulkanUploadContext::IsSubmissionHandedOver(uint64_t submissionId) const
+{
+	//graphics parts can be submitted out of order, submissions without transfer part don't wait for earlier ones
+	for (const Submission& submission : m_Submissions)
+	{
+		if (submission.id <= submissionId && !submission.graphicsSubmitted)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void VulkanUploadContext::WaitForUploads()
+{
+	Flush();
+
+	for (Submission& submission : m_Submissions)
+	{
+		WaitForSubmission(submission);
+		RetireSubmission(submission);
+	}
+	m_Submissions.clear();
+
+	//nothing is in flight, next allocation can start at the beginning of the ring
+	m_RingHead = m_RingTail = 0;
+}
+
+void VulkanUploadContext::RetireSubmission(Submission& submission)
+{
+	m_RingTail = std::max(m_RingTail, submission.ringEnd);
+
+	m_MipGenerator->Retire(submission.id);
+
+	for (VulkanBuffer* stagingBuffer : submission.dedicatedStagingBuffers)
+	{
+		delete stagingBuffer;
+	}
+
+	VULKAN_API_CALL(vkResetFences(m_Device.GetGraphicDevice(), 1, &submission.fence));
+	m_FreeFences.push_back(submission.fence);
+
+	if (submission.transferCommandBuffer)
+	{
+		m_FreeTransferCommandBuffers.push_back(submission.transferCommandBuffer);
+	}
+	m_FreeGraphicsCommandBuffers.push_back(submission.graphicsCommandBuffer);
+}
+
+void VulkanUploadContext::RetireFinishedSubmissions()
+{
+	while (!m_Submissions.empty() && m_Submissions.front().graphicsSubmitted && vkGetFenceStatus(m_Device.GetGraphicDevice(), m_Submissions.front().fence) == VK_SUCCESS)
+	{
+		RetireSubmission(m_Submissions.front());
+		m_Submissions.pop_front();
+	}
+}
+
+VulkanCommandBuffer* VulkanUploadContext::AcquireCommandBuffer(bool transferQueue)
+{
+	RetireFinishedSubmissions();
+
+	std::vector<VulkanCommandBuffer*>& freeCommandBuffers = transferQueue ? m_FreeTransferCommandBuffers : m_FreeGraphicsCommandBuffers;
+
+	VulkanCommandBuffer* commandBuffer = nullptr;
+	if (freeCommandBuffers.empty())
+	{
+		commandBuffer = transferQueue ?
+			new VulkanCommandBuffer(m_Device, m_Device.GetTransferCommandPool(), "Upload Transfer Command Buffer") :
+			new VulkanCommandBuffer(m_Device, m_Device.GetCommandPool(), "Upload Command Buffer");
+	}
+	else
+	{
+		commandBuffer = freeCommandBuffers.back();
+		freeCommandBuffers.pop_back();
+	}
+
+	commandBuffer->BeginCommandBuffer(true);
+	return commandBuffer;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "common.h"
+#include "VulkanMipGenerator.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class VulkanDevice;
+class VulkanBuffer;
+class VulkanCommandBuffer;
+class VulkanTexture;
+enum class ResourceState : uint8_t;
+
+#define UPLOAD_STAGING_RING_SIZE	(MB_64)
+//satisfies buffer to image copy alignment of every format, including block compressed ones
+#define UPLOAD_STAGING_ALIGNMENT	(16)
+
+struct StagingAllocation
+{
+	VulkanBuffer*	buffer;
+	uint64_t		offset;
+	void*			data;
+};
+
+//records uploads into shared command buffers, staging memory comes from a persistently mapped ring that is
+//reclaimed as submissions finish. outside of a batch every upload is submitted and waited on right away,
+//inside of a batch uploads are submitted only when ring runs out of space or batch ends.
+//batched copies go to the dedicated transfer queue when device has one and signal a timeline semaphore. graphics
+//part of the submission (ownership acquire, mips) is submitted by Update once copies are done, so rendering is never
+//blocked behind them. mips of all textures of a submission are generated together right before it is submitted.
+//resources uploaded in a batch must not be in use by the gpu
+class VulkanUploadContext
+{
+public:
+	VulkanUploadContext(VulkanDevice& device, uint64_t stagingRingSize = UPLOAD_STAGING_RING_SIZE);
+	~VulkanUploadContext();
+
+	NonCopyableAndMovable(VulkanUploadContext);
+
+	//has to be called before recording, allocation can submit work that is already recorded
+	StagingAllocation	AllocateStaging(uint64_t size, uint64_t alignment = UPLOAD_STAGING_ALIGNMENT);
+	//copies, recorded for transfer queue inside of a batch
+	VulkanCommandBuffer& GetCommandBuffer();
+	//work that needs graphics queue, runs after all copies of the same submission
+	VulkanCommandBuffer& GetGraphicsCommandBuffer();
+	//hands resource written by copies over to graphics queue family, no-op when copies are on graphics queue or
+	//resources are concurrent
+	void				TransferOwnership(VulkanTexture* texture, ResourceState state);
+	void				TransferOwnership(VulkanBuffer* buffer);
+	//marks the end of a single upload
+	void				EndUpload();
+
+	VulkanMipGenerator&	GetMipGenerator() { return *m_MipGenerator; }
+
+	void				UploadBuffer(VulkanBuffer* dstBuffer, const void* data, uint64_t size, uint64_t dstOffset = 0);
+
+	void				BeginBatch();
+	//without waiting uploads are finished by the time later work on the graphics queue executes
+	void				EndBatch(bool waitForUploads = true);
+
+	//submits recorded uploads without waiting for them
+	void				Flush();
+	void				WaitForUploads();
+	//id of the last flushed submission, every upload recorded before the flush is part of it or of an earlier one
+	inline uint64_t		GetLastSubmissionId() const { return m_LastSubmissionId; }
+	//true once graphics part of the submission and of all earlier ones is submitted,
+	//graphics work submitted after that sees the uploads
+	bool				IsSubmissionHandedOver(uint64_t submissionId) const;
+	//called once per frame, hands finished copies over to graphics queue and recycles finished submissions
+	void				Update();
+
+private:
+	struct Submission
+	{
+		VkFence						fence;
+		uint64_t					id;
+		VulkanCommandBuffer*		transferCommandBuffer;
+		VulkanCommandBuffer*		graphicsCommandBuffer;
+		uint64_t					transferTimelineValue;
+		bool						graphicsSubmitted;
+		uint64_t					ringEnd;
+		std::vector<VulkanBuffer*>	dedicatedStagingBuffers;
+	};
+
+	inline bool IsUsingTransferQueue() const { return m_HasDedicatedTransferQueue && m_BatchDepth > 0; }
+
+	VulkanCommandBuffer* AcquireCommandBuffer(bool transferQueue);
+	void SubmitGraphics(Submission& submission);
+	void WaitForSubmission(Submission& submission);
+	void RetireSubmission(Submission& submission);
+	void RetireFinishedSubmissions();
+
+	VulkanDevice&					m_Device;
+	bool							m_HasDedicatedTransferQueue;
+
+	std::unique_ptr<VulkanMipGenerator> m_MipGenerator;
+
+	VulkanBuffer*					m_StagingRing;
+	uint8_t*						m_StagingRingData;
+	uint64_t						m_StagingRingSize;
+	//virtual offsets that only grow, physical offset is modulo ring size
+	uint64_t						m_RingHead = 0;
+	uint64_t						m_RingTail = 0;
+
+	//signaled only by transfer queue, value of the last transfer submission
+	VkSemaphore						m_TransferTimeline;
+	uint64_t						m_TransferTimelineValue = 0;
+	uint64_t						m_LastSubmissionId = 0;
+
+	VulkanCommandBuffer*			m_TransferCommandBuffer = nullptr;
+	VulkanCommandBuffer*			m_GraphicsCommandBuffer = nullptr;
+	std::vector<VulkanBuffer*>		m_DedicatedStagingBuffers;
+	std::deque<Submission>			m_Submissions;
+	std::vector<VulkanCommandBuffer*> m_FreeTransferCommandBuffers;
+	std::vector<VulkanCommandBuffer*> m_FreeGraphicsCommandBuffers;
+	std::vector<VkFence>			m_FreeFences;
+
+	uint32_t						m_BatchDepth = 0;
+};
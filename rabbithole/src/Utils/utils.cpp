@@ -2,6 +2,8 @@
 
 #include "Logger/Logger.h"
 
+#include <crc32/Crc32.h>
+
 #include <vector>
 #include <fstream>
 #include <iostream>
@@ -9,6 +11,10 @@
 #include <ctime>
 #include <iomanip>
 
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
 namespace Utils
 {
 	long long SetStartTime()
@@ -68,5 +74,63 @@ namespace Utils
 		free(ptr);
 	}
 
-}
+	uint64_t Hash64(const void* data, size_t size, uint64_t seed)
+	{
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= static_cast<const uint8_t*>(data)[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	Hash128 HashContent(const void* data, size_t size, uint32_t seed)
+	{
+		Hash128 hash;
+		hash.low = Hash64(data, size, HASH64_SEED ^ seed);
+		hash.high = (static_cast<uint64_t>(crc32_fast(data, size, seed)) << 32) | static_cast<uint32_t>(size);
+		return hash;
+	}
+
+	MappedFile::MappedFile(const std::string& filepath)
+	{
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		m_FileHandle = file;
 
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			return;
+		}
+
+		m_MappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_MappingHandle == nullptr)
+		{
+			return;
+		}
+
+		m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		m_Size = m_Data ? static_cast<size_t>(fileSize.QuadPart) : 0;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_MappingHandle)
+		{
+			CloseHandle(m_MappingHandle);
+		}
+		if (m_FileHandle)
+		{
+			CloseHandle(m_FileHandle);
+		}
+	}
+}
@@ -15,4 +15,44 @@ namespace Utils
 
 	void* RabbitMalloc(size_t size);
 	void RabbitFree(void* ptr);
+
+	//64 bit fnv-1a, previous hash is passed as seed to hash several blocks together
+	#define HASH64_SEED 14695981039346656037ull
+	uint64_t Hash64(const void* data, size_t size, uint64_t seed = HASH64_SEED);
+
+	//fnv-1a and crc32 of the same bytes together with their size, content with equal hashes is shared without comparing it
+	struct Hash128
+	{
+		uint64_t low = 0;
+		uint64_t high = 0;
+
+		bool operator==(const Hash128& other) const = default;
+	};
+
+	struct Hash128Hasher
+	{
+		size_t operator()(const Hash128& hash) const { return static_cast<size_t>(hash.low ^ (hash.high * 31)); }
+	};
+
+	Hash128 HashContent(const void* data, size_t size, uint32_t seed);
+
+	//read only memory mapped view of a whole file, pages are loaded by the os on first access
+	class MappedFile
+	{
+	public:
+		MappedFile(const std::string& filepath);
+		~MappedFile();
+
+		NonCopyableAndMovable(MappedFile);
+
+		inline bool				IsValid() const { return m_Data != nullptr; }
+		inline const uint8_t*	GetData() const { return m_Data; }
+		inline size_t			GetSize() const { return m_Size; }
+
+	private:
+		void*			m_FileHandle = nullptr;
+		void*			m_MappingHandle = nullptr;
+		const uint8_t*	m_Data = nullptr;
+		size_t			m_Size = 0;
+	};
 }
@@ -52,6 +52,7 @@ typedef glm::vec4 rabbitVec4f;
 typedef glm::vec3 rabbitVec3f;
 typedef glm::vec2 rabbitVec2f;
 typedef glm::mat4 rabbitMat4f;
+typedef glm::mat3 rabbitMat3f;
 
 #define ZERO_VEC3f rabbitVec3f{0.0, 0.0, 0.0}
 #define ZERO_MAT4f rabbitMat4f{1.f}